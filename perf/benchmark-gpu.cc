@@ -48,8 +48,43 @@ static struct test_input_t
 static test_input_t *tests = default_tests;
 static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
 
+/* Band statistics over a whole font.  "curves/px" is the number of
+ * curves the fragment shader visits for a pixel: one horizontal plus
+ * one vertical band. */
+struct band_stats_t
+{
+  unsigned glyphs = 0;
+  unsigned worst = 0;
+  double sum_worst = 0;
+  double sum_mean = 0;
+  double sum_texels = 0;
+
+  void add (const hb_gpu_draw_encode_stats_t &stats)
+  {
+    if (!stats.texel_count)
+      return;
+    unsigned w = stats.max_hband_curves + stats.max_vband_curves;
+    glyphs++;
+    if (w > worst) worst = w;
+    sum_worst += w;
+    sum_mean += stats.mean_hband_curves + stats.mean_vband_curves;
+    sum_texels += stats.texel_count;
+  }
+
+  void report (benchmark::State &state) const
+  {
+    if (!glyphs)
+      return;
+    state.counters["max curves/px"] = worst;
+    state.counters["mean max curves/px"] = sum_worst / glyphs;
+    state.counters["mean curves/px"] = sum_mean / glyphs;
+    state.counters["texels/glyph"] = sum_texels / glyphs;
+  }
+};
+
 static void BM_GpuDrawEncode (benchmark::State &state,
-			   const test_input_t &test_input)
+			   const test_input_t &test_input,
+			   unsigned texel_budget)
 {
   hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (test_input.font_path, 0);
   if (!face)
@@ -62,15 +97,24 @@ static void BM_GpuDrawEncode (benchmark::State &state,
   unsigned num_glyphs = hb_face_get_glyph_count (face);
   hb_gpu_draw_t *draw = hb_gpu_draw_create_or_fail ();
   assert (draw);
+  hb_gpu_draw_set_texel_budget (draw, texel_budget);
 
+  band_stats_t stats;
   for (auto _ : state)
+  {
+    stats = band_stats_t ();
     for (unsigned gid = 0; gid < num_glyphs; ++gid)
     {
       hb_gpu_draw_clear (draw);
       hb_gpu_draw_glyph (draw, font, gid);
       hb_blob_t *blob = hb_gpu_draw_encode (draw, nullptr);
+      hb_gpu_draw_encode_stats_t encode_stats;
+      hb_gpu_draw_get_encode_stats (draw, &encode_stats);
+      stats.add (encode_stats);
       hb_gpu_draw_recycle_blob (draw, blob);
     }
+  }
+  stats.report (state);
 
   hb_gpu_draw_destroy (draw);
   hb_font_destroy (font);
@@ -148,7 +192,12 @@ int main (int argc, char **argv)
 
     char draw_name[1024] = "BM_GpuDrawEncode/";
     strcat (draw_name, base);
-    benchmark::RegisterBenchmark (draw_name, BM_GpuDrawEncode, test_input)
+    benchmark::RegisterBenchmark (draw_name, BM_GpuDrawEncode, test_input, 0u)
+      ->Unit (benchmark::kMillisecond);
+
+    char adaptive_name[1024] = "BM_GpuDrawEncodeAdaptive/";
+    strcat (adaptive_name, base);
+    benchmark::RegisterBenchmark (adaptive_name, BM_GpuDrawEncode, test_input, 65536u)
       ->Unit (benchmark::kMillisecond);
 
     char paint_name[1024] = "BM_GpuPaintEncode/";
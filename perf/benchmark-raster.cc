@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb-benchmark.hh"
+
+#include <hb-raster.h>
+
+#include <glib.h>
+
+#include <vector>
+
+#define SUBSET_FONT_BASE_PATH "test/subset/data/fonts/"
+
+static const char *font_path = SUBSET_FONT_BASE_PATH "Roboto-Regular.ttf";
+static int font_size = 64;
+
+static struct png_test_t
+{
+  const char *name;
+  hb_raster_png_options_t options;
+} png_tests[] =
+{
+  {"default",	HB_RASTER_PNG_OPTIONS_DEFAULT},
+  {"fast",	{1, HB_RASTER_PNG_FILTER_UP, HB_RASTER_PNG_A8_GRAY, nullptr, nullptr}},
+  {"stored",	{0, HB_RASTER_PNG_FILTER_NONE, HB_RASTER_PNG_A8_GRAY, nullptr, nullptr}},
+  {"palette",	{1, HB_RASTER_PNG_FILTER_UP, HB_RASTER_PNG_A8_PALETTE, nullptr, nullptr}},
+};
+
+/* Renders every glyph of the font once; the benchmarks only encode. */
+static std::vector<hb_raster_image_t *>
+render_glyphs (hb_face_t *face, bool color)
+{
+  std::vector<hb_raster_image_t *> images;
+
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, font_size, font_size);
+  unsigned num_glyphs = hb_face_get_glyph_count (face);
+
+  hb_raster_draw_t *draw = hb_raster_draw_create_or_fail ();
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  assert (draw && paint);
+
+  for (unsigned gid = 0; gid < num_glyphs; ++gid)
+  {
+    hb_glyph_extents_t extents;
+    if (!hb_font_get_glyph_extents (font, gid, &extents) ||
+	!extents.width || !extents.height)
+      continue;
+
+    hb_raster_image_t *image;
+    if (color)
+    {
+      hb_raster_paint_set_glyph_extents (paint, &extents);
+      hb_raster_paint_glyph (paint, font, gid);
+      image = hb_raster_paint_render (paint);
+    }
+    else
+    {
+      hb_raster_draw_set_glyph_extents (draw, &extents);
+      hb_raster_draw_glyph (draw, font, gid);
+      image = hb_raster_draw_render (draw);
+    }
+    if (image)
+      images.push_back (image);
+  }
+
+  hb_raster_paint_destroy (paint);
+  hb_raster_draw_destroy (draw);
+  hb_font_destroy (font);
+  return images;
+}
+
+static void BM_RasterPngEncode (benchmark::State &state,
+				const png_test_t &test,
+				bool color)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (font_path, 0);
+  if (!face)
+  {
+    state.SkipWithError ("Failed to open font file");
+    return;
+  }
+
+  std::vector<hb_raster_image_t *> images = render_glyphs (face, color);
+
+  size_t bytes = 0;
+  for (auto _ : state)
+    for (hb_raster_image_t *image : images)
+    {
+      hb_blob_t *blob = hb_raster_image_serialize_to_png_with_options_or_fail (image, &test.options);
+      bytes += hb_blob_get_length (blob);
+      hb_blob_destroy (blob);
+    }
+
+  state.SetItemsProcessed (state.iterations () * images.size ());
+  state.counters["bytes/image"] = images.size () && state.iterations ()
+				? (double) bytes / (state.iterations () * images.size ())
+				: 0.;
+
+  for (hb_raster_image_t *image : images)
+    hb_raster_image_destroy (image);
+  hb_face_destroy (face);
+}
+
+static const char *font_file = nullptr;
+
+static GOptionEntry entries[] =
+{
+  {"font-file", 0, 0, G_OPTION_ARG_STRING, &font_file, "Font file-path to benchmark", "FONTFILE"},
+  {"font-size", 0, 0, G_OPTION_ARG_INT, &font_size, "Font size in pixels (default: 64)", "SIZE"},
+  {nullptr}
+};
+
+int main (int argc, char **argv)
+{
+  benchmark::Initialize (&argc, argv);
+
+  GOptionContext *context = g_option_context_new ("");
+  g_option_context_set_summary (context, "Benchmark raster image PNG encoding");
+  g_option_context_add_main_entries (context, entries, nullptr);
+  g_option_context_parse (context, &argc, &argv, nullptr);
+  g_option_context_free (context);
+
+  argc--;
+  argv++;
+  if (!font_file && argc)
+  {
+    font_file = *argv;
+    argc--;
+    argv++;
+  }
+  if (font_file)
+    font_path = font_file;
+
+  for (const auto &test : png_tests)
+  {
+    char name[1024] = "BM_RasterPngEncode/a8/";
+    strcat (name, test.name);
+    benchmark::RegisterBenchmark (name, BM_RasterPngEncode, test, false)
+      ->Unit (benchmark::kMillisecond);
+  }
+  for (const auto &test : png_tests)
+  {
+    if (test.options.a8_mode != HB_RASTER_PNG_A8_GRAY)
+      continue;
+    char name[1024] = "BM_RasterPngEncode/bgra32/";
+    strcat (name, test.name);
+    benchmark::RegisterBenchmark (name, BM_RasterPngEncode, test, true)
+      ->Unit (benchmark::kMillisecond);
+  }
+
+  benchmark::RunSpecifiedBenchmarks ();
+  benchmark::Shutdown ();
+}
@@ -0,0 +1,194 @@
+#include "hb-benchmark.hh"
+
+#include <cstdio>
+#include <vector>
+
+/* Object graphs that overflow, saved with graph_t::save_fuzzer_seed () while
+ * subsetting real fonts.  The format is described in
+ * test/fuzzing/hb-repacker-fuzzer.cc. */
+static const char *default_graphs[] =
+{
+  "test/fuzzing/graphs/noto_nastaliq_urdu",
+  "test/fuzzing/graphs/clusterfuzz-testcase-minimized-hb-repacker-fuzzer-5196242811748352",
+};
+
+/* Subsets whose GSUB/GPOS overflow and have to be repacked. */
+static const char *default_subsets[] =
+{
+  "test/subset/data/repack_tests/basic.tests",
+  "test/subset/data/repack_tests/isolation.tests",
+  "test/subset/data/repack_tests/table_duplication.tests",
+};
+
+struct graph_input_t
+{
+  hb_tag_t tag = HB_TAG_NONE;
+  std::vector<char> data;
+  std::vector<char> scratch;
+  std::vector<hb_subset_serialize_object_t> objects;
+  std::vector<std::vector<hb_subset_serialize_link_t>> links;
+};
+
+template <typename T>
+static bool read_value (const char **data, const char *end, T *out)
+{
+  if (end - *data < (ptrdiff_t) sizeof (T)) return false;
+  memcpy (out, *data, sizeof (T));
+  *data += sizeof (T);
+  return true;
+}
+
+static bool load_graph (const char *path, graph_input_t &graph)
+{
+  FILE *f = fopen (path, "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t len;
+  while ((len = fread (buf, 1, sizeof (buf), f)))
+    graph.data.insert (graph.data.end (), buf, buf + len);
+  fclose (f);
+
+  /* The repacker may modify the objects in place, so they point into a
+   * scratch copy of the data that is restored before every run. */
+  graph.scratch = graph.data;
+  const char *start = graph.data.data ();
+  const char *p = start;
+  const char *end = start + graph.data.size ();
+
+  uint16_t num_objects;
+  if (!read_value (&p, end, &graph.tag) || !read_value (&p, end, &num_objects))
+    return false;
+
+  graph.objects.resize (num_objects);
+  graph.links.resize (num_objects);
+  for (auto &obj : graph.objects)
+  {
+    uint16_t size;
+    if (!read_value (&p, end, &size) || end - p < size) return false;
+    obj.head = graph.scratch.data () + (p - start);
+    obj.tail = obj.head + size;
+    p += size;
+  }
+
+  uint16_t num_links;
+  if (!read_value (&p, end, &num_links)) return false;
+  for (unsigned i = 0; i < num_links; i++)
+  {
+    struct
+    {
+      uint16_t parent;
+      uint16_t child;
+      uint16_t position;
+      uint8_t width;
+    } l;
+    if (!read_value (&p, end, &l) || l.parent >= num_objects)
+      return false;
+
+    hb_subset_serialize_link_t link;
+    link.width = l.width;
+    link.position = l.position;
+    link.objidx = l.child + 1; // Indices are shifted by one by the null object.
+    graph.links[l.parent].push_back (link);
+  }
+
+  for (unsigned i = 0; i < num_objects; i++)
+  {
+    graph.objects[i].num_real_links = graph.links[i].size ();
+    graph.objects[i].real_links = graph.links[i].data ();
+    graph.objects[i].num_virtual_links = 0;
+    graph.objects[i].virtual_links = nullptr;
+  }
+
+  return true;
+}
+
+static void BM_repack_graph (benchmark::State &state,
+			     const char *path)
+{
+  graph_input_t graph;
+  bool ret = load_graph (path, graph);
+  assert (ret);
+
+  for (auto _ : state)
+  {
+    memcpy (graph.scratch.data (), graph.data.data (), graph.data.size ());
+    hb_blob_t *blob = hb_subset_serialize_or_fail (graph.tag,
+						   graph.objects.data (),
+						   graph.objects.size ());
+    assert (blob);
+    hb_blob_destroy (blob);
+  }
+}
+
+static void BM_repack_subset (benchmark::State &state,
+			      const char *path)
+{
+  FILE *f = fopen (path, "r");
+  assert (f);
+
+  char line[256];
+  char *ret = fgets (line, sizeof (line), f);
+  assert (ret);
+  line[strcspn (line, "\r\n")] = '\0';
+
+  char font_path[512];
+  snprintf (font_path, sizeof (font_path), "test/subset/data/fonts/%s", line);
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (font_path, 0);
+  assert (face);
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  assert (input);
+  hb_set_t *unicodes = hb_subset_input_unicode_set (input);
+  while (fgets (line, sizeof (line), f))
+  {
+    unsigned u;
+    if (sscanf (line, "%x", &u) == 1)
+      hb_set_add (unicodes, u);
+  }
+  fclose (f);
+
+  for (auto _ : state)
+  {
+    hb_face_t *subset = hb_subset_or_fail (face, input);
+    assert (subset);
+    hb_face_destroy (subset);
+  }
+
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+static void test_repack (void (*bm) (benchmark::State &, const char *),
+			 const char *kind,
+			 const char *path)
+{
+  char name[1024] = "BM_repack/";
+  strcat (name, kind);
+  strcat (name, "/");
+  const char *p = strrchr (path, '/');
+  strcat (name, p ? p + 1 : path);
+
+  benchmark::RegisterBenchmark (name, bm, path)
+      ->Unit(benchmark::kMillisecond);
+}
+
+int main(int argc, char** argv)
+{
+  benchmark::Initialize(&argc, argv);
+
+  if (argc > 1)
+  {
+    for (int i = 1; i < argc; i++)
+      test_repack (BM_repack_graph, "graph", argv[i]);
+  }
+  else
+  {
+    for (auto path : default_graphs)
+      test_repack (BM_repack_graph, "graph", path);
+    for (auto path : default_subsets)
+      test_repack (BM_repack_subset, "subset", path);
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
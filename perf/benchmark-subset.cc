@@ -1,5 +1,10 @@
 #include "hb-benchmark.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 enum operation_t
 {
   subset_glyphs,
@@ -31,6 +36,23 @@ _roboto_flex_instance_opts[] =
   {HB_TAG ('Y', 'T', 'F', 'I'), 600.f},
 };
 
+/* Pins the parametric axes only, so gvar keeps wght, wdth and opsz
+ * and has deltas to IUP-optimize. */
+static const axis_location_t
+_roboto_flex_partial_instance_opts[] =
+{
+  {HB_TAG ('G', 'R', 'A', 'D'), -100.f},
+  {HB_TAG ('s', 'l', 'n', 't'), -3.f},
+  {HB_TAG ('X', 'T', 'R', 'A'), 500.f},
+  {HB_TAG ('X', 'O', 'P', 'Q'), 150.f},
+  {HB_TAG ('Y', 'O', 'P', 'Q'), 100.f},
+  {HB_TAG ('Y', 'T', 'L', 'C'), 480.f},
+  {HB_TAG ('Y', 'T', 'U', 'C'), 600.f},
+  {HB_TAG ('Y', 'T', 'A', 'S'), 800.f},
+  {HB_TAG ('Y', 'T', 'D', 'E'), -50.f},
+  {HB_TAG ('Y', 'T', 'F', 'I'), 600.f},
+};
+
 static const axis_location_t
 _mplus_instance_opts[] =
 {
@@ -76,6 +98,31 @@ struct test_input_t
 static test_input_t *tests = default_tests;
 static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
 
+/* Partial instances that keep glyph variations, for comparing instancing
+ * with and without HB_SUBSET_FLAGS_OPTIMIZE_IUP_DELTAS. */
+static test_input_t default_iup_tests[] =
+{
+  {SUBSET_FONT_BASE_PATH "RobotoFlex-Variable.ttf", 0, _roboto_flex_partial_instance_opts, ARRAY_LEN (_roboto_flex_partial_instance_opts)},
+  {SUBSET_FONT_BASE_PATH "Fraunces.ttf", 0, _fraunces_partial_instance_opts, ARRAY_LEN (_fraunces_partial_instance_opts)},
+};
+
+#ifndef HB_NO_SUBSET_DEPEND
+/* Dependency graph extraction is dominated by GSUB and by the number of
+ * glyphs, so exercise large CJK and color emoji fonts and complex-script
+ * fonts with long contextual lookup lists. */
+static test_input_t default_depend_tests[] =
+{
+  {SUBSET_FONT_BASE_PATH "Amiri-Regular.ttf", 0, nullptr, 0},
+  {SUBSET_FONT_BASE_PATH "NotoNastaliqUrdu-Regular.ttf", 0, nullptr, 0},
+  {SUBSET_FONT_BASE_PATH "Mplus1p-Regular.ttf", 0, nullptr, 0},
+  {SUBSET_FONT_BASE_PATH "SourceHanSans-Regular_subset.otf", 0, nullptr, 0},
+  {SUBSET_FONT_BASE_PATH "NotoColrEmojiGlyf-Regular.subset.ttf", 0, nullptr, 0},
+#if 0
+  {"perf/fonts/NotoSansCJKsc-VF.ttf", 0, nullptr, 0},
+#endif
+};
+#endif
+
 
 void AddCodepoints(const hb_set_t* codepoints_in_font,
                    unsigned subset_size,
@@ -205,6 +252,242 @@ static void BM_subset (benchmark::State &state,
   hb_face_destroy (face);
 }
 
+/* benchmark for planning and subsetting a sequence of related requests:
+ * several subsets of a common superset of max_subset_size codepoints.  With
+ * incremental set, the plan for the superset is created once up front and
+ * passed as the base for each request. */
+static void BM_subset_sequential (benchmark::State &state,
+                                  const test_input_t &test_input,
+                                  bool incremental)
+{
+  const unsigned num_requests = 8;
+  unsigned subset_size = state.range(0);
+
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (test_input.font_path, 0);
+  assert (face);
+  face = preprocess_face (face);
+
+  hb_set_t* all_codepoints = hb_set_create ();
+  hb_face_collect_unicodes (face, all_codepoints);
+
+  hb_subset_input_t* base_input = hb_subset_input_create_or_fail ();
+  assert (base_input);
+  AddCodepoints (all_codepoints, test_input.max_subset_size, base_input);
+  hb_set_destroy (all_codepoints);
+
+  const hb_set_t *superset = hb_subset_input_unicode_set (base_input);
+  unsigned superset_size = hb_set_get_population (superset);
+  unsigned size = subset_size < superset_size ? subset_size : superset_size;
+
+  hb_subset_input_t* inputs[num_requests];
+  for (unsigned i = 0; i < num_requests; i++)
+  {
+    inputs[i] = hb_subset_input_create_or_fail ();
+    assert (inputs[i]);
+    auto *unicodes = hb_subset_input_unicode_set (inputs[i]);
+    unsigned offset = (superset_size - size) * i / (num_requests - 1);
+    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+    for (unsigned j = 0; j < offset + size && hb_set_next (superset, &cp); j++)
+      if (j >= offset)
+        hb_set_add (unicodes, cp);
+  }
+
+  hb_subset_plan_t *base = nullptr;
+  if (incremental)
+  {
+    base = hb_subset_plan_create_or_fail (face, base_input);
+    assert (base);
+  }
+
+  for (auto _ : state)
+  {
+    for (unsigned i = 0; i < num_requests; i++)
+    {
+      hb_subset_plan_t *plan = hb_subset_plan_create_from_base_or_fail (face, inputs[i], base);
+      assert (plan);
+      hb_face_t* subset = hb_subset_plan_execute_or_fail (plan);
+      assert (subset);
+      hb_face_destroy (subset);
+      hb_subset_plan_destroy (plan);
+    }
+  }
+
+  hb_subset_plan_destroy (base);
+  for (unsigned i = 0; i < num_requests; i++)
+    hb_subset_input_destroy (inputs[i]);
+  hb_subset_input_destroy (base_input);
+  hb_face_destroy (face);
+}
+
+static void test_subset_sequential (bool incremental,
+                                    benchmark::TimeUnit time_unit,
+                                    const test_input_t &test_input)
+{
+  char name[1024] = "BM_subset_sequential/";
+  const char *p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+  if (incremental)
+    strcat (name, "/incremental");
+
+  benchmark::RegisterBenchmark (name, BM_subset_sequential, test_input, incremental)
+      ->Range(10, test_input.max_subset_size)
+      ->Unit(time_unit);
+}
+
+/* Runs the tasks on one worker thread per hardware thread. */
+static void thread_executor (hb_subset_task_func_t task,
+                             void *task_data,
+                             unsigned int count,
+                             void *user_data)
+{
+  std::atomic<unsigned> next {0};
+  auto worker = [&] ()
+  {
+    for (unsigned i; (i = next++) < count;)
+      task (task_data, i);
+  };
+
+  unsigned num_threads = std::min (count, std::max (std::thread::hardware_concurrency (), 1u));
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < num_threads; i++)
+    workers.push_back (std::thread (worker));
+  worker ();
+  for (auto &w : workers)
+    w.join ();
+}
+
+enum iup_mode_t
+{
+  iup_off,
+  iup_on,
+  iup_on_parallel,
+};
+
+/* benchmark for instancing all glyphs of a font, with or without IUP
+ * delta optimization; with parallel, glyph variations are instanced on
+ * all cores. */
+static void BM_instance (benchmark::State &state,
+                         const test_input_t &test_input,
+                         iup_mode_t mode)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (test_input.font_path, 0);
+  assert (face);
+  face = preprocess_face (face);
+
+  hb_subset_input_t* input = hb_subset_input_create_or_fail ();
+  assert (input);
+  hb_set_clear (hb_subset_input_unicode_set (input));
+  hb_set_invert (hb_subset_input_unicode_set (input));
+  hb_set_clear (hb_subset_input_glyph_set (input));
+  hb_set_invert (hb_subset_input_glyph_set (input));
+
+  if (mode != iup_off)
+    hb_subset_input_set_flags (input, hb_subset_input_get_flags (input) | HB_SUBSET_FLAGS_OPTIMIZE_IUP_DELTAS);
+
+  for (unsigned i = 0; i < test_input.num_instance_opts; i++)
+    hb_subset_input_pin_axis_location (input, face,
+                                       test_input.instance_opts[i].axis_tag,
+                                       test_input.instance_opts[i].axis_value);
+
+  for (auto _ : state)
+  {
+    hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+    assert (plan);
+    hb_face_t* subset = hb_subset_plan_execute_parallel_or_fail (plan,
+                                                                 mode == iup_on_parallel ? thread_executor : nullptr,
+                                                                 nullptr);
+    assert (subset);
+    hb_face_destroy (subset);
+    hb_subset_plan_destroy (plan);
+  }
+
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+static void test_instance (iup_mode_t mode,
+                           const char *mode_name,
+                           benchmark::TimeUnit time_unit,
+                           const test_input_t &test_input)
+{
+  char name[1024] = "BM_instance/";
+  strcat (name, mode_name);
+  strcat (name, "/");
+  const char *p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+
+  auto *benchmark = benchmark::RegisterBenchmark (name, BM_instance, test_input, mode)
+      ->Unit(time_unit);
+  if (mode == iup_on_parallel)
+    benchmark->UseRealTime ();
+}
+
+#ifndef HB_NO_SUBSET_DEPEND
+enum depend_mode_t
+{
+  depend_build,
+  depend_build_parallel,
+  depend_load,
+};
+
+/* benchmark for obtaining the glyph dependency graph of a font: either
+ * computing it from the face, serially or on all cores, or loading a
+ * previously serialized copy. */
+static void BM_depend (benchmark::State &state,
+                       const test_input_t &test_input,
+                       depend_mode_t mode)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (test_input.font_path, 0);
+  assert (face);
+
+  hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+  assert (depend);
+  hb_blob_t *blob = hb_subset_depend_serialize_or_fail (depend);
+  assert (blob);
+  hb_subset_depend_destroy (depend);
+
+  for (auto _ : state)
+  {
+    switch (mode)
+    {
+      case depend_build:
+	depend = hb_subset_depend_from_face_or_fail (face);
+	break;
+      case depend_build_parallel:
+	depend = hb_subset_depend_from_face_parallel_or_fail (face, thread_executor, nullptr);
+	break;
+      case depend_load:
+	depend = hb_subset_depend_from_blob_or_fail (blob);
+	break;
+    }
+    assert (depend);
+    hb_subset_depend_destroy (depend);
+  }
+
+  state.counters["blob_size"] = hb_blob_get_length (blob);
+
+  hb_blob_destroy (blob);
+  hb_face_destroy (face);
+}
+
+static void test_depend (depend_mode_t mode,
+                         const char *mode_name,
+                         benchmark::TimeUnit time_unit,
+                         const test_input_t &test_input)
+{
+  char name[1024] = "BM_depend/";
+  strcat (name, mode_name);
+  strcat (name, "/");
+  const char *p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+
+  auto *benchmark = benchmark::RegisterBenchmark (name, BM_depend, test_input, mode)
+      ->Unit(time_unit);
+  if (mode == depend_build_parallel)
+    benchmark->UseRealTime ();
+}
+#endif
+
 static void test_subset (operation_t op,
                          const char *op_name,
                          bool retain_gids,
@@ -268,6 +551,36 @@ int main(int argc, char** argv)
 
 #undef TEST_OPERATION
 
+  for (unsigned i = 0; i < num_tests; i++)
+  {
+    test_subset_sequential (false, benchmark::kMicrosecond, tests[i]);
+    test_subset_sequential (true, benchmark::kMicrosecond, tests[i]);
+  }
+
+  if (tests == default_tests)
+    for (unsigned i = 0; i < ARRAY_LEN (default_iup_tests); i++)
+    {
+      test_instance (iup_off, "no-iup", benchmark::kMillisecond, default_iup_tests[i]);
+      test_instance (iup_on, "iup", benchmark::kMillisecond, default_iup_tests[i]);
+      test_instance (iup_on_parallel, "iup-parallel", benchmark::kMillisecond, default_iup_tests[i]);
+    }
+
+#ifndef HB_NO_SUBSET_DEPEND
+  const test_input_t *depend_tests = tests;
+  unsigned num_depend_tests = num_tests;
+  if (tests == default_tests)
+  {
+    depend_tests = default_depend_tests;
+    num_depend_tests = ARRAY_LEN (default_depend_tests);
+  }
+  for (unsigned i = 0; i < num_depend_tests; i++)
+  {
+    test_depend (depend_build, "build", benchmark::kMicrosecond, depend_tests[i]);
+    test_depend (depend_build_parallel, "build-parallel", benchmark::kMicrosecond, depend_tests[i]);
+    test_depend (depend_load, "load", benchmark::kMicrosecond, depend_tests[i]);
+  }
+#endif
+
   benchmark::RunSpecifiedBenchmarks();
   benchmark::Shutdown();
 
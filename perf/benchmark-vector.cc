@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb-benchmark.hh"
+
+#include <hb-vector.h>
+
+#include <glib.h>
+
+#include <vector>
+
+struct test_input_t
+{
+  const char *font_path;
+  const char *text_path;
+} default_tests[] =
+{
+  {"perf/fonts/Roboto-Regular.ttf",
+   "perf/texts/en-thelittleprince.txt"},
+
+  {"perf/fonts/Amiri-Regular.ttf",
+   "perf/texts/fa-thelittleprince.txt"},
+};
+
+static test_input_t *tests = default_tests;
+static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
+
+enum output_mode_t
+{
+  MODE_GLYPH,	/* One document per glyph. */
+  MODE_BUFFER,	/* One document per line, via hb_vector_draw_buffer(). */
+};
+
+/* Shapes each line of the text into its own buffer. */
+static std::vector<hb_buffer_t *>
+shape_lines (hb_font_t *font, const char *text, unsigned text_length)
+{
+  std::vector<hb_buffer_t *> lines;
+  const char *end;
+  while ((end = (const char *) memchr (text, '\n', text_length)))
+  {
+    hb_buffer_t *buf = hb_buffer_create ();
+    hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+    hb_buffer_guess_segment_properties (buf);
+    hb_shape (font, buf, nullptr, 0);
+    lines.push_back (buf);
+
+    unsigned skip = end - text + 1;
+    text_length -= skip;
+    text += skip;
+  }
+  return lines;
+}
+
+static void BM_Vector (benchmark::State &state,
+		       hb_vector_format_t format,
+		       output_mode_t mode,
+		       const test_input_t &input)
+{
+  hb_font_t *font;
+  {
+    hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+    assert (face);
+    font = hb_font_create (face);
+    hb_face_destroy (face);
+  }
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+
+  std::vector<hb_buffer_t *> lines = shape_lines (font, text, text_length);
+  unsigned num_glyphs = 0;
+  for (hb_buffer_t *buf : lines)
+    num_glyphs += hb_buffer_get_length (buf);
+
+  hb_vector_draw_t *draw = hb_vector_draw_create_or_fail (format);
+  assert (draw);
+
+  size_t bytes = 0;
+  for (auto _ : state)
+    for (hb_buffer_t *buf : lines)
+    {
+      if (mode == MODE_BUFFER)
+      {
+	hb_vector_draw_buffer (draw, font, buf, HB_VECTOR_EXTENTS_MODE_EXPAND);
+	hb_blob_t *blob = hb_vector_draw_render (draw);
+	if (blob)
+	  bytes += hb_blob_get_length (blob);
+	hb_vector_draw_recycle_blob (draw, blob);
+	continue;
+      }
+
+      unsigned count;
+      const hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buf, &count);
+      const hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buf, nullptr);
+      hb_position_t x = 0, y = 0;
+      for (unsigned i = 0; i < count; i++)
+      {
+	hb_vector_draw_set_transform (draw, 1, 0, 0, 1,
+				      x + pos[i].x_offset, y + pos[i].y_offset);
+	hb_vector_draw_glyph (draw, font, info[i].codepoint, HB_VECTOR_EXTENTS_MODE_EXPAND);
+	hb_blob_t *blob = hb_vector_draw_render (draw);
+	if (blob)
+	  bytes += hb_blob_get_length (blob);
+	hb_vector_draw_recycle_blob (draw, blob);
+	x += pos[i].x_advance;
+	y += pos[i].y_advance;
+      }
+    }
+
+  state.SetItemsProcessed (state.iterations () * num_glyphs);
+  state.counters["bytes/glyph"] = num_glyphs && state.iterations ()
+				? (double) bytes / (state.iterations () * num_glyphs)
+				: 0.;
+
+  hb_vector_draw_destroy (draw);
+  for (hb_buffer_t *buf : lines)
+    hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+/* Serializes every glyph of the font to SVG path data; dominated by
+ * number formatting.  High precision exercises the shortest
+ * round-trip form. */
+static void BM_VectorFont (benchmark::State &state,
+			   unsigned precision,
+			   const char *font_path)
+{
+  hb_font_t *font;
+  {
+    hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (font_path, 0);
+    assert (face);
+    font = hb_font_create (face);
+    hb_face_destroy (face);
+  }
+  unsigned num_glyphs = hb_face_get_glyph_count (hb_font_get_face (font));
+
+  hb_vector_draw_t *draw = hb_vector_draw_create_or_fail (HB_VECTOR_FORMAT_SVG);
+  assert (draw);
+  hb_vector_draw_set_precision (draw, precision);
+
+  size_t bytes = 0;
+  for (auto _ : state)
+    for (unsigned gid = 0; gid < num_glyphs; gid++)
+    {
+      hb_vector_draw_glyph (draw, font, gid, HB_VECTOR_EXTENTS_MODE_EXPAND);
+      hb_blob_t *blob = hb_vector_draw_render (draw);
+      if (blob)
+	bytes += hb_blob_get_length (blob);
+      hb_vector_draw_recycle_blob (draw, blob);
+    }
+
+  state.SetItemsProcessed (state.iterations () * num_glyphs);
+  state.counters["bytes/glyph"] = num_glyphs && state.iterations ()
+				? (double) bytes / (state.iterations () * num_glyphs)
+				: 0.;
+
+  hb_vector_draw_destroy (draw);
+  hb_font_destroy (font);
+}
+
+static void test_vector (hb_vector_format_t format,
+			 output_mode_t mode,
+			 const test_input_t &test_input)
+{
+  char name[1024] = "BM_Vector";
+  const char *p;
+  strcat (name, "/");
+  p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+  strcat (name, "/");
+  p = strrchr (test_input.text_path, '/');
+  strcat (name, p ? p + 1 : test_input.text_path);
+  strcat (name, format == HB_VECTOR_FORMAT_PDF ? "/pdf" : "/svg");
+  strcat (name, mode == MODE_BUFFER ? "/buffer" : "/glyph");
+
+  benchmark::RegisterBenchmark (name, BM_Vector, format, mode, test_input)
+   ->Unit(benchmark::kMillisecond);
+}
+
+static void test_vector_font (unsigned precision,
+			      const char *font_path)
+{
+  char name[1024] = "BM_VectorFont";
+  const char *p;
+  strcat (name, "/");
+  p = strrchr (font_path, '/');
+  strcat (name, p ? p + 1 : font_path);
+  snprintf (name + strlen (name), sizeof (name) - strlen (name), "/precision:%u", precision);
+
+  benchmark::RegisterBenchmark (name, BM_VectorFont, precision, font_path)
+   ->Unit(benchmark::kMillisecond);
+}
+
+static const char *font_file = nullptr;
+static const char *text_file = nullptr;
+
+static GOptionEntry entries[] =
+{
+  {"font-file", 0, 0, G_OPTION_ARG_STRING, &font_file, "Font file-path to benchmark", "FONTFILE"},
+  {"text-file", 0, 0, G_OPTION_ARG_STRING, &text_file, "Text file-path to benchmark", "TEXTFILE"},
+  {nullptr}
+};
+
+int main (int argc, char **argv)
+{
+  benchmark::Initialize (&argc, argv);
+
+  GOptionContext *context = g_option_context_new ("");
+  g_option_context_set_summary (context, "Benchmark vector output of shaped text, per glyph and per buffer");
+  g_option_context_add_main_entries (context, entries, nullptr);
+  g_option_context_parse (context, &argc, &argv, nullptr);
+  g_option_context_free (context);
+
+  argc--;
+  argv++;
+  if (!font_file && argc)
+  {
+    font_file = *argv;
+    argv++;
+    argc--;
+  }
+  if (!text_file && argc)
+  {
+    text_file = *argv;
+    argv++;
+    argc--;
+  }
+  if (font_file || text_file)
+  {
+    if (!font_file || !text_file)
+    {
+      g_printerr ("Both a font file and a text file are needed.\n");
+      return 1;
+    }
+    static test_input_t static_test = {};
+    static_test.font_path = font_file;
+    static_test.text_path = text_file;
+    tests = &static_test;
+    num_tests = 1;
+  }
+
+  for (unsigned i = 0; i < num_tests; i++)
+    for (hb_vector_format_t format : {HB_VECTOR_FORMAT_SVG, HB_VECTOR_FORMAT_PDF})
+      for (output_mode_t mode : {MODE_GLYPH, MODE_BUFFER})
+	test_vector (format, mode, tests[i]);
+  for (unsigned i = 0; i < num_tests; i++)
+    for (unsigned precision : {2u, 12u})
+      test_vector_font (precision, tests[i].font_path);
+
+  benchmark::RunSpecifiedBenchmarks ();
+  benchmark::Shutdown ();
+}
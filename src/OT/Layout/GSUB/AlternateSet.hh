@@ -29,6 +29,13 @@ struct AlternateSet
   void closure (hb_closure_context_t *c) const
   { c->output->add_array (alternates.arrayZ, alternates.len); }
 
+  void closure_relation (hb_closure_relation_context_t *c, hb_codepoint_t source) const
+  {
+    + hb_iter (alternates)
+    | hb_apply ([&] (const hb_codepoint_t &target) { c->add (source, target); })
+    ;
+  }
+
   void depend (hb_depend_context_t *c, hb_codepoint_t source) const
   {
     + hb_iter (alternates)
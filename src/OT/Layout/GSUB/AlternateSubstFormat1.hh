@@ -57,6 +57,15 @@ struct AlternateSubstFormat1_2
     ;
   }
 
+  void closure_relation (hb_closure_relation_context_t *c) const
+  {
+    + hb_zip (this+coverage, alternateSet)
+    | hb_apply ([&] (const hb_pair_t<hb_codepoint_t, const typename Types::template OffsetTo<AlternateSet<Types>> &> &_) {
+        (this+_.second).closure_relation (c, _.first);
+      })
+    ;
+  }
+
   void closure_lookups (hb_closure_lookups_context_t *c) const {}
 
   void collect_glyphs (hb_collect_glyphs_context_t *c) const
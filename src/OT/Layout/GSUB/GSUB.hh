@@ -54,6 +54,26 @@ struct GSUB : GSUBGPOS
 struct GSUB_accelerator_t : Layout::GSUB::accelerator_t {
   GSUB_accelerator_t (hb_face_t *face) : Layout::GSUB::accelerator_t (face) {}
   HB_INTERNAL void depend (hb_depend_data_builder_t *builder, hb_face_t *face) const;
+  /* The two halves of depend(), for building in parallel: collect the
+   * features of every lookup into @builder, then walk a range of lookups
+   * into a builder that has those features. */
+  HB_INTERNAL bool depend_lookup_features (hb_depend_data_builder_t *builder, hb_face_t *face) const;
+  HB_INTERNAL void depend_lookups (hb_depend_data_builder_t *builder, hb_face_t *face,
+				   unsigned start, unsigned end) const;
+};
+
+/* Closure relations of the non-contextual GSUB lookups of a face, for
+ * computing many glyph closures against the same face. */
+struct GSUB_closure_cache_t
+{
+  HB_INTERNAL GSUB_closure_cache_t (hb_face_t *face);
+
+  /* Same as hb_ot_layout_lookups_substitute_closure(). */
+  HB_INTERNAL void closure (hb_face_t      *face,
+			    const hb_set_t *lookups,
+			    hb_set_t       *glyphs /* IN/OUT */) const;
+
+  hb_vector_t<hb_closure_relation_t> relations;
 };
 
 
@@ -38,6 +38,9 @@ struct Ligature
     c->output->add (ligGlyph);
   }
 
+  void closure_relation (hb_closure_relation_context_t *c, hb_codepoint_t first) const
+  { c->add_ligature (first, ligGlyph, component); }
+
   void depend (hb_depend_context_t *c, hb_codepoint_t first) const
   {
     // Build the complete ligature set upfront before adding any edges
@@ -68,8 +71,7 @@ struct Ligature
     ;
 
     // If no edges were added, a newly allocated set is unused - free it for reuse
-    if (!any_added && ligset_created)
-      c->depend_data->discard_set (ligset_idx);
+    c->depend_data->finish_set (ligset_idx, ligset_created, any_added);
   }
 
   void collect_glyphs (hb_collect_glyphs_context_t *c) const
@@ -54,6 +54,14 @@ struct LigatureSet
     ;
   }
 
+  void closure_relation (hb_closure_relation_context_t *c, hb_codepoint_t first) const
+  {
+    + hb_iter (ligature)
+    | hb_map (hb_add (this))
+    | hb_apply ([&] (const Ligature<Types> &_) { _.closure_relation (c, first); })
+    ;
+  }
+
   void depend (hb_depend_context_t *c, hb_codepoint_t first) const
   {
     + hb_iter (ligature)
@@ -28,6 +28,13 @@ struct Sequence
   void closure (hb_closure_context_t *c) const
   { c->output->add_array (substitute.arrayZ, substitute.len); }
 
+  void closure_relation (hb_closure_relation_context_t *c, hb_codepoint_t source) const
+  {
+    + hb_iter (substitute)
+    | hb_apply ([&] (const hb_codepoint_t &target) { c->add (source, target); })
+    ;
+  }
+
   void depend (hb_depend_context_t *c, hb_codepoint_t source) const
   {
     + hb_iter (substitute)
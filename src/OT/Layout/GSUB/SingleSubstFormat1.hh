@@ -93,6 +93,37 @@ struct SingleSubstFormat1_3
     ;
   }
 
+  void closure_relation (hb_closure_relation_context_t *c) const
+  {
+    hb_codepoint_t d = deltaGlyphID;
+    hb_codepoint_t mask = get_mask ();
+
+    /* Mirror the guards in closure().  The overlapping-range one depends
+     * on the glyph set; it can only trigger if some covered glyph maps into
+     * the coverage range, in which case leave the lookup to closure(). */
+    auto &cov = this+coverage;
+    if (cov.get_population () >= mask)
+      return;
+
+    hb_codepoint_t min = HB_SET_VALUE_INVALID, max = 0;
+    for (hb_codepoint_t g : cov.iter ())
+    {
+      min = hb_min (min, g);
+      max = hb_max (max, g);
+    }
+
+    for (hb_codepoint_t g : cov.iter ())
+    {
+      hb_codepoint_t substitute = (g + d) & mask;
+      if (min <= substitute && substitute <= max)
+      {
+	c->set_uncacheable ();
+	return;
+      }
+      c->add (g, substitute);
+    }
+  }
+
   void closure_lookups (hb_closure_lookups_context_t *c) const {}
 
   void collect_glyphs (hb_collect_glyphs_context_t *c) const
@@ -84,6 +84,13 @@ struct SingleSubstFormat2_4
     ;
   }
 
+  void closure_relation (hb_closure_relation_context_t *c) const
+  {
+    + hb_zip (this+coverage, substitute)
+    | hb_apply ([c] (const hb_pair_t<hb_codepoint_t, hb_codepoint_t> &_) { c->add (_.first, _.second); })
+    ;
+  }
+
   void closure_lookups (hb_closure_lookups_context_t *c) const {}
 
   void collect_glyphs (hb_collect_glyphs_context_t *c) const
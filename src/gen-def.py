@@ -27,8 +27,11 @@ hb_subset_cff_get_charstrings_index
 hb_subset_cff2_get_charstring_data
 hb_subset_cff2_get_charstrings_index
 hb_subset_depend_from_face_or_fail
+hb_subset_depend_from_face_parallel_or_fail
 hb_subset_depend_lookup_glyph
 hb_subset_depend_lookup_set
+hb_subset_depend_serialize_or_fail
+hb_subset_depend_from_blob_or_fail
 hb_subset_depend_destroy
 """.splitlines ()
 	symbols = [x for x in symbols if x not in experimental_symbols]
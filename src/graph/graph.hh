@@ -31,8 +31,77 @@
 #ifndef GRAPH_GRAPH_HH
 #define GRAPH_GRAPH_HH
 
+#if HB_DEBUG_SUBSET_REPACK
+#include <chrono>
+#endif
+
 namespace graph {
 
+/*
+ * Counts of the work done while resolving overflows on a graph.
+ *
+ * The phase times are only collected when HB_DEBUG_SUBSET_REPACK is
+ * enabled, so that release builds don't pull in a clock.
+ */
+struct repack_stats_t
+{
+  unsigned rounds = 0;
+  unsigned iterations = 0;
+  unsigned isolations = 0;
+  unsigned duplications = 0;
+  unsigned priority_raises = 0;
+  unsigned subtable_splits = 0;
+  unsigned extension_promotions = 0;
+  unsigned sorts = 0;
+  unsigned full_distance_updates = 0;
+  unsigned incremental_distance_updates = 0;
+
+  double presplit_ms = 0;
+  double sort_ms = 0;
+  double distance_ms = 0;
+  double overflow_check_ms = 0;
+  double resolution_ms = 0;
+
+  void print () const
+  {
+    if (!DEBUG_ENABLED(SUBSET_REPACK)) return;
+
+    DEBUG_MSG (SUBSET_REPACK, nullptr,
+               "Repacker stats: %u rounds, %u iterations, %u isolations, %u duplications, "
+               "%u priority raises, %u subtable splits, %u extension promotions.",
+               rounds, iterations, isolations, duplications,
+               priority_raises, subtable_splits, extension_promotions);
+    DEBUG_MSG (SUBSET_REPACK, nullptr,
+               "Repacker stats: %u sorts, %u full and %u incremental distance updates.",
+               sorts, full_distance_updates, incremental_distance_updates);
+    DEBUG_MSG (SUBSET_REPACK, nullptr,
+               "Repacker stats: presplit %.3fms, sort %.3fms (distances %.3fms), "
+               "overflow check %.3fms, resolution %.3fms.",
+               presplit_ms, sort_ms, distance_ms, overflow_check_ms, resolution_ms);
+  }
+};
+
+/*
+ * Adds the time spent in the enclosing scope to one of the
+ * repack_stats_t phase times.
+ */
+struct repack_phase_timer_t
+{
+#if HB_DEBUG_SUBSET_REPACK
+  repack_phase_timer_t (double &ms_)
+    : ms (ms_), start (std::chrono::steady_clock::now ()) {}
+  ~repack_phase_timer_t ()
+  {
+    ms += std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+  }
+
+  double &ms;
+  std::chrono::steady_clock::time_point start;
+#else
+  repack_phase_timer_t (double &ms HB_UNUSED) {}
+#endif
+};
+
 /**
  * Represents a serialized table in the form of a graph.
  * Provides methods for modifying and reordering the graph.
@@ -630,14 +699,21 @@ struct graph_t
       return;
     }
 
+    stats.sorts++;
+    repack_phase_timer_t timer (stats.sort_ms);
+
     update_distances ();
 
-    hb_priority_queue_t<int64_t> queue;
+    // The queue and edge counts are kept across sorts, the repacker sorts
+    // once per iteration and this saves reallocating them each time.
+    auto& queue = queue_scratch_;
+    queue.reset ();
     queue.alloc (vertices_.length);
     hb_vector_t<unsigned> &new_ordering = ordering_scratch_;
     if (unlikely (!check_success (new_ordering.resize (vertices_.length)))) return;
 
-    hb_vector_t<unsigned> removed_edges;
+    hb_vector_t<unsigned> &removed_edges = removed_edges_scratch_;
+    removed_edges.resize (0);
     if (unlikely (!check_success (removed_edges.resize (vertices_.length)))) return;
     update_parents ();
 
@@ -1340,6 +1416,7 @@ struct graph_t
 
     DEBUG_MSG (SUBSET_REPACK, nullptr, "  Duplicating %u, ..., %u => %u", first_parent, last_parent, child_idx);
 
+    bool distances_valid = !distance_invalid;
     unsigned clone_idx = duplicate (child_idx);
     if (clone_idx == (unsigned) -1) return false;
 
@@ -1359,6 +1436,16 @@ struct graph_t
       }
     }
 
+    if (distances_valid)
+    {
+      // Only links into child and the clone were changed, so only their
+      // subgraphs can have moved. Leave the rest of the distances in place,
+      // update_distances () will recompute just those subgraphs.
+      distance_update_roots_.push (child_idx);
+      distance_update_roots_.push (clone_idx);
+      distance_invalid = distance_update_roots_.in_error ();
+    }
+
     return clone_idx;
   }
 
@@ -1681,7 +1768,13 @@ struct graph_t
    */
   void update_distances ()
   {
-    if (!distance_invalid) return;
+    if (!distance_invalid &&
+        (!distance_update_roots_ || update_distances_below_roots ()))
+      return;
+
+    repack_phase_timer_t timer (stats.distance_ms);
+    stats.full_distance_updates++;
+    distance_update_roots_.reset ();
 
     // Uses Dijkstra's algorithm to find all of the shortest distances.
     // https://en.wikipedia.org/wiki/Dijkstra%27s_algorithm
@@ -1698,7 +1791,8 @@ struct graph_t
       vertices_.arrayZ[i].distance = hb_int_max (int64_t);
     vertices_[root_idx ()].distance = 0;
 
-    hb_priority_queue_t<int64_t> queue;
+    auto& queue = queue_scratch_;
+    queue.reset ();
     queue.alloc (count);
     queue.insert (0, root_idx ());
 
@@ -1718,11 +1812,7 @@ struct graph_t
         if (visited[link.objidx]) continue;
 
         auto& child_v = vertices_.arrayZ[link.objidx];
-        const auto& child = child_v.obj;
-        unsigned link_width = link.width ? link.width : 4; // treat virtual offsets as 32 bits wide
-        int64_t child_weight = (child.tail - child.head) +
-                               ((int64_t) 1 << (link_width * 8)) * (child_v.space + 1);
-        int64_t child_distance = next_distance + child_weight;
+        int64_t child_distance = next_distance + link_weight (link);
 
         if (child_distance < child_v.distance)
         {
@@ -1743,6 +1833,120 @@ struct graph_t
   }
 
  private:
+  /*
+   * Returns the weight of link for the shortest distance computation.
+   */
+  int64_t link_weight (const hb_serialize_context_t::object_t::link_t& link) const
+  {
+    const auto& child_v = vertices_.arrayZ[link.objidx];
+    const auto& child = child_v.obj;
+    unsigned link_width = link.width ? link.width : 4; // treat virtual offsets as 32 bits wide
+    return (child.tail - child.head) +
+           ((int64_t) 1 << (link_width * 8)) * (child_v.space + 1);
+  }
+
+  /*
+   * Recomputes the distances of the nodes reachable from distance_update_roots_,
+   * these are the only nodes whose shortest path may have gone through a changed
+   * link. Every other node keeps its distance and those are used to seed a
+   * Dijkstra search limited to the changed subgraph. This produces exactly the
+   * same distances as a full update.
+   *
+   * Returns false if a full update is needed instead.
+   */
+  bool update_distances_below_roots ()
+  {
+    repack_phase_timer_t timer (stats.distance_ms);
+    update_parents ();
+
+    hb_set_t affected;
+    // For performance we want to avoid allocating extra memory. So use the ordering_scratch_
+    // buffer to implement a stack for DFS.
+    auto& stack = ordering_scratch_;
+    stack.reset ();
+    for (unsigned root : distance_update_roots_)
+      stack.push (root);
+    distance_update_roots_.reset ();
+
+    unsigned root = root_idx ();
+    bool found_root = false;
+    while (stack && !found_root)
+    {
+      unsigned next_idx = stack.pop ();
+      if (affected.has (next_idx)) continue;
+      found_root = next_idx == root;
+      affected.add (next_idx);
+      for (const auto& link : vertices_.arrayZ[next_idx].obj.all_links ())
+        if (!affected.has (link.objidx))
+          stack.push (link.objidx);
+    }
+    if (found_root || stack.in_error () || affected.in_error ())
+    {
+      // The root is in a cycle or we ran out of memory.
+      distance_invalid = true;
+      return false;
+    }
+
+    auto& queue = queue_scratch_;
+    queue.reset ();
+
+    for (unsigned i : affected)
+      vertices_.arrayZ[i].distance = hb_int_max (int64_t);
+
+    for (unsigned i : affected)
+    {
+      auto& v = vertices_.arrayZ[i];
+      for (unsigned p : v.parents_iter ())
+      {
+        if (affected.has (p)) continue;
+        const auto& parent = vertices_.arrayZ[p];
+        for (const auto& link : parent.obj.all_links ())
+        {
+          if (link.objidx != i) continue;
+          v.distance = hb_min (v.distance, parent.distance + link_weight (link));
+        }
+      }
+      if (v.distance != hb_int_max (int64_t))
+        queue.insert (v.distance, i);
+    }
+
+    unsigned remaining = affected.get_population ();
+    while (!queue.in_error () && !queue.is_empty ())
+    {
+      auto item = queue.pop_minimum ();
+      unsigned next_idx = item.second;
+      const auto& next = vertices_.arrayZ[next_idx];
+      if (item.first != next.distance || !affected.has (next_idx)) continue;
+      // Mark as visited by removing it from the set of nodes left to settle.
+      affected.del (next_idx);
+      remaining--;
+
+      for (const auto& link : next.obj.all_links ())
+      {
+        if (!affected.has (link.objidx)) continue;
+
+        auto& child_v = vertices_.arrayZ[link.objidx];
+        int64_t child_distance = next.distance + link_weight (link);
+        if (child_distance < child_v.distance)
+        {
+          child_v.distance = child_distance;
+          queue.insert (child_distance, link.objidx);
+        }
+      }
+    }
+
+    if (queue.in_error () || affected.in_error () || remaining)
+    {
+      // Out of memory or some of the subgraph became unreachable, let the full update
+      // handle (and report) it.
+      distance_invalid = true;
+      return false;
+    }
+
+    stats.incremental_distance_updates++;
+    return true;
+  }
+
   /*
    * Updates a link in the graph to point to a different object. Corrects the
    * parents vector on the previous and new child nodes.
@@ -1860,6 +2064,9 @@ struct graph_t
   hb_vector_t<unsigned> ordering_;
   hb_vector_t<unsigned> ordering_scratch_;
 
+  // Counts of the work done on this graph by the repacker.
+  repack_stats_t stats;
+
  private:
   bool parents_invalid;
   bool distance_invalid;
@@ -1867,6 +2074,12 @@ struct graph_t
   bool successful;
   hb_vector_t<unsigned> num_roots_for_space_;
   hb_vector_t<char*> buffers;
+
+  // Roots of the subgraphs whose distances need updating, see
+  // update_distances_below_roots ().
+  hb_vector_t<unsigned> distance_update_roots_;
+  hb_priority_queue_t<int64_t> queue_scratch_;
+  hb_vector_t<unsigned> removed_edges_scratch_;
 };
 
 }
@@ -124,7 +124,9 @@
 #endif
 
 #ifdef HB_HAS_GPU
+#include "hb-gpu-atlas.cc"
 #include "hb-gpu-draw.cc"
+#include "hb-gpu-glyphs.cc"
 #include "hb-gpu-paint.cc"
 #include "hb-gpu.cc"
 #include "hb-static.cc"
@@ -173,10 +175,12 @@
 #ifdef HB_HAS_VECTOR
 #include "hb-static.cc"
 #include "hb-vector-draw.cc"
+#include "hb-vector-num.cc"
 #include "hb-vector-paint-pdf.cc"
 #include "hb-vector-paint-svg.cc"
 #include "hb-vector-paint.cc"
 #include "hb-vector-path.cc"
+#include "hb-vector-pdf.cc"
 #include "hb-vector.cc"
 #include "hb-zlib.cc"
 #endif
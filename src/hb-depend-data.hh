@@ -265,6 +265,51 @@ struct hb_depend_data_t
   }
 };
 
+/**
+ * hb_depend_data_log_t:
+ *
+ * Ordered record of the changes a builder made to its hb_depend_data_t:
+ * edges added, sets created, and ligature sets finished (which discards
+ * them if unused). The parallel builder runs each task on a private
+ * builder that keeps such a log, then replays the logs into the final
+ * builder in task order with hb_depend_data_builder_t::replay(). This
+ * reproduces exactly what a single builder walking the same tables in
+ * the same order would have produced: set numbering, edge order and all.
+ */
+struct hb_depend_data_log_t
+{
+  enum op_type_t
+  {
+    EDGE,		/* index: into edges. */
+    SET_CREATED,	/* index: set index; snapshot: into snapshots or -1. */
+    SET_FINISHED,	/* index: set index of a set created since. */
+  };
+
+  struct op_t
+  {
+    op_type_t type;
+    unsigned index;
+    unsigned snapshot;
+  };
+
+  struct edge_t
+  {
+    hb_codepoint_t source;
+    hb_depend_edge_t record;
+  };
+
+  bool log (op_type_t type, unsigned index)
+  { return ops.push_or_fail (op_t {type, index, (unsigned) -1}); }
+
+  hb_vector_t<op_t> ops;
+  hb_vector_t<edge_t> edges;
+  /* Contents of sets that were discarded, and whose index may have been
+   * reused since, as of their creation. */
+  hb_vector_t<hb_set_t> snapshots;
+  /* Per set index, the op that last created it. */
+  hb_vector_t<unsigned> created_ops;
+};
+
 /**
  * hb_depend_data_builder_t:
  *
@@ -280,6 +325,7 @@ struct hb_depend_data_t
  * - free_set_list: Indices of freed sets available for reuse
  * - current_context_set_index: Context requirements for current rule
  * - current_edge_flags: Flags to apply to edges being recorded
+ * - log: If set, receives every change made to data (see hb_depend_data_log_t)
  */
 struct hb_depend_data_builder_t
 {
@@ -301,6 +347,18 @@ struct hb_depend_data_builder_t
                  set_index, data.sets.length - 1);
       return;
     }
+    if (log && set_index < log->created_ops.length)
+    {
+      /* The index will be reused; keep the contents for replay. */
+      unsigned snapshot = log->snapshots.length;
+      if (unlikely (!log->snapshots.push_or_fail (*data.sets[set_index]) ||
+		    log->snapshots.tail ().in_error ()))
+      {
+	fail ();
+	return;
+      }
+      log->ops[log->created_ops[set_index]].snapshot = snapshot;
+    }
     set_to_index.del (data.sets[set_index].get ());
     data.sets[set_index]->clear ();
     check_success (free_set_list.push_or_fail (set_index));
@@ -352,10 +410,34 @@ struct hb_depend_data_builder_t
 
     if (unlikely (!set_to_index.set (data.sets[new_idx].get (), new_idx)))
       return fail_invalid ();
+    if (log)
+    {
+      if (unlikely (new_idx >= log->created_ops.length &&
+		    !log->created_ops.resize (new_idx + 1)))
+	return fail_invalid ();
+      log->created_ops[new_idx] = log->ops.length;
+      if (unlikely (!log->log (hb_depend_data_log_t::SET_CREATED, new_idx)))
+	return fail_invalid ();
+    }
     if (created) *created = true;
     return new_idx;
   }
 
+  /* Called once all edges referencing a set returned by find_or_create_set()
+   * have been added; a set that was created for them but ended up unused
+   * is discarded. */
+  void finish_set (hb_codepoint_t set_index, bool created, bool used)
+  {
+    if (!created) return;
+    if (log && unlikely (!log->log (hb_depend_data_log_t::SET_FINISHED, set_index)))
+    {
+      fail ();
+      return;
+    }
+    if (!used)
+      discard_set (set_index);
+  }
+
   hb_codepoint_t find_or_create_context_set (const hb_set_t &set)
   { return find_or_create_set (set); }
 
@@ -536,6 +618,94 @@ struct hb_depend_data_builder_t
 
     edge_slots[slot] = encode_edge_ref (source, index);
     edge_population++;
+
+    if (log)
+    {
+      if (unlikely (!log->log (hb_depend_data_log_t::EDGE, log->edges.length) ||
+		    !log->edges.push_or_fail (hb_depend_data_log_t::edge_t {source, record})))
+	return fail ();
+    }
+    return true;
+  }
+
+  /* Replays the log of a builder that built into @other_data, as if the
+   * edges and sets had been added to this builder directly.  Set indices
+   * in edges and in context sets are renumbered along the way. */
+  bool replay (const hb_depend_data_t &other_data, const hb_depend_data_log_t &other_log)
+  {
+    if (unlikely (!successful)) return false;
+
+    /* Per set index of other_data: its index here, and edge_population
+     * at its creation here, or -1 if it already existed. */
+    hb_vector_t<hb_codepoint_t> set_map;
+    hb_vector_t<unsigned> created_at;
+    if (unlikely (!set_map.resize (other_data.sets.length) ||
+		  !created_at.resize (other_data.sets.length)))
+      return fail ();
+
+    hb_set_t set;
+    for (const hb_depend_data_log_t::op_t &op : other_log.ops)
+    {
+      switch (op.type)
+      {
+      case hb_depend_data_log_t::EDGE:
+      {
+	const hb_depend_data_log_t::edge_t &edge = other_log.edges[op.index];
+	hb_depend_edge_t record = edge.record;
+	if (record.ligature_set != HB_CODEPOINT_INVALID)
+	  record.ligature_set = set_map[record.ligature_set];
+	if (record.context_set != HB_CODEPOINT_INVALID)
+	  record.context_set = set_map[record.context_set];
+	add_edge (edge.source, record);
+	break;
+      }
+
+      case hb_depend_data_log_t::SET_CREATED:
+      {
+	const hb_set_t *other = op.snapshot != (unsigned) -1
+			      ? &other_log.snapshots[op.snapshot]
+			      : other_data.sets[op.index].get ();
+	if (other->get_max () >= HB_DEPEND_CONTEXT_SET_FLAG &&
+	    other->get_max () != HB_SET_VALUE_INVALID)
+	{
+	  /* Renumber the references to other sets. */
+	  set.clear ();
+	  hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+	  while (other->next_range (&first, &last))
+	  {
+	    if (last < HB_DEPEND_CONTEXT_SET_FLAG)
+	    {
+	      set.add_range (first, last);
+	      continue;
+	    }
+	    for (hb_codepoint_t g = first; g <= last; g++)
+	      set.add (g < HB_DEPEND_CONTEXT_SET_FLAG ? g
+		       : HB_DEPEND_CONTEXT_SET_FLAG | set_map[g & ~HB_DEPEND_CONTEXT_SET_FLAG]);
+	  }
+	  if (unlikely (set.in_error ()))
+	    return fail ();
+	  other = &set;
+	}
+
+	bool created = false;
+	hb_codepoint_t index = find_or_create_set (*other, &created);
+	if (unlikely (index == HB_CODEPOINT_INVALID))
+	  return false;
+	set_map[op.index] = index;
+	created_at[op.index] = created ? edge_population : (unsigned) -1;
+	break;
+      }
+
+      case hb_depend_data_log_t::SET_FINISHED:
+	if (created_at[op.index] != (unsigned) -1)
+	  finish_set (set_map[op.index], true,
+		      edge_population != created_at[op.index]);
+	break;
+      }
+
+      if (unlikely (!successful))
+	return false;
+    }
     return true;
   }
 
@@ -617,6 +787,14 @@ struct hb_depend_data_builder_t
     return true;
   }
 
+  bool copy_lookup_features (const hb_depend_data_builder_t &o)
+  {
+    lookup_features = o.lookup_features;
+    lookup_feature_offsets = o.lookup_feature_offsets;
+    return check_success (!lookup_features.in_error () &&
+			  !lookup_feature_offsets.in_error ());
+  }
+
   hb_array_t<const uint64_t> get_lookup_features (hb_codepoint_t lookup_index) const
   {
     if (unlikely (!lookup_feature_offsets.length ||
@@ -642,6 +820,7 @@ struct hb_depend_data_builder_t
   { return hb_map_get (&nominal_glyphs, cp); }
 
   HB_INTERNAL bool compile (hb_face_t *face);
+  HB_INTERNAL void compile_table (hb_face_t *face, hb_tag_t table_tag);
 
   bool fail () { successful = false; return false; }
   hb_codepoint_t fail_invalid () { fail (); return HB_CODEPOINT_INVALID; }
@@ -660,6 +839,7 @@ struct hb_depend_data_builder_t
   hb_vector_t<hb_codepoint_t> free_set_list;
   hb_codepoint_t current_context_set_index;
   hb_subset_depend_edge_flags_t current_edge_flags;
+  hb_depend_data_log_t *log = nullptr;
 
   hb_depend_data_t &data;
 };
@@ -37,6 +37,12 @@
 #include "OT/Color/COLR/COLR.hh"
 #include "OT/Color/COLR/colrv1-depend.hh"
 
+/* Upper bound on the number of GSUB lookup ranges a parallel build splits
+ * the lookups into. */
+#ifndef HB_DEPEND_MAX_LOOKUP_RANGES
+#define HB_DEPEND_MAX_LOOKUP_RANGES 32
+#endif
+
 /**
  * SECTION:hb-subset-depend
  * @title: hb-subset-depend
@@ -69,40 +75,183 @@ hb_subset_depend_t::hb_subset_depend_t (hb_face_t *f)
   successful = hb_depend_data_builder_t (data).compile (f);
 }
 
+hb_subset_depend_t::hb_subset_depend_t (hb_blob_t *b)
+{
+  blob = hb_sanitize_context_t ().sanitize_blob<OT::DependGraph> (hb_blob_reference (b));
+  graph = blob->as<OT::DependGraph> ();
+  successful = graph != &Null (OT::DependGraph);
+}
+
+/* Tables walked by hb_depend_data_builder_t::compile(), in order.
+ * Note: cmap (UVS) dependencies are not extracted - UVS closure is handled
+ * separately via hb_font_get_variation_glyph() query API during closure
+ * computation. */
+static const hb_tag_t _hb_depend_tables[] =
+{
+  HB_OT_TAG_GSUB,
+  HB_OT_TAG_MATH,
+  HB_OT_TAG_COLR,
+  HB_OT_TAG_glyf,
+  HB_OT_TAG_CFF1,
+};
+
 bool
 hb_depend_data_builder_t::compile (hb_face_t *face)
 {
-  /* Extract dependencies from all relevant OpenType tables.
-   * Note: cmap (UVS) dependencies are not extracted - UVS closure is handled
-   * separately via hb_font_get_variation_glyph() query API during closure
-   * computation.
-   *
-   * For GSUB, hb_ot_layout_has_substitution() forces lazy-loader initialization
+  /* Extract dependencies from all relevant OpenType tables. */
+  for (hb_tag_t table_tag : _hb_depend_tables)
+    compile_table (face, table_tag);
+  /* XXX TODO: add face->table.VARC->depend (this) here.
+   * VARC closure and subsetting are not yet implemented (see hb-subset-plan.cc),
+   * so the right traversal architecture for VarComponent records hasn't been
+   * established. Implement VARC depend() in the same commit that adds VARC
+   * closure, so both share the same traversal model. Component conditions should
+   * be treated as over-approximations (include all components regardless of
+   * condition), consistent with how FeatureVariations edges are handled. */
+  return successful;
+}
+
+void
+hb_depend_data_builder_t::compile_table (hb_face_t *face, hb_tag_t table_tag)
+{
+  switch (table_tag)
+  {
+  /* For GSUB, hb_ot_layout_has_substitution() forces lazy-loader initialization
    * in libharfbuzz, after which get_relaxed() safely returns the already-
    * constructed accelerator without instantiating the GSUB_accelerator_t
    * constructor (which references a hidden is_blocklisted symbol) in this TU. */
-  if (hb_ot_layout_has_substitution (face))
-    face->table.GSUB.get_relaxed ()->depend (this, face);
+  case HB_OT_TAG_GSUB:
+    if (hb_ot_layout_has_substitution (face))
+      face->table.GSUB.get_relaxed ()->depend (this, face);
+    break;
 #ifndef HB_NO_MATH
-  face->table.MATH->depend (this);
+  case HB_OT_TAG_MATH:
+    face->table.MATH->depend (this);
+    break;
 #endif
 #ifndef HB_NO_COLOR
-  face->table.COLR->depend (this);
+  case HB_OT_TAG_COLR:
+    face->table.COLR->depend (this);
+    break;
 #endif
-  face->table.glyf->depend (this);
+  case HB_OT_TAG_glyf:
+    face->table.glyf->depend (this);
+    break;
 #ifndef HB_NO_CFF
-  OT::cff1_subset_accelerator_t (face).depend (this);
+  case HB_OT_TAG_CFF1:
+    OT::cff1_subset_accelerator_t (face).depend (this);
+    break;
 #endif
-  /* XXX TODO: add face->table.VARC->depend (this) here.
-   * VARC closure and subsetting are not yet implemented (see hb-subset-plan.cc),
-   * so the right traversal architecture for VarComponent records hasn't been
-   * established. Implement VARC depend() in the same commit that adds VARC
-   * closure, so both share the same traversal model. Component conditions should
-   * be treated as over-approximations (include all components regardless of
-   * condition), consistent with how FeatureVariations edges are handled. */
-  return successful;
+  default:
+    break;
+  }
+}
+
+
+/* Parallel construction.
+ *
+ * GSUB lookups are split into contiguous ranges; every range, and every
+ * other table, becomes a task that walks into private data with a
+ * hb_depend_data_log_t.  The logs are then replayed into the final data
+ * in the order compile() would have walked them, so the result is
+ * identical to that of a serial build regardless of task scheduling. */
+
+struct hb_depend_task_t
+{
+  hb_tag_t table_tag;
+  unsigned lookup_start, lookup_end;	/* GSUB only. */
+  bool successful;
+  hb_depend_data_t data;
+  hb_depend_data_log_t log;
+};
+
+struct hb_depend_parallel_data_t
+{
+  hb_face_t *face;
+  const OT::GSUB_accelerator_t *gsub;
+  const hb_depend_data_builder_t *gsub_builder;	/* Has the lookup features. */
+  hb_vector_t<hb_depend_task_t> tasks;
+};
+
+static void
+_hb_depend_task (void *task_data, unsigned index)
+{
+  hb_depend_parallel_data_t *p = (hb_depend_parallel_data_t *) task_data;
+  hb_depend_task_t &task = p->tasks.arrayZ[index];
+
+  task.successful = false;
+  if (unlikely (!task.data.glyph_dependencies.resize_exact (p->face->get_num_glyphs ())))
+    return;
+
+  {
+    hb_depend_data_builder_t builder (task.data);
+    builder.log = &task.log;
+    if (task.table_tag == HB_OT_TAG_GSUB)
+    {
+      if (likely (builder.copy_lookup_features (*p->gsub_builder)))
+	p->gsub->depend_lookups (&builder, p->face, task.lookup_start, task.lookup_end);
+    }
+    else
+      builder.compile_table (p->face, task.table_tag);
+    task.successful = builder.successful;
+  }
+
+  /* Replay only needs the sets and the log. */
+  task.data.glyph_dependencies.fini ();
 }
 
+hb_subset_depend_t::hb_subset_depend_t (hb_face_t *f,
+					hb_subset_executor_func_t executor,
+					void *user_data)
+{
+  successful = false;
+  if (unlikely (!data.glyph_dependencies.resize_exact (f->get_num_glyphs ())))
+    return;
+
+  hb_depend_data_builder_t builder (data);
+
+  hb_depend_parallel_data_t p;
+  p.face = f;
+  p.gsub = nullptr;
+  p.gsub_builder = &builder;
+
+  if (hb_ot_layout_has_substitution (f))
+  {
+    p.gsub = f->table.GSUB.get_relaxed ();
+    if (p.gsub->table->has_data ())
+    {
+      if (unlikely (!p.gsub->depend_lookup_features (&builder, f)))
+	return;
+
+      unsigned num_lookups = p.gsub->table->get_lookup_count ();
+      unsigned num_ranges = hb_min (num_lookups, (unsigned) HB_DEPEND_MAX_LOOKUP_RANGES);
+      for (unsigned i = 0; i < num_ranges; i++)
+      {
+	hb_depend_task_t *task = p.tasks.push ();
+	task->table_tag = HB_OT_TAG_GSUB;
+	task->lookup_start = num_lookups * i / num_ranges;
+	task->lookup_end = num_lookups * (i + 1) / num_ranges;
+      }
+    }
+  }
+  for (hb_tag_t table_tag : _hb_depend_tables)
+    if (table_tag != HB_OT_TAG_GSUB)
+      p.tasks.push ()->table_tag = table_tag;
+  if (unlikely (p.tasks.in_error ()))
+    return;
+
+  if (executor && p.tasks.length > 1)
+    executor (_hb_depend_task, &p, p.tasks.length, user_data);
+  else
+    for (unsigned i = 0; i < p.tasks.length; i++)
+      _hb_depend_task (&p, i);
+
+  for (const hb_depend_task_t &task : p.tasks)
+    if (unlikely (!task.successful || !builder.replay (task.data, task.log)))
+      return;
+
+  successful = builder.successful;
+}
 
 #ifndef HB_NO_SUBSET_DEPEND
 
@@ -147,6 +296,44 @@ hb_subset_depend_from_face_or_fail (hb_face_t *face)
   return depend;
 }
 
+/**
+ * hb_subset_depend_from_face_parallel_or_fail:
+ * @face: font face to collect dependencies from
+ * @executor: (nullable): callback that runs the extraction tasks
+ * @user_data: data to pass to @executor
+ *
+ * Like hb_subset_depend_from_face_or_fail(), but splits the extraction
+ * into independent tasks (ranges of GSUB lookups, and each of the other
+ * tables) and hands them to @executor, which may run them concurrently.
+ * The per-task results are merged in a fixed order, so the returned
+ * graph is identical to the one hb_subset_depend_from_face_or_fail()
+ * computes, independent of how @executor schedules the tasks.
+ *
+ * If @executor is `NULL` the tasks are run serially on the calling thread.
+ *
+ * Return value: (transfer full): New depend object, or `nullptr` if creation
+ * failed (out of memory or invalid face). Destroy with hb_subset_depend_destroy().
+ *
+ * XSince: REPLACEME
+ **/
+hb_subset_depend_t *
+hb_subset_depend_from_face_parallel_or_fail (hb_face_t                 *face,
+					     hb_subset_executor_func_t  executor,
+					     void                      *user_data)
+{
+  hb_subset_depend_t *depend;
+  if (unlikely (!(depend = hb_object_create<hb_subset_depend_t> (face, executor, user_data))))
+    return nullptr;
+
+  if (unlikely (depend->in_error ()))
+  {
+    hb_subset_depend_destroy (depend);
+    return nullptr;
+  }
+
+  return depend;
+}
+
 /**
  * hb_subset_depend_lookup_glyph:
  * @depend: depend object
@@ -183,21 +370,13 @@ hb_subset_depend_lookup_glyph (hb_subset_depend_t *depend,
                                 unsigned int *entry_count,
                                 hb_subset_depend_entry_t *entries)
 {
-  unsigned int total = depend->data.get_glyph_entry_count (gid);
+  unsigned int total = depend->get_glyph_entry_count (gid);
   if (entry_count)
   {
     unsigned int count = hb_min (*entry_count,
                                   start_offset < total ? total - start_offset : 0u);
     for (unsigned int i = 0; i < count; i++)
-    {
-      uint8_t flags_byte = 0;
-      depend->data.get_glyph_entry (gid, start_offset + i,
-                                    &entries[i].table_tag, &entries[i].dependent,
-                                    &entries[i].layout_tag, &entries[i].ligature_set_index,
-                                    &entries[i].context_set_index,
-                                    &flags_byte);
-      entries[i].flags = (hb_subset_depend_edge_flags_t) flags_byte;
-    }
+      depend->get_glyph_entry (gid, start_offset + i, &entries[i]);
     *entry_count = count;
   }
   return total;
@@ -230,10 +409,101 @@ hb_bool_t
 hb_subset_depend_lookup_set (hb_subset_depend_t *depend, hb_codepoint_t index,
                               hb_set_t *out)
 {
-  const hb_set_t *s = depend->get_set_from_index (index);
-  if (!s) return false;
-  out->set (*s);
-  return true;
+  return depend->get_set (index, out);
+}
+
+/**
+ * hb_subset_depend_serialize_or_fail:
+ * @depend: depend object
+ *
+ * Serializes the dependency graph in @depend to a compact binary blob.
+ * The blob can be stored, for example alongside the font file, and later
+ * loaded with hb_subset_depend_from_blob_or_fail() instead of recomputing
+ * the graph from the face.
+ *
+ * The format is private to HarfBuzz and may change between releases;
+ * loading a blob written by a different version fails cleanly.
+ *
+ * Return value: (transfer full): Blob holding the serialized graph, or
+ * `nullptr` on failure. Destroy with hb_blob_destroy().
+ *
+ * XSince: REPLACEME
+ **/
+hb_blob_t *
+hb_subset_depend_serialize_or_fail (hb_subset_depend_t *depend)
+{
+  if (unlikely (depend->in_error ()))
+    return nullptr;
+
+  if (depend->blob)
+    return hb_blob_reference (depend->blob);
+
+  /* Exact size of the flat format; see OT::DependGraph. */
+  const hb_depend_data_t &data = depend->data;
+  size_t size = OT::DependGraph::min_size +
+		(data.glyph_dependencies.length + 1) * OT::HBUINT32::static_size +
+		(data.sets.length + 1) * OT::HBUINT32::static_size;
+  for (const auto &record : data.glyph_dependencies)
+    size += record.dependencies.length * OT::DependEdgeRecord::static_size;
+  for (const auto &set : data.sets)
+  {
+    hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+    while (set->next_range (&first, &last))
+      size += OT::DependSetRange::static_size;
+  }
+  if (unlikely (size > UINT_MAX))
+    return nullptr;
+
+  char *buf = (char *) hb_malloc (size);
+  if (unlikely (!buf))
+    return nullptr;
+
+  hb_serialize_context_t c (buf, size);
+  OT::DependGraph *graph = c.start_serialize<OT::DependGraph> ();
+  bool ret = graph->serialize (&c, data);
+  c.end_serialize ();
+
+  if (unlikely (!ret || c.in_error ()))
+  {
+    hb_free (buf);
+    return nullptr;
+  }
+
+  return hb_blob_create_or_fail (buf, size, HB_MEMORY_MODE_WRITABLE, buf, hb_free);
+}
+
+/**
+ * hb_subset_depend_from_blob_or_fail:
+ * @blob: blob holding a graph serialized by hb_subset_depend_serialize_or_fail()
+ *
+ * Loads a dependency graph previously serialized with
+ * hb_subset_depend_serialize_or_fail(). The blob is validated but not
+ * parsed: hb_subset_depend_lookup_glyph() and hb_subset_depend_lookup_set()
+ * read directly from its data, which makes loading from a blob created
+ * with hb_blob_create_from_file_or_fail() (memory-mapped where supported)
+ * nearly free. A reference to @blob is held for the lifetime of the
+ * returned object.
+ *
+ * Return value: (transfer full): New depend object, or `nullptr` if @blob
+ * does not hold a valid serialized graph or on allocation failure.
+ * Destroy with hb_subset_depend_destroy().
+ *
+ * XSince: REPLACEME
+ **/
+hb_subset_depend_t *
+hb_subset_depend_from_blob_or_fail (hb_blob_t *blob)
+{
+  hb_subset_depend_t *depend;
+  if (unlikely (!(depend = hb_object_create<hb_subset_depend_t> (blob))))
+    return nullptr;
+
+  if (unlikely (depend->in_error ()))
+  {
+    hb_subset_depend_destroy (depend);
+    return nullptr;
+  }
+
+  return depend;
 }
 
 /**
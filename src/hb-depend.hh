@@ -29,8 +29,196 @@
 
 #include "hb.hh"
 
-#include "hb-subset-depend.h"
+#include "hb-subset.h"
 #include "hb-depend-data.hh"
+#include "hb-open-type.hh"
+
+
+namespace OT {
+
+/*
+ * Serialized dependency graph.
+ *
+ * A flat image of hb_depend_data_t that is queried in place, so a graph
+ * loaded from a (memory-mapped) blob needs no parsing beyond sanitize.
+ * The arrays follow the header back to back:
+ *
+ *   edgeStarts[glyphCount + 1]	Index of the first edge of each glyph.
+ *   edges[edgeCount]
+ *   setStarts[setCount + 1]	Index of the first range of each set.
+ *   setRanges[rangeCount]
+ */
+
+#define HB_DEPEND_GRAPH_TAG HB_TAG('h','b','d','g')
+
+struct DependEdgeRecord
+{
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (c->check_struct (this));
+  }
+
+  Tag		tableTag;	/* Source table. */
+  HBUINT32	dependent;	/* Target glyph ID. */
+  Tag		layoutTag;	/* Feature tag for GSUB edges. */
+  HBUINT32	ligatureSet;	/* Index of ligature set, or 0xFFFFFFFF. */
+  HBUINT32	contextSet;	/* Index of context set, or 0xFFFFFFFF. */
+  HBUINT8	flags;		/* hb_subset_depend_edge_flags_t. */
+  public:
+  DEFINE_SIZE_STATIC (21);
+};
+
+struct DependSetRange
+{
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (c->check_struct (this));
+  }
+
+  HBUINT32	first;
+  HBUINT32	last;
+  public:
+  DEFINE_SIZE_STATIC (8);
+};
+
+struct DependGraph
+{
+  hb_array_t<const DependEdgeRecord> get_edges (hb_codepoint_t gid) const
+  {
+    if (gid >= glyphCount) return hb_array_t<const DependEdgeRecord> ();
+    const HBUINT32 *starts = edgeStarts.arrayZ;
+    unsigned start = hb_min ((unsigned) starts[gid], (unsigned) edgeCount);
+    unsigned end = hb_clamp ((unsigned) starts[gid + 1], start, (unsigned) edgeCount);
+    return hb_array (get_edge_records () + start, end - start);
+  }
+
+  bool get_set (hb_codepoint_t index, hb_set_t *out) const
+  {
+    if (index >= setCount) return false;
+    const HBUINT32 *starts = get_set_starts ();
+    unsigned start = hb_min ((unsigned) starts[index], (unsigned) rangeCount);
+    unsigned end = hb_clamp ((unsigned) starts[index + 1], start, (unsigned) rangeCount);
+    out->clear ();
+    /* Members are (up to 24-bit) glyph IDs, which may exceed glyphCount in
+     * broken fonts, or set indices tagged with HB_DEPEND_CONTEXT_SET_FLAG.
+     * Clamp to those so that a bogus range cannot blow up the output set. */
+    for (const DependSetRange &range : hb_array (get_set_ranges () + start, end - start))
+    {
+      add_range_clamped (out, range, 0, 1u << 24);
+      add_range_clamped (out, range, HB_DEPEND_CONTEXT_SET_FLAG,
+			 hb_min ((unsigned) setCount, ~HB_DEPEND_CONTEXT_SET_FLAG));
+    }
+    return true;
+  }
+
+  bool serialize (hb_serialize_context_t *c, const hb_depend_data_t &data)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (this))) return_trace (false);
+
+    magic = HB_DEPEND_GRAPH_TAG;
+    version.major = 1;
+    version.minor = 0;
+    glyphCount = data.glyph_dependencies.length;
+    setCount = data.sets.length;
+
+    unsigned edge_count = 0;
+    for (const auto &record : data.glyph_dependencies)
+    {
+      if (unlikely (!c->embed (HBUINT32 (edge_count)))) return_trace (false);
+      edge_count += record.dependencies.length;
+    }
+    if (unlikely (!c->embed (HBUINT32 (edge_count)))) return_trace (false);
+    edgeCount = edge_count;
+
+    for (const auto &record : data.glyph_dependencies)
+      for (const hb_depend_edge_t &edge : record.dependencies)
+      {
+	DependEdgeRecord *out = c->allocate_min<DependEdgeRecord> ();
+	if (unlikely (!out)) return_trace (false);
+	out->tableTag = edge.table_tag;
+	out->dependent = edge.dependent;
+	out->layoutTag = edge.layout_tag;
+	out->ligatureSet = edge.ligature_set;
+	out->contextSet = edge.context_set;
+	out->flags = edge.flags;
+      }
+
+    unsigned range_count = 0;
+    for (const auto &set : data.sets)
+    {
+      if (unlikely (!c->embed (HBUINT32 (range_count)))) return_trace (false);
+      hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+      while (set->next_range (&first, &last))
+	range_count++;
+    }
+    if (unlikely (!c->embed (HBUINT32 (range_count)))) return_trace (false);
+    rangeCount = range_count;
+
+    for (const auto &set : data.sets)
+    {
+      hb_codepoint_t first = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+      while (set->next_range (&first, &last))
+      {
+	DependSetRange *out = c->allocate_min<DependSetRange> ();
+	if (unlikely (!out)) return_trace (false);
+	out->first = first;
+	out->last = last;
+      }
+    }
+
+    return_trace (true);
+  }
+
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    /* The +1 in each starts array must not wrap. */
+    return_trace (likely (c->check_struct (this) &&
+			  magic == HB_DEPEND_GRAPH_TAG &&
+			  version.major == 1 &&
+			  glyphCount < HB_CODEPOINT_INVALID &&
+			  setCount < HB_CODEPOINT_INVALID &&
+			  c->check_array (edgeStarts.arrayZ, glyphCount + 1) &&
+			  c->check_array (get_edge_records (), edgeCount) &&
+			  c->check_array (get_set_starts (), setCount + 1) &&
+			  c->check_array (get_set_ranges (), rangeCount)));
+  }
+
+  protected:
+  static void add_range_clamped (hb_set_t *out, const DependSetRange &range,
+				 hb_codepoint_t base, unsigned count)
+  {
+    if (!count) return;
+    hb_codepoint_t first = hb_max ((hb_codepoint_t) range.first, base);
+    hb_codepoint_t last = hb_min ((hb_codepoint_t) range.last, base + count - 1);
+    if (first <= last)
+      out->add_range (first, last);
+  }
+
+  const DependEdgeRecord *get_edge_records () const
+  { return &StructAtOffset<DependEdgeRecord> (edgeStarts.arrayZ, (glyphCount + 1) * HBUINT32::static_size); }
+  const HBUINT32 *get_set_starts () const
+  { return &StructAtOffset<HBUINT32> (get_edge_records (), edgeCount * DependEdgeRecord::static_size); }
+  const DependSetRange *get_set_ranges () const
+  { return &StructAtOffset<DependSetRange> (get_set_starts (), (setCount + 1) * HBUINT32::static_size); }
+
+  protected:
+  Tag		magic;		/* 'hbdg'. */
+  FixedVersion<>version;	/* Major version 1. */
+  HBUINT32	glyphCount;
+  HBUINT32	edgeCount;
+  HBUINT32	setCount;
+  HBUINT32	rangeCount;
+  UnsizedArrayOf<HBUINT32>
+		edgeStarts;	/* [glyphCount + 1]; other arrays follow. */
+  public:
+  DEFINE_SIZE_ARRAY (24, edgeStarts);
+};
+
+} /* namespace OT */
 
 
 /**
@@ -39,12 +227,19 @@
  * Internal structure implementing the dependency graph API.
  *
  * Initialized via hb_subset_depend_from_face_or_fail() which computes the dependency
- * graph once via hb_depend_data_builder_t::compile(). The graph remains
+ * graph once via hb_depend_data_builder_t::compile(), or via
+ * hb_subset_depend_from_blob_or_fail() which queries a graph serialized by
+ * hb_subset_depend_serialize_or_fail() in place. The graph remains
  * immutable for the lifetime of the object.
  */
 struct hb_subset_depend_t
 {
   HB_INTERNAL hb_subset_depend_t (hb_face_t *face);
+  HB_INTERNAL hb_subset_depend_t (hb_face_t *face,
+				  hb_subset_executor_func_t executor,
+				  void *user_data);
+  HB_INTERNAL hb_subset_depend_t (hb_blob_t *blob);
+  ~hb_subset_depend_t () { hb_blob_destroy (blob); }
 
   hb_object_header_t header;
 
@@ -52,12 +247,60 @@ struct hb_subset_depend_t
 
   bool in_error () const { return !successful; }
 
-  const hb_set_t *get_set_from_index (hb_codepoint_t index)
+  unsigned int get_glyph_entry_count (hb_codepoint_t gid) const
   {
-    return data.get_set_from_index (index);
+    if (graph)
+      return graph->get_edges (gid).length;
+    return data.get_glyph_entry_count (gid);
   }
 
+#ifndef HB_NO_SUBSET_DEPEND
+  bool get_glyph_entry (hb_codepoint_t gid, unsigned int index,
+			hb_subset_depend_entry_t *entry)
+  {
+    if (graph)
+    {
+      auto edges = graph->get_edges (gid);
+      if (index >= edges.length)
+	return false;
+      const OT::DependEdgeRecord &e = edges.arrayZ[index];
+      entry->table_tag = e.tableTag;
+      entry->dependent = e.dependent;
+      entry->layout_tag = e.layoutTag;
+      entry->ligature_set_index = e.ligatureSet;
+      entry->context_set_index = e.contextSet;
+      entry->flags = (hb_subset_depend_edge_flags_t) (e.flags &
+						      (HB_SUBSET_DEPEND_EDGE_FLAG_FROM_CONTEXT_POSITION |
+						       HB_SUBSET_DEPEND_EDGE_FLAG_FROM_NESTED_CONTEXT));
+      return true;
+    }
+
+    uint8_t flags = 0;
+    bool ret = data.get_glyph_entry (gid, index,
+				     &entry->table_tag, &entry->dependent,
+				     &entry->layout_tag, &entry->ligature_set_index,
+				     &entry->context_set_index, &flags);
+    entry->flags = (hb_subset_depend_edge_flags_t) flags;
+    return ret;
+  }
+#endif
+
+  bool get_set (hb_codepoint_t index, hb_set_t *out)
+  {
+    if (graph)
+      return graph->get_set (index, out);
+    const hb_set_t *s = data.get_set_from_index (index);
+    if (!s) return false;
+    out->set (*s);
+    return true;
+  }
+
+  /* Built graph; empty when loaded from a blob. */
   hb_depend_data_t data;
+
+  /* Serialized graph, queried in place; nullptr when built from a face. */
+  hb_blob_t *blob = nullptr;
+  const OT::DependGraph *graph = nullptr;
 };
 
 
@@ -91,6 +91,27 @@ _hb_face_builder_data_destroy (void *user_data)
   hb_free (data);
 }
 
+static hb_tag_t
+_hb_face_builder_data_sfnt_tag (hb_face_builder_data_t *data)
+{
+  bool is_cff = (data->tables.has (HB_TAG ('C','F','F',' '))
+                 || data->tables.has (HB_TAG ('C','F','F','2')));
+  return is_cff ? OT::OpenTypeFontFile::CFFTag : OT::OpenTypeFontFile::TrueTypeTag;
+}
+
+static bool
+_hb_face_builder_data_sort_entries (hb_face_builder_data_t *data,
+				    hb_vector_t<hb_pair_t <hb_tag_t, face_table_info_t>> &sorted_entries)
+{
+  // Sort the tags so that produced face is deterministic.
+  data->tables.iter () | hb_sink (sorted_entries);
+  if (unlikely (sorted_entries.in_error ()))
+    return false;
+
+  sorted_entries.qsort (compare_entries);
+  return true;
+}
+
 static hb_blob_t *
 _hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
 {
@@ -109,21 +130,15 @@ _hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
   c.propagate_error (data->tables);
   OT::OpenTypeFontFile *f = c.start_serialize<OT::OpenTypeFontFile> ();
 
-  bool is_cff = (data->tables.has (HB_TAG ('C','F','F',' '))
-                 || data->tables.has (HB_TAG ('C','F','F','2')));
-  hb_tag_t sfnt_tag = is_cff ? OT::OpenTypeFontFile::CFFTag : OT::OpenTypeFontFile::TrueTypeTag;
+  hb_tag_t sfnt_tag = _hb_face_builder_data_sfnt_tag (data);
 
-  // Sort the tags so that produced face is deterministic.
   hb_vector_t<hb_pair_t <hb_tag_t, face_table_info_t>> sorted_entries;
-  data->tables.iter () | hb_sink (sorted_entries);
-  if (unlikely (sorted_entries.in_error ()))
+  if (unlikely (!_hb_face_builder_data_sort_entries (data, sorted_entries)))
   {
     hb_free (buf);
     return nullptr;
   }
 
-  sorted_entries.qsort (compare_entries);
-
   bool ret = f->serialize_single (&c,
                                   sfnt_tag,
                                   + sorted_entries.iter()
@@ -142,6 +157,89 @@ _hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
   return hb_blob_create (buf, face_length, HB_MEMORY_MODE_WRITABLE, buf, hb_free);
 }
 
+static const char _hb_face_builder_padding[4] = {};
+
+/* Fills blobs with the pieces of the font file _hb_face_builder_data_reference_blob ()
+ * would return. */
+static bool
+_hb_face_builder_data_reference_blobs (hb_face_builder_data_t *data,
+				       hb_vector_t<hb_blob_t *> &blobs)
+{
+  hb_vector_t<hb_pair_t <hb_tag_t, face_table_info_t>> sorted_entries;
+  if (unlikely (data->tables.in_error () ||
+		!_hb_face_builder_data_sort_entries (data, sorted_entries)))
+    return false;
+
+  auto add = [&] (hb_blob_t *blob)
+  {
+    blobs.push (blob);
+    if (unlikely (blobs.in_error ()))
+    {
+      hb_blob_destroy (blob);
+      return false;
+    }
+    return true;
+  };
+
+  unsigned int dir_length = sorted_entries.length * 16 + 12;
+  char *buf = (char *) hb_malloc (dir_length);
+  if (unlikely (!buf))
+    return false;
+
+  hb_serialize_context_t c (buf, dir_length);
+  OT::OpenTypeOffsetTable *dir = c.start_serialize<OT::OpenTypeOffsetTable> ();
+  uint32_t checksum_adjustment = 0;
+  bool ret = dir->serialize_directory (&c,
+				       _hb_face_builder_data_sfnt_tag (data),
+				       + sorted_entries.iter()
+				       | hb_map ([&] (hb_pair_t<hb_tag_t, face_table_info_t> _) {
+					 return hb_pair_t<hb_tag_t, hb_blob_t*> (_.first, _.second.data);
+				       }),
+				       &checksum_adjustment);
+  c.end_serialize ();
+
+  if (unlikely (!ret))
+  {
+    hb_free (buf);
+    return false;
+  }
+
+  if (unlikely (!add (hb_blob_create (buf, dir_length, HB_MEMORY_MODE_WRITABLE, buf, hb_free))))
+    return false;
+
+  for (const auto &_ : sorted_entries)
+  {
+    hb_blob_t *blob = _.second.data;
+    unsigned len = blob->length;
+    if (!len) continue;
+
+    if (_.first == HB_OT_TAG_head &&
+	hb_ceil_to_4 (len) >= OT::head::static_size)
+    {
+      /* The only table that is copied, to fill in checkSumAdjustment. */
+      char *head = (char *) hb_malloc (len);
+      if (unlikely (!head))
+	return false;
+      hb_memcpy (head, blob->data, len);
+      ((OT::head *) head)->set_checksum_adjustment (checksum_adjustment);
+      blob = hb_blob_create (head, len, HB_MEMORY_MODE_WRITABLE, head, hb_free);
+    }
+    else
+      blob = hb_blob_reference (blob);
+
+    if (unlikely (!add (blob)))
+      return false;
+
+    unsigned padding = hb_ceil_to_4 (len) - len;
+    if (padding &&
+	unlikely (!add (hb_blob_create (_hb_face_builder_padding, padding,
+					HB_MEMORY_MODE_READONLY, nullptr, nullptr))))
+      return false;
+  }
+
+  return true;
+}
+
 static hb_blob_t *
 _hb_face_builder_reference_table (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data)
 {
@@ -295,3 +393,63 @@ hb_face_builder_sort_tables (hb_face_t *face,
     info->order = order++;
   }
 }
+
+/**
+ * hb_face_builder_reference_blobs:
+ * @face: A face object created with hb_face_builder_create()
+ * @start_offset: The index of the first blob to retrieve
+ * @blob_count: (inout): Input = the maximum number of blobs to return;
+ *              Output = the actual number of blobs returned (may be zero)
+ * @blobs: (out) (array length=blob_count) (transfer full): The array of blobs found
+ *
+ * Fetches a list of blobs that, concatenated, make up the same font file
+ * hb_face_reference_blob() returns for @face: the table directory, then
+ * each table followed by its padding, if any.
+ *
+ * Unlike hb_face_reference_blob(), this does not copy the tables into a
+ * new buffer; the table blobs added to @face are returned themselves,
+ * except for the 'head' table, which is copied to fill in its checksum
+ * adjustment.  The list is suitable for writing out with writev() or
+ * streaming to a sink, without holding two copies of the font in memory.
+ *
+ * The list returned will begin at the offset provided.  The caller must
+ * destroy the returned blobs.
+ *
+ * Return value: Total number of blobs, or zero if @face is not a
+ * builder face or on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_face_builder_reference_blobs (hb_face_t    *face,
+				 unsigned int  start_offset,
+				 unsigned int *blob_count, /* IN/OUT */
+				 hb_blob_t   **blobs /* OUT */)
+{
+  hb_vector_t<hb_blob_t *> all;
+  if (unlikely (face->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy ||
+		!_hb_face_builder_data_reference_blobs ((hb_face_builder_data_t *) face->user_data, all)))
+  {
+    for (hb_blob_t *blob : all)
+      hb_blob_destroy (blob);
+    if (blob_count)
+      *blob_count = 0;
+    return 0;
+  }
+
+  unsigned count = 0;
+  if (blob_count)
+  {
+    auto array = all.as_array ().sub_array (start_offset, blob_count);
+    + array.iter ()
+    | hb_sink (hb_array (blobs, *blob_count))
+    ;
+    count = array.length;
+  }
+  /* Drop the blobs not returned. */
+  for (unsigned i = 0; i < all.length; i++)
+    if (i < start_offset || i >= start_offset + count)
+      hb_blob_destroy (all[i]);
+
+  return all.length;
+}
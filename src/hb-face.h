@@ -236,6 +236,12 @@ HB_EXTERN void
 hb_face_builder_sort_tables (hb_face_t *face,
                              const hb_tag_t  *tags);
 
+HB_EXTERN unsigned int
+hb_face_builder_reference_blobs (hb_face_t    *face,
+				 unsigned int  start_offset,
+				 unsigned int *blob_count, /* IN/OUT */
+				 hb_blob_t   **blobs /* OUT */);
+
 
 HB_END_DECLS
 
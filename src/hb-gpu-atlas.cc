@@ -0,0 +1,861 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb.hh"
+
+#include "hb-gpu-atlas.hh"
+
+
+/* Internal methods */
+
+bool
+hb_gpu_atlas_t::instance_t::matches (hb_font_t *f) const
+{
+  int xs, ys;
+  hb_font_get_scale (f, &xs, &ys);
+  if (xs != x_scale || ys != y_scale)
+    return false;
+  float xe, ye;
+  hb_bool_t in_place;
+  hb_font_get_synthetic_bold (f, &xe, &ye, &in_place);
+  /* In-place only matters when emboldening. */
+  if (xe != x_embolden || ye != y_embolden ||
+      ((xe || ye) && (bool) in_place != (bool) embolden_in_place) ||
+      hb_font_get_synthetic_slant (f) != slant)
+    return false;
+  unsigned length;
+  const int *c = hb_font_get_var_coords_normalized (f, &length);
+  return length == coords.length &&
+	 (!length || !hb_memcmp (c, coords.arrayZ, length * sizeof (int)));
+}
+
+void
+hb_gpu_atlas_t::init (unsigned capacity_)
+{
+  capacity = capacity_;
+  if (capacity)
+    free_ranges.push (hb_gpu_atlas_range_t {0, capacity});
+}
+
+void
+hb_gpu_atlas_t::fini ()
+{
+  for (auto &inst : instances)
+    hb_font_destroy (inst.font);
+}
+
+void
+hb_gpu_atlas_t::clear ()
+{
+  fini ();
+  instances.clear ();
+  entries.clear ();
+  entry_index.clear ();
+  lru.reset ();
+  free_ranges.reset ();
+  if (capacity)
+    free_ranges.push (hb_gpu_atlas_range_t {0, capacity});
+  dirty_ranges.reset ();
+  used = 0;
+  last_font = nullptr;
+  frame_start = clock;
+  serial++;
+}
+
+bool
+hb_gpu_atlas_t::find_instance (hb_font_t *font, bool create, unsigned *index)
+{
+  unsigned font_serial = hb_font_get_serial (font);
+  if (font == last_font &&
+      instances.arrayZ[last_instance].serial == font_serial)
+  {
+    *index = last_instance;
+    return true;
+  }
+
+  unsigned free_slot = instances.length;
+  for (unsigned i = 0; i < instances.length; i++)
+  {
+    instance_t &inst = instances.arrayZ[i];
+    if (!inst.font)
+    {
+      free_slot = hb_min (free_slot, i);
+      continue;
+    }
+    if (inst.font == font && inst.matches (font))
+    {
+      inst.serial = font_serial;
+      last_font = font;
+      last_instance = *index = i;
+      return true;
+    }
+  }
+  if (!create)
+    return false;
+
+  if (free_slot == instances.length && unlikely (!instances.push_or_fail ()))
+    return false;
+  instance_t &inst = instances.arrayZ[free_slot];
+  unsigned length;
+  const int *coords = hb_font_get_var_coords_normalized (font, &length);
+  inst.coords.clear ();
+  if (unlikely (!inst.coords.resize (length)))
+    return false;
+  if (length)
+    hb_memcpy (inst.coords.arrayZ, coords, length * sizeof (int));
+  hb_font_get_scale (font, &inst.x_scale, &inst.y_scale);
+  hb_font_get_synthetic_bold (font, &inst.x_embolden, &inst.y_embolden,
+			      &inst.embolden_in_place);
+  inst.slant = hb_font_get_synthetic_slant (font);
+  inst.font = hb_font_reference (font);
+  inst.serial = font_serial;
+  inst.entry_count = 0;
+  last_font = font;
+  last_instance = *index = free_slot;
+  return true;
+}
+
+hb_gpu_atlas_t::entry_t *
+hb_gpu_atlas_t::find (hb_font_t *font, hb_codepoint_t glyph)
+{
+  unsigned instance;
+  if (!find_instance (font, false, &instance))
+    return nullptr;
+  unsigned *i;
+  if (!entry_index.has (((uint64_t) instance << 32) | glyph, &i))
+    return nullptr;
+  entry_t *e = &entries.arrayZ[*i];
+  e->last_use = ++clock;
+  if (e->length)
+    lru.touch (entries.arrayZ, *i);
+  return e;
+}
+
+bool
+hb_gpu_atlas_t::add (hb_font_t *font, hb_codepoint_t glyph,
+		     hb_blob_t *blob, const hb_glyph_extents_t *extents,
+		     unsigned *offset)
+{
+  unsigned bytes = hb_blob_get_length (blob);
+  if (unlikely (bytes % HB_GPU_ATLAS_TEXEL_SIZE))
+    return false;
+  unsigned length = bytes / HB_GPU_ATLAS_TEXEL_SIZE;
+
+  unsigned instance;
+  if (unlikely (!find_instance (font, true, &instance)))
+    return false;
+  uint64_t key = ((uint64_t) instance << 32) | glyph;
+
+  /* Hold the instance while evicting room for the new entry. */
+  instances.arrayZ[instance].entry_count++;
+
+  unsigned *existing;
+  if (entry_index.has (key, &existing))
+    remove_entry (*existing);
+
+  unsigned off = 0;
+  bool allocated = length && allocate (length, &off);
+  unsigned end = (off + length) * HB_GPU_ATLAS_TEXEL_SIZE;
+  if (unlikely ((length && !allocated) ||
+		(data.length < end && !data.resize (end)) ||
+		!entries.push_or_fail (entry_t {key, off, length,
+						extents ? *extents : hb_glyph_extents_t {},
+						++clock, {}})))
+  {
+    if (allocated)
+      release (off, length);
+    release_instance (instance);
+    return false;
+  }
+  if (unlikely (!entry_index.set (key, entries.length - 1)))
+  {
+    entries.pop ();
+    if (allocated)
+      release (off, length);
+    release_instance (instance);
+    return false;
+  }
+  /* The hold now counts the new entry. */
+
+  if (length)
+  {
+    lru.push (entries.arrayZ, entries.length - 1);
+    hb_memcpy (data.arrayZ + off * HB_GPU_ATLAS_TEXEL_SIZE,
+	       hb_blob_get_data (blob, nullptr), bytes);
+    mark_dirty (off, length);
+  }
+  used += length;
+  if (offset)
+    *offset = off;
+  return true;
+}
+
+/* Finds room for @length texels: first fit, else compaction if the
+ * free space suffices but is fragmented, else eviction. */
+bool
+hb_gpu_atlas_t::allocate (unsigned length, unsigned *offset)
+{
+  for (;;)
+  {
+    if (take_free (length, offset))
+      return true;
+    if (capacity - used >= length)
+    {
+      compact ();
+      return take_free (length, offset);
+    }
+    if (!evict_one ())
+      return false;
+  }
+}
+
+bool
+hb_gpu_atlas_t::take_free (unsigned length, unsigned *offset)
+{
+  for (unsigned i = 0; i < free_ranges.length; i++)
+  {
+    hb_gpu_atlas_range_t &r = free_ranges.arrayZ[i];
+    if (r.length < length)
+      continue;
+    *offset = r.offset;
+    r.offset += length;
+    r.length -= length;
+    if (!r.length)
+      free_ranges.remove_ordered (i);
+    return true;
+  }
+  return false;
+}
+
+void
+hb_gpu_atlas_t::release (unsigned offset, unsigned length)
+{
+  /* First range after @offset. */
+  unsigned lo = 0, hi = free_ranges.length;
+  while (lo < hi)
+  {
+    unsigned mid = (lo + hi) / 2;
+    if (free_ranges.arrayZ[mid].offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  unsigned i = lo;
+
+  bool merge_prev = i && free_ranges.arrayZ[i - 1].offset + free_ranges.arrayZ[i - 1].length == offset;
+  bool merge_next = i < free_ranges.length && offset + length == free_ranges.arrayZ[i].offset;
+  if (merge_prev && merge_next)
+  {
+    free_ranges.arrayZ[i - 1].length += length + free_ranges.arrayZ[i].length;
+    free_ranges.remove_ordered (i);
+  }
+  else if (merge_prev)
+    free_ranges.arrayZ[i - 1].length += length;
+  else if (merge_next)
+  {
+    free_ranges.arrayZ[i].offset = offset;
+    free_ranges.arrayZ[i].length += length;
+  }
+  else if (unlikely (!free_ranges.push_or_fail ()))
+    /* The texels are lost until the next compaction. */
+    return;
+  else
+  {
+    memmove (free_ranges.arrayZ + i + 1, free_ranges.arrayZ + i,
+	     (free_ranges.length - 1 - i) * sizeof (free_ranges.arrayZ[0]));
+    free_ranges.arrayZ[i] = hb_gpu_atlas_range_t {offset, length};
+  }
+}
+
+/* Evicts the least recently used entry not used by the current frame.
+ * The eviction list is in last_use order, so if its head was used by
+ * the current frame, all entries were. */
+bool
+hb_gpu_atlas_t::evict_one ()
+{
+  if (lru.is_empty () || entries.arrayZ[lru.head].last_use > frame_start)
+    return false;
+  remove_entry (lru.head);
+  return true;
+}
+
+void
+hb_gpu_atlas_t::remove_entry (unsigned i)
+{
+  entry_t e = entries.arrayZ[i];
+  if (e.length)
+  {
+    lru.remove (entries.arrayZ, i);
+    release (e.offset, e.length);
+    used -= e.length;
+    serial++;
+  }
+  entry_index.del (e.key);
+  if (i != entries.length - 1)
+  {
+    entries.arrayZ[i] = entries.tail ();
+    /* Update in place; set() may insert a second copy of a live key
+     * into an earlier tombstone. */
+    unsigned *moved;
+    if (entry_index.has (entries.arrayZ[i].key, &moved))
+      *moved = i;
+    if (entries.arrayZ[i].length)
+      lru.moved (entries.arrayZ, i);
+  }
+  entries.pop ();
+
+  release_instance ((unsigned) (e.key >> 32));
+}
+
+void
+hb_gpu_atlas_t::release_instance (unsigned instance)
+{
+  instance_t &inst = instances.arrayZ[instance];
+  if (--inst.entry_count)
+    return;
+  hb_font_destroy (inst.font);
+  inst.font = nullptr;
+  if (last_instance == instance)
+    last_font = nullptr;
+}
+
+/* Slides all entries to the start of the atlas, in offset order. */
+void
+hb_gpu_atlas_t::compact ()
+{
+  hb_vector_t<unsigned> order;
+  if (unlikely (!order.resize_dirty (entries.length)))
+    return;
+  for (unsigned i = 0; i < entries.length; i++)
+    order.arrayZ[i] = i;
+  const entry_t *e = entries.arrayZ;
+  order.qsort ([e] (const unsigned &a, const unsigned &b)
+	       { return e[a].offset < e[b].offset ? -1 : e[a].offset > e[b].offset ? 1 : 0; });
+
+  unsigned cursor = 0;
+  for (unsigned i : order)
+  {
+    entry_t &entry = entries.arrayZ[i];
+    if (!entry.length)
+      continue;
+    if (entry.offset != cursor)
+      memmove (data.arrayZ + cursor * HB_GPU_ATLAS_TEXEL_SIZE,
+	       data.arrayZ + entry.offset * HB_GPU_ATLAS_TEXEL_SIZE,
+	       entry.length * HB_GPU_ATLAS_TEXEL_SIZE);
+    entry.offset = cursor;
+    cursor += entry.length;
+  }
+
+  free_ranges.reset ();
+  if (cursor < capacity)
+    free_ranges.push (hb_gpu_atlas_range_t {cursor, capacity - cursor});
+  dirty_ranges.clear ();
+  mark_dirty (0, cursor);
+  serial++;
+}
+
+void
+hb_gpu_atlas_t::mark_dirty (unsigned offset, unsigned length)
+{
+  if (!length || unlikely (dirty_ranges.in_error ()))
+    return;
+  unsigned end = offset + length;
+
+  /* Ranges overlapping or touching [offset, end) merge with it. */
+  unsigned i = 0;
+  while (i < dirty_ranges.length &&
+	 dirty_ranges.arrayZ[i].offset + dirty_ranges.arrayZ[i].length < offset)
+    i++;
+  unsigned j = i;
+  while (j < dirty_ranges.length && dirty_ranges.arrayZ[j].offset <= end)
+  {
+    offset = hb_min (offset, dirty_ranges.arrayZ[j].offset);
+    end = hb_max (end, dirty_ranges.arrayZ[j].offset + dirty_ranges.arrayZ[j].length);
+    j++;
+  }
+
+  hb_gpu_atlas_range_t r = {offset, end - offset};
+  if (j > i)
+  {
+    dirty_ranges.arrayZ[i] = r;
+    for (unsigned k = i + 1; k < j; k++)
+      dirty_ranges.remove_ordered (i + 1);
+    return;
+  }
+
+  if (dirty_ranges.length >= HB_GPU_ATLAS_MAX_DIRTY_RANGES)
+  {
+    /* Upload one covering range instead. */
+    unsigned lo = hb_min (r.offset, dirty_ranges.arrayZ[0].offset);
+    unsigned hi = hb_max (end, dirty_ranges.tail ().offset + dirty_ranges.tail ().length);
+    dirty_ranges.resize (1);
+    dirty_ranges.arrayZ[0] = hb_gpu_atlas_range_t {lo, hi - lo};
+    return;
+  }
+  /* On failure the vector stays in error, which reports everything as
+   * dirty. */
+  if (unlikely (!dirty_ranges.push_or_fail ()))
+    return;
+  memmove (dirty_ranges.arrayZ + i + 1, dirty_ranges.arrayZ + i,
+	   (dirty_ranges.length - 1 - i) * sizeof (dirty_ranges.arrayZ[0]));
+  dirty_ranges.arrayZ[i] = r;
+}
+
+
+/* ---- Public API ---- */
+
+/**
+ * hb_gpu_atlas_create_or_fail:
+ * @capacity: atlas size, in texels (8 bytes each)
+ *
+ * Creates a new CPU-side glyph atlas.  The atlas packs blobs from
+ * hb_gpu_draw_encode() or hb_gpu_paint_encode() into one texel
+ * buffer, meant to mirror a GPU buffer of the same capacity, and
+ * keeps track of which glyph lives where.
+ *
+ * Entries are keyed by font, glyph, and the font's scale, normalized
+ * variation coordinates, synthetic bold and synthetic slant at the
+ * time they are added.
+ * Draw and paint encodings of a glyph share a key, so use separate
+ * atlases if both are needed.
+ *
+ * When full, the atlas makes room by evicting the least recently used
+ * entries that were not used since the last hb_gpu_atlas_clear_dirty(),
+ * and by moving entries together when the free space is fragmented.
+ * Either invalidates offsets handed out earlier; see
+ * hb_gpu_atlas_get_serial().
+ *
+ * Memory for the texel buffer is allocated as it fills up.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_gpu_atlas_t, or `NULL` on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_gpu_atlas_t *
+hb_gpu_atlas_create_or_fail (unsigned int capacity)
+{
+  if (unlikely (capacity > UINT_MAX / HB_GPU_ATLAS_TEXEL_SIZE))
+    return nullptr;
+
+  hb_gpu_atlas_t *atlas = hb_object_create<hb_gpu_atlas_t> ();
+  if (unlikely (!atlas))
+    return nullptr;
+
+  atlas->init (capacity);
+  if (unlikely (atlas->free_ranges.in_error ()))
+  {
+    hb_gpu_atlas_destroy (atlas);
+    return nullptr;
+  }
+  return atlas;
+}
+
+/**
+ * hb_gpu_atlas_reference: (skip)
+ * @atlas: a GPU glyph atlas
+ *
+ * Increases the reference count on @atlas by one.
+ *
+ * Return value: (transfer full):
+ * The referenced #hb_gpu_atlas_t.
+ *
+ * XSince: REPLACEME
+ **/
+hb_gpu_atlas_t *
+hb_gpu_atlas_reference (hb_gpu_atlas_t *atlas)
+{
+  return hb_object_reference (atlas);
+}
+
+/**
+ * hb_gpu_atlas_destroy: (skip)
+ * @atlas: a GPU glyph atlas
+ *
+ * Decreases the reference count on @atlas by one. When the
+ * reference count reaches zero, the atlas and the references it
+ * holds on fonts are released.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_atlas_destroy (hb_gpu_atlas_t *atlas)
+{
+  if (!hb_object_should_destroy (atlas))
+    return;
+
+  atlas->fini ();
+
+  hb_object_actually_destroy (atlas);
+  hb_free (atlas);
+}
+
+/**
+ * hb_gpu_atlas_set_user_data: (skip)
+ * @atlas: a GPU glyph atlas
+ * @key: the user-data key
+ * @data: a pointer to the user data
+ * @destroy: (nullable): a callback to call when @data is not needed anymore
+ * @replace: whether to replace an existing data with the same key
+ *
+ * Attaches user data to @atlas.
+ *
+ * Return value: `true` if success, `false` otherwise
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_set_user_data (hb_gpu_atlas_t     *atlas,
+			    hb_user_data_key_t *key,
+			    void               *data,
+			    hb_destroy_func_t   destroy,
+			    hb_bool_t           replace)
+{
+  return hb_object_set_user_data (atlas, key, data, destroy, replace);
+}
+
+/**
+ * hb_gpu_atlas_get_user_data: (skip)
+ * @atlas: a GPU glyph atlas
+ * @key: the user-data key
+ *
+ * Fetches the user-data associated with the specified key.
+ *
+ * Return value: (transfer none):
+ * A pointer to the user data
+ *
+ * XSince: REPLACEME
+ **/
+void *
+hb_gpu_atlas_get_user_data (const hb_gpu_atlas_t *atlas,
+			    hb_user_data_key_t   *key)
+{
+  return hb_object_get_user_data (atlas, key);
+}
+
+/**
+ * hb_gpu_atlas_get_capacity:
+ * @atlas: a GPU glyph atlas
+ *
+ * Fetches the capacity @atlas was created with.
+ *
+ * Return value: the capacity, in texels
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_capacity (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->capacity;
+}
+
+/**
+ * hb_gpu_atlas_get_used:
+ * @atlas: a GPU glyph atlas
+ *
+ * Fetches how much of @atlas is held by entries.
+ *
+ * Return value: the number of texels in use
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_used (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->used;
+}
+
+/**
+ * hb_gpu_atlas_get_serial:
+ * @atlas: a GPU glyph atlas
+ *
+ * Fetches the serial of @atlas.  The serial changes whenever an
+ * offset returned before may no longer be valid: when an entry is
+ * evicted, when entries are moved to defragment the atlas, and on
+ * hb_gpu_atlas_clear().
+ *
+ * Callers that keep offsets, e.g. in vertex data, should compare the
+ * serial before drawing and look their glyphs up again if it changed.
+ * Entries used since the last hb_gpu_atlas_clear_dirty() are never
+ * evicted, so looking them up again does not re-encode them.
+ *
+ * Return value: the current serial
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_serial (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->serial;
+}
+
+/**
+ * hb_gpu_atlas_lookup:
+ * @atlas: a GPU glyph atlas
+ * @font: font the glyph was added for
+ * @glyph: glyph ID
+ * @offset: (out) (nullable): where to store the offset of the glyph's
+ *          data, in texels
+ * @extents: (out) (nullable): where to store the extents the glyph
+ *           was added with
+ *
+ * Looks up a glyph, at the current scale, variation coordinates and
+ * synthetic bold and slant of @font, and marks it as used by the
+ * current frame.
+ *
+ * Glyphs with no outline have a length of zero in the atlas; their
+ * offset is 0.
+ *
+ * Return value: `true` if the glyph is in @atlas, `false` otherwise
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_lookup (hb_gpu_atlas_t     *atlas,
+		     hb_font_t          *font,
+		     hb_codepoint_t      glyph,
+		     unsigned int       *offset,
+		     hb_glyph_extents_t *extents)
+{
+  const hb_gpu_atlas_t::entry_t *e = atlas->find (font, glyph);
+  if (!e)
+    return false;
+  if (offset)
+    *offset = e->offset;
+  if (extents)
+    *extents = e->extents;
+  return true;
+}
+
+/**
+ * hb_gpu_atlas_add:
+ * @atlas: a GPU glyph atlas
+ * @font: font the glyph was encoded from
+ * @glyph: glyph ID
+ * @blob: encoded glyph, from hb_gpu_draw_encode() or
+ *        hb_gpu_paint_encode()
+ * @extents: (nullable): extents to store with the glyph
+ * @offset: (out) (nullable): where to store the offset of the glyph's
+ *          data, in texels
+ *
+ * Copies @blob into @atlas for @glyph at the current scale, variation
+ * coordinates and synthetic bold and slant of @font, replacing any
+ * previous entry, and marks the texels written as dirty.  @atlas
+ * keeps a reference on @font while it holds entries for it.
+ *
+ * Return value: `true` if the glyph was added, `false` if it does not
+ * fit even after evicting every entry not used by the current frame,
+ * or on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_add (hb_gpu_atlas_t           *atlas,
+		  hb_font_t                *font,
+		  hb_codepoint_t            glyph,
+		  hb_blob_t                *blob,
+		  const hb_glyph_extents_t *extents,
+		  unsigned int             *offset)
+{
+  return atlas->add (font, glyph, blob, extents, offset);
+}
+
+/**
+ * hb_gpu_atlas_draw_glyph:
+ * @atlas: a GPU glyph atlas
+ * @draw: a GPU shape encoder, used on a miss
+ * @font: font to draw from
+ * @glyph: glyph ID
+ * @offset: (out) (nullable): where to store the offset of the glyph's
+ *          data, in texels
+ * @extents: (out) (nullable): where to store the glyph extents
+ *
+ * Looks @glyph up in @atlas; if it is not there, encodes it with
+ * @draw and adds it.
+ *
+ * Return value: `true` on success, `false` if encoding or adding
+ * failed.
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_draw_glyph (hb_gpu_atlas_t     *atlas,
+			 hb_gpu_draw_t      *draw,
+			 hb_font_t          *font,
+			 hb_codepoint_t      glyph,
+			 unsigned int       *offset,
+			 hb_glyph_extents_t *extents)
+{
+  if (hb_gpu_atlas_lookup (atlas, font, glyph, offset, extents))
+    return true;
+
+  hb_glyph_extents_t ext;
+  hb_gpu_draw_glyph (draw, font, glyph);
+  hb_blob_t *blob = hb_gpu_draw_encode (draw, &ext);
+  if (unlikely (!blob))
+    return false;
+  hb_bool_t ret = atlas->add (font, glyph, blob, &ext, offset);
+  hb_gpu_draw_recycle_blob (draw, blob);
+  if (ret && extents)
+    *extents = ext;
+  return ret;
+}
+
+/**
+ * hb_gpu_atlas_paint_glyph:
+ * @atlas: a GPU glyph atlas
+ * @paint: a GPU color-glyph encoder, used on a miss
+ * @font: font to paint from
+ * @glyph: glyph ID
+ * @offset: (out) (nullable): where to store the offset of the glyph's
+ *          data, in texels
+ * @extents: (out) (nullable): where to store the glyph extents
+ *
+ * Looks @glyph up in @atlas; if it is not there, encodes it with
+ * @paint and adds it.
+ *
+ * Return value: `true` on success, `false` if encoding or adding
+ * failed.
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_paint_glyph (hb_gpu_atlas_t     *atlas,
+			  hb_gpu_paint_t     *paint,
+			  hb_font_t          *font,
+			  hb_codepoint_t      glyph,
+			  unsigned int       *offset,
+			  hb_glyph_extents_t *extents)
+{
+  if (hb_gpu_atlas_lookup (atlas, font, glyph, offset, extents))
+    return true;
+
+  hb_glyph_extents_t ext;
+  hb_gpu_paint_glyph (paint, font, glyph);
+  hb_blob_t *blob = hb_gpu_paint_encode (paint, &ext);
+  if (unlikely (!blob))
+    return false;
+  hb_bool_t ret = atlas->add (font, glyph, blob, &ext, offset);
+  hb_gpu_paint_recycle_blob (paint, blob);
+  if (ret && extents)
+    *extents = ext;
+  return ret;
+}
+
+/**
+ * hb_gpu_atlas_clear:
+ * @atlas: a GPU glyph atlas
+ *
+ * Removes all entries from @atlas and releases the fonts it holds.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_atlas_clear (hb_gpu_atlas_t *atlas)
+{
+  atlas->clear ();
+}
+
+/**
+ * hb_gpu_atlas_get_data:
+ * @atlas: a GPU glyph atlas
+ * @length: (out) (nullable): where to store the length of the data,
+ *          in bytes
+ *
+ * Fetches the texel buffer of @atlas.  Only the part up to the
+ * highest texel written so far is allocated and returned; the rest
+ * of the capacity has never been written.
+ *
+ * Return value: (transfer none) (array length=length):
+ * The texel data, valid until @atlas is next modified.
+ *
+ * XSince: REPLACEME
+ **/
+const char *
+hb_gpu_atlas_get_data (const hb_gpu_atlas_t *atlas,
+		       unsigned int         *length)
+{
+  if (length)
+    *length = atlas->data.length;
+  return atlas->data.arrayZ;
+}
+
+/**
+ * hb_gpu_atlas_get_dirty_ranges:
+ * @atlas: a GPU glyph atlas
+ * @start_offset: index of the first range to retrieve
+ * @range_count: (inout) (nullable): input = the maximum number of
+ *               ranges to return; output = the actual number of
+ *               ranges returned
+ * @ranges: (out) (array length=range_count) (nullable): the ranges
+ *
+ * Fetches the ranges of texels written since the last
+ * hb_gpu_atlas_clear_dirty(), in increasing order.  Uploading these
+ * ranges of hb_gpu_atlas_get_data() brings a GPU copy of the atlas
+ * up to date.
+ *
+ * Return value: the total number of dirty ranges
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_dirty_ranges (const hb_gpu_atlas_t *atlas,
+			       unsigned int          start_offset,
+			       unsigned int         *range_count,
+			       hb_gpu_atlas_range_t *ranges)
+{
+  hb_gpu_atlas_range_t all = {0, atlas->data.length / HB_GPU_ATLAS_TEXEL_SIZE};
+  hb_array_t<const hb_gpu_atlas_range_t> dirty;
+  if (unlikely (atlas->dirty_ranges.in_error ()))
+    dirty = hb_array (&all, all.length ? 1 : 0);
+  else
+    dirty = atlas->dirty_ranges.as_array ();
+
+  if (range_count)
+  {
+    + dirty.sub_array (start_offset, range_count)
+    | hb_sink (hb_array (ranges, *range_count))
+    ;
+  }
+  return dirty.length;
+}
+
+/**
+ * hb_gpu_atlas_clear_dirty:
+ * @atlas: a GPU glyph atlas
+ *
+ * Marks all texels as uploaded, and starts a new frame: entries
+ * looked up or added from now on are protected from eviction until
+ * the next call.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_atlas_clear_dirty (hb_gpu_atlas_t *atlas)
+{
+  atlas->dirty_ranges.reset ();
+  atlas->frame_start = atlas->clock;
+}
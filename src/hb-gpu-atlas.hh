@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_GPU_ATLAS_HH
+#define HB_GPU_ATLAS_HH
+
+#include "hb.hh"
+#include "hb-gpu.h"
+#include "hb-object.hh"
+#include "hb-lru-list.hh"
+#include "hb-map.hh"
+#include "hb-vector.hh"
+
+
+#define HB_GPU_ATLAS_TEXEL_SIZE 8
+
+/* Ranges beyond this many are merged into one. */
+#define HB_GPU_ATLAS_MAX_DIRTY_RANGES 64
+
+struct hb_gpu_atlas_t
+{
+  hb_object_header_t header;
+
+  /* A font at one scale, one set of variation coordinates and one
+   * synthetic bold and slant setting.  Entries refer to it by index; a
+   * slot whose font is nullptr is free. */
+  struct instance_t
+  {
+    hb_font_t *font;	/* Referenced */
+    unsigned serial;	/* hb_font_get_serial() when last matched */
+    int x_scale, y_scale;
+    hb_vector_t<int> coords;
+    float x_embolden, y_embolden;
+    hb_bool_t embolden_in_place;
+    float slant;
+    unsigned entry_count;
+
+    bool matches (hb_font_t *f) const;
+  };
+
+  struct entry_t
+  {
+    uint64_t key;	/* instance << 32 | glyph */
+    unsigned offset;	/* In texels */
+    unsigned length;	/* In texels */
+    hb_glyph_extents_t extents;
+    uint64_t last_use;
+    hb_lru_link_t lru;	/* Only entries with texels are linked */
+  };
+
+  unsigned capacity = 0;	/* In texels */
+  unsigned used = 0;		/* Texels held by entries */
+  unsigned serial = 0;
+
+  hb_vector_t<char> data;	/* Grown up to the highest texel written */
+  hb_vector_t<instance_t> instances;
+  hb_vector_t<entry_t> entries;
+  hb_hashmap_t<uint64_t, unsigned> entry_index;
+  hb_lru_list_t<entry_t> lru;	/* Eviction order */
+  hb_vector_t<hb_gpu_atlas_range_t> free_ranges;	/* Sorted, coalesced */
+  hb_vector_t<hb_gpu_atlas_range_t> dirty_ranges;	/* Sorted, coalesced */
+
+  /* Entries used after frame_start are in use by the current frame
+   * and are not evicted. */
+  uint64_t clock = 0;
+  uint64_t frame_start = 0;
+
+  /* Last instance looked up. */
+  hb_font_t *last_font = nullptr;
+  unsigned last_instance = 0;
+
+  HB_INTERNAL void init (unsigned capacity);
+  HB_INTERNAL void fini ();
+  HB_INTERNAL void clear ();
+
+  HB_INTERNAL bool find_instance (hb_font_t *font, bool create, unsigned *index);
+  HB_INTERNAL entry_t *find (hb_font_t *font, hb_codepoint_t glyph);
+  HB_INTERNAL bool add (hb_font_t *font, hb_codepoint_t glyph,
+			hb_blob_t *blob, const hb_glyph_extents_t *extents,
+			unsigned *offset);
+
+  private:
+  bool allocate (unsigned length, unsigned *offset);
+  bool take_free (unsigned length, unsigned *offset);
+  void release (unsigned offset, unsigned length);
+  bool evict_one ();
+  void remove_entry (unsigned i);
+  void release_instance (unsigned instance);
+  void compact ();
+  void mark_dirty (unsigned offset, unsigned length);
+};
+
+
+#endif /* HB_GPU_ATLAS_HH */
@@ -353,6 +353,136 @@ encode_curve_info (const hb_gpu_curve_t *c)
   return info;
 }
 
+/* The shader recomputes the band index from the fragment position in
+ * float32, this code does it in double.  Widen the band range of each
+ * curve by a hair so the two cannot disagree at a band boundary. */
+static const double BAND_EPSILON = 1.0 / 1024;
+
+static inline void
+band_range (double lo, double hi,
+	    double origin, double band_size, unsigned num_bands,
+	    int *band_lo, int *band_hi)
+{
+  *band_lo = (int) floor ((lo - origin) / band_size - BAND_EPSILON);
+  *band_hi = (int) floor ((hi - origin) / band_size + BAND_EPSILON);
+  *band_lo = hb_max (*band_lo, 0);
+  *band_hi = hb_min (*band_hi, (int) num_bands - 1);
+}
+
+/* For every band count 1..max_bands along one axis, compute the
+ * largest per-band curve count and the total number of band entries
+ * (which is what the band index lists cost in texels, per sort
+ * order).  Mirrors the band assignment in hb_gpu_draw_encode(). */
+static void
+measure_band_axis (const hb_gpu_encode_curve_info_t *infos,
+		   unsigned num_curves,
+		   bool vertical,
+		   double origin, double extent,
+		   unsigned max_bands,
+		   unsigned *max_count,
+		   unsigned *total)
+{
+  for (unsigned n = 1; n <= max_bands; n++)
+  {
+    int diff[HB_GPU_DRAW_MAX_BANDS + 1] = {};
+    double band_size = extent / n;
+    unsigned sum = 0;
+
+    for (unsigned i = 0; i < num_curves; i++)
+    {
+      const hb_gpu_encode_curve_info_t &info = infos[i];
+      if (vertical ? info.is_vertical : info.is_horizontal)
+	continue;
+
+      int lo = 0, hi = 0;
+      if (extent > 0)
+      {
+	if (vertical)
+	  band_range (info.min_x, info.max_x, origin, band_size, n, &lo, &hi);
+	else
+	  band_range (info.min_y, info.max_y, origin, band_size, n, &lo, &hi);
+      }
+      if (hi < lo)
+	continue;
+
+      diff[lo]++;
+      diff[hi + 1]--;
+      sum += hi - lo + 1;
+    }
+
+    int running = 0;
+    unsigned worst = 0;
+    for (unsigned b = 0; b < n; b++)
+    {
+      running += diff[b];
+      worst = hb_max (worst, (unsigned) running);
+    }
+
+    max_count[n] = worst;
+    total[n] = sum;
+  }
+}
+
+/* Pick the band counts that minimize the worst-case number of curves
+ * a fragment has to visit (one horizontal plus one vertical band),
+ * subject to the encoded length staying within @budget texels.  Ties
+ * go to the smaller encoding.  If nothing fits, the smallest encoding
+ * wins. */
+static void
+choose_band_counts (const hb_gpu_encode_curve_info_t *infos,
+		    unsigned num_curves,
+		    double min_x, double min_y,
+		    double width, double height,
+		    unsigned fixed_len,
+		    unsigned budget,
+		    unsigned *num_hbands,
+		    unsigned *num_vbands)
+{
+  unsigned max_bands = hb_min (num_curves, (unsigned) HB_GPU_DRAW_MAX_BANDS);
+  unsigned max_hbands = height > 0 ? max_bands : 1;
+  unsigned max_vbands = width  > 0 ? max_bands : 1;
+
+  unsigned hmax[HB_GPU_DRAW_MAX_BANDS + 1], htotal[HB_GPU_DRAW_MAX_BANDS + 1];
+  unsigned vmax[HB_GPU_DRAW_MAX_BANDS + 1], vtotal[HB_GPU_DRAW_MAX_BANDS + 1];
+  measure_band_axis (infos, num_curves, false, min_y, height, max_hbands, hmax, htotal);
+  measure_band_axis (infos, num_curves, true,  min_x, width,  max_vbands, vmax, vtotal);
+
+  unsigned limit = hb_min (budget, (unsigned) UINT16_MAX + 1u);
+
+  unsigned best_h = 1, best_v = 1;
+  bool best_fits = false;
+  unsigned best_work = (unsigned) -1;
+  unsigned best_len = (unsigned) -1;
+
+  for (unsigned nh = 1; nh <= max_hbands; nh++)
+    for (unsigned nv = 1; nv <= max_vbands; nv++)
+    {
+      unsigned len = fixed_len + nh + nv + 2 * (htotal[nh] + vtotal[nv]);
+      unsigned work = hmax[nh] + vmax[nv];
+      bool fits = len <= limit;
+
+      bool better;
+      if (fits != best_fits)
+	better = fits;
+      else if (fits)
+	better = work < best_work || (work == best_work && len < best_len);
+      else
+	better = len < best_len;
+
+      if (better)
+      {
+	best_h = nh;
+	best_v = nv;
+	best_fits = fits;
+	best_work = work;
+	best_len = len;
+      }
+    }
+
+  *num_hbands = best_h;
+  *num_vbands = best_v;
+}
+
 static void
 _hb_gpu_draw_get_extents (hb_gpu_draw_t      *draw,
 			  hb_glyph_extents_t *extents)
@@ -416,6 +546,10 @@ _hb_gpu_draw_get_extents (hb_gpu_draw_t      *draw,
  * callers can distinguish "nothing to render" (length 0) from a
  * real failure (`NULL`).
  *
+ * The band layout used for the blob is described by
+ * hb_gpu_draw_get_encode_stats(); see hb_gpu_draw_set_texel_budget()
+ * for how it is chosen.
+ *
  * Since: 14.0.0
  **/
 hb_blob_t *
@@ -426,6 +560,7 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
   if (extents)
     _hb_gpu_draw_get_extents (draw, extents);
   HB_SCOPE_GUARD (hb_gpu_draw_clear (draw));
+  draw->stats = {};
 
   if (unlikely (!draw->success))
     return nullptr;
@@ -478,26 +613,47 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
   for (unsigned i = 0; i < num_curves; i++)
     s.curve_infos.arrayZ[i] = encode_curve_info (&curves[i]);
 
-  /* Choose number of bands (capped at 16 per Slug paper) */
-  unsigned num_hbands = hb_min (num_curves, 16u);
-  unsigned num_vbands = hb_min (num_curves, 16u);
-  num_hbands = hb_max (num_hbands, 1u);
-  num_vbands = hb_max (num_vbands, 1u);
+  unsigned header_len = 2;
+
+  unsigned num_contour_breaks = 0;
+  for (unsigned i = 0; i + 1 < num_curves; i++)
+    if (curves[i + 1].contour_start)
+      num_contour_breaks++;
+
+  unsigned curve_data_len;
+  if (unlikely (hb_unsigned_add_overflows (num_curves,
+					   num_contour_breaks,
+					   &curve_data_len) ||
+		hb_unsigned_add_overflows (curve_data_len,
+					   1,
+					   &curve_data_len)))
+    return nullptr;
 
   double height = max_y - min_y;
   double width  = max_x - min_x;
 
-  if (height <= 0) num_hbands = 1;
-  if (width  <= 0) num_vbands = 1;
+  unsigned num_hbands, num_vbands;
+  if (draw->texel_budget)
+    choose_band_counts (s.curve_infos.arrayZ, num_curves,
+			min_x, min_y, width, height,
+			header_len + curve_data_len,
+			draw->texel_budget,
+			&num_hbands, &num_vbands);
+  else
+  {
+    /* Choose number of bands (capped at 16 per Slug paper) */
+    num_hbands = hb_min (num_curves, 16u);
+    num_vbands = hb_min (num_curves, 16u);
+    num_hbands = hb_max (num_hbands, 1u);
+    num_vbands = hb_max (num_vbands, 1u);
+
+    if (height <= 0) num_hbands = 1;
+    if (width  <= 0) num_vbands = 1;
+  }
 
   double hband_size = height / num_hbands;
   double vband_size = width  / num_vbands;
 
-  /* The shader recomputes the band index from the fragment position in
-   * float32, this code does it in double.  Widen the band range of each
-   * curve by a hair so the two cannot disagree at a band boundary. */
-  static const double BAND_EPSILON = 1.0 / 1024;
-
   if (unlikely (!s.hband_curve_counts.resize (num_hbands) ||
 		!s.vband_curve_counts.resize (num_vbands)))
     return nullptr;
@@ -512,10 +668,8 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
     if (!info.is_horizontal)
     {
       if (height > 0) {
-	info.hband_lo = (int) floor ((info.min_y - min_y) / hband_size - BAND_EPSILON);
-	info.hband_hi = (int) floor ((info.max_y - min_y) / hband_size + BAND_EPSILON);
-	info.hband_lo = hb_max (info.hband_lo, 0);
-	info.hband_hi = hb_min (info.hband_hi, (int) num_hbands - 1);
+	band_range (info.min_y, info.max_y, min_y, hband_size, num_hbands,
+		    &info.hband_lo, &info.hband_hi);
 	for (int b = info.hband_lo; b <= info.hband_hi; b++)
 	  s.hband_curve_counts.arrayZ[b]++;
       } else {
@@ -528,10 +682,8 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
     if (!info.is_vertical)
     {
       if (width > 0) {
-	info.vband_lo = (int) floor ((info.min_x - min_x) / vband_size - BAND_EPSILON);
-	info.vband_hi = (int) floor ((info.max_x - min_x) / vband_size + BAND_EPSILON);
-	info.vband_lo = hb_max (info.vband_lo, 0);
-	info.vband_hi = hb_min (info.vband_hi, (int) num_vbands - 1);
+	band_range (info.min_x, info.max_x, min_x, vband_size, num_vbands,
+		    &info.vband_lo, &info.vband_hi);
 	for (int b = info.vband_lo; b <= info.vband_hi; b++)
 	  s.vband_curve_counts.arrayZ[b]++;
       } else {
@@ -639,22 +791,6 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
 					   &total_curve_indices)))
     return nullptr;
 
-  unsigned header_len = 2;
-
-  unsigned num_contour_breaks = 0;
-  for (unsigned i = 0; i + 1 < num_curves; i++)
-    if (curves[i + 1].contour_start)
-      num_contour_breaks++;
-
-  unsigned curve_data_len;
-  if (unlikely (hb_unsigned_add_overflows (num_curves,
-					   num_contour_breaks,
-					   &curve_data_len) ||
-		hb_unsigned_add_overflows (curve_data_len,
-					   1,
-					   &curve_data_len)))
-    return nullptr;
-
   unsigned band_headers_len;
   if (unlikely (hb_unsigned_add_overflows (num_hbands,
 					   num_vbands,
@@ -856,10 +992,24 @@ hb_gpu_draw_encode (hb_gpu_draw_t      *draw,
     buf[hdr].a = vband_split;
   }
 
+  hb_gpu_draw_encode_stats_t &stats = draw->stats;
+  stats.num_hbands = num_hbands;
+  stats.num_vbands = num_vbands;
+  for (unsigned b = 0; b < num_hbands; b++)
+    stats.max_hband_curves = hb_max (stats.max_hband_curves, s.hband_curve_counts.arrayZ[b]);
+  for (unsigned b = 0; b < num_vbands; b++)
+    stats.max_vband_curves = hb_max (stats.max_vband_curves, s.vband_curve_counts.arrayZ[b]);
+  stats.mean_hband_curves = (float) total_hband_indices / num_hbands;
+  stats.mean_vband_curves = (float) total_vband_indices / num_vbands;
+  stats.texel_count = total_len;
+
   hb_blob_t *recycled = draw->recycled_blob;
   draw->recycled_blob = nullptr;
-  return hb_blob_t::recycle_finalize ((char *) buf, buf_capacity, needed_bytes,
-				recycled, replaced_recycled_buf);
+  hb_blob_t *blob = hb_blob_t::recycle_finalize ((char *) buf, buf_capacity, needed_bytes,
+						 recycled, replaced_recycled_buf);
+  if (unlikely (!blob))
+    stats = {};
+  return blob;
 }
 
 
@@ -1114,6 +1264,7 @@ hb_gpu_draw_reset (hb_gpu_draw_t *draw)
 {
   draw->x_scale = 0;
   draw->y_scale = 0;
+  draw->texel_budget = 0;
   hb_gpu_draw_clear (draw);
 }
 
@@ -1138,6 +1289,71 @@ hb_gpu_draw_recycle_blob (hb_gpu_draw_t *draw,
   hb_blob_t::recycle_stash (&draw->recycled_blob, blob);
 }
 
+/**
+ * hb_gpu_draw_set_texel_budget:
+ * @draw: a GPU shape encoder
+ * @texel_budget: maximum encoded size in texels, or 0
+ *
+ * Selects how hb_gpu_draw_encode() lays out bands.
+ *
+ * With a budget of 0 (the default), every glyph gets the same
+ * number of horizontal and vertical bands, up to 16.  That is
+ * cheap to compute but leaves dense glyphs (CJK ideographs,
+ * Nastaliq ligatures) with bands holding many curves, which is
+ * what the fragment shader pays for per pixel.
+ *
+ * With a non-zero budget, the horizontal and vertical band counts
+ * are chosen independently per glyph, up to 32 each, to minimize
+ * the largest number of curves a pixel has to visit while keeping
+ * the encoded blob within @texel_budget texels.  If no layout
+ * fits, the smallest one is used.  This makes encoding slower.
+ *
+ * The blob format is unchanged either way; shaders need no
+ * adjustment.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_draw_set_texel_budget (hb_gpu_draw_t *draw,
+			      unsigned int   texel_budget)
+{
+  draw->texel_budget = texel_budget;
+}
+
+/**
+ * hb_gpu_draw_get_texel_budget:
+ * @draw: a GPU shape encoder
+ *
+ * Fetches the texel budget set by hb_gpu_draw_set_texel_budget().
+ *
+ * Return value: the texel budget, or 0 for the fixed band layout
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_draw_get_texel_budget (const hb_gpu_draw_t *draw)
+{
+  return draw->texel_budget;
+}
+
+/**
+ * hb_gpu_draw_get_encode_stats:
+ * @draw: a GPU shape encoder
+ * @stats: (out): where to store the statistics
+ *
+ * Fetches band statistics for the blob returned by the most recent
+ * hb_gpu_draw_encode() call on @draw.  If that call failed or
+ * returned an empty blob, all fields are zero.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_draw_get_encode_stats (const hb_gpu_draw_t        *draw,
+			      hb_gpu_draw_encode_stats_t *stats)
+{
+  *stats = draw->stats;
+}
+
 
 #include "hb-gpu-draw-fragment-glsl.hh"
 #include "hb-gpu-draw-fragment-msl.hh"
@@ -110,6 +110,13 @@ struct hb_gpu_draw_t
   int x_scale = 0;
   int y_scale = 0;
 
+  /* Texel budget for adaptive band layout; 0 means the fixed layout.
+   * Set by hb_gpu_draw_set_texel_budget(). */
+  unsigned texel_budget = 0;
+
+  /* Band statistics of the last encode. */
+  hb_gpu_draw_encode_stats_t stats = {};
+
   /* Encode scratch (reused across calls) */
   hb_gpu_encode_scratch_t scratch;
 
@@ -0,0 +1,514 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb.hh"
+
+#include "hb-gpu-glyphs.hh"
+#include "hb-sanitize.hh"
+
+
+static inline unsigned
+_hb_gpu_glyphs_host_flags ()
+{
+  const uint16_t one = 1;
+  return *(const char *) &one ? 0 : HB_GPU_GLYPHS_FLAG_BIG_ENDIAN;
+}
+
+
+/* Internal methods */
+
+bool
+hb_gpu_glyphs_t::get_glyph (hb_codepoint_t glyph, glyph_t *out) const
+{
+  if (unlikely (glyph >= glyph_count))
+    return false;
+
+  if (table)
+  {
+    const OT::GPUGlyphRecord &r = table->records.arrayZ[glyph];
+    out->offset = r.offset;
+    out->length = r.length;
+    out->extents.x_bearing = r.xBearing;
+    out->extents.y_bearing = r.yBearing;
+    out->extents.width = r.width;
+    out->extents.height = r.height;
+    return true;
+  }
+
+  *out = glyphs.arrayZ[glyph];
+  return true;
+}
+
+const char *
+hb_gpu_glyphs_t::get_data (unsigned *length) const
+{
+  if (table)
+  {
+    *length = table->texelCount * HB_GPU_GLYPHS_TEXEL_SIZE;
+    return table->get_data ();
+  }
+  *length = data.length;
+  return data.arrayZ;
+}
+
+bool
+hb_gpu_glyphs_t::set_glyph (hb_codepoint_t glyph,
+			    hb_blob_t *blob,
+			    const hb_glyph_extents_t *extents)
+{
+  unsigned bytes = hb_blob_get_length (blob);
+  if (unlikely (glyph >= glyph_count ||
+		bytes % HB_GPU_GLYPHS_TEXEL_SIZE))
+    return false;
+
+  unsigned offset = data.length / HB_GPU_GLYPHS_TEXEL_SIZE;
+  unsigned length = bytes / HB_GPU_GLYPHS_TEXEL_SIZE;
+  if (unlikely (offset + length < offset ||
+		offset + length > UINT_MAX / HB_GPU_GLYPHS_TEXEL_SIZE ||
+		!data.resize_dirty (data.length + bytes)))
+    return false;
+  if (bytes)
+    hb_memcpy (data.arrayZ + offset * HB_GPU_GLYPHS_TEXEL_SIZE,
+	       hb_blob_get_data (blob, nullptr), bytes);
+
+  /* Replaced data is left behind; serialize() drops it. */
+  glyph_t &g = glyphs.arrayZ[glyph];
+  g.offset = length ? offset : 0;
+  g.length = length;
+  g.extents = extents ? *extents : hb_glyph_extents_t {};
+  return true;
+}
+
+/* Lays out glyph data in glyph order, storing identical glyphs once. */
+hb_blob_t *
+hb_gpu_glyphs_t::serialize () const
+{
+  if (blob)
+    return hb_blob_reference (blob);
+
+  hb_vector_t<unsigned> offsets;
+  hb_hashmap_t<uint32_t, hb_codepoint_t> seen;
+  if (unlikely (!offsets.resize_dirty (glyph_count)))
+    return nullptr;
+
+  unsigned texel_count = 0;
+  for (unsigned i = 0; i < glyph_count; i++)
+  {
+    const glyph_t &g = glyphs.arrayZ[i];
+    offsets.arrayZ[i] = texel_count;
+    if (!g.length)
+      continue;
+
+    hb_bytes_t bytes (data.arrayZ + g.offset * HB_GPU_GLYPHS_TEXEL_SIZE,
+		      g.length * HB_GPU_GLYPHS_TEXEL_SIZE);
+    uint32_t hash = bytes.hash ();
+    hb_codepoint_t *other;
+    if (seen.has (hash, &other))
+    {
+      const glyph_t &o = glyphs.arrayZ[*other];
+      if (o.length == g.length &&
+	  !hb_memcmp (data.arrayZ + o.offset * HB_GPU_GLYPHS_TEXEL_SIZE,
+		      bytes.arrayZ, bytes.length))
+      {
+	offsets.arrayZ[i] = offsets.arrayZ[*other];
+	continue;
+      }
+    }
+    else
+      seen.set (hash, i);
+
+    texel_count += g.length;
+  }
+
+  size_t header_size = OT::GPUGlyphs::min_size +
+		       (size_t) glyph_count * OT::GPUGlyphRecord::static_size;
+  size_t total = header_size + (size_t) texel_count * HB_GPU_GLYPHS_TEXEL_SIZE;
+  if (unlikely (seen.in_error () || total > UINT_MAX))
+    return nullptr;
+
+  char *buf = (char *) hb_calloc (total, 1);
+  if (unlikely (!buf))
+    return nullptr;
+
+  OT::GPUGlyphs *t = (OT::GPUGlyphs *) buf;
+  t->tag = HB_GPU_GLYPHS_TAG;
+  t->version.major = 1;
+  t->version.minor = 0;
+  t->flags = _hb_gpu_glyphs_host_flags ();
+  t->glyphCount = glyph_count;
+  t->texelCount = texel_count;
+
+  char *out = buf + header_size;
+  unsigned cursor = 0;
+  for (unsigned i = 0; i < glyph_count; i++)
+  {
+    const glyph_t &g = glyphs.arrayZ[i];
+    OT::GPUGlyphRecord &r = t->records.arrayZ[i];
+    r.offset = g.length ? offsets.arrayZ[i] : 0;
+    r.length = g.length;
+    r.xBearing = g.extents.x_bearing;
+    r.yBearing = g.extents.y_bearing;
+    r.width = g.extents.width;
+    r.height = g.extents.height;
+
+    /* Duplicates point back at data already written. */
+    if (g.length && offsets.arrayZ[i] == cursor)
+    {
+      hb_memcpy (out + cursor * HB_GPU_GLYPHS_TEXEL_SIZE,
+		 data.arrayZ + g.offset * HB_GPU_GLYPHS_TEXEL_SIZE,
+		 g.length * HB_GPU_GLYPHS_TEXEL_SIZE);
+      cursor += g.length;
+    }
+  }
+
+  return hb_blob_create (buf, total, HB_MEMORY_MODE_WRITABLE, buf, hb_free);
+}
+
+
+/* ---- Public API ---- */
+
+/**
+ * hb_gpu_glyphs_create_or_fail:
+ * @glyph_count: number of glyphs
+ *
+ * Creates an empty set of encoded glyphs, to be filled with
+ * hb_gpu_glyphs_set_glyph() and saved with
+ * hb_gpu_glyphs_serialize().
+ *
+ * This is how a font's encoded form is built once, e.g. offline, and
+ * then loaded at startup with hb_gpu_glyphs_create_for_blob_or_fail()
+ * without encoding anything again.  Encoding can be spread over
+ * threads by giving each its own #hb_gpu_draw_t or #hb_gpu_paint_t,
+ * and adding the results here under a lock.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_gpu_glyphs_t, or `NULL` on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_gpu_glyphs_t *
+hb_gpu_glyphs_create_or_fail (unsigned int glyph_count)
+{
+  hb_gpu_glyphs_t *glyphs = hb_object_create<hb_gpu_glyphs_t> ();
+  if (unlikely (!glyphs))
+    return nullptr;
+
+  glyphs->glyph_count = glyph_count;
+  if (unlikely (!glyphs->glyphs.resize (glyph_count)))
+  {
+    hb_gpu_glyphs_destroy (glyphs);
+    return nullptr;
+  }
+  return glyphs;
+}
+
+/**
+ * hb_gpu_glyphs_create_for_blob_or_fail:
+ * @blob: data from hb_gpu_glyphs_serialize()
+ *
+ * Loads encoded glyphs serialized with hb_gpu_glyphs_serialize().
+ * Nothing is copied: glyph data is read from @blob in place, so a
+ * blob from hb_blob_create_from_file() is used straight from the
+ * memory-mapped file.
+ *
+ * Serialized glyphs are only valid for the byte order of the machine
+ * that encoded them; blobs from a machine of the other byte order are
+ * rejected.
+ *
+ * The returned object is immutable.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_gpu_glyphs_t, or `NULL` if @blob is not
+ * valid or on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_gpu_glyphs_t *
+hb_gpu_glyphs_create_for_blob_or_fail (hb_blob_t *blob)
+{
+  blob = hb_sanitize_context_t ().sanitize_blob<OT::GPUGlyphs> (hb_blob_reference (blob));
+  const OT::GPUGlyphs *table = blob->as<OT::GPUGlyphs> ();
+  if (unlikely (!blob->length ||
+		(table->flags & HB_GPU_GLYPHS_FLAG_BIG_ENDIAN) != _hb_gpu_glyphs_host_flags ()))
+  {
+    hb_blob_destroy (blob);
+    return nullptr;
+  }
+
+  hb_gpu_glyphs_t *glyphs = hb_object_create<hb_gpu_glyphs_t> ();
+  if (unlikely (!glyphs))
+  {
+    hb_blob_destroy (blob);
+    return nullptr;
+  }
+
+  glyphs->blob = blob;
+  glyphs->table = table;
+  glyphs->glyph_count = table->glyphCount;
+  hb_object_make_immutable (glyphs);
+  return glyphs;
+}
+
+/**
+ * hb_gpu_glyphs_reference: (skip)
+ * @glyphs: a set of encoded glyphs
+ *
+ * Increases the reference count on @glyphs by one.
+ *
+ * Return value: (transfer full):
+ * The referenced #hb_gpu_glyphs_t.
+ *
+ * XSince: REPLACEME
+ **/
+hb_gpu_glyphs_t *
+hb_gpu_glyphs_reference (hb_gpu_glyphs_t *glyphs)
+{
+  return hb_object_reference (glyphs);
+}
+
+/**
+ * hb_gpu_glyphs_destroy: (skip)
+ * @glyphs: a set of encoded glyphs
+ *
+ * Decreases the reference count on @glyphs by one. When the
+ * reference count reaches zero, @glyphs is freed.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_gpu_glyphs_destroy (hb_gpu_glyphs_t *glyphs)
+{
+  if (!hb_object_should_destroy (glyphs))
+    return;
+
+  hb_blob_destroy (glyphs->blob);
+
+  hb_object_actually_destroy (glyphs);
+  hb_free (glyphs);
+}
+
+/**
+ * hb_gpu_glyphs_set_user_data: (skip)
+ * @glyphs: a set of encoded glyphs
+ * @key: the user-data key
+ * @data: a pointer to the user data
+ * @destroy: (nullable): a callback to call when @data is not needed anymore
+ * @replace: whether to replace an existing data with the same key
+ *
+ * Attaches user data to @glyphs.
+ *
+ * Return value: `true` if success, `false` otherwise
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_glyphs_set_user_data (hb_gpu_glyphs_t    *glyphs,
+			     hb_user_data_key_t *key,
+			     void               *data,
+			     hb_destroy_func_t   destroy,
+			     hb_bool_t           replace)
+{
+  return hb_object_set_user_data (glyphs, key, data, destroy, replace);
+}
+
+/**
+ * hb_gpu_glyphs_get_user_data: (skip)
+ * @glyphs: a set of encoded glyphs
+ * @key: the user-data key
+ *
+ * Fetches the user-data associated with the specified key.
+ *
+ * Return value: (transfer none):
+ * A pointer to the user data
+ *
+ * XSince: REPLACEME
+ **/
+void *
+hb_gpu_glyphs_get_user_data (const hb_gpu_glyphs_t *glyphs,
+			     hb_user_data_key_t    *key)
+{
+  return hb_object_get_user_data (glyphs, key);
+}
+
+/**
+ * hb_gpu_glyphs_get_glyph_count:
+ * @glyphs: a set of encoded glyphs
+ *
+ * Fetches the number of glyphs @glyphs has room for.
+ *
+ * Return value: the glyph count
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_gpu_glyphs_get_glyph_count (const hb_gpu_glyphs_t *glyphs)
+{
+  return glyphs->glyph_count;
+}
+
+/**
+ * hb_gpu_glyphs_set_glyph:
+ * @glyphs: a set of encoded glyphs
+ * @glyph: glyph ID
+ * @blob: encoded glyph, from hb_gpu_draw_encode() or
+ *        hb_gpu_paint_encode()
+ * @extents: (nullable): extents to store with the glyph
+ *
+ * Copies @blob into @glyphs as the encoding of @glyph, replacing any
+ * previous one.  Glyphs never set are empty.
+ *
+ * All glyphs in one set should come from the same kind of encoder,
+ * as nothing records which produced them.
+ *
+ * Return value: `true` on success, `false` if @glyphs is immutable,
+ * @glyph is out of range, @blob is not a whole number of texels, or
+ * on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_glyphs_set_glyph (hb_gpu_glyphs_t          *glyphs,
+			 hb_codepoint_t            glyph,
+			 hb_blob_t                *blob,
+			 const hb_glyph_extents_t *extents)
+{
+  if (hb_object_is_immutable (glyphs))
+    return false;
+  return glyphs->set_glyph (glyph, blob, extents);
+}
+
+/**
+ * hb_gpu_glyphs_get_glyph:
+ * @glyphs: a set of encoded glyphs
+ * @glyph: glyph ID
+ * @offset: (out) (nullable): where to store the offset of the glyph's
+ *          data within hb_gpu_glyphs_get_data(), in texels
+ * @length: (out) (nullable): where to store the length of the glyph's
+ *          data, in texels; 0 for empty glyphs
+ * @extents: (out) (nullable): where to store the glyph extents
+ *
+ * Fetches where @glyph lives in the texel data of @glyphs.
+ *
+ * Return value: `true` if @glyph is in range, `false` otherwise
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_glyphs_get_glyph (const hb_gpu_glyphs_t *glyphs,
+			 hb_codepoint_t         glyph,
+			 unsigned int          *offset,
+			 unsigned int          *length,
+			 hb_glyph_extents_t    *extents)
+{
+  hb_gpu_glyphs_t::glyph_t g;
+  if (!glyphs->get_glyph (glyph, &g))
+    return false;
+  if (offset)
+    *offset = g.offset;
+  if (length)
+    *length = g.length;
+  if (extents)
+    *extents = g.extents;
+  return true;
+}
+
+/**
+ * hb_gpu_glyphs_get_data:
+ * @glyphs: a set of encoded glyphs
+ * @length: (out) (nullable): where to store the length of the data,
+ *          in bytes
+ *
+ * Fetches the texel data of all glyphs in @glyphs.  Uploading it as
+ * one GPU buffer makes the offsets from hb_gpu_glyphs_get_glyph()
+ * usable as they are.
+ *
+ * Return value: (transfer none) (array length=length):
+ * The texel data, valid until @glyphs is next modified.
+ *
+ * XSince: REPLACEME
+ **/
+const char *
+hb_gpu_glyphs_get_data (const hb_gpu_glyphs_t *glyphs,
+			unsigned int          *length)
+{
+  unsigned len;
+  const char *data = glyphs->get_data (&len);
+  if (length)
+    *length = len;
+  return data;
+}
+
+/**
+ * hb_gpu_glyphs_reference_glyph_blob:
+ * @glyphs: a set of encoded glyphs
+ * @glyph: glyph ID
+ *
+ * Fetches the encoding of @glyph as a blob, e.g. to pass to
+ * hb_gpu_atlas_add().  For loaded glyphs this is a sub-blob of the
+ * serialized data, and copies nothing.
+ *
+ * Return value: (transfer full):
+ * The glyph's encoding, or the empty blob if @glyph is empty or out
+ * of range.
+ *
+ * XSince: REPLACEME
+ **/
+hb_blob_t *
+hb_gpu_glyphs_reference_glyph_blob (const hb_gpu_glyphs_t *glyphs,
+				    hb_codepoint_t         glyph)
+{
+  hb_gpu_glyphs_t::glyph_t g;
+  if (!glyphs->get_glyph (glyph, &g) || !g.length)
+    return hb_blob_get_empty ();
+
+  unsigned offset = g.offset * HB_GPU_GLYPHS_TEXEL_SIZE;
+  unsigned length = g.length * HB_GPU_GLYPHS_TEXEL_SIZE;
+  if (glyphs->table)
+    return hb_blob_create_sub_blob (glyphs->blob,
+				    glyphs->table->get_data () - glyphs->blob->data + offset,
+				    length);
+  return hb_blob_create (glyphs->data.arrayZ + offset, length,
+			 HB_MEMORY_MODE_DUPLICATE, nullptr, nullptr);
+}
+
+/**
+ * hb_gpu_glyphs_serialize:
+ * @glyphs: a set of encoded glyphs
+ *
+ * Serializes @glyphs into a compact container that
+ * hb_gpu_glyphs_create_for_blob_or_fail() loads.  Glyph data is laid
+ * out in glyph order, and identical glyphs are stored once.
+ *
+ * Return value: (transfer full):
+ * The serialized data, or `NULL` on allocation failure.
+ *
+ * XSince: REPLACEME
+ **/
+hb_blob_t *
+hb_gpu_glyphs_serialize (hb_gpu_glyphs_t *glyphs)
+{
+  return glyphs->serialize ();
+}
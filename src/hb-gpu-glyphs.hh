@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_GPU_GLYPHS_HH
+#define HB_GPU_GLYPHS_HH
+
+#include "hb.hh"
+#include "hb-gpu.h"
+#include "hb-object.hh"
+#include "hb-open-type.hh"
+#include "hb-vector.hh"
+
+
+#define HB_GPU_GLYPHS_TEXEL_SIZE 8
+
+#define HB_GPU_GLYPHS_TAG HB_TAG ('h','b','g','g')
+
+/* Texel data is in the byte order of the host that encoded it. */
+#define HB_GPU_GLYPHS_FLAG_BIG_ENDIAN 0x0001u
+
+
+/*
+ * Serialized container:
+ *
+ *   header (24 bytes)
+ *   glyphCount records (24 bytes each)
+ *   texelCount texels (8 bytes each)
+ *
+ * Both header and records are multiples of 8 bytes, so the texel data
+ * stays texel-aligned relative to the start of the blob, and can be
+ * uploaded as-is; record offsets index into it directly.
+ */
+
+namespace OT {
+
+struct GPUGlyphRecord
+{
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (c->check_struct (this));
+  }
+
+  HBUINT32	offset;		/* Into texel data, in texels. */
+  HBUINT32	length;		/* In texels; 0 for empty glyphs. */
+  HBINT32	xBearing;
+  HBINT32	yBearing;
+  HBINT32	width;
+  HBINT32	height;
+  public:
+  DEFINE_SIZE_STATIC (24);
+};
+
+struct GPUGlyphs
+{
+  const char *get_data () const
+  { return (const char *) (records.arrayZ + glyphCount); }
+
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    if (unlikely (!(c->check_struct (this) &&
+		    tag == HB_GPU_GLYPHS_TAG &&
+		    version.major == 1 &&
+		    records.sanitize_shallow (c, glyphCount) &&
+		    c->check_range (get_data (), texelCount, HB_GPU_GLYPHS_TEXEL_SIZE))))
+      return_trace (false);
+
+    for (unsigned i = 0; i < glyphCount; i++)
+    {
+      const GPUGlyphRecord &r = records.arrayZ[i];
+      if (unlikely ((uint64_t) r.offset + r.length > texelCount))
+	return_trace (false);
+    }
+    return_trace (true);
+  }
+
+  Tag		tag;		/* 'hbgg' */
+  FixedVersion<>version;	/* 1.0 */
+  HBUINT32	flags;		/* HB_GPU_GLYPHS_FLAG_* */
+  HBUINT32	glyphCount;
+  HBUINT32	texelCount;
+  HBUINT32	reserved;	/* Set to 0. */
+  UnsizedArrayOf<GPUGlyphRecord>
+		records;	/* [glyphCount] */
+  public:
+  DEFINE_SIZE_ARRAY (24, records);
+};
+
+} /* namespace OT */
+
+
+struct hb_gpu_glyphs_t
+{
+  hb_object_header_t header;
+
+  struct glyph_t
+  {
+    unsigned offset;	/* In texels */
+    unsigned length;	/* In texels */
+    hb_glyph_extents_t extents;
+  };
+
+  unsigned glyph_count = 0;
+
+  /* Loaded from a serialized container. */
+  hb_blob_t *blob = nullptr;
+  const OT::GPUGlyphs *table = nullptr;
+
+  /* Being built; glyphs refer into data. */
+  hb_vector_t<glyph_t> glyphs;
+  hb_vector_t<char> data;
+
+  HB_INTERNAL bool get_glyph (hb_codepoint_t glyph, glyph_t *out) const;
+  HB_INTERNAL const char *get_data (unsigned *length) const;
+  HB_INTERNAL bool set_glyph (hb_codepoint_t glyph,
+			      hb_blob_t *blob,
+			      const hb_glyph_extents_t *extents);
+  HB_INTERNAL hb_blob_t *serialize () const;
+};
+
+
+#endif /* HB_GPU_GLYPHS_HH */
@@ -176,6 +176,53 @@ HB_EXTERN void
 hb_gpu_draw_recycle_blob (hb_gpu_draw_t *draw,
 			    hb_blob_t      *blob);
 
+/* Band layout */
+
+HB_EXTERN void
+hb_gpu_draw_set_texel_budget (hb_gpu_draw_t *draw,
+			      unsigned int   texel_budget);
+
+HB_EXTERN unsigned int
+hb_gpu_draw_get_texel_budget (const hb_gpu_draw_t *draw);
+
+/**
+ * hb_gpu_draw_encode_stats_t:
+ * @num_hbands: number of horizontal bands
+ * @num_vbands: number of vertical bands
+ * @max_hband_curves: largest number of curves in any horizontal band
+ * @max_vband_curves: largest number of curves in any vertical band
+ * @mean_hband_curves: average number of curves per horizontal band
+ * @mean_vband_curves: average number of curves per vertical band
+ * @texel_count: length of the encoded blob, in texels
+ *
+ * Statistics describing the band layout chosen by the most recent
+ * hb_gpu_draw_encode() call.  A fragment shader invocation walks
+ * one horizontal and one vertical band, so
+ * @max_hband_curves + @max_vband_curves bounds the per-pixel
+ * curve work for the glyph.
+ *
+ * XSince: REPLACEME
+ */
+typedef struct hb_gpu_draw_encode_stats_t {
+  unsigned int num_hbands;
+  unsigned int num_vbands;
+  unsigned int max_hband_curves;
+  unsigned int max_vband_curves;
+  float        mean_hband_curves;
+  float        mean_vband_curves;
+  unsigned int texel_count;
+
+  /*< private >*/
+  unsigned int reserved1;
+  unsigned int reserved2;
+  unsigned int reserved3;
+  unsigned int reserved4;
+} hb_gpu_draw_encode_stats_t;
+
+HB_EXTERN void
+hb_gpu_draw_get_encode_stats (const hb_gpu_draw_t        *draw,
+			      hb_gpu_draw_encode_stats_t *stats);
+
 
 /**
  * hb_gpu_paint_t:
@@ -265,6 +312,169 @@ hb_gpu_paint_shader_source (hb_gpu_shader_stage_t stage,
 			    hb_gpu_shader_lang_t  lang);
 
 
+/**
+ * hb_gpu_atlas_t:
+ *
+ * An opaque GPU glyph atlas.  Packs encoded glyph blobs into one
+ * texel buffer, with least-recently-used eviction, and tracks which
+ * parts of it need uploading.
+ *
+ * XSince: REPLACEME
+ */
+typedef struct hb_gpu_atlas_t hb_gpu_atlas_t;
+
+/**
+ * hb_gpu_atlas_range_t:
+ * @offset: first texel of the range
+ * @length: number of texels in the range
+ *
+ * A range of texels in an #hb_gpu_atlas_t.
+ *
+ * XSince: REPLACEME
+ */
+typedef struct hb_gpu_atlas_range_t {
+  unsigned int offset;
+  unsigned int length;
+} hb_gpu_atlas_range_t;
+
+HB_EXTERN hb_gpu_atlas_t *
+hb_gpu_atlas_create_or_fail (unsigned int capacity);
+
+HB_EXTERN hb_gpu_atlas_t *
+hb_gpu_atlas_reference (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN void
+hb_gpu_atlas_destroy (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_set_user_data (hb_gpu_atlas_t     *atlas,
+			    hb_user_data_key_t *key,
+			    void               *data,
+			    hb_destroy_func_t   destroy,
+			    hb_bool_t           replace);
+
+HB_EXTERN void *
+hb_gpu_atlas_get_user_data (const hb_gpu_atlas_t *atlas,
+			    hb_user_data_key_t   *key);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_capacity (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_used (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_serial (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_lookup (hb_gpu_atlas_t     *atlas,
+		     hb_font_t          *font,
+		     hb_codepoint_t      glyph,
+		     unsigned int       *offset,
+		     hb_glyph_extents_t *extents);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_add (hb_gpu_atlas_t           *atlas,
+		  hb_font_t                *font,
+		  hb_codepoint_t            glyph,
+		  hb_blob_t                *blob,
+		  const hb_glyph_extents_t *extents,
+		  unsigned int             *offset);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_draw_glyph (hb_gpu_atlas_t     *atlas,
+			 hb_gpu_draw_t      *draw,
+			 hb_font_t          *font,
+			 hb_codepoint_t      glyph,
+			 unsigned int       *offset,
+			 hb_glyph_extents_t *extents);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_paint_glyph (hb_gpu_atlas_t     *atlas,
+			  hb_gpu_paint_t     *paint,
+			  hb_font_t          *font,
+			  hb_codepoint_t      glyph,
+			  unsigned int       *offset,
+			  hb_glyph_extents_t *extents);
+
+HB_EXTERN void
+hb_gpu_atlas_clear (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN const char *
+hb_gpu_atlas_get_data (const hb_gpu_atlas_t *atlas,
+		       unsigned int         *length);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_dirty_ranges (const hb_gpu_atlas_t *atlas,
+			       unsigned int          start_offset,
+			       unsigned int         *range_count /* IN/OUT */,
+			       hb_gpu_atlas_range_t *ranges /* OUT */);
+
+HB_EXTERN void
+hb_gpu_atlas_clear_dirty (hb_gpu_atlas_t *atlas);
+
+
+/**
+ * hb_gpu_glyphs_t:
+ *
+ * An opaque set of encoded glyphs, indexed by glyph ID, that can be
+ * serialized and loaded back without encoding again.
+ *
+ * XSince: REPLACEME
+ */
+typedef struct hb_gpu_glyphs_t hb_gpu_glyphs_t;
+
+HB_EXTERN hb_gpu_glyphs_t *
+hb_gpu_glyphs_create_or_fail (unsigned int glyph_count);
+
+HB_EXTERN hb_gpu_glyphs_t *
+hb_gpu_glyphs_create_for_blob_or_fail (hb_blob_t *blob);
+
+HB_EXTERN hb_gpu_glyphs_t *
+hb_gpu_glyphs_reference (hb_gpu_glyphs_t *glyphs);
+
+HB_EXTERN void
+hb_gpu_glyphs_destroy (hb_gpu_glyphs_t *glyphs);
+
+HB_EXTERN hb_bool_t
+hb_gpu_glyphs_set_user_data (hb_gpu_glyphs_t    *glyphs,
+			     hb_user_data_key_t *key,
+			     void               *data,
+			     hb_destroy_func_t   destroy,
+			     hb_bool_t           replace);
+
+HB_EXTERN void *
+hb_gpu_glyphs_get_user_data (const hb_gpu_glyphs_t *glyphs,
+			     hb_user_data_key_t    *key);
+
+HB_EXTERN unsigned int
+hb_gpu_glyphs_get_glyph_count (const hb_gpu_glyphs_t *glyphs);
+
+HB_EXTERN hb_bool_t
+hb_gpu_glyphs_set_glyph (hb_gpu_glyphs_t          *glyphs,
+			 hb_codepoint_t            glyph,
+			 hb_blob_t                *blob,
+			 const hb_glyph_extents_t *extents);
+
+HB_EXTERN hb_bool_t
+hb_gpu_glyphs_get_glyph (const hb_gpu_glyphs_t *glyphs,
+			 hb_codepoint_t         glyph,
+			 unsigned int          *offset,
+			 unsigned int          *length,
+			 hb_glyph_extents_t    *extents);
+
+HB_EXTERN const char *
+hb_gpu_glyphs_get_data (const hb_gpu_glyphs_t *glyphs,
+			unsigned int          *length);
+
+HB_EXTERN hb_blob_t *
+hb_gpu_glyphs_reference_glyph_blob (const hb_gpu_glyphs_t *glyphs,
+				    hb_codepoint_t         glyph);
+
+HB_EXTERN hb_blob_t *
+hb_gpu_glyphs_serialize (hb_gpu_glyphs_t *glyphs);
+
+
 HB_END_DECLS
 
 
@@ -272,6 +482,8 @@ HB_END_DECLS
 namespace hb {
 HB_DEFINE_VTABLE (gpu_draw,  nullptr);
 HB_DEFINE_VTABLE (gpu_paint, nullptr);
+HB_DEFINE_VTABLE (gpu_atlas, nullptr);
+HB_DEFINE_VTABLE (gpu_glyphs, nullptr);
 } // namespace hb
 #endif
 
@@ -120,6 +120,12 @@
 #define HB_GPU_DRAW_MAX_CURVES 65536
 #endif
 
+/* Upper bound on bands per axis that hb_gpu_draw_encode() considers
+ * when a texel budget is set. */
+#ifndef HB_GPU_DRAW_MAX_BANDS
+#define HB_GPU_DRAW_MAX_BANDS 32
+#endif
+
 /* Tiles emitted by one hb_paint_sweep_gradient_tiles() call.  Also
  * sets the angular resolution (2π over this) below which a repeating
  * color line is filled with its average color instead of tiled;
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_LRU_LIST_HH
+#define HB_LRU_LIST_HH
+
+#include "hb.hh"
+
+
+/*
+ * hb_lru_list_t
+ *
+ * Recency order over items stored in an array, threaded through an
+ * hb_lru_link_t member named lru in each item, so that using an item
+ * and finding the least recently used one are both O(1).  Items are
+ * named by their index in the array; after moving a linked item to
+ * another index (as hb_vector_t::remove_unordered() does), call
+ * moved() with its new index.
+ */
+struct hb_lru_link_t
+{
+  unsigned prev;
+  unsigned next;
+};
+
+template <typename item_t>
+struct hb_lru_list_t
+{
+  static constexpr unsigned NONE = (unsigned) -1;
+
+  unsigned head = NONE;	/* Least recently used */
+  unsigned tail = NONE;	/* Most recently used */
+
+  bool is_empty () const { return head == NONE; }
+  void reset () { head = tail = NONE; }
+
+  /* Links @i as the most recently used item. */
+  void push (item_t *items, unsigned i)
+  {
+    items[i].lru = hb_lru_link_t {tail, NONE};
+    if (tail != NONE)
+      items[tail].lru.next = i;
+    else
+      head = i;
+    tail = i;
+  }
+
+  void remove (item_t *items, unsigned i)
+  {
+    const hb_lru_link_t &l = items[i].lru;
+    if (l.prev != NONE)
+      items[l.prev].lru.next = l.next;
+    else
+      head = l.next;
+    if (l.next != NONE)
+      items[l.next].lru.prev = l.prev;
+    else
+      tail = l.prev;
+  }
+
+  /* Marks linked item @i most recently used. */
+  void touch (item_t *items, unsigned i)
+  {
+    if (i == tail)
+      return;
+    remove (items, i);
+    push (items, i);
+  }
+
+  /* A linked item, links included, now lives at index @i. */
+  void moved (item_t *items, unsigned i)
+  {
+    const hb_lru_link_t &l = items[i].lru;
+    if (l.prev != NONE)
+      items[l.prev].lru.next = i;
+    else
+      head = i;
+    if (l.next != NONE)
+      items[l.next].lru.prev = i;
+    else
+      tail = i;
+  }
+};
+
+
+#endif /* HB_LRU_LIST_HH */
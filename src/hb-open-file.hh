@@ -197,6 +197,69 @@ typedef struct OpenTypeOffsetTable
     return_trace (true);
   }
 
+  /* Like serialize (), but only writes the table directory, for the tables
+   * to be laid out right after it in iteration order, each padded to four
+   * bytes.  The tables are not copied, so the head checkSumAdjustment is
+   * returned in checksum_adjustment instead of written; it is left alone if
+   * there is no head table. */
+  template <typename Iterator,
+	    hb_requires ((hb_is_source_of<Iterator, hb_pair_t<hb_tag_t, hb_blob_t *>>::value))>
+  bool serialize_directory (hb_serialize_context_t *c,
+			    hb_tag_t sfnt_tag,
+			    Iterator it,
+			    uint32_t *checksum_adjustment)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (this))) return_trace (false);
+    sfnt_version = sfnt_tag;
+    unsigned num_items = hb_len (it);
+    if (unlikely (!tables.serialize (c, num_items))) return_trace (false);
+
+    const char *dir_end = (const char *) c->head;
+    bool has_head = false;
+
+    uint64_t offset = dir_end - (const char *) this;
+    unsigned i = 0;
+    for (hb_pair_t<hb_tag_t, hb_blob_t*> entry : it)
+    {
+      hb_blob_t *blob = entry.second;
+      unsigned len = blob->length;
+
+      TableRecord &rec = tables.arrayZ[i];
+      rec.tag = entry.first;
+      rec.length = len;
+      rec.offset = 0;
+      if (unlikely (!c->check_assign (rec.offset, offset,
+				      HB_SERIALIZE_ERROR_OFFSET_OVERFLOW)))
+        return_trace (false);
+      offset += hb_ceil_to_4 (len);
+
+      rec.checkSum.set_for_unpadded_data (blob->data, len);
+      if (entry.first == HB_OT_TAG_head &&
+	  hb_ceil_to_4 (len) >= head::static_size)
+      {
+	/* The table checksum is taken with checkSumAdjustment zeroed. */
+	has_head = true;
+	rec.checkSum = rec.checkSum - ((const head *) blob->data)->checkSumAdjustment;
+      }
+      i++;
+    }
+
+    tables.qsort ();
+
+    if (has_head)
+    {
+      CheckSum checksum;
+      checksum.set_for_data (this, dir_end - (const char *) this);
+      for (unsigned int i = 0; i < num_items; i++)
+	checksum = checksum + tables.arrayZ[i].checkSum;
+
+      *checksum_adjustment = 0xB1B0AFBAu - checksum;
+    }
+
+    return_trace (true);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -356,6 +356,21 @@ struct CheckSum : HBUINT32
   void set_for_data (const void *data, unsigned int length)
   { *this = CalcTableChecksum ((const HBUINT32 *) data, length); }
 
+  /* Same result as set_for_data () on the data zero-padded to 4 bytes. */
+  void set_for_unpadded_data (const void *data, unsigned int length)
+  {
+    unsigned int padded = length & ~3u;
+    uint32_t sum = CalcTableChecksum ((const HBUINT32 *) data, padded);
+    if (length != padded)
+    {
+      HBUINT32 tail;
+      tail = 0;
+      hb_memcpy (&tail, (const char *) data + padded, length - padded);
+      sum += tail;
+    }
+    *this = sum;
+  }
+
   public:
   DEFINE_SIZE_STATIC (4);
 };
@@ -54,6 +54,9 @@ struct head
     return 16 <= upem && upem <= 16384 ? upem : 1000;
   }
 
+  void set_checksum_adjustment (uint32_t adjustment)
+  { checkSumAdjustment = adjustment; }
+
   bool serialize (hb_serialize_context_t *c) const
   {
     TRACE_SERIALIZE (this);
@@ -115,21 +115,90 @@ inline bool SubstLookup::dispatch_recurse_func<hb_ot_apply_context_t> (hb_ot_app
 } /* namespace GSUB_impl */
 } /* namespace Layout */
 
+inline
+GSUB_closure_cache_t::GSUB_closure_cache_t (hb_face_t *face)
+{
+  const Layout::GSUB &gsub = *face->table.GSUB->table;
+  unsigned num_lookups = gsub.get_lookup_count ();
+  if (unlikely (!relations.resize (num_lookups)))
+    return;
+
+  unsigned num_glyphs = face->get_num_glyphs ();
+  for (unsigned i = 0; i < num_lookups; i++)
+  {
+    hb_closure_relation_t &relation = relations.arrayZ[i];
+    hb_closure_relation_context_t c (&relation, num_glyphs);
+    gsub.get_lookup (i).dispatch (&c);
+
+    if (c.cacheable && !relation.in_error ())
+    {
+      relation.finish ();
+      relation.cacheable = true;
+    }
+    else
+      relation = hb_closure_relation_t ();
+  }
+}
+
+inline void
+GSUB_closure_cache_t::closure (hb_face_t      *face,
+			       const hb_set_t *lookups,
+			       hb_set_t       *glyphs /* IN/OUT */) const
+{
+  hb_map_t done_lookups_glyph_count;
+  hb_hashmap_t<unsigned, hb::unique_ptr<hb_set_t>> done_lookups_glyph_set;
+  hb_closure_context_t c (face, glyphs, &done_lookups_glyph_count, &done_lookups_glyph_set);
+  const Layout::GSUB &gsub = *face->table.GSUB->table;
+
+  /* The iteration of hb_ot_layout_lookups_substitute_closure(), with
+   * cacheable lookups applying their relation instead of walking their
+   * subtables; visit accounting is kept the same so the result is too. */
+  unsigned int iteration_count = 0;
+  unsigned int glyphs_length;
+  do
+  {
+    c.reset_lookup_visit_count ();
+    glyphs_length = glyphs->get_population ();
+    for (auto lookup_index : *lookups)
+    {
+      if (lookup_index < relations.length && relations.arrayZ[lookup_index].cacheable)
+      {
+	if (!c.should_visit_lookup (lookup_index))
+	  continue;
+	relations.arrayZ[lookup_index].closure (*glyphs, c.output);
+	c.flush ();
+      }
+      else
+	gsub.get_lookup (lookup_index).closure (&c, lookup_index);
+    }
+  } while (iteration_count++ <= HB_CLOSURE_MAX_STAGES &&
+	   glyphs_length != glyphs->get_population ());
+}
+
 inline void
 GSUB_accelerator_t::depend (hb_depend_data_builder_t *builder, hb_face_t *face) const
 {
   if (!this->table->has_data ()) return;
 
+  if (unlikely (!depend_lookup_features (builder, face)))
+    return;
+
+  depend_lookups (builder, face, 0, this->table->get_lookup_count ());
+}
+
+inline bool
+GSUB_accelerator_t::depend_lookup_features (hb_depend_data_builder_t *builder, hb_face_t *face) const
+{
   unsigned num_features = this->table->get_feature_count ();
   unsigned num_lookups  = this->table->get_lookup_count ();
 
   hb_vector_t<hb_tag_t> feature_tags;
   if (!builder->check_success (feature_tags.resize (num_features)))
-    return;
+    return false;
   this->table->get_feature_tags (0, &num_features, feature_tags.arrayZ);
 
   if (!builder->init_lookup_features (num_lookups))
-    return;
+    return false;
 
   hb_vector_t<hb_tag_t> feature_query_v;
   feature_query_v.resize (2);
@@ -152,7 +221,7 @@ GSUB_accelerator_t::depend (hb_depend_data_builder_t *builder, hb_face_t *face)
 
     for (auto lookup_index : lookup_indexes)
       if (unlikely (!builder->add_lookup_feature (lookup_index, ft)))
-	return;
+	return false;
 
     auto &fv = this->table->get_feature_variations ();
     auto fi_count = fv.record_count ();
@@ -167,19 +236,23 @@ GSUB_accelerator_t::depend (hb_depend_data_builder_t *builder, hb_face_t *face)
       }
       for (auto lookup_index : lookup_indexes)
         if (unlikely (!builder->add_lookup_feature (lookup_index, ft)))
-	  return;
+	  return false;
     }
   }
 
-  if (unlikely (!builder->finish_lookup_features ()))
-    return;
+  return builder->finish_lookup_features ();
+}
 
+inline void
+GSUB_accelerator_t::depend_lookups (hb_depend_data_builder_t *builder, hb_face_t *face,
+				    unsigned start, unsigned end) const
+{
   hb_set_t all_glyphs;
   all_glyphs.add_range (0, face->get_num_glyphs () - 1);
 
   hb_depend_context_t c (builder, face, &all_glyphs);
 
-  for (unsigned i = 0; i < num_lookups; i++)
+  for (unsigned i = start; i < end; i++)
   {
     auto features = builder->get_lookup_features (i);
     if (!features)
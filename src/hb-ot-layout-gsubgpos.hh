@@ -202,6 +202,142 @@ struct hb_closure_context_t :
   unsigned int lookup_count = 0;
 };
 
+/* The glyph relation closure() computes for a non-contextual lookup:
+ * which glyphs each glyph can be substituted with, and which ligatures
+ * each glyph starts.  Can be computed once per lookup and applied to any
+ * glyph set, instead of reinterpreting the subtables every time. */
+struct hb_closure_relation_t
+{
+  struct ligature_t
+  {
+    hb_codepoint_t first;
+    hb_codepoint_t ligature;
+    unsigned components_start;
+    unsigned num_components;
+  };
+
+  void finish ()
+  {
+    singles.qsort ([] (const hb_codepoint_pair_t &a, const hb_codepoint_pair_t &b)
+		   { return a.first < b.first ? -1 : a.first > b.first ? 1 : 0; });
+    ligatures.qsort ([] (const ligature_t &a, const ligature_t &b)
+		     { return a.first < b.first ? -1 : a.first > b.first ? 1 : 0; });
+  }
+
+  /* Adds to output what closure() of the lookup adds for glyphs. */
+  void closure (const hb_set_t &glyphs, hb_set_t *output) const
+  {
+    unsigned pop = glyphs.get_population ();
+
+    if (singles.length > pop * 4)
+    {
+      for (hb_codepoint_t g : glyphs)
+	for (unsigned i = lower_bound (singles, g);
+	     i < singles.length && singles.arrayZ[i].first == g;
+	     i++)
+	  output->add (singles.arrayZ[i].second);
+    }
+    else
+    {
+      for (const auto &_ : singles)
+	if (glyphs.has (_.first))
+	  output->add (_.second);
+    }
+
+    if (ligatures.length > pop * 4)
+    {
+      for (hb_codepoint_t g : glyphs)
+	for (unsigned i = lower_bound (ligatures, g);
+	     i < ligatures.length && ligatures.arrayZ[i].first == g;
+	     i++)
+	  add_ligature (ligatures.arrayZ[i], glyphs, output);
+    }
+    else
+    {
+      for (const auto &_ : ligatures)
+	if (glyphs.has (_.first))
+	  add_ligature (_, glyphs, output);
+    }
+  }
+
+  bool in_error () const
+  { return singles.in_error () || ligatures.in_error () || components.in_error (); }
+
+  private:
+  void add_ligature (const ligature_t &l, const hb_set_t &glyphs, hb_set_t *output) const
+  {
+    if (hb_all (components.as_array ().sub_array (l.components_start, l.num_components), &glyphs))
+      output->add (l.ligature);
+  }
+
+  template <typename T>
+  static unsigned lower_bound (const hb_vector_t<T> &v, hb_codepoint_t g)
+  {
+    unsigned lo = 0, hi = v.length;
+    while (lo < hi)
+    {
+      unsigned mid = lo + (hi - lo) / 2;
+      if (v.arrayZ[mid].first < g)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+    return lo;
+  }
+
+  public:
+  bool cacheable = false;
+  hb_vector_t<hb_codepoint_pair_t> singles;	/* Sorted by first. */
+  hb_vector_t<ligature_t> ligatures;		/* Sorted by first. */
+  hb_vector_t<hb_codepoint_t> components;
+};
+
+struct hb_closure_relation_context_t :
+       hb_dispatch_context_t<hb_closure_relation_context_t>
+{
+  template <typename T>
+  static inline auto relate_ (const T &obj, hb_closure_relation_context_t *c, hb_priority<1>) HB_AUTO_RETURN ( obj.closure_relation (c) )
+  template <typename T>
+  static inline void relate_ (const T &obj HB_UNUSED, hb_closure_relation_context_t *c, hb_priority<0>) { c->set_uncacheable (); }
+  template <typename T>
+  return_t dispatch (const T &obj) { relate_ (obj, this, hb_prioritize); return hb_empty_t (); }
+  static return_t default_return_value () { return hb_empty_t (); }
+  bool stop_sublookup_iteration (return_t r HB_UNUSED) const { return !cacheable; }
+
+  /* Subtables whose closure depends on more than the relation call this. */
+  void set_uncacheable () { cacheable = false; }
+
+  void add (hb_codepoint_t glyph, hb_codepoint_t substitute)
+  {
+    /* closure() drops invalid glyphs when flushing its output. */
+    if (substitute < num_glyphs)
+      relation->singles.push (hb_pair (glyph, substitute));
+  }
+
+  template <typename Iterable>
+  void add_ligature (hb_codepoint_t first, hb_codepoint_t ligature, const Iterable &components)
+  {
+    if (ligature >= num_glyphs)
+      return;
+    unsigned start = relation->components.length;
+    + hb_iter (components)
+    | hb_sink (relation->components)
+    ;
+    relation->ligatures.push (hb_closure_relation_t::ligature_t {first, ligature,
+								  start,
+								  relation->components.length - start});
+  }
+
+  hb_closure_relation_context_t (hb_closure_relation_t *relation_,
+				 unsigned num_glyphs_) :
+				 relation (relation_),
+				 num_glyphs (num_glyphs_) {}
+
+  hb_closure_relation_t *relation;
+  unsigned num_glyphs;
+  bool cacheable = true;
+};
+
 
 
 struct hb_closure_lookups_context_t :
@@ -420,9 +556,12 @@ struct hb_depend_context_t :
 			     const void *data_,
 			     hb_codepoint_t active_glyphs_,
 			     unsigned value_,
-			     unsigned format_)
+			     unsigned format_,
+			     const void *backtrack_data_,
+			     const void *lookahead_data_)
       : rule (rule_), record (record_), data (data_), active_glyphs (active_glyphs_),
-	value (value_), format (format_) {}
+	value (value_), format (format_),
+	backtrack_data (backtrack_data_), lookahead_data (lookahead_data_) {}
 
     bool operator == (const context_set_cache_key_t &o) const
     {
@@ -431,7 +570,9 @@ struct hb_depend_context_t :
 	     data == o.data &&
 	     active_glyphs == o.active_glyphs &&
 	     value == o.value &&
-	     format == o.format;
+	     format == o.format &&
+	     backtrack_data == o.backtrack_data &&
+	     lookahead_data == o.lookahead_data;
     }
 
     uint32_t hash () const
@@ -441,7 +582,9 @@ struct hb_depend_context_t :
       current = current * 31 + hb_hash ((uintptr_t) data);
       current = current * 31 + hb_hash (active_glyphs);
       current = current * 31 + hb_hash (value);
-      return current * 31 + hb_hash (format);
+      current = current * 31 + hb_hash (format);
+      current = current * 31 + hb_hash ((uintptr_t) backtrack_data);
+      return current * 31 + hb_hash ((uintptr_t) lookahead_data);
     }
 
     const void *rule = nullptr;
@@ -450,6 +593,10 @@ struct hb_depend_context_t :
     hb_codepoint_t active_glyphs = HB_CODEPOINT_INVALID;
     unsigned value = 0;
     unsigned format = 0;
+    /* Chain rules can be shared between subtables whose backtrack and
+     * lookahead ClassDefs differ, so those are part of the key too. */
+    const void *backtrack_data = nullptr;
+    const void *lookahead_data = nullptr;
   };
 
   struct recurse_key_t
@@ -619,12 +766,15 @@ struct hb_depend_context_t :
 				  const void *data,
 				  unsigned value,
 				  unsigned format,
+				  const void *backtrack_data,
+				  const void *lookahead_data,
 				  context_set_cache_key_t *key)
   {
     hb_codepoint_t active_idx;
     if (!get_parent_active_glyphs_index (&active_idx))
       return false;
-    *key = context_set_cache_key_t (rule, record, data, active_idx, value, format);
+    *key = context_set_cache_key_t (rule, record, data, active_idx, value, format,
+				    backtrack_data, lookahead_data);
     return true;
   }
 
@@ -2346,7 +2496,9 @@ context_depend_sets_are_cached (hb_depend_context_t *c,
 				unsigned value,
 				ContextFormat context_format,
 				const void *data,
-				hb_vector_t<hb_codepoint_t> *cached_context_sets)
+				hb_vector_t<hb_codepoint_t> *cached_context_sets,
+				const void *backtrack_data = nullptr,
+				const void *lookahead_data = nullptr)
 {
   hb_codepoint_t active_idx = HB_CODEPOINT_INVALID;
   bool have_active_idx = false;
@@ -2363,7 +2515,8 @@ context_depend_sets_are_cached (hb_depend_context_t *c,
     }
 
     hb_depend_context_t::context_set_cache_key_t key (
-      rule, &lookup_records[i], data, active_idx, value, context_format);
+      rule, &lookup_records[i], data, active_idx, value, context_format,
+      backtrack_data, lookahead_data);
     hb_codepoint_t *cached_context_set = nullptr;
     if (!c->context_set_cache.has (key, &cached_context_set))
       return false;
@@ -2389,7 +2542,9 @@ static void context_depend_recurse_lookups (hb_depend_context_t *c,
 					     const hb_set_t &preliminary_context,
 					     const hb_vector_t<const hb_set_t *> *input_position_glyphs,
 					     const hb_vector_t<hb_codepoint_t> *cached_context_sets,
-					     hb_depend_context_t::depend_scratch_t *scratch)
+					     hb_depend_context_t::depend_scratch_t *scratch,
+					     const void *backtrack_data = nullptr,
+					     const void *lookahead_data = nullptr)
 {
   /* For depend graph extraction, we filter active glyphs by InputCoverage constraints
    * (same as closure), but we do NOT do sequential accumulation of outputs.
@@ -2414,7 +2569,9 @@ static void context_depend_recurse_lookups (hb_depend_context_t *c,
 
     hb_depend_context_t::context_set_cache_key_t context_cache_key;
     if (unlikely (!c->get_context_set_cache_key (rule, &lookupRecord[i], data, value,
-						 context_format, &context_cache_key)))
+						 context_format,
+						 backtrack_data, lookahead_data,
+						 &context_cache_key)))
       return;
 
     hb_codepoint_t context_set_idx;
@@ -4179,7 +4336,8 @@ static inline void chain_context_depend_lookup (hb_depend_context_t *c,
   bool context_sets_cached = context_depend_sets_are_cached (
     c, inputCount, lookupCount, lookupRecord, rule, value,
     lookup_context.context_format, lookup_context.intersects_data[1],
-    &scratch->cached_context_sets);
+    &scratch->cached_context_sets,
+    lookup_context.intersects_data[0], lookup_context.intersects_data[2]);
   if (unlikely (!c->depend_data->successful))
     return;
   if (context_sets_cached)
@@ -4196,7 +4354,9 @@ static inline void chain_context_depend_lookup (hb_depend_context_t *c,
 				    scratch->preliminary_context,
 				    nullptr,
 				    &scratch->cached_context_sets,
-				    scratch);
+				    scratch,
+				    lookup_context.intersects_data[0],
+				    lookup_context.intersects_data[2]);
     return;
   }
 
@@ -4320,7 +4480,9 @@ static inline void chain_context_depend_lookup (hb_depend_context_t *c,
 				  preliminary_context,
 				  context_sets_cached ? nullptr : &input_position_glyphs,
 				  context_sets_cached ? &scratch->cached_context_sets : nullptr,
-				  scratch);
+				  scratch,
+				  lookup_context.intersects_data[0],
+				  lookup_context.intersects_data[2]);
 }
 
 template <typename HBUINT>
@@ -858,7 +858,8 @@ struct avar
       return false;
     if (!item_vars.instantiate_tuple_vars (c->plan->old_intermediates,
                                            c->plan->axes_triple_distances,
-                                           false))
+                                           false,
+                                           &c->plan->rebase_tent_cache))
       return false;
 
     /* 4. Self-contained pinned axes (whose final coordinate is constant over
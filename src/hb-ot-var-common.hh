@@ -400,7 +400,8 @@ struct tuple_delta_t
 				    TripleDistances axis_triple_distances,
 				    hb_vector_t<tuple_delta_t>& out,
 				    rebase_tent_result_scratch_t &scratch,
-				    hb_alloc_pool_t *pool = nullptr)
+				    hb_alloc_pool_t *pool = nullptr,
+				    rebase_tent_cache_t *rebase_tent_cache = nullptr)
   {
     // May move *this out.
 
@@ -430,7 +431,10 @@ struct tuple_delta_t
       return;
 
     rebase_tent_result_t &solutions = scratch.first;
-    rebase_tent (*tent, axis_limit, axis_triple_distances, solutions, scratch.second);
+    if (rebase_tent_cache)
+      rebase_tent_cache->rebase_tent (*tent, axis_limit, axis_triple_distances, solutions, scratch.second);
+    else
+      rebase_tent (*tent, axis_limit, axis_triple_distances, solutions, scratch.second);
     for (unsigned i = 0; i < solutions.length; i++)
     {
       auto &t = solutions.arrayZ[i];
@@ -1140,7 +1144,8 @@ struct TupleVariationData
 
     bool change_tuple_variations_axis_limits (const hb_hashmap_t<hb_tag_t, Triple>& normalized_axes_location,
                                               const hb_hashmap_t<hb_tag_t, TripleDistances>& axes_triple_distances,
-					      hb_alloc_pool_t *pool = nullptr)
+					      hb_alloc_pool_t *pool = nullptr,
+					      rebase_tent_cache_t *rebase_tent_cache = nullptr)
     {
       /* sort axis_tag/axis_limits, make result deterministic */
       hb_vector_t<hb_tag_t> axis_tags;
@@ -1167,7 +1172,7 @@ struct TupleVariationData
         for (tuple_delta_t& var : tuple_vars)
         {
 	  // This may move var out.
-	  var.change_tuple_var_axis_limit (axis_tag, *axis_limit, axis_triple_distances, out, scratch, pool);
+	  var.change_tuple_var_axis_limit (axis_tag, *axis_limit, axis_triple_distances, out, scratch, pool, rebase_tent_cache);
           if (!out) continue;
 
           unsigned new_len = new_vars.length + out.length;
@@ -1326,10 +1331,11 @@ struct TupleVariationData
 		      optimize_scratch_t &scratch,
 		      hb_alloc_pool_t *pool = nullptr,
                       contour_point_vector_t* contour_points = nullptr,
-                      bool optimize = false)
+                      bool optimize = false,
+		      rebase_tent_cache_t *rebase_tent_cache = nullptr)
     {
       if (!tuple_vars) return true;
-      if (!change_tuple_variations_axis_limits (normalized_axes_location, axes_triple_distances, pool))
+      if (!change_tuple_variations_axis_limits (normalized_axes_location, axes_triple_distances, pool, rebase_tent_cache))
         return false;
       /* compute inferred deltas only for gvar */
       if (contour_points)
@@ -1859,7 +1865,8 @@ struct item_variations_t
     if (plan->has_avar2 && plan->avar2_reachable_ranges.get_population ())
       for (tuple_variations_t& tuple_vars : vars)
 	tuple_vars.cull_unreachable (plan->avar2_reachable_ranges);
-    if (!instantiate_tuple_vars (plan->axes_location, plan->axes_triple_distances))
+    if (!instantiate_tuple_vars (plan->axes_location, plan->axes_triple_distances,
+                                 true, &plan->rebase_tent_cache))
       return false;
     return as_item_varstore (optimize, use_no_variation_idx);
   }
@@ -1899,11 +1906,13 @@ struct item_variations_t
 
   bool instantiate_tuple_vars (const hb_hashmap_t<hb_tag_t, Triple>& normalized_axes_location,
                                const hb_hashmap_t<hb_tag_t, TripleDistances>& axes_triple_distances,
-                               bool build_regions = true)
+                               bool build_regions = true,
+                               rebase_tent_cache_t *rebase_tent_cache = nullptr)
   {
     optimize_scratch_t scratch;
     for (tuple_variations_t& tuple_vars : vars)
-      if (!tuple_vars.instantiate (normalized_axes_location, axes_triple_distances, scratch))
+      if (!tuple_vars.instantiate (normalized_axes_location, axes_triple_distances, scratch,
+                                   nullptr, nullptr, false, rebase_tent_cache))
         return false;
 
     return !build_regions || build_region_list ();
@@ -74,6 +74,12 @@ struct glyph_variations_t
   hb_hashmap_t<const hb_vector_t<F2DOT14>*, unsigned> shared_tuples_idx_map;
 
   hb_alloc_pool_t pool;
+  /* Pools and results of the tasks of defer_instantiate (). */
+  hb_vector_t<hb_alloc_pool_t> task_pools;
+  hb_vector_t<bool> task_success;
+  const hb_subset_plan_t *task_plan = nullptr;
+
+  bool compiled = false;
 
   public:
   unsigned compiled_shared_tuples_count () const
@@ -140,28 +146,45 @@ struct glyph_variations_t
 
   bool instantiate (const hb_subset_plan_t *plan)
   {
-    unsigned count = plan->new_to_old_gid_list.length;
-    bool iup_optimize = false;
     optimize_scratch_t scratch;
-    iup_optimize = plan->flags & HB_SUBSET_FLAGS_OPTIMIZE_IUP_DELTAS;
-    for (unsigned i = 0; i < count; i++)
-    {
-      hb_codepoint_t new_gid = plan->new_to_old_gid_list[i].first;
-      contour_point_vector_t *all_points;
-      if (!plan->new_gid_contour_points_map.has (new_gid, &all_points))
-        return false;
-      /* avar2 partial instancing: cull unreachable tuples. */
-      if (plan->has_avar2 && plan->avar2_reachable_ranges.get_population ())
-	glyph_variations[i].cull_unreachable (plan->avar2_reachable_ranges);
-      if (!glyph_variations[i].instantiate (plan->axes_location, plan->axes_triple_distances, scratch, &pool, all_points, iup_optimize))
-        return false;
-    }
+    return instantiate_glyphs (plan, 0, plan->new_to_old_gid_list.length, scratch, &pool);
+  }
+
+  /* Instancing glyphs, IUP optimization in particular, is independent
+   * per glyph; with an executor, it is deferred to tasks of
+   * GLYPHS_PER_TASK glyphs (see hb_subset_plan_t::defer_tasks ()), each
+   * with its own scratch and allocation pool. */
+  static bool can_defer_instantiate (const hb_subset_plan_t *plan)
+  { return plan->executor && plan->new_to_old_gid_list.length > GLYPHS_PER_TASK; }
+
+  bool defer_instantiate (hb_subset_plan_t *plan, hb_tag_t tag)
+  {
+    unsigned count = plan->new_to_old_gid_list.length;
+    unsigned num_tasks = (count + GLYPHS_PER_TASK - 1) / GLYPHS_PER_TASK;
+
+    task_plan = plan;
+    if (unlikely (!task_pools.resize (num_tasks) ||
+                  !task_success.resize (num_tasks)))
+      return false;
+
+    return plan->defer_tasks (tag, instantiate_task, num_tasks);
+  }
+
+  bool deferred_instantiate_succeeded () const
+  {
+    for (bool success : task_success)
+      if (!success) return false;
     return true;
   }
 
+  /* Only compiles once; the table may be serialized more than once if
+   * it runs out of room. */
   bool compile_bytes (const hb_map_t& axes_index_map,
                       const hb_map_t& axes_old_index_tag_map)
   {
+    if (compiled)
+      return true;
+
     if (!compile_shared_tuples (axes_index_map, axes_old_index_tag_map))
       return false;
     for (tuple_variations_t& vars: glyph_variations)
@@ -172,9 +195,49 @@ struct glyph_variations_t
 			       &pool))
         return false;
 
+    compiled = true;
     return true;
   }
 
+  private:
+  static constexpr unsigned GLYPHS_PER_TASK = 64;
+
+  bool instantiate_glyphs (const hb_subset_plan_t *plan,
+                           unsigned start, unsigned end,
+                           optimize_scratch_t &scratch,
+                           hb_alloc_pool_t *glyph_pool)
+  {
+    bool iup_optimize = plan->flags & HB_SUBSET_FLAGS_OPTIMIZE_IUP_DELTAS;
+    for (unsigned i = start; i < end; i++)
+    {
+      hb_codepoint_t new_gid = plan->new_to_old_gid_list[i].first;
+      contour_point_vector_t *all_points;
+      if (!plan->new_gid_contour_points_map.has (new_gid, &all_points))
+        return false;
+      /* avar2 partial instancing: cull unreachable tuples. */
+      if (plan->has_avar2 && plan->avar2_reachable_ranges.get_population ())
+	glyph_variations[i].cull_unreachable (plan->avar2_reachable_ranges);
+      if (!glyph_variations[i].instantiate (plan->axes_location, plan->axes_triple_distances, scratch, glyph_pool, all_points, iup_optimize,
+                                            &plan->rebase_tent_cache))
+        return false;
+    }
+    return true;
+  }
+
+  static void instantiate_task (void *task_data, unsigned index)
+  {
+    glyph_variations_t *glyph_vars = (glyph_variations_t *) task_data;
+    const hb_subset_plan_t *plan = glyph_vars->task_plan;
+    unsigned count = plan->new_to_old_gid_list.length;
+    unsigned start = index * GLYPHS_PER_TASK;
+    unsigned end = hb_min (start + GLYPHS_PER_TASK, count);
+
+    optimize_scratch_t scratch;
+    glyph_vars->task_success.arrayZ[index] = glyph_vars->instantiate_glyphs (plan, start, end, scratch,
+                                                                             &glyph_vars->task_pools.arrayZ[index]);
+  }
+
+  public:
   bool compile_shared_tuples (const hb_map_t& axes_index_map,
                               const hb_map_t& axes_old_index_tag_map)
   {
@@ -406,11 +469,32 @@ struct gvar_GVAR
   bool instantiate (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
-    glyph_variations_t<GidOffsetType> glyph_vars;
-    if (!decompile_glyph_variations (c, glyph_vars))
+    using glyph_vars_t = glyph_variations_t<GidOffsetType>;
+
+    /* With an executor, glyphs are instanced in tasks of their own after
+     * this returns, and the table is subsetted again to finish. */
+    glyph_vars_t *deferred = c->plan->get_deferred<glyph_vars_t> (c->table_tag);
+    if (!deferred && glyph_vars_t::can_defer_instantiate (c->plan))
+    {
+      /* Failing here drops the table, as it does below. */
+      deferred = c->plan->create_deferred<glyph_vars_t> (c->table_tag);
+      if (deferred && decompile_glyph_variations (c, *deferred))
+	deferred->defer_instantiate (c->plan, c->table_tag);
       return_trace (false);
+    }
 
-    if (!glyph_vars.instantiate (c->plan)) return_trace (false);
+    glyph_vars_t local_glyph_vars;
+    glyph_vars_t &glyph_vars = deferred ? *deferred : local_glyph_vars;
+    if (deferred)
+    {
+      if (!glyph_vars.deferred_instantiate_succeeded ()) return_trace (false);
+    }
+    else
+    {
+      if (!decompile_glyph_variations (c, glyph_vars))
+	return_trace (false);
+      if (!glyph_vars.instantiate (c->plan)) return_trace (false);
+    }
     if (!glyph_vars.compile_bytes (c->plan->axes_index_map, c->plan->axes_old_index_tag_map))
       return_trace (false);
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_PAINT_IMAGE_CACHE_HH
+#define HB_PAINT_IMAGE_CACHE_HH
+
+#include "hb.hh"
+#include "hb-lru-list.hh"
+#include "hb-map.hh"
+
+
+/* hb_paint_image_cache_t — decoded paint images, shared by the raster
+ * and vector painters.
+ *
+ * The image callback only sees the image blob.  For sbix and CBDT
+ * that is a sub-blob of the face's table blob, so the bytes it points
+ * at identify the (face, table, strike, glyph) image.  Each entry
+ * keeps a reference on its blob, which pins those bytes; the pointer
+ * cannot be reused for another image while the entry is alive.
+ * Entries are hashed on (data, length, format) and evicted in least
+ * recently used order.  Each painter has a cache of its own.
+ *
+ * payload_t is what the painter decodes the image into.  It must be
+ * movable and provide:
+ *
+ *   size_t size () const;	// bytes held, for the budget
+ *   void fini ();		// releases what it holds
+ */
+struct hb_paint_image_cache_key_t
+{
+  const char *data = nullptr;
+  unsigned length = 0;
+  hb_tag_t format = 0;
+
+  bool operator == (const hb_paint_image_cache_key_t &o) const
+  { return data == o.data && length == o.length && format == o.format; }
+
+  uint32_t hash () const
+  {
+    uint32_t current = hb_hash ((uintptr_t) data);
+    current = current * 31 + hb_hash (length);
+    current = current * 31 + hb_hash (format);
+    return current;
+  }
+};
+
+template <typename payload_t>
+struct hb_paint_image_cache_t
+{
+  using key_t = hb_paint_image_cache_key_t;
+
+  struct entry_t
+  {
+    hb_blob_t *blob;	/* Referenced */
+    key_t key;
+    payload_t payload;
+    size_t bytes;
+    hb_lru_link_t lru;
+  };
+
+  hb_vector_t<entry_t> entries;
+  hb_hashmap_t<key_t, unsigned> index;	/* Key to position in entries */
+  hb_lru_list_t<entry_t> lru;	/* Eviction order */
+  size_t max_bytes;
+  size_t bytes = 0;
+
+  hb_paint_image_cache_t (size_t max_bytes_) : max_bytes (max_bytes_) {}
+  ~hb_paint_image_cache_t () { shrink (0); }
+
+  static bool get_key (hb_blob_t *blob, hb_tag_t format, key_t *key)
+  {
+    key->data = hb_blob_get_data (blob, &key->length);
+    key->format = format;
+    return key->data;
+  }
+
+  payload_t *lookup (hb_blob_t *blob, hb_tag_t format)
+  {
+    key_t key;
+    unsigned *i;
+    if (!get_key (blob, format, &key) || !index.has (key, &i))
+      return nullptr;
+    lru.touch (entries.arrayZ, *i);
+    return &entries.arrayZ[*i].payload;
+  }
+
+  /* Takes ownership of @payload on success and returns where it now
+   * lives, valid until the next insert() or shrink().  On failure
+   * @payload is left with the caller. */
+  payload_t *insert (hb_blob_t *blob, hb_tag_t format, payload_t &payload)
+  {
+    size_t size = payload.size () + sizeof (entry_t);
+    if (size > max_bytes)
+      return nullptr;
+    key_t key;
+    if (!get_key (blob, format, &key))
+      return nullptr;
+
+    unsigned *i;
+    if (index.has (key, &i))
+      remove (*i);
+    shrink (max_bytes - size);
+
+    if (unlikely (!entries.push_or_fail ()))
+      return nullptr;
+    if (unlikely (!index.set (key, entries.length - 1)))
+    {
+      entries.pop ();
+      return nullptr;
+    }
+    entry_t &e = entries.tail ();
+    e.blob = hb_blob_reference (blob);
+    e.key = key;
+    e.payload = std::move (payload);
+    e.bytes = size;
+    lru.push (entries.arrayZ, entries.length - 1);
+    bytes += size;
+    return &e.payload;
+  }
+
+  /* Re-reads the size of the payload for @blob and @format after it
+   * grew in place (e.g. by adding mipmap levels).  The budget is
+   * enforced again on the next insert. */
+  void update (hb_blob_t *blob, hb_tag_t format)
+  {
+    key_t key;
+    unsigned *i;
+    if (!get_key (blob, format, &key) || !index.has (key, &i))
+      return;
+    entry_t &e = entries.arrayZ[*i];
+    bytes -= e.bytes;
+    e.bytes = e.payload.size () + sizeof (entry_t);
+    bytes += e.bytes;
+  }
+
+  /* Evicts least recently used entries until at most @limit bytes
+   * remain cached. */
+  void shrink (size_t limit)
+  {
+    while (bytes > limit && !lru.is_empty ())
+      remove (lru.head);
+  }
+
+  void remove (unsigned i)
+  {
+    entry_t &e = entries.arrayZ[i];
+    bytes -= e.bytes;
+    lru.remove (entries.arrayZ, i);
+    index.del (e.key);
+    e.payload.fini ();
+    hb_blob_destroy (e.blob);
+    entries.remove_unordered (i);
+    /* The last entry, if any, moved into slot @i.  Update its index
+     * in place, as set() could leave a stale copy behind a tombstone. */
+    if (i < entries.length)
+    {
+      unsigned *moved;
+      if (index.has (entries.arrayZ[i].key, &moved))
+	*moved = i;
+      lru.moved (entries.arrayZ, i);
+    }
+  }
+};
+
+
+#endif /* HB_PAINT_IMAGE_CACHE_HH */
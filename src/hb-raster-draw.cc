@@ -30,14 +30,6 @@
 #include "hb-geometry.hh"
 #include "hb-machinery.hh"
 
-#if defined(__aarch64__) || defined(_M_ARM64)
-#include <arm_neon.h>
-#define HB_RASTER_NEON 1
-#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
-#include <emmintrin.h>
-#define HB_RASTER_SSE2 1
-#endif
-
 
 /* Fixed-point precision for sub-pixel coordinates.
    8 bits = 24.8: 256 sub-pixel units per pixel. */
@@ -101,6 +93,9 @@ struct hb_raster_draw_t
 
   /* Recycled image for zero-malloc render */
   hb_raster_image_t *recycled_image = nullptr;
+
+  /* Caller-provided image to render into; one-shot, like extents */
+  hb_raster_image_t *target_image = nullptr;
 };
 
 static HB_ALWAYS_INLINE void
@@ -173,6 +168,7 @@ hb_raster_draw_destroy (hb_raster_draw_t *draw)
     return;
 
   hb_raster_image_destroy (draw->recycled_image);
+  hb_raster_image_destroy (draw->target_image);
   hb_object_actually_destroy (draw);
   hb_free (draw);
 }
@@ -460,6 +456,36 @@ hb_raster_draw_set_glyph_extents (hb_raster_draw_t         *draw,
   return true;
 }
 
+/**
+ * hb_raster_draw_set_target_image:
+ * @draw: a rasterizer
+ * @image: (nullable): the image to render into
+ *
+ * Makes the next hb_raster_draw_render() rasterize directly into
+ * @image instead of into a newly allocated or recycled image.  Combined
+ * with hb_raster_image_create_for_data_or_fail(), this renders glyphs
+ * straight into caller-owned memory such as atlas slots.
+ *
+ * The extents of @image become the output extents, as if passed to
+ * hb_raster_draw_set_extents(); call this before drawing so curve
+ * flattening is clipped to them.  @image must be
+ * @HB_RASTER_FORMAT_A8.  Only the pixels of @image are touched, not
+ * its row padding.
+ *
+ * Like the extents, the target is cleared after each render.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_raster_draw_set_target_image (hb_raster_draw_t  *draw,
+				 hb_raster_image_t *image)
+{
+  hb_raster_image_destroy (draw->target_image);
+  draw->target_image = hb_raster_image_reference (image);
+  if (image)
+    hb_raster_draw_set_extents (draw, &image->extents);
+}
+
 /**
  * hb_raster_draw_clear:
  * @draw: a rasterizer
@@ -476,6 +502,8 @@ hb_raster_draw_clear (hb_raster_draw_t *draw)
 {
   draw->fixed_extents     = {};
   draw->has_extents = false;
+  hb_raster_image_destroy (draw->target_image);
+  draw->target_image = nullptr;
   draw->has_clip_box = false;
   draw->flatten_clip_active = false;
   draw->flatten_work_left = HB_RASTER_MAX_DRAW_WORK;
@@ -544,7 +572,8 @@ hb_raster_draw_get_edge_work (hb_raster_draw_t *draw, unsigned max_rows)
  * ownership of @image to @draw and must not use it afterwards.
  *
  * If @draw already holds a recycled image, the previously recycled
- * image is destroyed.
+ * image is destroyed.  Images wrapping caller-owned storage are
+ * not kept for reuse.
  *
  * Since: 13.0.0
  **/
@@ -552,6 +581,11 @@ void
 hb_raster_draw_recycle_image (hb_raster_draw_t  *draw,
 			      hb_raster_image_t *image)
 {
+  if (image && image->is_external ())
+  {
+    hb_raster_image_destroy (image);
+    return;
+  }
   hb_raster_image_destroy (draw->recycled_image);
   draw->recycled_image = image;
 }
@@ -1444,6 +1478,10 @@ sweep_row_to_alpha (uint8_t *__restrict row_buf,
  * cleared so the rasterizer can be reused. Output format is always
  * @HB_RASTER_FORMAT_A8.
  *
+ * If a target image was set with hb_raster_draw_set_target_image(),
+ * the geometry is rasterized into it and a new reference to it is
+ * returned instead.
+ *
  * Return value: (transfer full):
  * A rendered #hb_raster_image_t. Returns `NULL` on allocation/configuration
  * failure. If no geometry was accumulated, returns an empty image.
@@ -1506,7 +1544,14 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
   HB_SCOPE_GUARD (hb_raster_draw_clear (draw));
 
   hb_unique_ptr_t<hb_raster_image_t> image;
-  if (draw->recycled_image)
+  if (draw->target_image)
+  {
+    if (unlikely (draw->target_image->format != HB_RASTER_FORMAT_A8))
+      return nullptr;
+    image = hb_unique_ptr_t<hb_raster_image_t> (hb_raster_image_reference (draw->target_image));
+    ext = image->extents;
+  }
+  else if (draw->recycled_image)
   {
     image = hb_unique_ptr_t<hb_raster_image_t> (draw->recycled_image);
     draw->recycled_image = nullptr;
@@ -1520,6 +1565,7 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
   if (unlikely (!image->configure (HB_RASTER_FORMAT_A8, ext)))
     return nullptr;
   image->clear ();
+  uint8_t *pixels = image->data ();
 
   /* ── 4. Bucket edges by starting row and rasterize scanlines ──── */
   if (draw->edges.length && ext.width && ext.height)
@@ -1580,7 +1626,7 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
 
       if (x_min <= x_max)
       {
-	int32_t cover_accum = sweep_row_to_alpha (image->buffer.arrayZ + row * ext.stride,
+	int32_t cover_accum = sweep_row_to_alpha (pixels + row * ext.stride,
 						   draw->row_area.arrayZ, draw->row_cover.arrayZ,
 						   x_min, x_max);
 
@@ -1592,7 +1638,7 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
 	  if (alpha > HB_RASTER_FULL_COVERAGE) alpha = HB_RASTER_FULL_COVERAGE;
 	  uint8_t byte = (uint8_t) (((unsigned) alpha * 255 + HB_RASTER_FULL_COVERAGE / 2) >> (2 * HB_RASTER_PIXEL_BITS + 1));
 
-	  uint8_t *row_buf = image->buffer.arrayZ + row * ext.stride;
+	  uint8_t *row_buf = pixels + row * ext.stride;
 	  hb_memset (row_buf + x_max + 1, byte, ext.width - 1 - x_max);
 	}
       }
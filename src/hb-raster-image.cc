@@ -84,6 +84,10 @@
 #include <png.h>
 #endif
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #ifdef HAVE_PNG
 struct hb_raster_png_read_blob_t
 {
@@ -199,99 +203,6 @@ hb_raster_png_write_blob_fini (hb_raster_png_write_blob_t *w)
  * Image compositing
  */
 
-/* Unpack premultiplied pixel to float RGBA [0,1]. */
-static inline void
-unpack_to_float (uint32_t px, float &r, float &g, float &b, float &a)
-{
-  b = (px & 0xFF) / 255.f;
-  g = ((px >> 8) & 0xFF) / 255.f;
-  r = ((px >> 16) & 0xFF) / 255.f;
-  a = (px >> 24) / 255.f;
-}
-
-/* Pack float RGBA [0,1] premultiplied back to uint32_t. */
-static inline uint32_t
-pack_from_float (float r, float g, float b, float a)
-{
-  return hb_raster_pack_pixel ((uint8_t) (hb_clamp (b, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (g, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (r, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (a, 0.f, 1.f) * 255.f + 0.5f));
-}
-
-/* Separable blend mode functions: operate on unpremultiplied [0,1] channels. */
-static inline float
-blend_multiply (float sc, float dc) { return sc * dc; }
-static inline float
-blend_screen (float sc, float dc) { return sc + dc - sc * dc; }
-static inline float
-blend_overlay (float sc, float dc)
-{ return dc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
-static inline float
-blend_darken (float sc, float dc) { return hb_min (sc, dc); }
-static inline float
-blend_lighten (float sc, float dc) { return hb_max (sc, dc); }
-static inline float
-blend_color_dodge (float sc, float dc)
-{
-  if (dc <= 0.f) return 0.f;
-  if (sc >= 1.f) return 1.f;
-  return hb_min (1.f, dc / (1.f - sc));
-}
-static inline float
-blend_color_burn (float sc, float dc)
-{
-  if (dc >= 1.f) return 1.f;
-  if (sc <= 0.f) return 0.f;
-  return 1.f - hb_min (1.f, (1.f - dc) / sc);
-}
-static inline float
-blend_hard_light (float sc, float dc)
-{ return sc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
-static inline float
-blend_soft_light (float sc, float dc)
-{
-  if (sc <= 0.5f)
-    return dc - (1.f - 2.f * sc) * dc * (1.f - dc);
-  float d = (dc <= 0.25f) ? ((16.f * dc - 12.f) * dc + 4.f) * dc
-			   : sqrtf (dc);
-  return dc + (2.f * sc - 1.f) * (d - dc);
-}
-static inline float
-blend_difference (float sc, float dc) { return fabsf (sc - dc); }
-static inline float
-blend_exclusion (float sc, float dc) { return sc + dc - 2.f * sc * dc; }
-
-/* Apply a separable blend mode per-pixel.
- * Both src and dst are premultiplied BGRA32. */
-static inline uint32_t
-apply_separable_blend (uint32_t src, uint32_t dst,
-		       float (*blend_fn)(float, float))
-{
-  float sr, sg, sb, sa;
-  float dr, dg, db, da;
-  unpack_to_float (src, sr, sg, sb, sa);
-  unpack_to_float (dst, dr, dg, db, da);
-
-  float usr = sa > 0.f ? sr / sa : 0.f;
-  float usg = sa > 0.f ? sg / sa : 0.f;
-  float usb = sa > 0.f ? sb / sa : 0.f;
-  float udr = da > 0.f ? dr / da : 0.f;
-  float udg = da > 0.f ? dg / da : 0.f;
-  float udb = da > 0.f ? db / da : 0.f;
-
-  float br = blend_fn (usr, udr);
-  float bg = blend_fn (usg, udg);
-  float bb = blend_fn (usb, udb);
-
-  float ra = sa + da - sa * da;
-  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
-  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
-  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
-
-  return pack_from_float (rr, rg, rb, ra);
-}
-
 /* HSL helpers */
 static inline float
 hsl_luminosity (float r, float g, float b)
@@ -363,8 +274,8 @@ apply_hsl_blend (uint32_t src, uint32_t dst,
 {
   float sr, sg, sb, sa;
   float dr, dg, db, da;
-  unpack_to_float (src, sr, sg, sb, sa);
-  unpack_to_float (dst, dr, dg, db, da);
+  hb_raster_unpack_to_float (src, sr, sg, sb, sa);
+  hb_raster_unpack_to_float (dst, dr, dg, db, da);
 
   float usr = sa > 0.f ? sr / sa : 0.f;
   float usg = sa > 0.f ? sg / sa : 0.f;
@@ -403,7 +314,7 @@ apply_hsl_blend (uint32_t src, uint32_t dst,
   float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
   float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
 
-  return pack_from_float (rr, rg, rb, ra);
+  return hb_raster_pack_from_float (rr, rg, rb, ra);
 }
 
 /* Composite per-pixel with full blend mode support. */
@@ -474,17 +385,17 @@ composite_pixel (uint32_t src, uint32_t dst,
     return hb_raster_pack_pixel (rb, rg, rr, ra);
   }
 
-  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:  return apply_separable_blend (src, dst, blend_multiply);
-  case HB_PAINT_COMPOSITE_MODE_SCREEN:    return apply_separable_blend (src, dst, blend_screen);
-  case HB_PAINT_COMPOSITE_MODE_OVERLAY:   return apply_separable_blend (src, dst, blend_overlay);
-  case HB_PAINT_COMPOSITE_MODE_DARKEN:    return apply_separable_blend (src, dst, blend_darken);
-  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:   return apply_separable_blend (src, dst, blend_lighten);
-  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: return apply_separable_blend (src, dst, blend_color_dodge);
-  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  return apply_separable_blend (src, dst, blend_color_burn);
-  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  return apply_separable_blend (src, dst, blend_hard_light);
-  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  return apply_separable_blend (src, dst, blend_soft_light);
-  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  return apply_separable_blend (src, dst, blend_difference);
-  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   return apply_separable_blend (src, dst, blend_exclusion);
+  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:  return hb_raster_separable_blend (src, dst, hb_raster_blend_multiply);
+  case HB_PAINT_COMPOSITE_MODE_SCREEN:    return hb_raster_separable_blend (src, dst, hb_raster_blend_screen);
+  case HB_PAINT_COMPOSITE_MODE_OVERLAY:   return hb_raster_separable_blend (src, dst, hb_raster_blend_overlay);
+  case HB_PAINT_COMPOSITE_MODE_DARKEN:    return hb_raster_separable_blend (src, dst, hb_raster_blend_darken);
+  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:   return hb_raster_separable_blend (src, dst, hb_raster_blend_lighten);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: return hb_raster_separable_blend (src, dst, hb_raster_blend_color_dodge);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  return hb_raster_separable_blend (src, dst, hb_raster_blend_color_burn);
+  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  return hb_raster_separable_blend (src, dst, hb_raster_blend_hard_light);
+  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  return hb_raster_separable_blend (src, dst, hb_raster_blend_soft_light);
+  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  return hb_raster_separable_blend (src, dst, hb_raster_blend_difference);
+  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   return hb_raster_separable_blend (src, dst, hb_raster_blend_exclusion);
 
   case HB_PAINT_COMPOSITE_MODE_HSL_HUE:
   case HB_PAINT_COMPOSITE_MODE_HSL_SATURATION:
@@ -524,6 +435,19 @@ hb_raster_image_t::configure (hb_raster_format_t format,
   if (extents.height && extents.stride > (size_t) -1 / extents.height)
     return false;
 
+  if (is_external ())
+  {
+    /* Caller-owned storage cannot grow; the last row only needs
+     * its pixels, so atlas slots may end flush with the buffer. */
+    if (extents.height &&
+	(size_t) extents.stride * (extents.height - 1) + min_stride > external_length)
+      return false;
+
+    this->format = format;
+    this->extents = extents;
+    return true;
+  }
+
   size_t buf_size = (size_t) extents.stride * extents.height;
   if (buf_size > HB_RASTER_MAX_BUFFER_SIZE)
     return false;
@@ -693,22 +617,321 @@ hb_raster_image_t::deserialize_from_png (hb_blob_t *blob)
     }
   }
 
+  hb_raster_png_read_blob_fini (reader);
+
+  if (is_external ())
+  {
+    /* Decode into the caller's storage, keeping its stride. */
+    hb_raster_extents_t old_extents = this->extents;
+    hb_raster_format_t old_format = format;
+    decoded_extents.stride = this->extents.stride;
+    if (!configure (HB_RASTER_FORMAT_BGRA32, decoded_extents))
+    {
+      this->extents = old_extents;
+      format = old_format;
+      return false;
+    }
+    for (unsigned y = 0; y < (unsigned) h; y++)
+      hb_memcpy (external_data + (size_t) y * this->extents.stride,
+		 decoded.buffer.arrayZ + (size_t) y * decoded.extents.stride,
+		 (size_t) w * 4u);
+    return true;
+  }
+
   hb_swap (buffer, decoded.buffer);
   hb_swap (this->extents, decoded.extents);
   hb_swap (format, decoded.format);
-  hb_raster_png_read_blob_fini (reader);
   return true;
 #endif
 }
 
+#ifdef HAVE_ZLIB
+/* PNG row filtering, for one byte per pixel.  @prev is the previous
+ * unfiltered row, all zeros for the first one. */
+static inline uint8_t
+hb_raster_png_paeth (uint8_t a, uint8_t b, uint8_t c)
+{
+  int p = (int) a + (int) b - (int) c;
+  int pa = abs (p - (int) a);
+  int pb = abs (p - (int) b);
+  int pc = abs (p - (int) c);
+  return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+static void
+hb_raster_png_filter_row (unsigned filter,
+			  const uint8_t *row,
+			  const uint8_t *prev,
+			  unsigned width,
+			  uint8_t *out)
+{
+  out[0] = (uint8_t) filter;
+  out++;
+  switch (filter)
+  {
+  case 0: /* None */
+    hb_memcpy (out, row, width);
+    break;
+  case 1: /* Sub */
+    out[0] = row[0];
+    for (unsigned x = 1; x < width; x++)
+      out[x] = row[x] - row[x - 1];
+    break;
+  case 2: /* Up */
+    for (unsigned x = 0; x < width; x++)
+      out[x] = row[x] - prev[x];
+    break;
+  case 3: /* Average */
+    out[0] = row[0] - (prev[0] >> 1);
+    for (unsigned x = 1; x < width; x++)
+      out[x] = row[x] - (uint8_t) (((unsigned) row[x - 1] + prev[x]) >> 1);
+    break;
+  case 4: /* Paeth */
+    out[0] = row[0] - prev[0];
+    for (unsigned x = 1; x < width; x++)
+      out[x] = row[x] - hb_raster_png_paeth (row[x - 1], prev[x], prev[x - 1]);
+    break;
+  }
+}
+
+/* Sum of the filtered bytes as signed differences; the smaller, the
+ * better the row tends to compress. */
+static unsigned
+hb_raster_png_filter_cost (const uint8_t *filtered, unsigned width)
+{
+  unsigned cost = 0;
+  for (unsigned x = 1; x <= width; x++)
+    cost += (unsigned) abs ((int) (int8_t) filtered[x]);
+  return cost;
+}
+
+static inline void
+hb_raster_png_put_u32 (uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t) (v >> 24);
+  p[1] = (uint8_t) (v >> 16);
+  p[2] = (uint8_t) (v >> 8);
+  p[3] = (uint8_t) v;
+}
+
+/* Reserves a chunk with @length bytes of data at the end of @out; the
+ * caller fills the data in, then hb_raster_png_end_chunk() writes the
+ * header and CRC, and trims to the @length actually used. */
+static bool
+hb_raster_png_begin_chunk (hb_vector_t<uint8_t> *out, unsigned length)
+{
+  return out->resize_dirty (out->length + 8 + length + 4);
+}
+
+static void
+hb_raster_png_end_chunk (hb_vector_t<uint8_t> *out, unsigned start,
+			 uint32_t tag, unsigned length)
+{
+  uint8_t *p = out->arrayZ + start;
+  hb_raster_png_put_u32 (p, length);
+  hb_raster_png_put_u32 (p + 4, tag);
+  uLong crc = crc32 (0L, p + 4, 4 + length);
+  hb_raster_png_put_u32 (p + 8 + length, (uint32_t) crc);
+  out->resize_dirty (start + 8 + length + 4);
+}
+
+static bool
+hb_raster_png_add_chunk (hb_vector_t<uint8_t> *out, uint32_t tag,
+			 const uint8_t *data, unsigned length)
+{
+  unsigned start = out->length;
+  if (unlikely (!hb_raster_png_begin_chunk (out, length)))
+    return false;
+  if (length)
+    hb_memcpy (out->arrayZ + start + 8, data, length);
+  hb_raster_png_end_chunk (out, start, tag, length);
+  return true;
+}
+
+/* Built-in encoder for A8 images: filters rows and deflates them with
+ * zlib directly, or writes stored deflate blocks at level 0.  Avoids
+ * libpng's per-image setup and per-row callbacks, which dominate for
+ * glyph-sized images. */
+static hb_blob_t *
+hb_raster_png_encode_a8 (const hb_raster_image_t *image,
+			 const hb_raster_png_options_t &options)
+{
+  unsigned width = image->extents.width;
+  unsigned height = image->extents.height;
+  unsigned row_bytes = width + 1;
+  unsigned raw_len;
+  if (width == UINT_MAX ||
+      hb_unsigned_mul_overflows (row_bytes, height, &raw_len))
+    return nullptr;
+
+  int level = hb_clamp (options.compression_level, -1, 9);
+  unsigned filter = options.filter;
+  if (filter > HB_RASTER_PNG_FILTER_PAETH)
+    filter = HB_RASTER_PNG_FILTER_DEFAULT;
+  if (filter == HB_RASTER_PNG_FILTER_DEFAULT && level == 0)
+    filter = HB_RASTER_PNG_FILTER_NONE;
+
+  /* Filtered scanlines, top row first. */
+  hb_vector_t<uint8_t> raw;
+  if (unlikely (!raw.resize_dirty (raw_len)))
+    return nullptr;
+  hb_vector_t<uint8_t> scratch;
+  if (filter == HB_RASTER_PNG_FILTER_DEFAULT &&
+      unlikely (!scratch.resize_dirty (row_bytes)))
+    return nullptr;
+  hb_vector_t<uint8_t> zeros;
+  if (unlikely (!zeros.resize (width)))
+    return nullptr;
+
+  const uint8_t *prev = zeros.arrayZ;
+  for (unsigned y = 0; y < height; y++)
+  {
+    const uint8_t *row = image->data () + (size_t) (height - 1 - y) * image->extents.stride;
+    uint8_t *out = raw.arrayZ + (size_t) y * row_bytes;
+    if (filter != HB_RASTER_PNG_FILTER_DEFAULT)
+      hb_raster_png_filter_row (filter - HB_RASTER_PNG_FILTER_NONE, row, prev, width, out);
+    else
+    {
+      hb_raster_png_filter_row (0, row, prev, width, out);
+      unsigned best = hb_raster_png_filter_cost (out, width);
+      for (unsigned f = 1; f <= 4 && best; f++)
+      {
+	hb_raster_png_filter_row (f, row, prev, width, scratch.arrayZ);
+	unsigned cost = hb_raster_png_filter_cost (scratch.arrayZ, width);
+	if (cost < best)
+	{
+	  best = cost;
+	  hb_memcpy (out, scratch.arrayZ, row_bytes);
+	}
+      }
+    }
+    prev = row;
+  }
+
+  hb_vector_t<uint8_t> png;
+  static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  bool palette = options.a8_mode == HB_RASTER_PNG_A8_PALETTE;
+  uint8_t ihdr[13];
+  hb_raster_png_put_u32 (ihdr, width);
+  hb_raster_png_put_u32 (ihdr + 4, height);
+  ihdr[8] = 8;			/* Bit depth */
+  ihdr[9] = palette ? 3 : 0;	/* Indexed or grayscale */
+  ihdr[10] = ihdr[11] = ihdr[12] = 0;
+  if (unlikely (!png.alloc (8 + 25 + (palette ? 12 + 768 + 12 + 256 : 0) +
+			    12 + raw_len / 4 + 12)))
+    return nullptr;
+  png.resize_dirty (8);
+  hb_memcpy (png.arrayZ, signature, 8);
+  if (unlikely (!hb_raster_png_add_chunk (&png, 0x49484452u /* IHDR */, ihdr, 13)))
+    return nullptr;
+  if (palette)
+  {
+    /* Black at every alpha; pixel values index into it directly. */
+    uint8_t trns[256];
+    for (unsigned i = 0; i < 256; i++)
+      trns[i] = (uint8_t) i;
+    unsigned start = png.length;
+    if (unlikely (!hb_raster_png_begin_chunk (&png, 768)))
+      return nullptr;
+    hb_memset (png.arrayZ + start + 8, 0, 768);
+    hb_raster_png_end_chunk (&png, start, 0x504C5445u /* PLTE */, 768);
+    if (unlikely (!hb_raster_png_add_chunk (&png, 0x74524E53u /* tRNS */, trns, 256)))
+      return nullptr;
+  }
+
+  unsigned idat_start = png.length;
+  unsigned idat_len;
+  if (level == 0)
+  {
+    /* zlib stream of stored blocks; no deflate state needed. */
+    unsigned blocks = raw_len ? (raw_len + 65534) / 65535 : 1;
+    idat_len = 2 + blocks * 5 + raw_len + 4;
+    if (unlikely (!hb_raster_png_begin_chunk (&png, idat_len)))
+      return nullptr;
+    uint8_t *p = png.arrayZ + idat_start + 8;
+    *p++ = 0x78;
+    *p++ = 0x01;
+    unsigned offset = 0;
+    for (unsigned b = 0; b < blocks; b++)
+    {
+      unsigned n = hb_min (raw_len - offset, 65535u);
+      *p++ = b + 1 == blocks ? 1 : 0;
+      p[0] = (uint8_t) n;
+      p[1] = (uint8_t) (n >> 8);
+      p[2] = (uint8_t) ~n;
+      p[3] = (uint8_t) (~n >> 8);
+      p += 4;
+      hb_memcpy (p, raw.arrayZ + offset, n);
+      p += n;
+      offset += n;
+    }
+    hb_raster_png_put_u32 (p, (uint32_t) adler32 (1L, raw.arrayZ, raw_len));
+  }
+  else
+  {
+    /* A window and hash no larger than the data compress the same,
+     * and are much cheaper to set up for glyph-sized images.  At the
+     * fast levels, run-length matching suits coverage masks, which
+     * are mostly runs of 0 and 255; it is both faster and smaller. */
+    int window_bits = 9;
+    while (window_bits < 15 && (1u << window_bits) < raw_len)
+      window_bits++;
+    int mem_level = hb_clamp (window_bits - 6, 5, 8);
+    int strategy = level >= 1 && level <= 3 ? Z_RLE : Z_DEFAULT_STRATEGY;
+    z_stream stream = {};
+    if (deflateInit2 (&stream, level, Z_DEFLATED, window_bits,
+		      mem_level, strategy) != Z_OK)
+      return nullptr;
+    uLong bound = deflateBound (&stream, raw_len);
+    if (bound > UINT_MAX - png.length - 12 - 12 ||
+	unlikely (!hb_raster_png_begin_chunk (&png, (unsigned) bound)))
+    {
+      deflateEnd (&stream);
+      return nullptr;
+    }
+    stream.next_in = raw.arrayZ;
+    stream.avail_in = raw_len;
+    stream.next_out = png.arrayZ + idat_start + 8;
+    stream.avail_out = (uInt) bound;
+    int status = deflate (&stream, Z_FINISH);
+    idat_len = (unsigned) stream.total_out;
+    deflateEnd (&stream);
+    if (status != Z_STREAM_END)
+      return nullptr;
+  }
+  hb_raster_png_end_chunk (&png, idat_start, 0x49444154u /* IDAT */, idat_len);
+  if (unlikely (!hb_raster_png_add_chunk (&png, 0x49454E44u /* IEND */, nullptr, 0)))
+    return nullptr;
+
+  unsigned length;
+  char *data = (char *) png.steal (&length);
+  if (!data)
+    return nullptr;
+  hb_blob_t *blob = hb_blob_create_or_fail (data, length,
+					    HB_MEMORY_MODE_WRITABLE,
+					    data, hb_free);
+  if (!blob)
+    hb_free (data);
+  return blob;
+}
+#endif
+
 hb_blob_t *
-hb_raster_image_t::serialize_to_png_or_fail () const
+hb_raster_image_t::serialize_to_png_or_fail (const hb_raster_png_options_t &options) const
 {
+  if (!extents.width || !extents.height)
+    return nullptr;
+
+#ifdef HAVE_ZLIB
+  if (format == HB_RASTER_FORMAT_A8)
+    return hb_raster_png_encode_a8 (this, options);
+#endif
+
 #ifndef HAVE_PNG
   return nullptr;
 #else
-  if (format != HB_RASTER_FORMAT_BGRA32 || !extents.width || !extents.height)
-    return nullptr;
+  bool a8 = format == HB_RASTER_FORMAT_A8;
+  bool palette = a8 && options.a8_mode == HB_RASTER_PNG_A8_PALETTE;
 
   png_structp png = png_create_write_struct (PNG_LIBPNG_VER_STRING, nullptr,
 					     hb_raster_png_error,
@@ -740,13 +963,39 @@ hb_raster_image_t::serialize_to_png_or_fail () const
 
   png_set_IHDR (png, info,
 		extents.width, extents.height,
-		8, PNG_COLOR_TYPE_RGBA,
+		8, palette ? PNG_COLOR_TYPE_PALETTE :
+		   a8 ? PNG_COLOR_TYPE_GRAY : PNG_COLOR_TYPE_RGBA,
 		PNG_INTERLACE_NONE,
 		PNG_COMPRESSION_TYPE_DEFAULT,
 		PNG_FILTER_TYPE_DEFAULT);
+  if (palette)
+  {
+    /* Black at every alpha; pixel values index into it directly. */
+    png_color colors[256] = {};
+    png_byte alphas[256];
+    for (unsigned i = 0; i < 256; i++)
+      alphas[i] = (png_byte) i;
+    png_set_PLTE (png, info, colors, 256);
+    png_set_tRNS (png, info, alphas, 256, nullptr);
+  }
+  if (options.compression_level >= 0)
+    png_set_compression_level (png, hb_min (options.compression_level, 9));
+  switch (options.filter)
+  {
+  case HB_RASTER_PNG_FILTER_NONE:    png_set_filter (png, 0, PNG_FILTER_NONE);  break;
+  case HB_RASTER_PNG_FILTER_SUB:     png_set_filter (png, 0, PNG_FILTER_SUB);   break;
+  case HB_RASTER_PNG_FILTER_UP:      png_set_filter (png, 0, PNG_FILTER_UP);    break;
+  case HB_RASTER_PNG_FILTER_AVERAGE: png_set_filter (png, 0, PNG_FILTER_AVG);   break;
+  case HB_RASTER_PNG_FILTER_PAETH:   png_set_filter (png, 0, PNG_FILTER_PAETH); break;
+  case HB_RASTER_PNG_FILTER_DEFAULT:
+  default:
+    if (options.compression_level == 0)
+      png_set_filter (png, 0, PNG_FILTER_NONE);
+    break;
+  }
   png_write_info (png, info);
 
-  size_t rowbytes = (size_t) extents.width * 4u;
+  size_t rowbytes = (size_t) extents.width * (a8 ? 1u : 4u);
   size_t rgba_size = rowbytes * (size_t) extents.height;
   if (extents.height && rgba_size / (size_t) extents.height != rowbytes)
   {
@@ -755,8 +1004,9 @@ hb_raster_image_t::serialize_to_png_or_fail () const
     return nullptr;
   }
 
-  writer->rgba = (uint8_t *) hb_malloc (rgba_size);
-  if (!writer->rgba)
+  /* A8 rows are written as they are; BGRA32 is unpremultiplied. */
+  writer->rgba = a8 ? nullptr : (uint8_t *) hb_malloc (rgba_size);
+  if (!a8 && !writer->rgba)
   {
     png_destroy_write_struct (&png, &info);
     hb_raster_png_write_blob_fini (writer);
@@ -781,9 +1031,14 @@ hb_raster_image_t::serialize_to_png_or_fail () const
 
   for (unsigned y = 0; y < extents.height; y++)
   {
-    uint8_t *dst = writer->rgba + (size_t) y * rowbytes;
-    const uint8_t *src = buffer.arrayZ + (size_t) (extents.height - 1 - y) * extents.stride;
+    const uint8_t *src = data () + (size_t) (extents.height - 1 - y) * extents.stride;
+    if (a8)
+    {
+      writer->rows[y] = (png_bytep) src;
+      continue;
+    }
 
+    uint8_t *dst = writer->rgba + (size_t) y * rowbytes;
     for (unsigned x = 0; x < extents.width; x++)
     {
       uint32_t px;
@@ -836,14 +1091,25 @@ hb_raster_image_t::serialize_to_png_or_fail () const
 void
 hb_raster_image_t::clear ()
 {
-  size_t buf_size = (size_t) extents.stride * extents.height;
-  hb_memset (buffer.arrayZ, 0, buf_size);
+  unsigned row_bytes = extents.width * bytes_per_pixel (format);
+  if (!is_external () || extents.stride == row_bytes)
+  {
+    size_t buf_size = (size_t) extents.stride * extents.height;
+    if (buf_size)
+      hb_memset (data (), 0, buf_size);
+    return;
+  }
+
+  /* Padding of caller-owned rows may belong to neighboring atlas
+   * slots; only touch the image's own pixels. */
+  for (unsigned y = 0; y < extents.height; y++)
+    hb_memset (external_data + (size_t) y * extents.stride, 0, row_bytes);
 }
 
 const uint8_t *
 hb_raster_image_t::get_buffer () const
 {
-  return buffer.arrayZ;
+  return data ();
 }
 
 void
@@ -853,18 +1119,27 @@ hb_raster_image_t::composite_from (const hb_raster_image_t *src,
   unsigned w = extents.width;
   unsigned h = extents.height;
   unsigned stride = extents.stride;
+  unsigned src_stride = src->extents.stride;
 
   for (unsigned y = 0; y < h; y++)
   {
-    hb_packed_t<uint32_t> *dp = (hb_packed_t<uint32_t> *) (buffer.arrayZ + y * stride);
-    const hb_packed_t<uint32_t> *sp = (const hb_packed_t<uint32_t> *) (src->buffer.arrayZ + y * stride);
+    hb_packed_t<uint32_t> *dp = (hb_packed_t<uint32_t> *) (data () + y * stride);
+    const hb_packed_t<uint32_t> *sp = (const hb_packed_t<uint32_t> *) (src->data () + y * src_stride);
+    if (mode == HB_PAINT_COMPOSITE_MODE_SRC_OVER)
+    {
+      hb_raster_src_over_span (dp, sp, nullptr, w);
+      continue;
+    }
+    if (hb_raster_separable_blend_span (dp, sp, w, mode))
+      continue;
     for (unsigned x = 0; x < w; x++)
       dp[x] = hb_packed_t<uint32_t> (composite_pixel ((uint32_t) sp[x], (uint32_t) dp[x], mode));
   }
 }
 
 /* Composite src image onto dst image.
- * Both images must have the same extents and BGRA32 format. */
+ * Both images must have the same width, height and BGRA32 format;
+ * strides may differ. */
 void
 hb_raster_image_composite (hb_raster_image_t *dst,
 			   const hb_raster_image_t *src,
@@ -894,6 +1169,67 @@ hb_raster_image_create_or_fail (void)
   return hb_object_create<hb_raster_image_t> ();
 }
 
+/**
+ * hb_raster_image_create_for_data_or_fail:
+ * @data: (array length=length): caller-owned pixel storage
+ * @length: length of @data in bytes
+ * @format: the pixel format
+ * @extents: image extents; @extents.stride is the row pitch of @data
+ * @user_data: (nullable): data to pass to @destroy
+ * @destroy: (nullable): callback to call when the image no longer
+ *   references @data
+ *
+ * Creates a raster image that wraps caller-owned pixel storage, such
+ * as a glyph-atlas slot or a mapped upload buffer.  Rows are stored
+ * bottom-to-top, @extents.stride bytes apart; only the
+ * @extents.width pixels of each row are ever written, so row padding
+ * may belong to neighboring slots.
+ *
+ * Pass the image to hb_raster_draw_set_target_image() or
+ * hb_raster_paint_set_target_image() to render directly into @data,
+ * without an intermediate image allocation or copy.
+ *
+ * The image can be reconfigured with hb_raster_image_configure(), but
+ * only within @length; its storage is never reallocated.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_raster_image_t, or `NULL` if @data is too
+ * small for @extents or on allocation failure.  On failure, @destroy
+ * is called immediately.
+ *
+ * XSince: REPLACEME
+ **/
+hb_raster_image_t *
+hb_raster_image_create_for_data_or_fail (uint8_t                   *data,
+					 unsigned int               length,
+					 hb_raster_format_t         format,
+					 const hb_raster_extents_t *extents,
+					 void                      *user_data,
+					 hb_destroy_func_t          destroy)
+{
+  hb_raster_image_t *image;
+  if (unlikely (!data || !extents ||
+		!(image = hb_object_create<hb_raster_image_t> ())))
+  {
+    if (destroy)
+      destroy (user_data);
+    return nullptr;
+  }
+
+  image->external_data = data;
+  image->external_length = length;
+  image->external_user_data = user_data;
+  image->external_destroy = destroy;
+
+  if (unlikely (!image->configure (format, *extents)))
+  {
+    hb_raster_image_destroy (image);
+    return nullptr;
+  }
+
+  return image;
+}
+
 /**
  * hb_raster_image_reference: (skip)
  * @image: a raster image
@@ -985,7 +1321,9 @@ hb_raster_image_get_user_data (const hb_raster_image_t  *image,
  * at most once. This function does not clear pixel contents.
  *
  * Passing `NULL` for @extents clears extents and releases the backing
- * allocation.
+ * allocation.  Images wrapping caller-owned storage (see
+ * hb_raster_image_create_for_data_or_fail()) can only be configured to
+ * extents that fit in that storage.
  *
  * Return value: `true` if configuration succeeds, `false` on allocation
  * failure
@@ -1101,9 +1439,8 @@ hb_raster_image_deserialize_from_png_or_fail (hb_raster_image_t *image,
  * hb_raster_image_serialize_to_png_or_fail:
  * @image: a raster image
  *
- * Serializes @image to a PNG blob.
- *
- * Currently only #HB_RASTER_FORMAT_BGRA32 images are supported.
+ * Serializes @image to a PNG blob, with the default options.
+ * See hb_raster_image_serialize_to_png_with_options_or_fail().
  *
  * Return value: (transfer full):
  * A newly allocated PNG #hb_blob_t, or `NULL` on failure
@@ -1113,5 +1450,36 @@ hb_raster_image_deserialize_from_png_or_fail (hb_raster_image_t *image,
 hb_blob_t *
 hb_raster_image_serialize_to_png_or_fail (const hb_raster_image_t *image)
 {
-  return image->serialize_to_png_or_fail ();
+  hb_raster_png_options_t options = HB_RASTER_PNG_OPTIONS_DEFAULT;
+  return image->serialize_to_png_or_fail (options);
+}
+
+/**
+ * hb_raster_image_serialize_to_png_with_options_or_fail:
+ * @image: a raster image
+ * @options: (nullable): encoding options, or `NULL` for the defaults
+ *
+ * Serializes @image to a PNG blob.
+ *
+ * #HB_RASTER_FORMAT_BGRA32 images are stored as unpremultiplied RGBA,
+ * and #HB_RASTER_FORMAT_A8 images as set by @options.
+ *
+ * When built with zlib, A8 images are encoded without libpng, which
+ * makes the per-image cost close to that of the compression alone.
+ * For many small images, such as individual glyphs, a low
+ * @compression_level with a fixed filter, or level 0 to store the
+ * pixels uncompressed, encodes several times faster than the defaults
+ * at the expense of size.
+ *
+ * Return value: (transfer full):
+ * A newly allocated PNG #hb_blob_t, or `NULL` on failure
+ *
+ * XSince: REPLACEME
+ **/
+hb_blob_t *
+hb_raster_image_serialize_to_png_with_options_or_fail (const hb_raster_image_t       *image,
+						       const hb_raster_png_options_t *options)
+{
+  hb_raster_png_options_t default_options = HB_RASTER_PNG_OPTIONS_DEFAULT;
+  return image->serialize_to_png_or_fail (options ? *options : default_options);
 }
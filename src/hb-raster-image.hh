@@ -43,10 +43,27 @@ struct hb_raster_image_t
   hb_raster_extents_t  extents     = {};
   hb_raster_format_t   format      = HB_RASTER_FORMAT_A8;
 
+  /* Caller-owned pixel storage; when set, used instead of buffer.
+   * See hb_raster_image_create_for_data_or_fail(). */
+  uint8_t             *external_data   = nullptr;
+  size_t               external_length = 0;
+  void                *external_user_data = nullptr;
+  hb_destroy_func_t    external_destroy   = nullptr;
+
+  ~hb_raster_image_t ()
+  {
+    if (external_destroy)
+      external_destroy (external_user_data);
+  }
+
+  bool is_external () const { return external_data; }
+  uint8_t *data () { return is_external () ? external_data : buffer.arrayZ; }
+  const uint8_t *data () const { return is_external () ? external_data : buffer.arrayZ; }
+
   HB_INTERNAL static unsigned bytes_per_pixel (hb_raster_format_t format);
   HB_INTERNAL bool configure (hb_raster_format_t format, hb_raster_extents_t extents);
   HB_INTERNAL bool deserialize_from_png (hb_blob_t *png);
-  HB_INTERNAL hb_blob_t *serialize_to_png_or_fail () const;
+  HB_INTERNAL hb_blob_t *serialize_to_png_or_fail (const hb_raster_png_options_t &options) const;
   HB_INTERNAL void clear ();
   HB_INTERNAL const uint8_t *get_buffer () const;
   HB_INTERNAL void composite_from (const hb_raster_image_t *src,
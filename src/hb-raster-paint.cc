@@ -29,6 +29,7 @@
 #include "hb-raster-paint.hh"
 #include "hb-machinery.hh"
 #include "hb-paint.hh"
+#include "hb-ot.h"
 
 #include <math.h>
 
@@ -48,51 +49,6 @@ color_to_premul_pixel (hb_color_t color)
   return (uint32_t) b | ((uint32_t) g << 8) | ((uint32_t) r << 16) | ((uint32_t) a << 24);
 }
 
-/* Bilinear sample from a premultiplied BGRA32 image. */
-static inline uint32_t
-hb_raster_sample_bilinear_premul (const hb_packed_t<uint32_t> *src,
-				  unsigned width,
-				  unsigned height,
-				  float x,
-				  float y)
-{
-  int x0 = (int) floorf (x);
-  int y0 = (int) floorf (y);
-  int x1 = x0 + 1;
-  int y1 = y0 + 1;
-  if (x1 >= (int) width) x1 = (int) width - 1;
-  if (y1 >= (int) height) y1 = (int) height - 1;
-
-  float tx = x - x0;
-  float ty = y - y0;
-  float omtx = 1.f - tx;
-  float omty = 1.f - ty;
-
-  uint32_t p00 = (uint32_t) src[(size_t) y0 * width + (size_t) x0];
-  uint32_t p10 = (uint32_t) src[(size_t) y0 * width + (size_t) x1];
-  uint32_t p01 = (uint32_t) src[(size_t) y1 * width + (size_t) x0];
-  uint32_t p11 = (uint32_t) src[(size_t) y1 * width + (size_t) x1];
-
-  float w00 = omtx * omty;
-  float w10 = tx * omty;
-  float w01 = omtx * ty;
-  float w11 = tx * ty;
-
-  float b = ((p00 >>  0) & 0xff) * w00 + ((p10 >>  0) & 0xff) * w10 +
-	    ((p01 >>  0) & 0xff) * w01 + ((p11 >>  0) & 0xff) * w11;
-  float g = ((p00 >>  8) & 0xff) * w00 + ((p10 >>  8) & 0xff) * w10 +
-	    ((p01 >>  8) & 0xff) * w01 + ((p11 >>  8) & 0xff) * w11;
-  float r = ((p00 >> 16) & 0xff) * w00 + ((p10 >> 16) & 0xff) * w10 +
-	    ((p01 >> 16) & 0xff) * w01 + ((p11 >> 16) & 0xff) * w11;
-  float a = ((p00 >> 24) & 0xff) * w00 + ((p10 >> 24) & 0xff) * w10 +
-	    ((p01 >> 24) & 0xff) * w01 + ((p11 >> 24) & 0xff) * w11;
-
-  return (uint32_t) (b + 0.5f)
-       | ((uint32_t) (g + 0.5f) << 8)
-       | ((uint32_t) (r + 0.5f) << 16)
-       | ((uint32_t) (a + 0.5f) << 24);
-}
-
 
 /*
  * Paint callbacks
@@ -123,7 +79,7 @@ ensure_initialized (hb_raster_paint_t *c)
     return;
 
   /* Root surface */
-  hb_raster_image_t *root = c->acquire_surface ();
+  hb_raster_image_t *root = c->acquire_root_surface ();
   if (unlikely (!root)) return;
 
   if (hb_color_get_alpha (c->background))
@@ -132,15 +88,13 @@ ensure_initialized (hb_raster_paint_t *c)
 			    hb_color_get_green (c->background),
 			    hb_color_get_red (c->background),
 			    hb_color_get_alpha (c->background));
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-align"
-    uint32_t *pixels = (uint32_t *) hb_raster_image_get_buffer (root);
-#pragma GCC diagnostic pop
-    hb_raster_extents_t ext;
-    hb_raster_image_get_extents (root, &ext);
-    unsigned count = ext.width * ext.height;
-    for (unsigned i = 0; i < count; i++)
-      pixels[i] = bg;
+    const hb_raster_extents_t &ext = root->extents;
+    for (unsigned y = 0; y < ext.height; y++)
+    {
+      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (root->data () + (size_t) y * ext.stride);
+      for (unsigned x = 0; x < ext.width; x++)
+	row[x] = hb_packed_t<uint32_t> (bg);
+    }
   }
 
   if (unlikely (!c->surface_stack.push_or_fail (root)))
@@ -165,6 +119,17 @@ ensure_initialized (hb_raster_paint_t *c)
   }
 }
 
+/* Called from every paint callback other than the transform ones:
+ * those that clip, group or paint.  Notes that content was painted,
+ * so a subtree that consisted of transforms alone can be told apart
+ * (see hb_raster_paint_render_subtree()). */
+static void
+begin_content (hb_raster_paint_t *c)
+{
+  c->painted_content = true;
+  ensure_initialized (c);
+}
+
 static void
 hb_raster_paint_push_transform (hb_paint_funcs_t *pfuncs HB_UNUSED,
 				void *paint_data,
@@ -192,17 +157,215 @@ hb_raster_paint_pop_transform (hb_paint_funcs_t *pfuncs HB_UNUSED,
     c->transform_stack.pop ();
 }
 
+/* Render the paint graph of @glyph, under the current transform, into
+ * a new surface with extents @ext and a clear clip, and return it
+ * cropped to its painted pixels.  Returns nullptr on failure or if
+ * the work budget ran out, leaving the paint stacks as they were. */
+static hb_raster_image_t *
+hb_raster_paint_render_subtree (hb_raster_paint_t *c,
+				hb_font_t *font,
+				hb_codepoint_t glyph,
+				const hb_raster_extents_t &ext)
+{
+  /* The clear, and the crop scan below. */
+  if (unlikely (!c->charge_work (2 * (int64_t) ext.width * ext.height)))
+    return nullptr;
+
+  hb_raster_image_t *surf = hb_raster_image_create_or_fail ();
+  if (unlikely (!surf)) return nullptr;
+  if (unlikely (!surf->configure (HB_RASTER_FORMAT_BGRA32, ext)))
+  {
+    hb_raster_image_destroy (surf);
+    return nullptr;
+  }
+  surf->clear ();
+
+  unsigned surface_depth = c->surface_stack.length;
+  unsigned clip_depth = c->clip_stack.length;
+  unsigned transform_depth = c->transform_stack.length;
+
+  hb_raster_clip_t clip;
+  clip.init_full (ext.width, ext.height);
+  if (unlikely (!c->surface_stack.push_or_fail (surf)))
+  {
+    hb_raster_image_destroy (surf);
+    return nullptr;
+  }
+  if (unlikely (!c->clip_stack.push_or_fail (std::move (clip))))
+  {
+    c->surface_stack.pop ();
+    hb_raster_image_destroy (surf);
+    return nullptr;
+  }
+
+  /* Nested PaintColrGlyph nodes are painted in place, under the
+   * cycle detection of this inner traversal. */
+  bool painted_content = c->painted_content;
+  c->painted_content = false;
+  c->caching_group = true;
+  hb_font_paint_glyph (font, glyph,
+		       hb_raster_paint_get_funcs (c), c,
+		       c->palette, c->foreground);
+  c->caching_group = false;
+  /* Painted as a root glyph, an unbounded paint graph without a
+   * ClipBox is skipped, leaving just the push and pop of the font
+   * transform; painted in place it fills the current clip.  Let the
+   * caller do the latter.  Any bounded graph clips or paints. */
+  bool skipped = !c->painted_content;
+  c->painted_content = painted_content;
+
+  while (c->clip_stack.length > clip_depth)
+    c->release_clip (c->clip_stack.pop ());
+  while (c->surface_stack.length > surface_depth + 1)
+    c->release_surface (c->surface_stack.pop ());
+  c->transform_stack.resize (transform_depth);
+  if (unlikely (c->surface_stack.length != surface_depth + 1 ||
+		c->surface_stack.tail () != surf))
+    return nullptr; /* Unbalanced group calls consumed our surface. */
+  c->surface_stack.pop ();
+
+  if (unlikely (skipped || c->work_left <= 0))
+  {
+    hb_raster_image_destroy (surf);
+    return nullptr;
+  }
+
+  /* Crop to the bounding box of non-zero alpha. */
+  unsigned x0 = ext.width, y0 = ext.height, x1 = 0, y1 = 0;
+  for (unsigned y = 0; y < ext.height; y++)
+  {
+    const hb_packed_t<uint32_t> *row = (const hb_packed_t<uint32_t> *) (surf->data () + (size_t) y * surf->extents.stride);
+    for (unsigned x = 0; x < ext.width; x++)
+      if ((uint32_t) row[x] >> 24)
+      {
+	x0 = hb_min (x0, x);
+	x1 = hb_max (x1, x + 1);
+	y0 = hb_min (y0, y);
+	y1 = y + 1;
+      }
+  }
+  if (x0 >= x1)
+    x0 = x1 = y0 = y1 = 0;
+  if (x0 == 0 && y0 == 0 && x1 == ext.width && y1 == ext.height)
+    return surf;
+
+  hb_raster_extents_t cropped = {
+    ext.x_origin + (int) x0, ext.y_origin + (int) y0,
+    x1 - x0, y1 - y0, 0
+  };
+  hb_raster_image_t *result = hb_raster_image_create_or_fail ();
+  if (unlikely (!result || !result->configure (HB_RASTER_FORMAT_BGRA32, cropped)))
+  {
+    hb_raster_image_destroy (result);
+    hb_raster_image_destroy (surf);
+    return nullptr;
+  }
+  for (unsigned y = 0; y < cropped.height; y++)
+    hb_memcpy (result->data () + (size_t) y * result->extents.stride,
+	       surf->data () + (size_t) (y0 + y) * surf->extents.stride + x0 * 4,
+	       cropped.width * 4);
+  hb_raster_image_destroy (surf);
+  return result;
+}
+
+/* Composite @img, a premultiplied BGRA32 image in the pixel space of
+ * @surf, onto @surf through the current clip. */
+static void
+hb_raster_paint_composite_through_clip (hb_raster_paint_t *c,
+					hb_raster_image_t *surf,
+					const hb_raster_image_t *img)
+{
+  const hb_raster_clip_t &clip = c->current_clip ();
+  if (unlikely (!clip.has_valid_alpha_mask ())) return;
+
+  int64_t ox = (int64_t) img->extents.x_origin - surf->extents.x_origin;
+  int64_t oy = (int64_t) img->extents.y_origin - surf->extents.y_origin;
+  int64_t x0 = hb_max ((int64_t) clip.min_x, ox);
+  int64_t y0 = hb_max ((int64_t) clip.min_y, oy);
+  int64_t x1 = hb_min ((int64_t) clip.max_x, ox + img->extents.width);
+  int64_t y1 = hb_min ((int64_t) clip.max_y, oy + img->extents.height);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  if (unlikely (!c->charge_work ((x1 - x0) * (y1 - y0))))
+    return;
+
+  unsigned n = (unsigned) (x1 - x0);
+  for (int64_t y = y0; y < y1; y++)
+  {
+    hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + (size_t) y * surf->extents.stride);
+    const hb_packed_t<uint32_t> *src = (const hb_packed_t<uint32_t> *)
+				       (img->data () + (size_t) (y - oy) * img->extents.stride) + (x0 - ox);
+    const uint8_t *cov = clip.is_rect ? nullptr : clip.alpha.arrayZ + (size_t) y * clip.stride + x0;
+    hb_raster_src_over_span (row + x0, src, cov, n);
+  }
+}
+
+/* PaintColrGlyph: render the referenced glyph's paint graph once into
+ * the subtree cache, then composite it wherever it recurs with the
+ * same transform and colors.  This is only done for glyphs painted
+ * with hb_raster_paint_glyph(), where the palette and foreground the
+ * font is painted with are known. */
 static hb_bool_t
 hb_raster_paint_color_glyph (hb_paint_funcs_t *pfuncs HB_UNUSED,
-			     void *paint_data HB_UNUSED,
-			     hb_codepoint_t glyph HB_UNUSED,
-			     hb_font_t *font HB_UNUSED,
+			     void *paint_data,
+			     hb_codepoint_t glyph,
+			     hb_font_t *font,
 			     void *user_data HB_UNUSED)
 {
-  return false;
-}
+  hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
+
+  if (!c->cache.max_bytes || !c->painting_glyph || c->caching_group)
+    return false;
+  if (!hb_ot_color_glyph_has_paint (hb_font_get_face (font), glyph))
+    return false;
 
-typedef void (*hb_raster_paint_clip_mask_emit_t) (hb_raster_draw_t *rdr, void *user_data);
+  begin_content (c);
+
+  hb_raster_image_t *surf = c->current_surface ();
+  if (unlikely (!surf || c->work_left <= 0)) return false;
+
+  const hb_raster_extents_t &ext = surf->extents;
+  int sx0 = ext.x_origin, sy0 = ext.y_origin;
+  int sx1 = hb_clamp_to<int32_t> ((int64_t) sx0 + ext.width);
+  int sy1 = hb_clamp_to<int32_t> ((int64_t) sy0 + ext.height);
+
+  hb_raster_paint_cache_key_t key;
+  key.font = font;
+  key.serial = hb_font_get_serial (font);
+  key.glyph = glyph;
+  key.transform = c->current_effective_transform ();
+  key.is_group = true;
+  key.palette = c->palette;
+  key.foreground = c->foreground;
+  key.palette_serial = c->custom_palette_serial;
+
+  const hb_raster_image_t *img = c->cache.lookup (key, sx0, sy0, sx1, sy1);
+  if (img)
+  {
+    hb_raster_paint_composite_through_clip (c, surf, img);
+    return true;
+  }
+
+  /* Render for a box larger than the surface, like glyph masks. */
+  hb_raster_extents_t box = {
+    hb_clamp_to<int32_t> ((int64_t) sx0 - ext.width / 2),
+    hb_clamp_to<int32_t> ((int64_t) sy0 - ext.height / 2),
+    0, 0, 0
+  };
+  box.width = (unsigned) (hb_clamp_to<int32_t> ((int64_t) sx1 + ext.width / 2) - box.x_origin);
+  box.height = (unsigned) (hb_clamp_to<int32_t> ((int64_t) sy1 + ext.height / 2) - box.y_origin);
+
+  hb_raster_image_t *rendered = hb_raster_paint_render_subtree (c, font, glyph, box);
+  if (unlikely (!rendered))
+    return false;
+
+  hb_raster_paint_composite_through_clip (c, surf, rendered);
+  if (!c->cache.insert (key, rendered,
+			box.x_origin, box.y_origin,
+			box.x_origin + (int) box.width, box.y_origin + (int) box.height))
+    hb_raster_image_destroy (rendered);
+  return true;
+}
 
 /* Attach the surface box and the session work budget to @rdr before
  * outlines are drawn into it: curves outside the surface collapse to
@@ -262,41 +425,15 @@ hb_raster_paint_intersect_mask (const hb_raster_image_t *surf,
   return true;
 }
 
-/* Render whatever edges have been accumulated into @rdr and
- * push the result as a new clip on the stack, intersecting
- * with the existing clip.  Used by the emitter-based clip
- * helpers (push_clip_glyph) and by push_clip_path_end once
- * the caller has drawn the path into @rdr. */
+/* Intersect @mask_img, an A8 coverage mask in the pixel space of
+ * @surf, with the current clip and push the result as a new clip.
+ * The caller has charged the work. */
 static void
-hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
-				    hb_raster_draw_t *rdr,
-				    hb_raster_image_t *surf,
-				    unsigned w, unsigned h)
+hb_raster_paint_push_clip_mask (hb_raster_paint_t *c,
+				const hb_raster_image_t *mask_img,
+				hb_raster_image_t *surf,
+				unsigned w, unsigned h)
 {
-  /* Charge the scanline work of the accumulated outline before
-   * rendering it. */
-  c->work_left -= hb_raster_draw_get_edge_work (rdr, h);
-
-  hb_raster_image_t *mask_img = hb_raster_draw_render (rdr);
-
-  if (unlikely (!mask_img))
-  {
-    hb_raster_paint_push_empty_clip (c, w, h);
-    return;
-  }
-
-  /* Charge the mask render (its own area; may exceed the surface) plus
-   * the clip-buffer pass below. */
-  hb_raster_extents_t mask_render_ext;
-  hb_raster_image_get_extents (mask_img, &mask_render_ext);
-  if (unlikely (!c->charge_work ((int64_t) mask_render_ext.width * mask_render_ext.height +
-				 (int64_t) w * h)))
-  {
-    hb_raster_draw_recycle_image (rdr, mask_img);
-    hb_raster_paint_push_empty_clip (c, w, h);
-    return;
-  }
-
   hb_raster_clip_t new_clip = c->acquire_clip (w, h);
 
   /* Allocate alpha buffer and intersect with previous clip */
@@ -304,7 +441,6 @@ hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
   if (unlikely (clip_size > HB_RASTER_MAX_BUFFER_SIZE ||
                 !new_clip.alpha.resize ((unsigned) clip_size)))
   {
-    hb_raster_draw_recycle_image (rdr, mask_img);
     hb_raster_paint_push_empty_clip (c, w, h);
     return;
   }
@@ -316,7 +452,6 @@ hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
   const hb_raster_clip_t &old_clip = c->current_clip ();
   if (unlikely (!old_clip.has_valid_alpha_mask ()))
   {
-    hb_raster_draw_recycle_image (rdr, mask_img);
     hb_raster_paint_push_empty_clip (c, w, h);
     return;
   }
@@ -327,7 +462,6 @@ hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
 				       &mask_x0, &mask_y0,
 				       &ix0, &iy0, &ix1, &iy1))
   {
-    hb_raster_draw_recycle_image (rdr, mask_img);
     hb_raster_paint_push_empty_clip (c, w, h);
     return;
   }
@@ -395,54 +529,137 @@ hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
     }
   }
 
-  hb_raster_draw_recycle_image (rdr, mask_img);
   if (unlikely (!c->clip_stack.push_or_fail (std::move (new_clip))))
     hb_raster_paint_push_empty_clip (c, w, h);
 }
 
-static void
-hb_raster_paint_push_clip_from_emitter (hb_raster_paint_t *c,
-					hb_raster_paint_clip_mask_emit_t emit,
-					void *emit_data)
-{
-  ensure_initialized (c);
 
-  hb_raster_image_t *surf = c->current_surface ();
-  if (unlikely (!surf)) return;
+/* Render whatever edges have been accumulated into @rdr and
+ * push the result as a new clip on the stack, intersecting
+ * with the existing clip.  Used by push_clip_path_end once
+ * the caller has drawn the path into @rdr.  Returns the
+ * rendered mask, which the caller must recycle, or nullptr. */
+static hb_raster_image_t *
+hb_raster_paint_finalize_path_clip (hb_raster_paint_t *c,
+				    hb_raster_draw_t *rdr,
+				    hb_raster_image_t *surf,
+				    unsigned w, unsigned h)
+{
+  /* Charge the scanline work of the accumulated outline before
+   * rendering it. */
+  c->work_left -= hb_raster_draw_get_edge_work (rdr, h);
 
-  unsigned w = surf->extents.width;
-  unsigned h = surf->extents.height;
+  hb_raster_image_t *mask_img = hb_raster_draw_render (rdr);
 
-  /* Out of budget: skip the glyph-outline extraction entirely, so
-   * per-glyph outline limits cannot multiply with the caller's
-   * paint-graph traversal limits. */
-  if (unlikely (c->work_left <= 0))
+  if (unlikely (!mask_img))
   {
     hb_raster_paint_push_empty_clip (c, w, h);
-    return;
+    return nullptr;
   }
 
-  hb_raster_draw_t *rdr = c->clip_rdr;
-  hb_transform_t<> t = c->current_effective_transform ();
-  hb_raster_draw_set_transform (rdr, t.xx, t.yx, t.xy, t.yy, t.x0, t.y0);
-  hb_raster_paint_attach_clip_rdr (c, rdr, surf);
-  emit (rdr, emit_data);
+  /* Charge the mask render (its own area; may exceed the surface) plus
+   * the clip-buffer pass below. */
+  hb_raster_extents_t mask_render_ext;
+  hb_raster_image_get_extents (mask_img, &mask_render_ext);
+  if (unlikely (!c->charge_work ((int64_t) mask_render_ext.width * mask_render_ext.height +
+				 (int64_t) w * h)))
+  {
+    hb_raster_paint_push_empty_clip (c, w, h);
+    return mask_img;
+  }
 
-  hb_raster_paint_finalize_path_clip (c, rdr, surf, w, h);
+  hb_raster_paint_push_clip_mask (c, mask_img, surf, w, h);
+  return mask_img;
 }
 
-struct hb_raster_paint_glyph_clip_data_t
+/* The coverage mask of a glyph outline under the current transform,
+ * for drawing onto a surface.  Served from the subtree cache when
+ * possible; otherwise rasterized through the clip rasterizer, with
+ * its work charged. */
+struct hb_raster_paint_glyph_mask_t
 {
-  hb_codepoint_t glyph;
-  hb_font_t *font;
+  const hb_raster_image_t *image = nullptr;
+  hb_raster_image_t *rendered = nullptr;	/* Owned; nullptr on cache hit */
+  hb_raster_paint_cache_key_t key;
+  int box_x0 = 0, box_y0 = 0, box_x1 = 0, box_y1 = 0;
 };
 
+static bool
+hb_raster_paint_get_glyph_mask (hb_raster_paint_t *c,
+				const hb_raster_image_t *surf,
+				hb_codepoint_t glyph,
+				hb_font_t *font,
+				hb_raster_paint_glyph_mask_t *m)
+{
+  const hb_raster_extents_t &ext = surf->extents;
+  int sx0 = ext.x_origin, sy0 = ext.y_origin;
+  int sx1 = hb_clamp_to<int32_t> ((int64_t) sx0 + ext.width);
+  int sy1 = hb_clamp_to<int32_t> ((int64_t) sy0 + ext.height);
+
+  hb_transform_t<> t = c->current_effective_transform ();
+
+  m->box_x0 = sx0; m->box_y0 = sy0;
+  m->box_x1 = sx1; m->box_y1 = sy1;
+  if (c->cache.max_bytes)
+  {
+    m->key.font = font;
+    m->key.serial = hb_font_get_serial (font);
+    m->key.glyph = glyph;
+    m->key.transform = t;
+    if ((m->image = c->cache.lookup (m->key, sx0, sy0, sx1, sy1)))
+      return true;
+
+    /* Render for a box larger than the surface, so that the mask
+     * also serves the differently-sized surfaces of other glyphs
+     * sharing this outline. */
+    m->box_x0 = hb_clamp_to<int32_t> ((int64_t) sx0 - ext.width / 2);
+    m->box_y0 = hb_clamp_to<int32_t> ((int64_t) sy0 - ext.height / 2);
+    m->box_x1 = hb_clamp_to<int32_t> ((int64_t) sx1 + ext.width / 2);
+    m->box_y1 = hb_clamp_to<int32_t> ((int64_t) sy1 + ext.height / 2);
+  }
+
+  /* Curves outside the box collapse to their chord, and flattening
+   * work is charged as it happens. */
+  hb_raster_draw_t *rdr = c->clip_rdr;
+  hb_raster_draw_set_transform (rdr, t.xx, t.yx, t.xy, t.yy, t.x0, t.y0);
+  hb_raster_draw_set_clip_box (rdr,
+			       (float) m->box_x0, (float) m->box_y0,
+			       (float) m->box_x1, (float) m->box_y1);
+  hb_raster_draw_set_external_work (rdr, &c->work_left);
+  /* Let draw-render choose tight glyph extents; we map by mask origin. */
+  hb_font_draw_glyph (font, glyph, hb_raster_draw_get_funcs (rdr), rdr);
+
+  /* Charge the scanline work of the accumulated outline before
+   * rendering it. */
+  c->work_left -= hb_raster_draw_get_edge_work (rdr, (unsigned) (m->box_y1 - m->box_y0));
+
+  m->rendered = hb_raster_draw_render (rdr);
+  if (unlikely (!m->rendered))
+    return false;
+
+  /* Charge the mask render (its own area; may exceed the surface). */
+  hb_raster_extents_t mask_ext;
+  hb_raster_image_get_extents (m->rendered, &mask_ext);
+  if (unlikely (!c->charge_work ((int64_t) mask_ext.width * mask_ext.height)))
+    return false;
+
+  m->image = m->rendered;
+  return true;
+}
+
 static void
-hb_raster_paint_emit_clip_glyph_mask (hb_raster_draw_t *rdr, void *user_data)
+hb_raster_paint_release_glyph_mask (hb_raster_paint_t *c,
+				    hb_raster_paint_glyph_mask_t *m)
 {
-  hb_raster_paint_glyph_clip_data_t *data = (hb_raster_paint_glyph_clip_data_t *) user_data;
-  /* Let draw-render choose tight glyph extents; we map by mask origin below. */
-  hb_font_draw_glyph (data->font, data->glyph, hb_raster_draw_get_funcs (rdr), rdr);
+  if (!m->rendered) return;
+
+  /* Only cache complete masks: flattening degrades once the work
+   * budget runs out. */
+  if (!m->image || !c->cache.max_bytes || c->work_left <= 0 ||
+      !c->cache.insert (m->key, m->rendered,
+			m->box_x0, m->box_y0, m->box_x1, m->box_y1))
+    hb_raster_draw_recycle_image (c->clip_rdr, m->rendered);
+  m->rendered = nullptr;
 }
 
 static void
@@ -453,8 +670,31 @@ hb_raster_paint_push_clip_glyph (hb_paint_funcs_t *pfuncs HB_UNUSED,
 				 void *user_data HB_UNUSED)
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
-  hb_raster_paint_glyph_clip_data_t data = {glyph, font};
-  hb_raster_paint_push_clip_from_emitter (c, hb_raster_paint_emit_clip_glyph_mask, &data);
+
+  begin_content (c);
+
+  hb_raster_image_t *surf = c->current_surface ();
+  if (unlikely (!surf)) return;
+
+  unsigned w = surf->extents.width;
+  unsigned h = surf->extents.height;
+
+  /* Out of budget: skip the glyph-outline extraction entirely, so
+   * per-glyph outline limits cannot multiply with the caller's
+   * paint-graph traversal limits. */
+  if (unlikely (c->work_left <= 0))
+  {
+    hb_raster_paint_push_empty_clip (c, w, h);
+    return;
+  }
+
+  hb_raster_paint_glyph_mask_t m;
+  if (likely (hb_raster_paint_get_glyph_mask (c, surf, glyph, font, &m) &&
+	      c->charge_work ((int64_t) w * h)))
+    hb_raster_paint_push_clip_mask (c, m.image, surf, w, h);
+  else
+    hb_raster_paint_push_empty_clip (c, w, h);
+  hb_raster_paint_release_glyph_mask (c, &m);
 }
 
 static void
@@ -466,7 +706,7 @@ hb_raster_paint_push_clip_rectangle (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   if (!c->surface_stack.length) return;
 
@@ -708,7 +948,7 @@ hb_raster_paint_push_clip_path_start (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   /* Prime clip_rdr with the current effective transform; the
    * caller then drives hb_draw_*() into it, and _end renders
@@ -751,7 +991,9 @@ hb_raster_paint_push_clip_path_end (hb_paint_funcs_t *pfuncs HB_UNUSED,
     return;
   }
 
-  hb_raster_paint_finalize_path_clip (c, c->clip_rdr, surf, w, h);
+  hb_raster_image_t *mask_img = hb_raster_paint_finalize_path_clip (c, c->clip_rdr, surf, w, h);
+  if (mask_img)
+    hb_raster_draw_recycle_image (c->clip_rdr, mask_img);
 }
 
 static void
@@ -771,13 +1013,21 @@ hb_raster_paint_push_group (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
+
+  hb_raster_image_t *surf = c->current_surface ();
+  if (unlikely (!surf)) return;
+
+  /* Groups match the current surface, which is not the root surface
+   * while rendering a subtree for the cache. */
+  hb_raster_extents_t ext = surf->extents;
+  ext.stride = 0;
 
   /* acquire_surface() clears a full surface; charge its area. */
-  if (unlikely (!c->charge_work ((int64_t) c->fixed_extents.width * c->fixed_extents.height)))
+  if (unlikely (!c->charge_work ((int64_t) ext.width * ext.height)))
     return;
 
-  hb_raster_image_t *new_surf = c->acquire_surface ();
+  hb_raster_image_t *new_surf = c->acquire_surface (ext);
   if (unlikely (!new_surf)) return;
   if (unlikely (!c->surface_stack.push_or_fail (new_surf)))
     c->release_surface (new_surf);
@@ -807,7 +1057,7 @@ static void
 hb_raster_paint_solid (hb_raster_paint_t *c,
 		       hb_raster_image_t *surf,
 		       hb_color_t color,
-		       hb_raster_image_t *mask_img)
+		       const hb_raster_image_t *mask_img)
 {
   uint32_t premul = color_to_premul_pixel (color);
   uint8_t premul_a = (uint8_t) (premul >> 24);
@@ -836,33 +1086,32 @@ hb_raster_paint_solid (hb_raster_paint_t *c,
   if (unlikely (!c->charge_work ((int64_t) (ix1 - ix0) * (iy1 - iy0))))
     return;
 
+  /* A span of the solid color, for the span compositor. */
+  hb_packed_t<uint32_t> solid[HB_RASTER_SPAN_LENGTH];
+  for (unsigned i = 0; i < HB_RASTER_SPAN_LENGTH; i++)
+    solid[i] = hb_packed_t<uint32_t> (premul);
+
   if (likely (!clip.is_rect))
   {
+    uint8_t cov[HB_RASTER_SPAN_LENGTH];
     for (unsigned y = iy0; y < iy1; y++)
     {
-      hb_packed_t<uint32_t> *__restrict row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + y * stride);
+      hb_packed_t<uint32_t> *__restrict row = (hb_packed_t<uint32_t> *) (surf->data () + y * stride);
       const uint8_t *__restrict clip_row = clip.alpha.arrayZ + y * clip.stride;
       const uint8_t *__restrict mask_row = mask_buf ? mask_buf + (unsigned) ((int64_t) y - mask_y0) * mask_ext.stride
 						    : nullptr;
       unsigned mx = (unsigned) ((int64_t) ix0 - mask_x0);
-      for (unsigned x = ix0; x < ix1; x++)
+      for (unsigned x0 = ix0; x0 < ix1; x0 += HB_RASTER_SPAN_LENGTH)
       {
-	uint8_t clip_alpha = clip_row[x];
+	unsigned n = hb_min (ix1 - x0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	const uint8_t *span_cov = clip_row + x0;
 	if (mask_row)
-	  clip_alpha = hb_raster_div255 (mask_row[mx++] * clip_alpha);
-	if (clip_alpha == 0) continue;
-	if (clip_alpha == 255)
 	{
-	  if (premul_a == 255)
-	    row[x] = hb_packed_t<uint32_t> (premul);
-	  else
-	    row[x] = hb_packed_t<uint32_t> (hb_raster_src_over (premul, (uint32_t) row[x]));
-	}
-	else
-	{
-	  uint32_t src = hb_raster_alpha_mul (premul, clip_alpha);
-	  row[x] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[x]));
+	  for (unsigned i = 0; i < n; i++)
+	    cov[i] = hb_raster_div255 (mask_row[mx++] * span_cov[i]);
+	  span_cov = cov;
 	}
+	hb_raster_src_over_span (row + x0, solid, span_cov, n);
       }
     }
   }
@@ -870,15 +1119,14 @@ hb_raster_paint_solid (hb_raster_paint_t *c,
   {
     for (unsigned y = iy0; y < iy1; y++)
     {
-      hb_packed_t<uint32_t> *__restrict row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + y * stride);
+      hb_packed_t<uint32_t> *__restrict row = (hb_packed_t<uint32_t> *) (surf->data () + y * stride);
       const uint8_t *__restrict mask_row = mask_buf + (unsigned) ((int64_t) y - mask_y0) * mask_ext.stride;
       unsigned mx = (unsigned) ((int64_t) ix0 - mask_x0);
-      for (unsigned x = ix0; x < ix1; x++)
+      for (unsigned x0 = ix0; x0 < ix1; x0 += HB_RASTER_SPAN_LENGTH)
       {
-	uint8_t mask_alpha = mask_row[mx++];
-	if (mask_alpha == 0) continue;
-	uint32_t src = hb_raster_alpha_mul (premul, mask_alpha);
-	row[x] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[x]));
+	unsigned n = hb_min (ix1 - x0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	hb_raster_src_over_span (row + x0, solid, mask_row + mx, n);
+	mx += n;
       }
     }
   }
@@ -886,9 +1134,10 @@ hb_raster_paint_solid (hb_raster_paint_t *c,
   {
     for (unsigned y = clip.min_y; y < clip.max_y; y++)
     {
-      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + y * stride);
-      for (unsigned x = clip.min_x; x < clip.max_x; x++)
-	row[x] = hb_packed_t<uint32_t> (hb_raster_src_over (premul, (uint32_t) row[x]));
+      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + y * stride);
+      for (unsigned x0 = clip.min_x; x0 < clip.max_x; x0 += HB_RASTER_SPAN_LENGTH)
+	hb_raster_src_over_span (row + x0, solid, nullptr,
+				 hb_min (clip.max_x - x0, (unsigned) HB_RASTER_SPAN_LENGTH));
     }
   }
 }
@@ -902,7 +1151,7 @@ hb_raster_paint_color (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   hb_raster_image_t *surf = c->current_surface ();
   if (unlikely (!surf)) return;
@@ -921,7 +1170,7 @@ hb_raster_paint_fill_glyph (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   hb_raster_image_t *surf = c->current_surface ();
   if (unlikely (!surf)) return;
@@ -929,27 +1178,114 @@ hb_raster_paint_fill_glyph (hb_paint_funcs_t *pfuncs HB_UNUSED,
   /* Out of budget: skip the glyph-outline extraction entirely. */
   if (unlikely (c->work_left <= 0)) return;
 
-  hb_raster_draw_t *rdr = c->clip_rdr;
-  hb_transform_t<> t = c->current_effective_transform ();
-  hb_raster_draw_set_transform (rdr, t.xx, t.yx, t.xy, t.yy, t.x0, t.y0);
-  hb_raster_paint_attach_clip_rdr (c, rdr, surf);
+  hb_raster_paint_glyph_mask_t m;
+  if (likely (hb_raster_paint_get_glyph_mask (c, surf, glyph, font, &m)))
+    hb_raster_paint_solid (c, surf, color, m.image);
+  hb_raster_paint_release_glyph_mask (c, &m);
+}
 
-  hb_raster_paint_glyph_clip_data_t data = {glyph, font};
-  hb_raster_paint_emit_clip_glyph_mask (rdr, &data);
+/* The texels of a BGRA image blob, if it holds @width x @height of them. */
+static const hb_packed_t<uint32_t> *
+hb_raster_paint_bgra_image_data (hb_blob_t *blob,
+				 unsigned width,
+				 unsigned height)
+{
+  if (width == 0 || height == 0)
+    return nullptr;
+  if (width > (unsigned) INT_MAX || height > (unsigned) INT_MAX)
+    return nullptr;
 
-  /* Charge the scanline work of the accumulated outline before
-   * rendering it. */
-  c->work_left -= hb_raster_draw_get_edge_work (rdr, surf->extents.height);
+  unsigned data_len;
+  const uint8_t *data = (const uint8_t *) hb_blob_get_data (blob, &data_len);
+  size_t pixel_count = (size_t) width * (size_t) height;
+  if (width && pixel_count / width != height)
+    return nullptr;
+  if (pixel_count > (size_t) -1 / 4u)
+    return nullptr;
+  size_t required_size = pixel_count * 4u;
+  if (!data || (size_t) data_len < required_size)
+    return nullptr;
 
-  hb_raster_image_t *mask_img = hb_raster_draw_render (rdr);
-  if (unlikely (!mask_img)) return;
+  return (const hb_packed_t<uint32_t> *) data;
+}
 
-  hb_raster_extents_t mask_ext;
-  hb_raster_image_get_extents (mask_img, &mask_ext);
-  if (likely (c->charge_work ((int64_t) mask_ext.width * mask_ext.height)))
-    hb_raster_paint_solid (c, surf, color, mask_img);
+static bool
+hb_raster_paint_decode_image (hb_blob_t *blob,
+			      unsigned width,
+			      unsigned height,
+			      hb_tag_t format,
+			      hb_raster_paint_image_t *out)
+{
+  hb_raster_image_t *img = hb_raster_image_create_or_fail ();
+  if (unlikely (!img)) return false;
+  if (unlikely (!out->levels.push_or_fail (img)))
+  {
+    hb_raster_image_destroy (img);
+    return false;
+  }
+
+  if (format == HB_PAINT_IMAGE_FORMAT_BGRA)
+  {
+    const hb_packed_t<uint32_t> *data = hb_raster_paint_bgra_image_data (blob, width, height);
+    if (!data)
+      return false;
+    hb_raster_extents_t ext = {0, 0, width, height, 0};
+    if (unlikely (!img->configure (HB_RASTER_FORMAT_BGRA32, ext)))
+      return false;
+    hb_memcpy (img->data (), data, (size_t) width * height * 4u);
+    return true;
+  }
+
+  if (format == HB_PAINT_IMAGE_FORMAT_PNG)
+    return img->deserialize_from_png (blob);
+
+  return false;
+}
+
+unsigned
+hb_raster_paint_image_t::ensure_level (unsigned level)
+{
+  while (levels.length <= level)
+  {
+    const hb_raster_image_t *src = levels.tail ();
+    unsigned sw = src->extents.width;
+    unsigned sh = src->extents.height;
+    if (sw < 2 && sh < 2)
+      break;
 
-  hb_raster_draw_recycle_image (rdr, mask_img);
+    hb_raster_image_t *dst = hb_raster_image_create_or_fail ();
+    if (unlikely (!dst)) break;
+    hb_raster_extents_t ext = {0, 0, (sw + 1) / 2, (sh + 1) / 2, 0};
+    if (unlikely (!dst->configure (HB_RASTER_FORMAT_BGRA32, ext) ||
+		  !levels.push_or_fail (dst)))
+    {
+      hb_raster_image_destroy (dst);
+      break;
+    }
+
+    /* 2x2 box filter; odd edges repeat their last texel. */
+    const hb_packed_t<uint32_t> *s = (const hb_packed_t<uint32_t> *) src->data ();
+    hb_packed_t<uint32_t> *d = (hb_packed_t<uint32_t> *) dst->data ();
+    for (unsigned y = 0; y < ext.height; y++)
+    {
+      const hb_packed_t<uint32_t> *r0 = s + (size_t) (2 * y) * sw;
+      const hb_packed_t<uint32_t> *r1 = s + (size_t) hb_min (2 * y + 1, sh - 1) * sw;
+      for (unsigned x = 0; x < ext.width; x++)
+      {
+	unsigned x0 = 2 * x, x1 = hb_min (2 * x + 1, sw - 1);
+	uint32_t p[4] = {r0[x0], r0[x1], r1[x0], r1[x1]};
+	uint32_t out = 0;
+	for (unsigned shift = 0; shift < 32; shift += 8)
+	{
+	  unsigned sum = ((p[0] >> shift) & 0xFF) + ((p[1] >> shift) & 0xFF) +
+			 ((p[2] >> shift) & 0xFF) + ((p[3] >> shift) & 0xFF);
+	  out |= ((sum + 2) >> 2) << shift;
+	}
+	d[(size_t) y * ext.width + x] = out;
+      }
+    }
+  }
+  return levels.length - 1;
 }
 
 static hb_bool_t
@@ -965,54 +1301,54 @@ hb_raster_paint_image (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   /* Out of budget: skip, including the image decode below. */
   if (unlikely (c->work_left <= 0)) return false;
 
+  if (format != HB_PAINT_IMAGE_FORMAT_BGRA &&
+      format != HB_PAINT_IMAGE_FORMAT_PNG)
+    return false;
+
+  hb_raster_image_t *surf = c->current_surface ();
+  if (unlikely (!surf)) return false;
+  if (!extents) return false;
+
+  /* Uncached BGRA is sampled straight from the blob; everything else
+   * goes through the decoded image cache. */
   unsigned src_width = width;
   unsigned src_height = height;
   const hb_packed_t<uint32_t> *src_data = nullptr;
-  hb_raster_image_t decoded_png;
+  hb_raster_paint_image_t decoded;
+  HB_SCOPE_GUARD (decoded.fini ());
+  hb_raster_paint_image_t *image = nullptr;
 
-  if (format == HB_PAINT_IMAGE_FORMAT_BGRA)
+  if (format == HB_PAINT_IMAGE_FORMAT_BGRA &&
+      !(c->image_mipmaps && c->image_cache.max_bytes))
   {
-    if (src_width == 0 || src_height == 0)
-      return false;
-    if (src_width > (unsigned) INT_MAX || src_height > (unsigned) INT_MAX)
-      return false;
-
-    unsigned data_len;
-    const uint8_t *data = (const uint8_t *) hb_blob_get_data (blob, &data_len);
-    size_t pixel_count = (size_t) src_width * (size_t) src_height;
-    if (src_width && pixel_count / src_width != src_height)
-      return false;
-    if (pixel_count > (size_t) -1 / 4u)
+    if (!(src_data = hb_raster_paint_bgra_image_data (blob, width, height)))
       return false;
-    size_t required_size = pixel_count * 4u;
-    if (!data || (size_t) data_len < required_size)
-      return false;
-
-    src_data = (const hb_packed_t<uint32_t> *) data;
   }
-  else if (format == HB_PAINT_IMAGE_FORMAT_PNG)
+  else
   {
-#ifdef HAVE_PNG
-    if (!decoded_png.deserialize_from_png (blob))
-      return false;
-    src_width = decoded_png.extents.width;
-    src_height = decoded_png.extents.height;
-    src_data = (const hb_packed_t<uint32_t> *) decoded_png.buffer.arrayZ;
-#else
-    return false;
-#endif
+    if (c->image_cache.max_bytes)
+      image = c->image_cache.lookup (blob, format);
+    if (!image)
+    {
+      if (!hb_raster_paint_decode_image (blob, width, height, format, &decoded))
+	return false;
+      image = c->image_cache.insert (blob, format, decoded);
+      if (!image)
+	image = &decoded;
+    }
   }
-  else
-    return false;
 
-  hb_raster_image_t *surf = c->current_surface ();
-  if (unlikely (!surf)) return false;
-  if (!extents) return false;
+  if (image)
+  {
+    src_width = image->levels[0]->extents.width;
+    src_height = image->levels[0]->extents.height;
+    src_data = (const hb_packed_t<uint32_t> *) image->levels[0]->data ();
+  }
 
   const hb_raster_clip_t &clip = c->current_clip ();
   hb_transform_t<> t = c->current_effective_transform ();
@@ -1032,6 +1368,37 @@ hb_raster_paint_image (hb_paint_funcs_t *pfuncs HB_UNUSED,
   int ox = surf->extents.x_origin;
   int oy = surf->extents.y_origin;
 
+  /* When minifying, sample the mipmap level closest above the output
+   * resolution instead of the full-size image. */
+  if (image && image != &decoded && c->image_mipmaps &&
+      extents->width && extents->height)
+  {
+    float img_sx = (float) extents->width / src_width;
+    float img_sy = (float) extents->height / src_height;
+    /* Texels stepped per output pixel, along each output axis. */
+    float step_x = sqrtf ((inv_xx / img_sx) * (inv_xx / img_sx) +
+			  (inv_yx / img_sy) * (inv_yx / img_sy));
+    float step_y = sqrtf ((inv_xy / img_sx) * (inv_xy / img_sx) +
+			  (inv_yy / img_sy) * (inv_yy / img_sy));
+    float step = hb_min (step_x, step_y);
+    unsigned level = 0;
+    while (step >= 2.f && level < 16)
+    {
+      step *= .5f;
+      level++;
+    }
+    if (level)
+    {
+      unsigned old_levels = image->levels.length;
+      level = image->ensure_level (level);
+      if (image->levels.length != old_levels)
+	c->image_cache.update (blob, format);
+      src_width = image->levels[level]->extents.width;
+      src_height = image->levels[level]->extents.height;
+      src_data = (const hb_packed_t<uint32_t> *) image->levels[level]->data ();
+    }
+  }
+
   /* Image source rectangle in glyph space */
   float img_x = extents->x_bearing;
   float img_y = extents->y_bearing;
@@ -1052,7 +1419,7 @@ hb_raster_paint_image (hb_paint_funcs_t *pfuncs HB_UNUSED,
   {
     for (unsigned py = clip.min_y; py < clip.max_y; py++)
     {
-      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * surf_stride);
+      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * surf_stride);
       float gx = inv_xx * (float) ((int) clip.min_x + ox) + inv_xy * (float) ((int) py + oy) + inv_x0;
       float gy = inv_yx * (float) ((int) clip.min_x + ox) + inv_yy * (float) ((int) py + oy) + inv_y0;
       for (unsigned px = clip.min_x; px < clip.max_x; px++)
@@ -1082,7 +1449,7 @@ hb_raster_paint_image (hb_paint_funcs_t *pfuncs HB_UNUSED,
   {
     for (unsigned py = clip.min_y; py < clip.max_y; py++)
     {
-      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * surf_stride);
+      hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * surf_stride);
       const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
       float gx = inv_xx * (float) ((int) clip.min_x + ox) + inv_xy * (float) ((int) py + oy) + inv_x0;
       float gy = inv_yx * (float) ((int) clip.min_x + ox) + inv_yy * (float) ((int) py + oy) + inv_y0;
@@ -1248,6 +1615,192 @@ lookup_gradient_lut (const uint32_t *lut,
   return lut[idx];
 }
 
+/* Linear gradient positions for a span of pixels, whose centers map to
+ * the glyph-space points (@gx[i], @gy[i]).  The SIMD paths compute each
+ * lane exactly as the scalar code does. */
+static void
+hb_raster_linear_gradient_positions (const float *gx, const float *gy,
+				     unsigned count,
+				     float gx0, float gy0,
+				     float dx, float dy, float inv_denom,
+				     float *ts)
+{
+  unsigned i = 0;
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+  const hb_raster_f32x4_t vgx0 = hb_raster_f32x4_splat (gx0);
+  const hb_raster_f32x4_t vgy0 = hb_raster_f32x4_splat (gy0);
+  const hb_raster_f32x4_t vdx = hb_raster_f32x4_splat (dx);
+  const hb_raster_f32x4_t vdy = hb_raster_f32x4_splat (dy);
+  const hb_raster_f32x4_t vinv_denom = hb_raster_f32x4_splat (inv_denom);
+  for (; i + 4 <= count; i += 4)
+  {
+    hb_raster_f32x4_t px = hb_raster_f32x4_sub (hb_raster_f32x4_load (gx + i), vgx0);
+    hb_raster_f32x4_t py = hb_raster_f32x4_sub (hb_raster_f32x4_load (gy + i), vgy0);
+    hb_raster_f32x4_t dot = hb_raster_f32x4_add (hb_raster_f32x4_mul (px, vdx),
+						 hb_raster_f32x4_mul (py, vdy));
+    hb_raster_f32x4_store (ts + i, hb_raster_f32x4_mul (dot, vinv_denom));
+  }
+#endif
+  for (; i < count; i++)
+    ts[i] = ((gx[i] - gx0) * dx + (gy[i] - gy0) * dy) * inv_denom;
+}
+
+/* Radial gradient positions for a span, as above: the root t of
+ * |p - c0 - t*(c1-c0)| = r0 + t*dr at each point, for circles
+ * differing by (@cdx, @cdy, @dr), with @A = cdx^2 + cdy^2 - dr^2.
+ * Pixels with no root get zero position and coverage. */
+static void
+hb_raster_radial_gradient_positions (const float *gx, const float *gy,
+				     unsigned count,
+				     float cx0, float cy0, float cr0,
+				     float cdx, float cdy, float dr, float A,
+				     float *ts, uint8_t *cov)
+{
+  bool quadratic = fabsf (A) > 1e-10f;
+  unsigned i = 0;
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+  const hb_raster_f32x4_t zero = hb_raster_f32x4_splat (0.f);
+  const hb_raster_f32x4_t vcx0 = hb_raster_f32x4_splat (cx0);
+  const hb_raster_f32x4_t vcy0 = hb_raster_f32x4_splat (cy0);
+  const hb_raster_f32x4_t vcr0 = hb_raster_f32x4_splat (cr0);
+  const hb_raster_f32x4_t vcdx = hb_raster_f32x4_splat (cdx);
+  const hb_raster_f32x4_t vcdy = hb_raster_f32x4_splat (cdy);
+  const hb_raster_f32x4_t vdr = hb_raster_f32x4_splat (dr);
+  const hb_raster_f32x4_t cr0_dr = hb_raster_f32x4_splat (cr0 * dr);
+  const hb_raster_f32x4_t cr0_cr0 = hb_raster_f32x4_splat (cr0 * cr0);
+  const hb_raster_f32x4_t four_A = hb_raster_f32x4_splat (4.f * A);
+  const hb_raster_f32x4_t two_A = hb_raster_f32x4_splat (2.f * A);
+  for (; i + 4 <= count; i += 4)
+  {
+    hb_raster_f32x4_t dpx = hb_raster_f32x4_sub (hb_raster_f32x4_load (gx + i), vcx0);
+    hb_raster_f32x4_t dpy = hb_raster_f32x4_sub (hb_raster_f32x4_load (gy + i), vcy0);
+    hb_raster_f32x4_t B = hb_raster_f32x4_mul (hb_raster_f32x4_splat (-2.f),
+					       hb_raster_f32x4_add (hb_raster_f32x4_add (hb_raster_f32x4_mul (dpx, vcdx),
+											 hb_raster_f32x4_mul (dpy, vcdy)),
+								    cr0_dr));
+    hb_raster_f32x4_t C = hb_raster_f32x4_sub (hb_raster_f32x4_add (hb_raster_f32x4_mul (dpx, dpx),
+								    hb_raster_f32x4_mul (dpy, dpy)),
+					       cr0_cr0);
+    hb_raster_f32x4_t t;
+    unsigned none;
+    if (quadratic)
+    {
+      hb_raster_f32x4_t disc = hb_raster_f32x4_sub (hb_raster_f32x4_mul (B, B),
+						    hb_raster_f32x4_mul (four_A, C));
+      none = hb_raster_f32x4_lt_bits (disc, zero);
+      hb_raster_f32x4_t sq = hb_raster_f32x4_sqrt (disc);
+      hb_raster_f32x4_t t1 = hb_raster_f32x4_div (hb_raster_f32x4_add (hb_raster_f32x4_neg (B), sq), two_A);
+      hb_raster_f32x4_t t2 = hb_raster_f32x4_div (hb_raster_f32x4_sub (hb_raster_f32x4_neg (B), sq), two_A);
+      /* The root that gives a positive radius. */
+      t = hb_raster_f32x4_select_le (zero, hb_raster_f32x4_add (vcr0, hb_raster_f32x4_mul (t1, vdr)), t1, t2);
+    }
+    else
+    {
+      none = hb_raster_f32x4_lt_bits (hb_raster_f32x4_abs (B), hb_raster_f32x4_splat (1e-10f));
+      t = hb_raster_f32x4_div (hb_raster_f32x4_neg (C), B);
+    }
+    hb_raster_f32x4_store (ts + i, t);
+    for (; none; none &= none - 1)
+    {
+      unsigned j = i + hb_ctz (none);
+      ts[j] = 0.f;
+      cov[j] = 0;
+    }
+  }
+#endif
+  for (; i < count; i++)
+  {
+    float dpx = gx[i] - cx0, dpy = gy[i] - cy0;
+    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
+    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
+
+    if (quadratic)
+    {
+      float disc = B * B - 4.f * A * C;
+      if (disc < 0.f)
+      {
+	ts[i] = 0.f;
+	cov[i] = 0;
+	continue;
+      }
+      float sq = sqrtf (disc);
+      float t1 = (-B + sq) / (2.f * A);
+      float t2 = (-B - sq) / (2.f * A);
+      ts[i] = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
+    }
+    else
+    {
+      if (fabsf (B) < 1e-10f)
+      {
+	ts[i] = 0.f;
+	cov[i] = 0;
+	continue;
+      }
+      ts[i] = -C / B;
+    }
+  }
+}
+
+/* Look up a span of gradient positions in @lut and composite the
+ * resulting colors, scaled by @cov, onto @dst.  The PAD index
+ * computation is vectorized; it matches lookup_gradient_lut() exactly. */
+static void
+hb_raster_paint_gradient_span (const uint32_t *lut,
+			       hb_paint_extend_t extend,
+			       const float *ts,
+			       const uint8_t *cov,
+			       unsigned count,
+			       hb_packed_t<uint32_t> *dst)
+{
+  uint32_t colors[HB_RASTER_SPAN_LENGTH];
+  unsigned i = 0;
+  if (extend == HB_PAINT_EXTEND_PAD)
+  {
+#if defined(HB_RASTER_SSE2)
+    const __m128 zero = _mm_setzero_ps ();
+    const __m128 one = _mm_set1_ps (1.f);
+    const __m128 scale = _mm_set1_ps ((float) (GRADIENT_LUT_SIZE - 1));
+    const __m128 half = _mm_set1_ps (0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128 t = _mm_loadu_ps (ts + i);
+      /* Non-finite positions map to 0, as t - t is NaN for them. */
+      t = _mm_and_ps (t, _mm_cmpeq_ps (_mm_sub_ps (t, t), zero));
+      t = _mm_min_ps (_mm_max_ps (t, zero), one);
+      int32_t idx[4];
+      _mm_storeu_si128 ((__m128i *) (void *) idx,
+			_mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (t, scale), half)));
+      colors[i + 0] = lut[idx[0]];
+      colors[i + 1] = lut[idx[1]];
+      colors[i + 2] = lut[idx[2]];
+      colors[i + 3] = lut[idx[3]];
+    }
+#elif defined(HB_RASTER_NEON)
+    const float32x4_t zero = vdupq_n_f32 (0.f);
+    const float32x4_t one = vdupq_n_f32 (1.f);
+    const float32x4_t scale = vdupq_n_f32 ((float) (GRADIENT_LUT_SIZE - 1));
+    const float32x4_t half = vdupq_n_f32 (0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+      float32x4_t t = vld1q_f32 (ts + i);
+      uint32x4_t finite = vceqq_f32 (vsubq_f32 (t, t), zero);
+      t = vreinterpretq_f32_u32 (vandq_u32 (vreinterpretq_u32_f32 (t), finite));
+      t = vminq_f32 (vmaxq_f32 (t, zero), one);
+      uint32_t idx[4];
+      vst1q_u32 (idx, vcvtq_u32_f32 (vaddq_f32 (vmulq_f32 (t, scale), half)));
+      colors[i + 0] = lut[idx[0]];
+      colors[i + 1] = lut[idx[1]];
+      colors[i + 2] = lut[idx[2]];
+      colors[i + 3] = lut[idx[3]];
+    }
+#endif
+  }
+  for (; i < count; i++)
+    colors[i] = lookup_gradient_lut (lut, ts[i], extend);
+
+  hb_raster_src_over_span (dst, (const hb_packed_t<uint32_t> *) colors, cov, count);
+}
+
 /*
  * Gradient paint callbacks
  */
@@ -1263,7 +1816,7 @@ hb_raster_paint_linear_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   hb_raster_image_t *surf = c->current_surface ();
   if (unlikely (!surf)) return;
@@ -1325,18 +1878,27 @@ hb_raster_paint_linear_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float gxs[HB_RASTER_SPAN_LENGTH], gys[HB_RASTER_SPAN_LENGTH];
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = lookup_gradient_lut (lut, proj_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
+	    {
+	      gxs[i] = gx;
+	      gys[i] = gy;
+	      cov[i] = 255;
+	      gx += inv_xx;
+	      gy += inv_yx;
+	    }
+	    hb_raster_linear_gradient_positions (gxs, gys, n, gx0, gy0, dx, dy, inv_denom, ts);
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1356,27 +1918,28 @@ hb_raster_paint_linear_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float gxs[HB_RASTER_SPAN_LENGTH], gys[HB_RASTER_SPAN_LENGTH];
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
 	    {
+	      gxs[i] = gx;
+	      gys[i] = gy;
+	      cov[i] = clip_row[px0 + i];
 	      gx += inv_xx;
 	      gy += inv_yx;
-	      continue;
 	    }
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = lookup_gradient_lut (lut, proj_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    hb_raster_linear_gradient_positions (gxs, gys, n, gx0, gy0, dx, dy, inv_denom, ts);
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1414,7 +1977,7 @@ hb_raster_paint_radial_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   hb_raster_image_t *surf = c->current_surface ();
   if (unlikely (!surf)) return;
@@ -1480,53 +2043,27 @@ hb_raster_paint_radial_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float gxs[HB_RASTER_SPAN_LENGTH], gys[HB_RASTER_SPAN_LENGTH];
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      /* Pick the larger root (t closer to 1 = outer circle) */
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      /* Choose the root that gives a positive radius */
-	      if (cr0 + t1 * dr >= 0.f)
-		grad_t = t1;
-	      else
-		grad_t = t2;
-	    }
-	    else
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
 	    {
-	      /* Linear case: Bt + C = 0 */
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
+	      gxs[i] = gx;
+	      gys[i] = gy;
+	      cov[i] = 255;
+	      gx += inv_xx;
+	      gy += inv_yx;
 	    }
-
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    hb_raster_radial_gradient_positions (gxs, gys, n, cx0, cy0, cr0, cdx, cdy, dr, A, ts, cov);
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1575,56 +2112,28 @@ hb_raster_paint_radial_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float gxs[HB_RASTER_SPAN_LENGTH], gys[HB_RASTER_SPAN_LENGTH];
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
 	    {
+	      gxs[i] = gx;
+	      gys[i] = gy;
+	      cov[i] = clip_row[px0 + i];
 	      gx += inv_xx;
 	      gy += inv_yx;
-	      continue;
-	    }
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      grad_t = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
-	    }
-	    else
-	    {
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
 	    }
-
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    hb_raster_radial_gradient_positions (gxs, gys, n, cx0, cy0, cr0, cdx, cdy, dr, A, ts, cov);
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1692,7 +2201,7 @@ hb_raster_paint_sweep_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
 {
   hb_raster_paint_t *c = (hb_raster_paint_t *) paint_data;
 
-  ensure_initialized (c);
+  begin_content (c);
 
   hb_raster_image_t *surf = c->current_surface ();
   if (unlikely (!surf)) return;
@@ -1744,20 +2253,27 @@ hb_raster_paint_sweep_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
+	    {
+	      float angle = atan2f (gy - cy, gx - cx);
+	      if (angle < 0) angle += (float) HB_2_PI;
+	      float grad_t = (angle - a0) * inv_angle_range;
+	      ts[i] = grad_t;
+	      cov[i] = 255;
+	      gx += inv_xx;
+	      gy += inv_yx;
+	    }
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1779,29 +2295,38 @@ hb_raster_paint_sweep_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
     {
       for (unsigned py = clip.min_y; py < clip.max_y; py++)
       {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
+	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->data () + py * stride);
 	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
 	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
 	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
 	if (use_lut)
 	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
+	  float ts[HB_RASTER_SPAN_LENGTH];
+	  uint8_t cov[HB_RASTER_SPAN_LENGTH];
+	  for (unsigned px0 = clip.min_x; px0 < clip.max_x; px0 += HB_RASTER_SPAN_LENGTH)
 	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
+	    unsigned n = hb_min (clip.max_x - px0, (unsigned) HB_RASTER_SPAN_LENGTH);
+	    for (unsigned i = 0; i < n; i++)
 	    {
+	      /* Skipped pixels get zero coverage. */
+	      ts[i] = 0.f;
+	      cov[i] = 0;
+	      uint8_t clip_alpha = clip_row[px0 + i];
+	      if (clip_alpha == 0)
+	      {
+		gx += inv_xx;
+		gy += inv_yx;
+		continue;
+	      }
+	      float angle = atan2f (gy - cy, gx - cx);
+	      if (angle < 0) angle += (float) HB_2_PI;
+	      float grad_t = (angle - a0) * inv_angle_range;
+	      ts[i] = grad_t;
+	      cov[i] = clip_alpha;
 	      gx += inv_xx;
 	      gy += inv_yx;
-	      continue;
 	    }
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
+	    hb_raster_paint_gradient_span (lut, extend, ts, cov, n, row + px0);
 	  }
 	}
 	else
@@ -1958,6 +2483,7 @@ hb_raster_paint_destroy (hb_raster_paint_t *paint)
 
   hb_map_destroy (paint->custom_palette);
   hb_raster_draw_destroy (paint->clip_rdr);
+  hb_raster_image_destroy (paint->target_image);
   for (auto *s : paint->surface_stack)
     hb_raster_image_destroy (s);
   for (auto *s : paint->surface_cache)
@@ -2228,6 +2754,43 @@ hb_raster_paint_set_glyph_extents (hb_raster_paint_t        *paint,
   return true;
 }
 
+/**
+ * hb_raster_paint_set_target_image:
+ * @paint: a paint context
+ * @image: (nullable): the image to paint into
+ *
+ * Makes the next render paint directly into @image instead of into
+ * an internally allocated surface.  Combined with
+ * hb_raster_image_create_for_data_or_fail(), this renders color glyphs
+ * straight into caller-owned memory such as atlas slots, and
+ * hb_raster_paint_render() then returns a new reference to @image.
+ *
+ * The extents of @image become the output extents, as if passed to
+ * hb_raster_paint_set_extents(); intermediate group surfaces are
+ * allocated with tightly packed rows regardless of the stride of
+ * @image.  @image must be @HB_RASTER_FORMAT_BGRA32.  Only the pixels
+ * of @image are touched, not its row padding.
+ *
+ * Call this before hb_font_paint_glyph(), and do not change the
+ * extents afterwards.  Like the extents, the target is cleared after
+ * each render.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_raster_paint_set_target_image (hb_raster_paint_t *paint,
+				  hb_raster_image_t *image)
+{
+  hb_raster_image_destroy (paint->target_image);
+  paint->target_image = hb_raster_image_reference (image);
+  if (image)
+  {
+    hb_raster_extents_t extents = image->extents;
+    extents.stride = 0;
+    hb_raster_paint_set_extents (paint, &extents);
+  }
+}
+
 /**
  * hb_raster_paint_set_foreground:
  * @paint: a paint context
@@ -2347,6 +2910,7 @@ hb_raster_paint_clear_custom_palette_colors (hb_raster_paint_t *paint)
 {
   if (paint->custom_palette)
     hb_map_clear (paint->custom_palette);
+  paint->custom_palette_serial++;
 }
 
 /**
@@ -2378,9 +2942,152 @@ hb_raster_paint_set_custom_palette_color (hb_raster_paint_t *paint,
       return false;
   }
   hb_map_set (paint->custom_palette, color_index, color);
+  paint->custom_palette_serial++;
   return hb_map_allocation_successful (paint->custom_palette);
 }
 
+/**
+ * hb_raster_paint_set_cache_size:
+ * @paint: a paint context
+ * @max_bytes: memory budget of the cache, in bytes; 0 disables it
+ *
+ * Sets the memory budget of @paint's subtree cache.
+ *
+ * Color glyphs commonly share parts of their paint graphs: the same
+ * outlines used as clips or fills, and the same glyphs included with
+ * PaintColrGlyph (flags, skin-tone variants).  With a non-zero budget,
+ * @paint keeps the rendered coverage masks and, for glyphs painted
+ * with hb_raster_paint_glyph() or hb_raster_paint_glyph_or_fail(), the
+ * rendered PaintColrGlyph subtrees, and reuses them when they recur
+ * with the same font, transform and colors, until the least recently
+ * used ones are evicted to stay within @max_bytes.
+ *
+ * A reused PaintColrGlyph subtree is composited as a whole, where
+ * painting it in place composites each of its layers in turn, so
+ * pixels can differ from uncached output by rounding.  The subtree
+ * cache is therefore off by default.
+ *
+ * Bitmap glyph images have a cache of their own; see
+ * hb_raster_paint_set_image_cache_size().
+ *
+ * The cache survives hb_raster_paint_clear() and
+ * hb_raster_paint_reset().  Cached entries keep a reference on their
+ * font.  Setting the budget to 0 releases all of them.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_raster_paint_set_cache_size (hb_raster_paint_t *paint,
+				unsigned int       max_bytes)
+{
+  paint->cache.max_bytes = max_bytes;
+  paint->cache.shrink (max_bytes);
+}
+
+/**
+ * hb_raster_paint_get_cache_size:
+ * @paint: a paint context
+ *
+ * Fetches the memory budget of @paint's subtree cache, as set with
+ * hb_raster_paint_set_cache_size().
+ *
+ * Return value: the budget, in bytes; 0 by default
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_raster_paint_get_cache_size (const hb_raster_paint_t *paint)
+{
+  return paint->cache.max_bytes;
+}
+
+/**
+ * hb_raster_paint_set_image_cache_size:
+ * @paint: a paint context
+ * @max_bytes: memory budget of the cache, in bytes; 0 disables it
+ *
+ * Sets the memory budget of @paint's image cache.
+ *
+ * Bitmap glyph images (sbix, CBDT) are kept decoded in the image
+ * cache, so they are not decoded again each time they are painted,
+ * until the least recently used ones are evicted to stay within
+ * @max_bytes.  Decoded images are exact, so the cache is on by
+ * default, with a budget of 4 megabytes.
+ *
+ * The cache survives hb_raster_paint_clear() and
+ * hb_raster_paint_reset().  Cached entries keep a reference on their
+ * image blob.  Setting the budget to 0 releases all of them.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_raster_paint_set_image_cache_size (hb_raster_paint_t *paint,
+				      unsigned int       max_bytes)
+{
+  paint->image_cache.max_bytes = max_bytes;
+  paint->image_cache.shrink (max_bytes);
+}
+
+/**
+ * hb_raster_paint_get_image_cache_size:
+ * @paint: a paint context
+ *
+ * Fetches the memory budget of @paint's image cache, as set with
+ * hb_raster_paint_set_image_cache_size().
+ *
+ * Return value: the budget, in bytes; 4 megabytes by default
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_raster_paint_get_image_cache_size (const hb_raster_paint_t *paint)
+{
+  return paint->image_cache.max_bytes;
+}
+
+/**
+ * hb_raster_paint_set_image_mipmaps:
+ * @paint: a paint context
+ * @mipmaps: whether to sample bitmap images from mipmaps
+ *
+ * Sets whether bitmap glyph images (sbix, CBDT) painted smaller than
+ * their native size are sampled from pre-scaled copies.
+ *
+ * By default images are sampled bilinearly at full size, which skips
+ * texels and aliases when minifying, e.g. a 136 pixel CBDT emoji
+ * painted at 24 pixels.  With mipmaps enabled, @paint keeps halved
+ * copies of each decoded image alongside it in the image cache, and
+ * samples the smallest one that is still at least the output size.
+ *
+ * Mipmaps need the image cache; they are not used while the cache
+ * budget set by hb_raster_paint_set_image_cache_size() is 0.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_raster_paint_set_image_mipmaps (hb_raster_paint_t *paint,
+				   hb_bool_t          mipmaps)
+{
+  paint->image_mipmaps = mipmaps;
+}
+
+/**
+ * hb_raster_paint_get_image_mipmaps:
+ * @paint: a paint context
+ *
+ * Fetches whether bitmap glyph images are sampled from mipmaps.
+ * See hb_raster_paint_set_image_mipmaps().
+ *
+ * Return value: `true` if mipmaps are enabled, `false` otherwise
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_raster_paint_get_image_mipmaps (const hb_raster_paint_t *paint)
+{
+  return paint->image_mipmaps;
+}
+
 /**
  * hb_raster_paint_get_funcs:
  * @paint: a rasterizer paint context.
@@ -2420,6 +3127,7 @@ hb_raster_paint_glyph_impl (hb_raster_paint_t *paint,
 			   paint->base_transform.x0, paint->base_transform.y0);
 
   hb_bool_t ret = true;
+  paint->painting_glyph = true;
   if (fallible)
     ret = hb_font_paint_glyph_or_fail (font, glyph,
 				       funcs, paint,
@@ -2428,6 +3136,7 @@ hb_raster_paint_glyph_impl (hb_raster_paint_t *paint,
     hb_font_paint_glyph (font, glyph,
 			 funcs, paint,
 			 paint->palette, paint->foreground);
+  paint->painting_glyph = false;
 
   hb_paint_pop_transform (funcs, paint);
   return ret;
@@ -2495,6 +3204,10 @@ hb_raster_paint_glyph (hb_raster_paint_t *paint,
  * Internal drawing state is cleared here so the same object can
  * be reused without client-side clearing.
  *
+ * If a target image was set with hb_raster_paint_set_target_image(),
+ * painting happened directly into it and a new reference to it is
+ * returned.
+ *
  * Return value: (transfer full):
  * A rendered #hb_raster_image_t. Returns `NULL` if extents were not set
  * or if allocation/configuration fails. If extents were set but nothing
@@ -2524,7 +3237,7 @@ hb_raster_paint_render (hb_raster_paint_t *paint)
   }
   else
   {
-    result = paint->acquire_surface ();
+    result = paint->acquire_root_surface ();
     if (unlikely (!result))
       return nullptr;
   }
@@ -2549,6 +3262,8 @@ hb_raster_paint_clear (hb_raster_paint_t *paint)
 {
   paint->fixed_extents = {};
   paint->has_extents = false;
+  hb_raster_image_destroy (paint->target_image);
+  paint->target_image = nullptr;
   paint->work_left = HB_RASTER_MAX_PAINT_WORK;
   paint->transform_stack.clear ();
   paint->release_all_clips ();
@@ -31,6 +31,9 @@
 
 #include "hb-raster-image.hh"
 #include "hb-geometry.hh"
+#include "hb-lru-list.hh"
+#include "hb-map.hh"
+#include "hb-paint-image-cache.hh"
 
 /* hb_raster_clip_t — alpha mask for clipping */
 struct hb_raster_clip_t
@@ -99,6 +102,188 @@ struct hb_raster_clip_t
 };
 
 
+/* Default memory budget of the paint subtree cache, in bytes of
+ * cached pixels; off unless set with hb_raster_paint_set_cache_size(),
+ * since reused PaintColrGlyph subtrees may differ from painting in
+ * place by rounding.  The image cache, which is exact, has its own
+ * default, set with hb_raster_paint_set_image_cache_size(). */
+#ifndef HB_RASTER_PAINT_CACHE_SIZE
+#define HB_RASTER_PAINT_CACHE_SIZE 0
+#endif
+#ifndef HB_RASTER_PAINT_IMAGE_CACHE_SIZE
+#define HB_RASTER_PAINT_IMAGE_CACHE_SIZE (4u << 20)
+#endif
+
+/* What a cached subtree was rendered from. */
+struct hb_raster_paint_cache_key_t
+{
+  hb_font_t         *font = nullptr;
+  unsigned           serial = 0;	/* hb_font_get_serial() of font */
+  hb_codepoint_t     glyph = 0;
+  hb_transform_t<>   transform;	/* Effective transform, to pixels */
+  /* Color state; only used for groups, zero for clip masks. */
+  bool               is_group = false;
+  unsigned           palette = 0;
+  hb_color_t         foreground = 0;
+  unsigned           palette_serial = 0;
+
+  bool operator == (const hb_raster_paint_cache_key_t &o) const
+  {
+    return font == o.font && serial == o.serial && glyph == o.glyph &&
+	   transform.xx == o.transform.xx && transform.yx == o.transform.yx &&
+	   transform.xy == o.transform.xy && transform.yy == o.transform.yy &&
+	   transform.x0 == o.transform.x0 && transform.y0 == o.transform.y0 &&
+	   is_group == o.is_group && palette == o.palette &&
+	   foreground == o.foreground && palette_serial == o.palette_serial;
+  }
+
+  uint32_t hash () const
+  {
+    /* Adding zero folds -0.f into 0.f, which compare equal. */
+    uint32_t current = hb_hash ((uintptr_t) font);
+    current = current * 31 + hb_hash (serial);
+    current = current * 31 + hb_hash (glyph);
+    current = current * 31 + hb_hash (transform.xx + 0.f);
+    current = current * 31 + hb_hash (transform.yx + 0.f);
+    current = current * 31 + hb_hash (transform.xy + 0.f);
+    current = current * 31 + hb_hash (transform.yy + 0.f);
+    current = current * 31 + hb_hash (transform.x0 + 0.f);
+    current = current * 31 + hb_hash (transform.y0 + 0.f);
+    current = current * 31 + hb_hash (is_group);
+    current = current * 31 + hb_hash (palette);
+    current = current * 31 + hb_hash (foreground);
+    return current * 31 + hb_hash (palette_serial);
+  }
+};
+
+/* hb_raster_paint_cache_t — rendered paint subtrees kept across
+ * renders: glyph clip masks (A8) and PaintColrGlyph results (BGRA32),
+ * in absolute pixel coordinates.  Each image is exact within its
+ * box, which is larger than the surface it was rendered for so that
+ * neighboring glyphs' surfaces still fall inside it.  Least recently
+ * used entries are evicted to stay within max_bytes. */
+struct hb_raster_paint_cache_t
+{
+  struct entry_t
+  {
+    hb_raster_paint_cache_key_t key;	/* Holds a reference on key.font */
+    hb_raster_image_t *image;
+    int box_x0, box_y0, box_x1, box_y1;
+    hb_lru_link_t lru;
+
+    size_t size () const
+    { return (size_t) image->extents.stride * image->extents.height + sizeof (*this); }
+  };
+
+  hb_vector_t<entry_t> entries;
+  hb_hashmap_t<hb_raster_paint_cache_key_t, unsigned> index;	/* Key to position in entries */
+  hb_lru_list_t<entry_t> lru;	/* Eviction order */
+  size_t max_bytes = HB_RASTER_PAINT_CACHE_SIZE;
+  size_t bytes = 0;
+
+  ~hb_raster_paint_cache_t () { shrink (0); }
+
+  /* The image cached for @key, if it is exact over the given box. */
+  const hb_raster_image_t *lookup (const hb_raster_paint_cache_key_t &key,
+				   int x0, int y0, int x1, int y1)
+  {
+    unsigned *i;
+    if (!index.has (key, &i))
+      return nullptr;
+    entry_t &e = entries.arrayZ[*i];
+    if (x0 < e.box_x0 || y0 < e.box_y0 || x1 > e.box_x1 || y1 > e.box_y1)
+      return nullptr;
+    lru.touch (entries.arrayZ, *i);
+    return e.image;
+  }
+
+  /* Takes ownership of @image on success, replacing any entry for
+   * @key.  Fails if @image alone exceeds the budget. */
+  bool insert (const hb_raster_paint_cache_key_t &key,
+	       hb_raster_image_t *image,
+	       int x0, int y0, int x1, int y1)
+  {
+    entry_t entry = {key, image, x0, y0, x1, y1, {}};
+    if (entry.size () > max_bytes)
+      return false;
+
+    unsigned *i;
+    if (index.has (key, &i))
+      remove (*i);
+    shrink (max_bytes - entry.size ());
+
+    if (unlikely (!entries.push_or_fail (entry)))
+      return false;
+    if (unlikely (!index.set (key, entries.length - 1)))
+    {
+      entries.pop ();
+      return false;
+    }
+    lru.push (entries.arrayZ, entries.length - 1);
+    hb_font_reference (key.font);
+    bytes += entry.size ();
+    return true;
+  }
+
+  /* Evicts least recently used entries until at most @limit bytes
+   * remain cached. */
+  void shrink (size_t limit)
+  {
+    while (bytes > limit && !lru.is_empty ())
+      remove (lru.head);
+  }
+
+  void remove (unsigned i)
+  {
+    entry_t &e = entries.arrayZ[i];
+    bytes -= e.size ();
+    lru.remove (entries.arrayZ, i);
+    index.del (e.key);
+    hb_raster_image_destroy (e.image);
+    hb_font_destroy (e.key.font);
+    entries.remove_unordered (i);
+    /* The last entry, if any, moved into slot @i.  Update its index
+     * in place: set() on a present key may leave a stale copy behind
+     * a tombstone. */
+    if (i < entries.length)
+    {
+      unsigned *moved;
+      if (index.has (entries.arrayZ[i].key, &moved))
+	*moved = i;
+      lru.moved (entries.arrayZ, i);
+    }
+  }
+};
+
+/* A decoded paint image, as kept in the image cache.  levels[0] is
+ * the image at full size, premultiplied BGRA32 with tightly packed
+ * rows; each further level is the previous one box-filtered to half
+ * size, built on demand when mipmapping is enabled. */
+struct hb_raster_paint_image_t
+{
+  hb_vector_t<hb_raster_image_t *> levels;
+
+  size_t size () const
+  {
+    size_t total = 0;
+    for (const auto *l : levels)
+      total += (size_t) l->extents.stride * l->extents.height;
+    return total;
+  }
+
+  void fini ()
+  {
+    for (auto *l : levels)
+      hb_raster_image_destroy (l);
+    levels.fini ();
+  }
+
+  /* Builds levels up to @level, as far as the image can be halved;
+   * returns the deepest level available, at most @level. */
+  HB_INTERNAL unsigned ensure_level (unsigned level);
+};
+
+
 /* hb_raster_paint_t — color glyph paint context */
 struct hb_raster_paint_t
 {
@@ -128,6 +313,20 @@ struct hb_raster_paint_t
   /* Internal rasterizer for clip-to-glyph */
   hb_raster_draw_t *clip_rdr = nullptr;
 
+  /* Caller-provided root surface; one-shot, like fixed_extents */
+  hb_raster_image_t *target_image = nullptr;
+
+  /* Subtree cache, kept across renders */
+  hb_raster_paint_cache_t cache;
+  unsigned custom_palette_serial = 0;	/* Bumped on custom palette changes */
+  bool painting_glyph = false;	/* Inside hb_raster_paint_glyph() */
+  bool caching_group = false;	/* Rendering a PaintColrGlyph for the cache */
+  bool painted_content = false;	/* A callback other than a transform was received */
+
+  /* Decoded bitmap images (sbix, CBDT), kept across renders */
+  hb_paint_image_cache_t<hb_raster_paint_image_t> image_cache {HB_RASTER_PAINT_IMAGE_CACHE_SIZE};
+  bool image_mipmaps = false;	/* Sample downscaled images from mipmaps */
+
   /* Cumulative work budget for the current paint session; reset by
    * hb_raster_paint_clear().  Bounds total pixel and outline work so
    * that per-node costs cannot multiply with the paint-graph traversal
@@ -146,6 +345,9 @@ struct hb_raster_paint_t
   }
 
   hb_raster_image_t *acquire_surface ()
+  { return acquire_surface (fixed_extents); }
+
+  hb_raster_image_t *acquire_surface (hb_raster_extents_t ext)
   {
     hb_raster_image_t *img;
     if (surface_cache.length)
@@ -156,7 +358,7 @@ struct hb_raster_paint_t
       if (unlikely (!img)) return nullptr;
     }
 
-    if (unlikely (!img->configure (HB_RASTER_FORMAT_BGRA32, fixed_extents)))
+    if (unlikely (!img->configure (HB_RASTER_FORMAT_BGRA32, ext)))
     {
       hb_raster_image_destroy (img);
       return nullptr;
@@ -165,9 +367,28 @@ struct hb_raster_paint_t
     return img;
   }
 
+  /* The root surface: the target image if one was set, otherwise a
+   * pooled surface. */
+  hb_raster_image_t *acquire_root_surface ()
+  {
+    if (!target_image)
+      return acquire_surface ();
+
+    const hb_raster_extents_t &ext = target_image->extents;
+    if (unlikely (target_image->format != HB_RASTER_FORMAT_BGRA32 ||
+		  ext.x_origin != fixed_extents.x_origin ||
+		  ext.y_origin != fixed_extents.y_origin ||
+		  ext.width != fixed_extents.width ||
+		  ext.height != fixed_extents.height))
+      return nullptr;
+    target_image->clear ();
+    return hb_raster_image_reference (target_image);
+  }
+
   void release_surface (hb_raster_image_t *img)
   {
-    if (!surface_cache.push_or_fail (img))
+    /* Never pool caller-owned storage. */
+    if (img->is_external () || !surface_cache.push_or_fail (img))
       hb_raster_image_destroy (img);
   }
 
@@ -82,6 +82,14 @@ typedef struct hb_raster_image_t hb_raster_image_t;
 HB_EXTERN hb_raster_image_t *
 hb_raster_image_create_or_fail (void);
 
+HB_EXTERN hb_raster_image_t *
+hb_raster_image_create_for_data_or_fail (uint8_t                   *data,
+					 unsigned int               length,
+					 hb_raster_format_t         format,
+					 const hb_raster_extents_t *extents,
+					 void                      *user_data,
+					 hb_destroy_func_t          destroy);
+
 HB_EXTERN hb_raster_image_t *
 hb_raster_image_reference (hb_raster_image_t *image);
 
@@ -124,6 +132,88 @@ hb_raster_image_deserialize_from_png_or_fail (hb_raster_image_t *image,
 HB_EXTERN hb_blob_t *
 hb_raster_image_serialize_to_png_or_fail (const hb_raster_image_t *image);
 
+/**
+ * hb_raster_png_filter_t:
+ * @HB_RASTER_PNG_FILTER_DEFAULT: choose a filter per row, by the usual
+ *   minimum-sum-of-differences heuristic; no filtering for stored images
+ * @HB_RASTER_PNG_FILTER_NONE: no filtering
+ * @HB_RASTER_PNG_FILTER_SUB: the Sub filter on every row
+ * @HB_RASTER_PNG_FILTER_UP: the Up filter on every row
+ * @HB_RASTER_PNG_FILTER_AVERAGE: the Average filter on every row
+ * @HB_RASTER_PNG_FILTER_PAETH: the Paeth filter on every row
+ *
+ * Row filtering strategy for PNG encoding.  Fixed filters are faster
+ * to encode than the default; how well the result compresses depends
+ * on the image.
+ *
+ * XSince: REPLACEME
+ */
+typedef enum {
+  HB_RASTER_PNG_FILTER_DEFAULT = 0,
+  HB_RASTER_PNG_FILTER_NONE,
+  HB_RASTER_PNG_FILTER_SUB,
+  HB_RASTER_PNG_FILTER_UP,
+  HB_RASTER_PNG_FILTER_AVERAGE,
+  HB_RASTER_PNG_FILTER_PAETH,
+} hb_raster_png_filter_t;
+
+/**
+ * hb_raster_png_a8_mode_t:
+ * @HB_RASTER_PNG_A8_GRAY: 8-bit grayscale, coverage as luminance
+ *   (white on black)
+ * @HB_RASTER_PNG_A8_PALETTE: 8-bit indexed color, black with coverage
+ *   as alpha
+ *
+ * How #HB_RASTER_FORMAT_A8 images are stored in PNG.
+ *
+ * XSince: REPLACEME
+ */
+typedef enum {
+  HB_RASTER_PNG_A8_GRAY = 0,
+  HB_RASTER_PNG_A8_PALETTE,
+} hb_raster_png_a8_mode_t;
+
+/**
+ * hb_raster_png_options_t:
+ * @compression_level: zlib compression level, from 0 (stored, no
+ *   compression) to 9; -1 for the zlib default
+ * @filter: row filtering strategy
+ * @a8_mode: how #HB_RASTER_FORMAT_A8 images are stored
+ *
+ * Options for hb_raster_image_serialize_to_png_with_options_or_fail().
+ * Initialize with #HB_RASTER_PNG_OPTIONS_DEFAULT and change the
+ * members of interest.
+ *
+ * XSince: REPLACEME
+ */
+typedef struct hb_raster_png_options_t {
+  int                     compression_level;
+  hb_raster_png_filter_t  filter;
+  hb_raster_png_a8_mode_t a8_mode;
+
+  /*< private >*/
+  void *reserved1;
+  void *reserved2;
+} hb_raster_png_options_t;
+
+/**
+ * HB_RASTER_PNG_OPTIONS_DEFAULT:
+ *
+ * The default #hb_raster_png_options_t, as used by
+ * hb_raster_image_serialize_to_png_or_fail().
+ *
+ * XSince: REPLACEME
+ */
+#define HB_RASTER_PNG_OPTIONS_DEFAULT {-1, \
+				       HB_RASTER_PNG_FILTER_DEFAULT, \
+				       HB_RASTER_PNG_A8_GRAY, \
+				       (void *) 0, \
+				       (void *) 0}
+
+HB_EXTERN hb_blob_t *
+hb_raster_image_serialize_to_png_with_options_or_fail (const hb_raster_image_t       *image,
+						       const hb_raster_png_options_t *options);
+
 
 /* hb_raster_draw_t */
 
@@ -192,6 +282,10 @@ HB_EXTERN hb_bool_t
 hb_raster_draw_set_glyph_extents (hb_raster_draw_t          *draw,
 				  const hb_glyph_extents_t  *glyph_extents);
 
+HB_EXTERN void
+hb_raster_draw_set_target_image (hb_raster_draw_t  *draw,
+				 hb_raster_image_t *image);
+
 HB_EXTERN hb_draw_funcs_t *
 hb_raster_draw_get_funcs (const hb_raster_draw_t *draw);
 
@@ -287,6 +381,10 @@ HB_EXTERN hb_bool_t
 hb_raster_paint_set_glyph_extents (hb_raster_paint_t         *paint,
 				   const hb_glyph_extents_t  *glyph_extents);
 
+HB_EXTERN void
+hb_raster_paint_set_target_image (hb_raster_paint_t *paint,
+				  hb_raster_image_t *image);
+
 HB_EXTERN void
 hb_raster_paint_set_foreground (hb_raster_paint_t *paint,
 				hb_color_t         foreground);
@@ -316,6 +414,27 @@ hb_raster_paint_set_custom_palette_color (hb_raster_paint_t *paint,
 					  unsigned int       color_index,
 					  hb_color_t         color);
 
+HB_EXTERN void
+hb_raster_paint_set_cache_size (hb_raster_paint_t *paint,
+				unsigned int       max_bytes);
+
+HB_EXTERN unsigned int
+hb_raster_paint_get_cache_size (const hb_raster_paint_t *paint);
+
+HB_EXTERN void
+hb_raster_paint_set_image_cache_size (hb_raster_paint_t *paint,
+				      unsigned int       max_bytes);
+
+HB_EXTERN unsigned int
+hb_raster_paint_get_image_cache_size (const hb_raster_paint_t *paint);
+
+HB_EXTERN void
+hb_raster_paint_set_image_mipmaps (hb_raster_paint_t *paint,
+				   hb_bool_t          mipmaps);
+
+HB_EXTERN hb_bool_t
+hb_raster_paint_get_image_mipmaps (const hb_raster_paint_t *paint);
+
 HB_EXTERN hb_paint_funcs_t *
 hb_raster_paint_get_funcs (const hb_raster_paint_t *paint);
 
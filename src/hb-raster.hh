@@ -31,6 +31,18 @@
 
 #include "hb-raster.h"
 
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HB_RASTER_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HB_RASTER_SSE2 1
+#endif
+
+/* Pixels per chunk for span-based paint kernels; spans are staged
+ * in stack buffers of this size. */
+#define HB_RASTER_SPAN_LENGTH 64
+
 /* Scanline work of the edges accumulated in @draw since the last
  * render/clear: one unit per edge plus its span in rows, clamped to
  * @max_rows per edge.  This is what rasterizing the edges costs, as
@@ -107,4 +119,602 @@ hb_raster_alpha_mul (uint32_t px, unsigned a)
   return (uint32_t) rb | ((uint32_t) rg << 8) | ((uint32_t) rr << 16) | ((uint32_t) ra << 24);
 }
 
+/* Span kernels.
+ *
+ * Both compute, per pixel, exactly
+ *
+ *   dst = hb_raster_src_over (hb_raster_alpha_mul (src, mask), dst)
+ *
+ * The branchless form of hb_raster_div255() used below reproduces the
+ * coverage==0 and coverage==255 early-outs of hb_raster_alpha_mul(),
+ * and alpha==255 in hb_raster_src_over().  Its alpha==0 early-out,
+ * which keeps @dst even where the source color is not zero, is
+ * reproduced by clearing such source pixels.  The SIMD paths are thus
+ * bit-exact with the scalar helpers.  A null @mask means full coverage. */
+
+#ifdef HB_RASTER_SSE2
+/* Four pixels: div255 (c * m) per channel, m given per byte. */
+static HB_ALWAYS_INLINE __m128i
+hb_raster_mul_div255_x4 (__m128i c, __m128i m)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i bias = _mm_set1_epi16 (255);
+  __m128i lo = _mm_mullo_epi16 (_mm_unpacklo_epi8 (c, zero), _mm_unpacklo_epi8 (m, zero));
+  __m128i hi = _mm_mullo_epi16 (_mm_unpackhi_epi8 (c, zero), _mm_unpackhi_epi8 (m, zero));
+  lo = _mm_srli_epi16 (_mm_add_epi16 (lo, bias), 8);
+  hi = _mm_srli_epi16 (_mm_add_epi16 (hi, bias), 8);
+  return _mm_packus_epi16 (lo, hi);
+}
+
+/* Broadcast each pixel's alpha byte to all four of its bytes. */
+static HB_ALWAYS_INLINE __m128i
+hb_raster_splat_alpha_x4 (__m128i px)
+{
+  __m128i a = _mm_srli_epi32 (px, 24);
+  a = _mm_or_si128 (a, _mm_slli_epi32 (a, 8));
+  return _mm_or_si128 (a, _mm_slli_epi32 (a, 16));
+}
+
+static HB_ALWAYS_INLINE __m128i
+hb_raster_src_over_x4 (__m128i src, __m128i dst)
+{
+  src = _mm_andnot_si128 (_mm_cmpeq_epi32 (_mm_srli_epi32 (src, 24), _mm_setzero_si128 ()), src);
+  __m128i inv_sa = _mm_xor_si128 (hb_raster_splat_alpha_x4 (src), _mm_set1_epi32 (-1));
+  return _mm_add_epi8 (hb_raster_mul_div255_x4 (dst, inv_sa), src);
+}
+#endif
+
+#ifdef HB_RASTER_NEON
+static HB_ALWAYS_INLINE uint8x16_t
+hb_raster_mul_div255_x4 (uint8x16_t c, uint8x16_t m)
+{
+  uint16x8_t lo = vmull_u8 (vget_low_u8 (c), vget_low_u8 (m));
+  uint16x8_t hi = vmull_u8 (vget_high_u8 (c), vget_high_u8 (m));
+  lo = vaddq_u16 (lo, vdupq_n_u16 (255));
+  hi = vaddq_u16 (hi, vdupq_n_u16 (255));
+  return vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi, 8));
+}
+
+static HB_ALWAYS_INLINE uint8x16_t
+hb_raster_splat_alpha_x4 (uint8x16_t px)
+{
+  uint32x4_t a = vshrq_n_u32 (vreinterpretq_u32_u8 (px), 24);
+  return vreinterpretq_u8_u32 (vmulq_n_u32 (a, 0x01010101u));
+}
+
+static HB_ALWAYS_INLINE uint8x16_t
+hb_raster_src_over_x4 (uint8x16_t src, uint8x16_t dst)
+{
+  uint32x4_t transparent = vceqq_u32 (vshrq_n_u32 (vreinterpretq_u32_u8 (src), 24), vdupq_n_u32 (0));
+  src = vbicq_u8 (src, vreinterpretq_u8_u32 (transparent));
+  uint8x16_t inv_sa = vmvnq_u8 (hb_raster_splat_alpha_x4 (src));
+  return vaddq_u8 (hb_raster_mul_div255_x4 (dst, inv_sa), src);
+}
+#endif
+
+/* Composite a span of premultiplied pixels, optionally scaled by a
+ * per-pixel coverage mask, onto @dst with SRC_OVER. */
+static inline void
+hb_raster_src_over_span (hb_packed_t<uint32_t> *dst,
+			 const hb_packed_t<uint32_t> *src,
+			 const uint8_t *mask,
+			 unsigned count)
+{
+  unsigned i = 0;
+#if defined(HB_RASTER_SSE2)
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i s = _mm_loadu_si128 ((const __m128i *) (const void *) (src + i));
+    if (mask)
+    {
+      uint32_t m4;
+      hb_memcpy (&m4, mask + i, 4);
+      if (!m4) continue;
+      /* Spread the four coverage bytes to their pixels' four bytes. */
+      __m128i m = _mm_cvtsi32_si128 ((int) m4);
+      m = _mm_unpacklo_epi8 (m, m);
+      m = _mm_unpacklo_epi16 (m, m);
+      if (m4 != 0xFFFFFFFFu)
+	s = hb_raster_mul_div255_x4 (s, m);
+    }
+    __m128i d = _mm_loadu_si128 ((const __m128i *) (const void *) (dst + i));
+    _mm_storeu_si128 ((__m128i *) (void *) (dst + i), hb_raster_src_over_x4 (s, d));
+  }
+#elif defined(HB_RASTER_NEON)
+  for (; i + 4 <= count; i += 4)
+  {
+    uint8x16_t s = vld1q_u8 ((const uint8_t *) (const void *) (src + i));
+    if (mask)
+    {
+      uint32_t m4;
+      hb_memcpy (&m4, mask + i, 4);
+      if (!m4) continue;
+      uint8x8_t m8 = vreinterpret_u8_u32 (vdup_n_u32 (m4));
+      uint8x8x2_t z = vzip_u8 (m8, m8);
+      uint16x4x2_t z2 = vzip_u16 (vreinterpret_u16_u8 (z.val[0]), vreinterpret_u16_u8 (z.val[0]));
+      uint8x16_t m = vreinterpretq_u8_u16 (vcombine_u16 (z2.val[0], z2.val[1]));
+      if (m4 != 0xFFFFFFFFu)
+	s = hb_raster_mul_div255_x4 (s, m);
+    }
+    uint8_t *d8 = (uint8_t *) (void *) (dst + i);
+    vst1q_u8 (d8, hb_raster_src_over_x4 (s, vld1q_u8 (d8)));
+  }
+#endif
+  for (; i < count; i++)
+  {
+    uint32_t s = (uint32_t) src[i];
+    if (mask)
+      s = hb_raster_alpha_mul (s, mask[i]);
+    dst[i] = hb_packed_t<uint32_t> (hb_raster_src_over (s, (uint32_t) dst[i]));
+  }
+}
+
+
+/* Four-lane float helpers for the kernels below.  Selects are spelled
+ * out so each lane computes exactly what the scalar code does. */
+
+#if defined(HB_RASTER_SSE2)
+typedef __m128 hb_raster_f32x4_t;
+typedef __m128i hb_raster_u32x4_t;
+
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_splat (float v) { return _mm_set1_ps (v); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_add (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return _mm_add_ps (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_sub (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return _mm_sub_ps (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_mul (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return _mm_mul_ps (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_div (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return _mm_div_ps (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_sqrt (hb_raster_f32x4_t a) { return _mm_sqrt_ps (a); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_abs (hb_raster_f32x4_t a) { return _mm_andnot_ps (_mm_set1_ps (-0.f), a); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_neg (hb_raster_f32x4_t a) { return _mm_xor_ps (a, _mm_set1_ps (-0.f)); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_load (const float *p) { return _mm_loadu_ps (p); }
+static HB_ALWAYS_INLINE void hb_raster_f32x4_store (float *p, hb_raster_f32x4_t v) { _mm_storeu_ps (p, v); }
+/* Bit i set where lane i of a < b. */
+static HB_ALWAYS_INLINE unsigned
+hb_raster_f32x4_lt_bits (hb_raster_f32x4_t a, hb_raster_f32x4_t b)
+{ return (unsigned) _mm_movemask_ps (_mm_cmplt_ps (a, b)); }
+/* a <= b ? x : y */
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_f32x4_select_le (hb_raster_f32x4_t a, hb_raster_f32x4_t b,
+			   hb_raster_f32x4_t x, hb_raster_f32x4_t y)
+{
+  __m128 le = _mm_cmple_ps (a, b);
+  return _mm_or_ps (_mm_and_ps (le, x), _mm_andnot_ps (le, y));
+}
+
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_u32x4_load (const hb_packed_t<uint32_t> *p)
+{ return _mm_loadu_si128 ((const __m128i *) (const void *) p); }
+static HB_ALWAYS_INLINE void
+hb_raster_u32x4_store (hb_packed_t<uint32_t> *p, hb_raster_u32x4_t v)
+{ _mm_storeu_si128 ((__m128i *) (void *) p, v); }
+
+/* One 8-bit channel of four pixels, as floats. */
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_channel_x4 (hb_raster_u32x4_t px, unsigned shift)
+{
+  __m128i c = _mm_srl_epi32 (px, _mm_cvtsi32_si128 ((int) shift));
+  return _mm_cvtepi32_ps (_mm_and_si128 (c, _mm_set1_epi32 (0xFF)));
+}
+/* Truncates four floats in [0,256) to bytes, shifted into place. */
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_channel_pack_x4 (hb_raster_f32x4_t v, unsigned shift)
+{ return _mm_sll_epi32 (_mm_cvttps_epi32 (v), _mm_cvtsi32_si128 ((int) shift)); }
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_u32x4_or (hb_raster_u32x4_t a, hb_raster_u32x4_t b) { return _mm_or_si128 (a, b); }
+#elif defined(HB_RASTER_NEON)
+typedef float32x4_t hb_raster_f32x4_t;
+typedef uint32x4_t hb_raster_u32x4_t;
+
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_splat (float v) { return vdupq_n_f32 (v); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_add (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return vaddq_f32 (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_sub (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return vsubq_f32 (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_mul (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return vmulq_f32 (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_div (hb_raster_f32x4_t a, hb_raster_f32x4_t b) { return vdivq_f32 (a, b); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_sqrt (hb_raster_f32x4_t a) { return vsqrtq_f32 (a); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_abs (hb_raster_f32x4_t a) { return vabsq_f32 (a); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_neg (hb_raster_f32x4_t a) { return vnegq_f32 (a); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t hb_raster_f32x4_load (const float *p) { return vld1q_f32 (p); }
+static HB_ALWAYS_INLINE void hb_raster_f32x4_store (float *p, hb_raster_f32x4_t v) { vst1q_f32 (p, v); }
+/* Bit i set where lane i of a < b. */
+static HB_ALWAYS_INLINE unsigned
+hb_raster_f32x4_lt_bits (hb_raster_f32x4_t a, hb_raster_f32x4_t b)
+{
+  const uint32_t bits[4] = {1, 2, 4, 8};
+  return vaddvq_u32 (vandq_u32 (vcltq_f32 (a, b), vld1q_u32 (bits)));
+}
+/* a <= b ? x : y */
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_f32x4_select_le (hb_raster_f32x4_t a, hb_raster_f32x4_t b,
+			   hb_raster_f32x4_t x, hb_raster_f32x4_t y)
+{ return vbslq_f32 (vcleq_f32 (a, b), x, y); }
+
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_u32x4_load (const hb_packed_t<uint32_t> *p)
+{ return vreinterpretq_u32_u8 (vld1q_u8 ((const uint8_t *) (const void *) p)); }
+static HB_ALWAYS_INLINE void
+hb_raster_u32x4_store (hb_packed_t<uint32_t> *p, hb_raster_u32x4_t v)
+{ vst1q_u8 ((uint8_t *) (void *) p, vreinterpretq_u8_u32 (v)); }
+
+/* One 8-bit channel of four pixels, as floats. */
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_channel_x4 (hb_raster_u32x4_t px, unsigned shift)
+{
+  uint32x4_t c = vshlq_u32 (px, vdupq_n_s32 (-(int) shift));
+  return vcvtq_f32_u32 (vandq_u32 (c, vdupq_n_u32 (0xFF)));
+}
+/* Truncates four floats in [0,256) to bytes, shifted into place. */
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_channel_pack_x4 (hb_raster_f32x4_t v, unsigned shift)
+{ return vshlq_u32 (vcvtq_u32_f32 (v), vdupq_n_s32 ((int) shift)); }
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_u32x4_or (hb_raster_u32x4_t a, hb_raster_u32x4_t b) { return vorrq_u32 (a, b); }
+#endif
+
+
+/* Bilinear sample from a premultiplied BGRA32 image.
+ *
+ * The SIMD paths weigh the four channels of each texel at once, with
+ * the same operations in the same order as the scalar code. */
+static inline uint32_t
+hb_raster_sample_bilinear_premul (const hb_packed_t<uint32_t> *src,
+				  unsigned width,
+				  unsigned height,
+				  float x,
+				  float y)
+{
+  int x0 = (int) floorf (x);
+  int y0 = (int) floorf (y);
+  int x1 = x0 + 1;
+  int y1 = y0 + 1;
+  if (x1 >= (int) width) x1 = (int) width - 1;
+  if (y1 >= (int) height) y1 = (int) height - 1;
+
+  float tx = x - x0;
+  float ty = y - y0;
+  float omtx = 1.f - tx;
+  float omty = 1.f - ty;
+
+  uint32_t p00 = (uint32_t) src[(size_t) y0 * width + (size_t) x0];
+  uint32_t p10 = (uint32_t) src[(size_t) y0 * width + (size_t) x1];
+  uint32_t p01 = (uint32_t) src[(size_t) y1 * width + (size_t) x0];
+  uint32_t p11 = (uint32_t) src[(size_t) y1 * width + (size_t) x1];
+
+  float w00 = omtx * omty;
+  float w10 = tx * omty;
+  float w01 = omtx * ty;
+  float w11 = tx * ty;
+
+#if defined(HB_RASTER_SSE2)
+  const __m128i zero = _mm_setzero_si128 ();
+#define HB_RASTER_TEXEL(p) \
+  _mm_cvtepi32_ps (_mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 ((int) (p)), zero), zero))
+  __m128 acc = _mm_mul_ps (HB_RASTER_TEXEL (p00), _mm_set1_ps (w00));
+  acc = _mm_add_ps (acc, _mm_mul_ps (HB_RASTER_TEXEL (p10), _mm_set1_ps (w10)));
+  acc = _mm_add_ps (acc, _mm_mul_ps (HB_RASTER_TEXEL (p01), _mm_set1_ps (w01)));
+  acc = _mm_add_ps (acc, _mm_mul_ps (HB_RASTER_TEXEL (p11), _mm_set1_ps (w11)));
+#undef HB_RASTER_TEXEL
+  __m128i v = _mm_cvttps_epi32 (_mm_add_ps (acc, _mm_set1_ps (0.5f)));
+  v = _mm_packs_epi32 (v, v);
+  return (uint32_t) _mm_cvtsi128_si32 (_mm_packus_epi16 (v, v));
+#elif defined(HB_RASTER_NEON)
+#define HB_RASTER_TEXEL(p) \
+  vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (vmovl_u8 (vreinterpret_u8_u32 (vdup_n_u32 (p))))))
+  float32x4_t acc = vmulq_n_f32 (HB_RASTER_TEXEL (p00), w00);
+  acc = vaddq_f32 (acc, vmulq_n_f32 (HB_RASTER_TEXEL (p10), w10));
+  acc = vaddq_f32 (acc, vmulq_n_f32 (HB_RASTER_TEXEL (p01), w01));
+  acc = vaddq_f32 (acc, vmulq_n_f32 (HB_RASTER_TEXEL (p11), w11));
+#undef HB_RASTER_TEXEL
+  uint16x4_t v = vmovn_u32 (vcvtq_u32_f32 (vaddq_f32 (acc, vdupq_n_f32 (0.5f))));
+  return vget_lane_u32 (vreinterpret_u32_u8 (vmovn_u16 (vcombine_u16 (v, v))), 0);
+#else
+  float b = ((p00 >>  0) & 0xff) * w00 + ((p10 >>  0) & 0xff) * w10 +
+	    ((p01 >>  0) & 0xff) * w01 + ((p11 >>  0) & 0xff) * w11;
+  float g = ((p00 >>  8) & 0xff) * w00 + ((p10 >>  8) & 0xff) * w10 +
+	    ((p01 >>  8) & 0xff) * w01 + ((p11 >>  8) & 0xff) * w11;
+  float r = ((p00 >> 16) & 0xff) * w00 + ((p10 >> 16) & 0xff) * w10 +
+	    ((p01 >> 16) & 0xff) * w01 + ((p11 >> 16) & 0xff) * w11;
+  float a = ((p00 >> 24) & 0xff) * w00 + ((p10 >> 24) & 0xff) * w10 +
+	    ((p01 >> 24) & 0xff) * w01 + ((p11 >> 24) & 0xff) * w11;
+
+  return (uint32_t) (b + 0.5f)
+       | ((uint32_t) (g + 0.5f) << 8)
+       | ((uint32_t) (r + 0.5f) << 16)
+       | ((uint32_t) (a + 0.5f) << 24);
+#endif
+}
+
+
+/* Separable blend modes. */
+
+/* Unpack premultiplied pixel to float RGBA [0,1]. */
+static inline void
+hb_raster_unpack_to_float (uint32_t px, float &r, float &g, float &b, float &a)
+{
+  b = (px & 0xFF) / 255.f;
+  g = ((px >> 8) & 0xFF) / 255.f;
+  r = ((px >> 16) & 0xFF) / 255.f;
+  a = (px >> 24) / 255.f;
+}
+
+/* Pack float RGBA [0,1] premultiplied back to uint32_t. */
+static inline uint32_t
+hb_raster_pack_from_float (float r, float g, float b, float a)
+{
+  return hb_raster_pack_pixel ((uint8_t) (hb_clamp (b, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (g, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (r, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (a, 0.f, 1.f) * 255.f + 0.5f));
+}
+
+/* Separable blend mode functions: operate on unpremultiplied [0,1]
+ * channels.  Each comes with a four-lane twin for the span kernel. */
+static inline float
+hb_raster_blend_multiply (float sc, float dc) { return sc * dc; }
+static inline float
+hb_raster_blend_screen (float sc, float dc) { return sc + dc - sc * dc; }
+static inline float
+hb_raster_blend_overlay (float sc, float dc)
+{ return dc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
+static inline float
+hb_raster_blend_darken (float sc, float dc) { return hb_min (sc, dc); }
+static inline float
+hb_raster_blend_lighten (float sc, float dc) { return hb_max (sc, dc); }
+static inline float
+hb_raster_blend_color_dodge (float sc, float dc)
+{
+  if (dc <= 0.f) return 0.f;
+  if (sc >= 1.f) return 1.f;
+  return hb_min (1.f, dc / (1.f - sc));
+}
+static inline float
+hb_raster_blend_color_burn (float sc, float dc)
+{
+  if (dc >= 1.f) return 1.f;
+  if (sc <= 0.f) return 0.f;
+  return 1.f - hb_min (1.f, (1.f - dc) / sc);
+}
+static inline float
+hb_raster_blend_hard_light (float sc, float dc)
+{ return sc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
+static inline float
+hb_raster_blend_soft_light (float sc, float dc)
+{
+  if (sc <= 0.5f)
+    return dc - (1.f - 2.f * sc) * dc * (1.f - dc);
+  float d = (dc <= 0.25f) ? ((16.f * dc - 12.f) * dc + 4.f) * dc
+			   : sqrtf (dc);
+  return dc + (2.f * sc - 1.f) * (d - dc);
+}
+static inline float
+hb_raster_blend_difference (float sc, float dc) { return fabsf (sc - dc); }
+static inline float
+hb_raster_blend_exclusion (float sc, float dc) { return sc + dc - 2.f * sc * dc; }
+
+/* Apply a separable blend mode per-pixel.
+ * Both src and dst are premultiplied BGRA32. */
+static inline uint32_t
+hb_raster_separable_blend (uint32_t src, uint32_t dst,
+			   float (*blend_fn)(float, float))
+{
+  float sr, sg, sb, sa;
+  float dr, dg, db, da;
+  hb_raster_unpack_to_float (src, sr, sg, sb, sa);
+  hb_raster_unpack_to_float (dst, dr, dg, db, da);
+
+  float usr = sa > 0.f ? sr / sa : 0.f;
+  float usg = sa > 0.f ? sg / sa : 0.f;
+  float usb = sa > 0.f ? sb / sa : 0.f;
+  float udr = da > 0.f ? dr / da : 0.f;
+  float udg = da > 0.f ? dg / da : 0.f;
+  float udb = da > 0.f ? db / da : 0.f;
+
+  float br = blend_fn (usr, udr);
+  float bg = blend_fn (usg, udg);
+  float bb = blend_fn (usb, udb);
+
+  float ra = sa + da - sa * da;
+  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
+  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
+  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
+
+  return hb_raster_pack_from_float (rr, rg, rb, ra);
+}
+
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+#define HB_RASTER_F4(v) hb_raster_f32x4_splat (v)
+#define HB_RASTER_ADD hb_raster_f32x4_add
+#define HB_RASTER_SUB hb_raster_f32x4_sub
+#define HB_RASTER_MUL hb_raster_f32x4_mul
+#define HB_RASTER_SEL hb_raster_f32x4_select_le
+
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_multiply_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return HB_RASTER_MUL (sc, dc); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_screen_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return HB_RASTER_SUB (HB_RASTER_ADD (sc, dc), HB_RASTER_MUL (sc, dc)); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_hard_light_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{
+  hb_raster_f32x4_t lo = HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_F4 (2.f), sc), dc);
+  hb_raster_f32x4_t hi = HB_RASTER_SUB (HB_RASTER_F4 (1.f),
+					HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_F4 (2.f),
+								      HB_RASTER_SUB (HB_RASTER_F4 (1.f), sc)),
+						       HB_RASTER_SUB (HB_RASTER_F4 (1.f), dc)));
+  return HB_RASTER_SEL (sc, HB_RASTER_F4 (0.5f), lo, hi);
+}
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_overlay_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{
+  hb_raster_f32x4_t lo = HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_F4 (2.f), sc), dc);
+  hb_raster_f32x4_t hi = HB_RASTER_SUB (HB_RASTER_F4 (1.f),
+					HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_F4 (2.f),
+								      HB_RASTER_SUB (HB_RASTER_F4 (1.f), sc)),
+						       HB_RASTER_SUB (HB_RASTER_F4 (1.f), dc)));
+  return HB_RASTER_SEL (dc, HB_RASTER_F4 (0.5f), lo, hi);
+}
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_darken_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return HB_RASTER_SEL (sc, dc, sc, dc); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_lighten_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return HB_RASTER_SEL (dc, sc, sc, dc); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_color_dodge_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{
+  const hb_raster_f32x4_t zero = HB_RASTER_F4 (0.f), one = HB_RASTER_F4 (1.f);
+  hb_raster_f32x4_t q = hb_raster_f32x4_div (dc, HB_RASTER_SUB (one, sc));
+  hb_raster_f32x4_t r = HB_RASTER_SEL (one, q, one, q);
+  r = HB_RASTER_SEL (one, sc, one, r);
+  return HB_RASTER_SEL (dc, zero, zero, r);
+}
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_color_burn_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{
+  const hb_raster_f32x4_t zero = HB_RASTER_F4 (0.f), one = HB_RASTER_F4 (1.f);
+  hb_raster_f32x4_t q = hb_raster_f32x4_div (HB_RASTER_SUB (one, dc), sc);
+  hb_raster_f32x4_t r = HB_RASTER_SUB (one, HB_RASTER_SEL (one, q, one, q));
+  r = HB_RASTER_SEL (sc, zero, zero, r);
+  return HB_RASTER_SEL (one, dc, one, r);
+}
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_soft_light_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{
+  const hb_raster_f32x4_t one = HB_RASTER_F4 (1.f), two = HB_RASTER_F4 (2.f);
+  hb_raster_f32x4_t lo = HB_RASTER_SUB (dc, HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_SUB (one, HB_RASTER_MUL (two, sc)), dc),
+							     HB_RASTER_SUB (one, dc)));
+  hb_raster_f32x4_t poly = HB_RASTER_MUL (HB_RASTER_ADD (HB_RASTER_MUL (HB_RASTER_SUB (HB_RASTER_MUL (HB_RASTER_F4 (16.f), dc),
+										       HB_RASTER_F4 (12.f)),
+								      dc),
+							HB_RASTER_F4 (4.f)),
+					  dc);
+  hb_raster_f32x4_t d = HB_RASTER_SEL (dc, HB_RASTER_F4 (0.25f), poly, hb_raster_f32x4_sqrt (dc));
+  hb_raster_f32x4_t hi = HB_RASTER_ADD (dc, HB_RASTER_MUL (HB_RASTER_SUB (HB_RASTER_MUL (two, sc), one),
+							  HB_RASTER_SUB (d, dc)));
+  return HB_RASTER_SEL (sc, HB_RASTER_F4 (0.5f), lo, hi);
+}
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_difference_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return hb_raster_f32x4_abs (HB_RASTER_SUB (sc, dc)); }
+static HB_ALWAYS_INLINE hb_raster_f32x4_t
+hb_raster_blend_exclusion_x4 (hb_raster_f32x4_t sc, hb_raster_f32x4_t dc)
+{ return HB_RASTER_SUB (HB_RASTER_ADD (sc, dc), HB_RASTER_MUL (HB_RASTER_MUL (HB_RASTER_F4 (2.f), sc), dc)); }
+
+/* hb_raster_separable_blend() on four pixels. */
+template <hb_raster_f32x4_t (*blend_x4) (hb_raster_f32x4_t, hb_raster_f32x4_t)>
+static HB_ALWAYS_INLINE hb_raster_u32x4_t
+hb_raster_separable_blend_x4 (hb_raster_u32x4_t src, hb_raster_u32x4_t dst)
+{
+  const hb_raster_f32x4_t zero = HB_RASTER_F4 (0.f), one = HB_RASTER_F4 (1.f);
+  const hb_raster_f32x4_t half = HB_RASTER_F4 (0.5f), c255 = HB_RASTER_F4 (255.f);
+  hb_raster_f32x4_t sa = hb_raster_f32x4_div (hb_raster_channel_x4 (src, 24), c255);
+  hb_raster_f32x4_t da = hb_raster_f32x4_div (hb_raster_channel_x4 (dst, 24), c255);
+
+  hb_raster_f32x4_t sada = HB_RASTER_MUL (sa, da);
+  hb_raster_f32x4_t sa_1da = HB_RASTER_MUL (sa, HB_RASTER_SUB (one, da));
+  hb_raster_f32x4_t _1sa_da = HB_RASTER_MUL (HB_RASTER_SUB (one, sa), da);
+
+  hb_raster_f32x4_t ra = HB_RASTER_SUB (HB_RASTER_ADD (sa, da), sada);
+  /* hb_clamp (v, 0.f, 1.f) * 255.f + 0.5f */
+#define HB_RASTER_PACK(v) \
+  HB_RASTER_ADD (HB_RASTER_MUL (HB_RASTER_SEL (HB_RASTER_SEL (zero, v, v, zero), one, \
+					      HB_RASTER_SEL (zero, v, v, zero), one), \
+				c255), half)
+  hb_raster_u32x4_t result = hb_raster_channel_pack_x4 (HB_RASTER_PACK (ra), 24);
+  for (unsigned shift = 0; shift < 24; shift += 8)
+  {
+    hb_raster_f32x4_t sc = hb_raster_f32x4_div (hb_raster_channel_x4 (src, shift), c255);
+    hb_raster_f32x4_t dc = hb_raster_f32x4_div (hb_raster_channel_x4 (dst, shift), c255);
+    hb_raster_f32x4_t usc = HB_RASTER_SEL (sa, zero, zero, hb_raster_f32x4_div (sc, sa));
+    hb_raster_f32x4_t udc = HB_RASTER_SEL (da, zero, zero, hb_raster_f32x4_div (dc, da));
+    hb_raster_f32x4_t rc = HB_RASTER_ADD (HB_RASTER_ADD (HB_RASTER_MUL (sada, blend_x4 (usc, udc)),
+							 HB_RASTER_MUL (sa_1da, usc)),
+					  HB_RASTER_MUL (_1sa_da, udc));
+    result = hb_raster_u32x4_or (result, hb_raster_channel_pack_x4 (HB_RASTER_PACK (rc), shift));
+  }
+#undef HB_RASTER_PACK
+  return result;
+}
+
+#undef HB_RASTER_F4
+#undef HB_RASTER_ADD
+#undef HB_RASTER_SUB
+#undef HB_RASTER_MUL
+#undef HB_RASTER_SEL
+#endif
+
+template <float (*blend_fn) (float, float)
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+	  , hb_raster_f32x4_t (*blend_x4) (hb_raster_f32x4_t, hb_raster_f32x4_t)
+#endif
+	  >
+static inline void
+hb_raster_separable_blend_span_impl (hb_packed_t<uint32_t> *dst,
+				const hb_packed_t<uint32_t> *src,
+				unsigned count)
+{
+  unsigned i = 0;
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+  for (; i + 4 <= count; i += 4)
+    hb_raster_u32x4_store (dst + i,
+			   hb_raster_separable_blend_x4<blend_x4> (hb_raster_u32x4_load (src + i),
+								   hb_raster_u32x4_load (dst + i)));
+#endif
+  for (; i < count; i++)
+    dst[i] = hb_packed_t<uint32_t> (hb_raster_separable_blend ((uint32_t) src[i], (uint32_t) dst[i], blend_fn));
+}
+
+/* Composite a span with a separable blend mode, bit-exact with
+ * hb_raster_separable_blend() per pixel.  Returns false, leaving @dst
+ * alone, for other modes. */
+static inline bool
+hb_raster_separable_blend_span (hb_packed_t<uint32_t> *dst,
+				const hb_packed_t<uint32_t> *src,
+				unsigned count,
+				hb_paint_composite_mode_t mode)
+{
+#if defined(HB_RASTER_SSE2) || defined(HB_RASTER_NEON)
+#define HB_RASTER_BLEND(name) \
+  hb_raster_separable_blend_span_impl<hb_raster_blend_##name, hb_raster_blend_##name##_x4> (dst, src, count)
+#else
+#define HB_RASTER_BLEND(name) \
+  hb_raster_separable_blend_span_impl<hb_raster_blend_##name> (dst, src, count)
+#endif
+  switch (mode)
+  {
+  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:    HB_RASTER_BLEND (multiply); break;
+  case HB_PAINT_COMPOSITE_MODE_SCREEN:      HB_RASTER_BLEND (screen); break;
+  case HB_PAINT_COMPOSITE_MODE_OVERLAY:     HB_RASTER_BLEND (overlay); break;
+  case HB_PAINT_COMPOSITE_MODE_DARKEN:      HB_RASTER_BLEND (darken); break;
+  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:     HB_RASTER_BLEND (lighten); break;
+  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: HB_RASTER_BLEND (color_dodge); break;
+  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  HB_RASTER_BLEND (color_burn); break;
+  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  HB_RASTER_BLEND (hard_light); break;
+  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  HB_RASTER_BLEND (soft_light); break;
+  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  HB_RASTER_BLEND (difference); break;
+  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   HB_RASTER_BLEND (exclusion); break;
+
+  case HB_PAINT_COMPOSITE_MODE_CLEAR:
+  case HB_PAINT_COMPOSITE_MODE_SRC:
+  case HB_PAINT_COMPOSITE_MODE_DEST:
+  case HB_PAINT_COMPOSITE_MODE_SRC_OVER:
+  case HB_PAINT_COMPOSITE_MODE_DEST_OVER:
+  case HB_PAINT_COMPOSITE_MODE_SRC_IN:
+  case HB_PAINT_COMPOSITE_MODE_DEST_IN:
+  case HB_PAINT_COMPOSITE_MODE_SRC_OUT:
+  case HB_PAINT_COMPOSITE_MODE_DEST_OUT:
+  case HB_PAINT_COMPOSITE_MODE_SRC_ATOP:
+  case HB_PAINT_COMPOSITE_MODE_DEST_ATOP:
+  case HB_PAINT_COMPOSITE_MODE_XOR:
+  case HB_PAINT_COMPOSITE_MODE_PLUS:
+  case HB_PAINT_COMPOSITE_MODE_HSL_HUE:
+  case HB_PAINT_COMPOSITE_MODE_HSL_SATURATION:
+  case HB_PAINT_COMPOSITE_MODE_HSL_COLOR:
+  case HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY:
+  default:
+    return false;
+  }
+#undef HB_RASTER_BLEND
+  return true;
+}
+
 #endif /* HB_RASTER_HH */
@@ -87,8 +87,12 @@ bool _presplit_subtables_if_needed (graph::gsubgpos_graph_context_t& ext_context
   for (unsigned lookup_index : lookup_indices)
   {
     graph::Lookup* lookup = ext_context.lookups.get(lookup_index);
+    unsigned num_subtables = lookup->number_of_subtables ();
     if (!lookup->split_subtables_if_needed (ext_context, lookup_index))
       return false;
+
+    lookup = ext_context.lookups.get(lookup_index);
+    ext_context.graph.stats.subtable_splits += lookup->number_of_subtables () - num_subtables;
   }
 
   return true;
@@ -183,6 +187,7 @@ bool _promote_extensions_if_needed (graph::gsubgpos_graph_context_t& ext_context
 
     if (!ext_context.lookups.get(p.lookup_index)->make_extension (ext_context, p.lookup_index))
       return false;
+    ext_context.graph.stats.extension_promotions++;
   }
 
   return true;
@@ -240,6 +245,7 @@ bool _try_isolating_subgraphs (const hb_vector_t<graph::overflow_record_t>& over
 
   sorted_graph.isolate_subgraph (roots_to_isolate);
   sorted_graph.move_to_new_space (roots_to_isolate);
+  sorted_graph.stats.isolations++;
 
   return true;
 }
@@ -273,6 +279,7 @@ bool _resolve_shared_overflow(const hb_vector_t<graph::overflow_record_t>& overf
   }
 
   if (result == (unsigned) -1) return false;
+  sorted_graph.stats.duplications++;
 
   if (parents.get_population() > 1) {
     // If the duplicated node has more than one parent pre-emptively raise it's priority to the maximum.
@@ -330,6 +337,7 @@ bool _process_overflows (const hb_vector_t<graph::overflow_record_t>& overflows,
       //                     the length of other offsets.
       if (sorted_graph.raise_childrens_priority (r.parent)) {
         priority_bumped_parents.add (r.parent);
+        sorted_graph.stats.priority_raises++;
         resolution_attempted = true;
       }
       continue;
@@ -368,6 +376,7 @@ hb_resolve_graph_overflows (hb_tag_t table_tag,
     DEBUG_MSG (SUBSET_REPACK, nullptr, "Applying GSUB/GPOS repacking specializations.");
     if (always_recalculate_extensions)
     {
+      graph::repack_phase_timer_t timer (sorted_graph.stats.presplit_ms);
       DEBUG_MSG (SUBSET_REPACK, nullptr, "Splitting subtables if needed.");
       if (!_presplit_subtables_if_needed (ext_context)) {
         DEBUG_MSG (SUBSET_REPACK, nullptr, "Subtable splitting failed.");
@@ -402,27 +411,39 @@ hb_resolve_graph_overflows (hb_tag_t table_tag,
   unsigned round = 0;
   unsigned total_iterations = 0;
   hb_vector_t<graph::overflow_record_t> overflows;
+  auto find_overflows = [&] ()
+  {
+    graph::repack_phase_timer_t timer (sorted_graph.stats.overflow_check_ms);
+    return graph::will_overflow (sorted_graph, &overflows);
+  };
   // TODO(garretrieger): select a good limit for max rounds.
   while (!sorted_graph.in_error ()
-         && graph::will_overflow (sorted_graph, &overflows)
+         && find_overflows ()
          && round < max_rounds
          && total_iterations < HB_REPACKER_MAX_ITERATIONS) {
     DEBUG_MSG (SUBSET_REPACK, nullptr, "=== Overflow resolution round %u ===", round);
     print_overflows (sorted_graph, overflows);
 
     total_iterations++;
+    sorted_graph.stats.iterations++;
     hb_set_t priority_bumped_parents;
 
-    if (!_try_isolating_subgraphs (overflows, sorted_graph))
     {
-      round++;
-      if (!_process_overflows (overflows, priority_bumped_parents, sorted_graph))
+      graph::repack_phase_timer_t timer (sorted_graph.stats.resolution_ms);
+      if (!_try_isolating_subgraphs (overflows, sorted_graph))
       {
-        DEBUG_MSG (SUBSET_REPACK, nullptr, "No resolution available :(");
-        break;
+        round++;
+        sorted_graph.stats.rounds++;
+        if (!_process_overflows (overflows, priority_bumped_parents, sorted_graph))
+        {
+          DEBUG_MSG (SUBSET_REPACK, nullptr, "No resolution available :(");
+          break;
+        }
       }
     }
 
+    // Duplications only invalidate the distances below the duplicated node,
+    // so this sort only recomputes those.
     sorted_graph.sort_shortest_distance ();
   }
 
@@ -488,7 +509,9 @@ hb_resolve_overflows (const T& packed,
     return nullptr;
   }
 
-  if (!hb_resolve_graph_overflows (table_tag, max_rounds, recalculate_extensions, sorted_graph))
+  bool resolved = hb_resolve_graph_overflows (table_tag, max_rounds, recalculate_extensions, sorted_graph);
+  sorted_graph.stats.print ();
+  if (!resolved)
     return nullptr;
 
   return graph::serialize (sorted_graph);
@@ -44,6 +44,7 @@ namespace OT {
 struct SubtableUnicodesCache;
 struct cff1_subset_accelerator_t;
 struct cff2_subset_accelerator_t;
+struct GSUB_closure_cache_t;
 }
 
 struct hb_subset_accelerator_t
@@ -90,6 +91,7 @@ struct hb_subset_accelerator_t
     cmap_cache(nullptr),
     destroy_cmap_cache(nullptr),
     has_seac(has_seac_),
+    gsub_closure_cache(nullptr),
     source(hb_face_reference (source))
   {
     gid_to_unicodes.alloc (unicode_to_gid.get_population ());
@@ -119,6 +121,13 @@ struct hb_subset_accelerator_t
   // CFF
   bool has_seac;
 
+  // GSUB
+  // Built on first use, for the preprocessed face the accelerator is
+  // attached to; that is the face subset plans close over.
+  mutable hb_atomic_t<OT::GSUB_closure_cache_t *> gsub_closure_cache;
+
+  HB_INTERNAL const OT::GSUB_closure_cache_t *get_gsub_closure_cache (hb_face_t *face) const;
+
   // TODO(garretrieger): cumulative glyf checksum map
 
   bool in_error () const
@@ -355,6 +355,30 @@ struct flatten_param_t
   bool emitted_blend = false;
 };
 
+/* A flattener or subsetter whose charstrings are done in tasks deferred
+ * during parallel execution (see hb_subset_plan_t::defer_tasks ()), with
+ * their results; kept by the plan until the table is subsetted again. */
+template <typename WORKER>
+struct cff_deferred_charstrings_t
+{
+  template <typename ...Ts>
+  cff_deferred_charstrings_t (Ts&&... ds) : worker (std::forward<Ts> (ds)...) {}
+
+  bool succeeded () const
+  {
+    for (bool s : success)
+      if (!s) return false;
+    return true;
+  }
+
+  WORKER worker;
+  str_buff_vec_t charstrings;
+  hb_vector_t<hb_vector_t<cs_command_t>> commands;
+  bool capture_commands = false;
+  bool encode_prefix = true;
+  hb_vector_t<bool> success;
+};
+
 template <typename ACC, typename ENV, typename OPSET, op_code_t endchar_op=OpCode_Invalid>
 struct subr_flattener_t
 {
@@ -368,7 +392,38 @@ struct subr_flattener_t
     unsigned count = plan->num_output_glyphs ();
     if (!flat_charstrings.resize_exact (count))
       return false;
-    for (unsigned int i = 0; i < count; i++)
+    return flatten_glyphs (flat_charstrings, command_capture, 0, count);
+  }
+
+  /* Each glyph is flattened on its own, into its own charstring; with an
+   * executor, glyphs are flattened in deferred tasks of GLYPHS_PER_TASK. */
+  using deferred_t = cff_deferred_charstrings_t<subr_flattener_t>;
+
+  static bool can_defer (const hb_subset_plan_t *plan)
+  { return plan->executor && plan->num_output_glyphs () > GLYPHS_PER_TASK; }
+
+  /* Defers flattening into @d, whose worker this is, for table @tag. */
+  bool defer (deferred_t &d, hb_subset_plan_t *mutable_plan, hb_tag_t tag,
+	      bool capture_commands = false) const
+  {
+    unsigned count = plan->num_output_glyphs ();
+    unsigned num_tasks = (count + GLYPHS_PER_TASK - 1) / GLYPHS_PER_TASK;
+    d.capture_commands = capture_commands;
+    if (unlikely (!d.charstrings.resize_exact (count) ||
+		  (capture_commands && !d.commands.resize_exact (count)) ||
+		  !d.success.resize (num_tasks)))
+      return false;
+    return mutable_plan->defer_tasks (tag, flatten_task, num_tasks);
+  }
+
+  private:
+  static constexpr unsigned GLYPHS_PER_TASK = 256;
+
+  bool flatten_glyphs (str_buff_vec_t &flat_charstrings,
+		       hb_vector_t<hb_vector_t<cs_command_t>> *command_capture,
+		       unsigned start, unsigned end) const
+  {
+    for (unsigned int i = start; i < end; i++)
     {
       hb_codepoint_t  glyph;
       if (!plan->old_gid_for_new_gid (i, &glyph))
@@ -398,6 +453,19 @@ struct subr_flattener_t
     return true;
   }
 
+  static void flatten_task (void *task_data, unsigned index)
+  {
+    deferred_t *d = (deferred_t *) task_data;
+    unsigned count = d->charstrings.length;
+    unsigned start = index * GLYPHS_PER_TASK;
+    unsigned end = hb_min (start + GLYPHS_PER_TASK, count);
+
+    d->success.arrayZ[index] = d->worker.flatten_glyphs (d->charstrings,
+							 d->capture_commands ? &d->commands : nullptr,
+							 start, end);
+  }
+
+  public:
   const ACC &acc;
   const hb_subset_plan_t *plan;
 };
@@ -954,39 +1022,31 @@ struct subr_subsetter_t
 
   bool encode_charstrings (str_buff_vec_t &buffArray, bool encode_prefix = true) const
   {
-    unsigned num_glyphs = plan->num_output_glyphs ();
-    if (unlikely (!buffArray.resize_exact (num_glyphs)))
+    if (unlikely (!prepare_charstrings (buffArray)))
       return false;
-    hb_codepoint_t last = 0;
-    for (auto _ : plan->new_to_old_gid_list)
-    {
-      hb_codepoint_t gid = _.first;
-      hb_codepoint_t old_glyph = _.second;
+    return encode_charstrings (buffArray, encode_prefix, 0, plan->new_to_old_gid_list.length);
+  }
 
-      if (endchar_op != OpCode_Invalid)
-        for (; last < gid; last++)
-	{
-	  // Hack to point vector to static string.
-	  auto &b = buffArray.arrayZ[last];
-	  b.set_storage (const_cast<unsigned char *>(endchar_str), 1);
-	}
+  /* Like flattening, encoding is independent per glyph; with an executor,
+   * charstrings are encoded in deferred tasks of GLYPHS_PER_TASK glyphs.
+   * Parsing and subroutine closure, in subset (), stay serial, as glyphs
+   * share parsed subroutines. */
+  using deferred_t = cff_deferred_charstrings_t<SUBSETTER>;
 
-      last++; // Skip over gid
-      unsigned int  fd = acc.fdSelect->get_fd (old_glyph);
-      if (unlikely (fd >= acc.fdCount))
-	return false;
-      if (unlikely (!encode_str (get_parsed_charstring (gid), fd, buffArray.arrayZ[gid], encode_prefix)))
-	return false;
-    }
-    if (endchar_op != OpCode_Invalid)
-      for (; last < num_glyphs; last++)
-      {
-	// Hack to point vector to static string.
-	auto &b = buffArray.arrayZ[last];
-	b.set_storage (const_cast<unsigned char *>(endchar_str), 1);
-      }
+  static bool can_defer (const hb_subset_plan_t *plan)
+  { return plan->executor && plan->new_to_old_gid_list.length > GLYPHS_PER_TASK; }
 
-    return true;
+  /* Defers encoding into @d, whose worker this is, for table @tag. */
+  bool defer (deferred_t &d, hb_subset_plan_t *mutable_plan, hb_tag_t tag,
+	      bool encode_prefix = true) const
+  {
+    unsigned count = plan->new_to_old_gid_list.length;
+    unsigned num_tasks = (count + GLYPHS_PER_TASK - 1) / GLYPHS_PER_TASK;
+    d.encode_prefix = encode_prefix;
+    if (unlikely (!prepare_charstrings (d.charstrings) ||
+		  !d.success.resize (num_tasks)))
+      return false;
+    return mutable_plan->defer_tasks (tag, encode_task, num_tasks);
   }
 
   bool encode_subrs (const parsed_cs_str_vec_t &subrs, const subr_remap_t& remap, unsigned int fd, str_buff_vec_t &buffArray) const
@@ -1016,6 +1076,67 @@ struct subr_subsetter_t
     return encode_subrs ((*parsed_local_subrs)[fd], remaps.local_remaps[fd], fd, buffArray);
   }
 
+  private:
+  static constexpr unsigned GLYPHS_PER_TASK = 256;
+
+  /* Sizes @buffArray, with endchar-only charstrings for missing glyphs. */
+  bool prepare_charstrings (str_buff_vec_t &buffArray) const
+  {
+    unsigned num_glyphs = plan->num_output_glyphs ();
+    if (unlikely (!buffArray.resize_exact (num_glyphs)))
+      return false;
+
+    if (endchar_op != OpCode_Invalid)
+    {
+      hb_codepoint_t last = 0;
+      for (auto _ : plan->new_to_old_gid_list)
+      {
+	for (; last < _.first; last++)
+	  set_endchar_str (buffArray.arrayZ[last]);
+	last++; // Skip over gid
+      }
+      for (; last < num_glyphs; last++)
+	set_endchar_str (buffArray.arrayZ[last]);
+    }
+    return true;
+  }
+
+  static void set_endchar_str (str_buff_t &b)
+  {
+    // Hack to point vector to static string.
+    b.set_storage (const_cast<unsigned char *>(endchar_str), 1);
+  }
+
+  /* Encodes the glyphs in [start, end) of plan->new_to_old_gid_list. */
+  bool encode_charstrings (str_buff_vec_t &buffArray, bool encode_prefix,
+			   unsigned start, unsigned end) const
+  {
+    for (auto _ : plan->new_to_old_gid_list.as_array ().sub_array (start, end - start))
+    {
+      hb_codepoint_t gid = _.first;
+      hb_codepoint_t old_glyph = _.second;
+
+      unsigned int  fd = acc.fdSelect->get_fd (old_glyph);
+      if (unlikely (fd >= acc.fdCount))
+	return false;
+      if (unlikely (!encode_str (get_parsed_charstring (gid), fd, buffArray.arrayZ[gid], encode_prefix)))
+	return false;
+    }
+    return true;
+  }
+
+  static void encode_task (void *task_data, unsigned index)
+  {
+    deferred_t *d = (deferred_t *) task_data;
+    const subr_subsetter_t &subsetter = d->worker;
+    unsigned count = subsetter.plan->new_to_old_gid_list.length;
+    unsigned start = index * GLYPHS_PER_TASK;
+    unsigned end = hb_min (start + GLYPHS_PER_TASK, count);
+
+    d->success.arrayZ[index] = subsetter.encode_charstrings (d->charstrings, d->encode_prefix,
+							     start, end);
+  }
+
   protected:
   struct drop_hints_param_t
   {
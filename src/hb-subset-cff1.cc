@@ -701,25 +701,62 @@ struct cff1_subset_plan
       topdict_mod.reassignSIDs (sidmap);
     }
 
+    /* With an executor, charstrings are flattened or encoded in deferred
+     * tasks; the table is then subsetted again, and picks them up here. */
+    hb_tag_t tag = OT::cff1::tableTag;
     if (desubroutinize)
     {
       /* Flatten global & local subrs */
-      subr_flattener_t<const OT::cff1::accelerator_subset_t, cff1_cs_interp_env_t, cff1_cs_opset_flatten_t, OpCode_endchar>
-		    flattener(acc, plan);
-      if (!flattener.flatten (subset_charstrings))
-	return false;
+      using flattener_t = subr_flattener_t<const OT::cff1::accelerator_subset_t, cff1_cs_interp_env_t, cff1_cs_opset_flatten_t, OpCode_endchar>;
+      auto *d = plan->get_deferred<flattener_t::deferred_t> (tag);
+      if (d)
+      {
+	if (!d->succeeded ())
+	  return false;
+	subset_charstrings = d->charstrings;
+      }
+      else if (flattener_t::can_defer (plan))
+      {
+	d = plan->create_deferred<flattener_t::deferred_t> (tag, acc, plan);
+	deferred = d && d->worker.defer (*d, plan, tag);
+	return deferred;
+      }
+      else
+      {
+	flattener_t flattener (acc, plan);
+	if (!flattener.flatten (subset_charstrings))
+	  return false;
+      }
     }
     else
     {
-      cff1_subr_subsetter_t       subr_subsetter (acc, plan);
+      auto *d = plan->get_deferred<cff1_subr_subsetter_t::deferred_t> (tag);
+      if (!d && cff1_subr_subsetter_t::can_defer (plan))
+      {
+	d = plan->create_deferred<cff1_subr_subsetter_t::deferred_t> (tag, acc, plan);
+	deferred = d && d->worker.subset () && d->worker.defer (*d, plan, tag);
+	return deferred;
+      }
 
-      /* Subset subrs: collect used subroutines, leaving all unused ones behind */
-      if (!subr_subsetter.subset ())
-	return false;
+      cff1_subr_subsetter_t       local_subsetter (acc, plan);
+      cff1_subr_subsetter_t       &subr_subsetter = d ? d->worker : local_subsetter;
 
-      /* encode charstrings, global subrs, local subrs with new subroutine numbers */
-      if (!subr_subsetter.encode_charstrings (subset_charstrings))
-	return false;
+      if (d)
+      {
+	if (!d->succeeded ())
+	  return false;
+	subset_charstrings = d->charstrings;
+      }
+      else
+      {
+	/* Subset subrs: collect used subroutines, leaving all unused ones behind */
+	if (!subr_subsetter.subset ())
+	  return false;
+
+	/* encode charstrings, global subrs, local subrs with new subroutine numbers */
+	if (!subr_subsetter.encode_charstrings (subset_charstrings))
+	  return false;
+      }
 
       if (!subr_subsetter.encode_globalsubrs (subset_globalsubrs))
 	return false;
@@ -801,6 +838,8 @@ struct cff1_subset_plan
 
   bool		desubroutinize = false;
   bool		identity_charset = false;
+  /* Charstrings are being done in deferred tasks; nothing to serialize yet. */
+  bool		deferred = false;
 
   unsigned	min_charstrings_off_size = 0;
 };
@@ -1010,6 +1049,8 @@ OT::cff1::accelerator_subset_t::subset (hb_subset_context_t *c) const
     DEBUG_MSG(SUBSET, nullptr, "Failed to generate a cff subsetting plan.");
     return false;
   }
+  if (cff_plan.deferred)
+    return false;
 
   return serialize (c->serializer, cff_plan);
 }
@@ -161,7 +161,8 @@ struct cff2_instancing_plan_t
       }
       if (unlikely (tuples.tuple_vars.in_error ())) return false;
 
-      if (!tuples.instantiate (plan->axes_location, plan->axes_triple_distances, scratch))
+      if (!tuples.instantiate (plan->axes_location, plan->axes_triple_distances, scratch,
+                               nullptr, nullptr, false, &plan->rebase_tent_cache))
 	return false;
 
       for (auto &tuple : tuples.tuple_vars)
@@ -1128,6 +1129,9 @@ struct cff2_subset_plan
     min_charstrings_off_size = 0;
  #endif
 
+    /* With an executor, charstrings are flattened or encoded in deferred
+     * tasks; the table is then subsetted again, and picks them up here. */
+    hb_tag_t tag = OT::cff2::tableTag;
     if (desubroutinize)
     {
       if (partial_instancing)
@@ -1202,8 +1206,24 @@ struct cff2_subset_plan
       else
       {
       /* Flatten global & local subrs */
-      subr_flattener_t<const OT::cff2::accelerator_subset_t, cff2_cs_interp_env_t<blend_arg_t>, cff2_cs_opset_flatten_t>
-		    flattener(acc, plan);
+      using flattener_t = subr_flattener_t<const OT::cff2::accelerator_subset_t, cff2_cs_interp_env_t<blend_arg_t>, cff2_cs_opset_flatten_t>;
+      auto *d = plan->get_deferred<flattener_t::deferred_t> (tag);
+      if (d)
+      {
+	if (!d->succeeded ())
+	  return false;
+	subset_charstrings = d->charstrings;
+	charstring_commands = d->commands;
+      }
+      else if (flattener_t::can_defer (plan))
+      {
+	d = plan->create_deferred<flattener_t::deferred_t> (tag, acc, plan);
+	deferred = d && d->worker.defer (*d, plan, tag, capture_commands);
+	return deferred;
+      }
+      else
+      {
+      flattener_t flattener (acc, plan);
 
       /* Enable command capture if requested (for specialization) */
       if (capture_commands)
@@ -1220,18 +1240,37 @@ struct cff2_subset_plan
 	  return false;
       }
       }
+      }
     }
     else
     {
-      cff2_subr_subsetter_t	subr_subsetter (acc, plan);
+      auto *d = plan->get_deferred<cff2_subr_subsetter_t::deferred_t> (tag);
+      if (!d && cff2_subr_subsetter_t::can_defer (plan))
+      {
+	d = plan->create_deferred<cff2_subr_subsetter_t::deferred_t> (tag, acc, plan);
+	deferred = d && d->worker.subset () && d->worker.defer (*d, plan, tag, !pinned);
+	return deferred;
+      }
 
-      /* Subset subrs: collect used subroutines, leaving all unused ones behind */
-      if (!subr_subsetter.subset ())
-	return false;
+      cff2_subr_subsetter_t	local_subsetter (acc, plan);
+      cff2_subr_subsetter_t	&subr_subsetter = d ? d->worker : local_subsetter;
 
-      /* encode charstrings, global subrs, local subrs with new subroutine numbers */
-      if (!subr_subsetter.encode_charstrings (subset_charstrings, !pinned))
-	return false;
+      if (d)
+      {
+	if (!d->succeeded ())
+	  return false;
+	subset_charstrings = d->charstrings;
+      }
+      else
+      {
+	/* Subset subrs: collect used subroutines, leaving all unused ones behind */
+	if (!subr_subsetter.subset ())
+	  return false;
+
+	/* encode charstrings, global subrs, local subrs with new subroutine numbers */
+	if (!subr_subsetter.encode_charstrings (subset_charstrings, !pinned))
+	  return false;
+      }
 
       if (!subr_subsetter.encode_globalsubrs (subset_globalsubrs))
 	return false;
@@ -1284,6 +1323,8 @@ struct cff2_subset_plan
 
   bool	    drop_hints = false;
   bool	    desubroutinize = false;
+  /* Charstrings are being done in deferred tasks; nothing to serialize yet. */
+  bool	    deferred = false;
 
   bool	    partial_instancing = false;
   cff2_instancing_plan_t instancing;
@@ -1933,6 +1974,7 @@ OT::cff2::accelerator_subset_t::subset (hb_subset_context_t *c) const
   cff2_subset_plan cff2_plan;
 
   if (unlikely (!cff2_plan.create (*this, c->plan))) return false;
+  if (cff2_plan.deferred) return false;
 
   // If instantiating (pinned) and downgrade flag is set, convert to CFF1
   if (cff2_plan.pinned && (c->plan->flags & HB_SUBSET_FLAGS_DOWNGRADE_CFF2))
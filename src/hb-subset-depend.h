@@ -32,6 +32,7 @@
 #endif
 
 #include "hb.h"
+#include "hb-subset-executor.h"
 
 HB_BEGIN_DECLS
 
@@ -111,6 +112,11 @@ typedef struct {
 HB_EXTERN hb_subset_depend_t *
 hb_subset_depend_from_face_or_fail (hb_face_t *face);
 
+HB_EXTERN hb_subset_depend_t *
+hb_subset_depend_from_face_parallel_or_fail (hb_face_t                 *face,
+					     hb_subset_executor_func_t  executor,
+					     void                      *user_data);
+
 HB_EXTERN unsigned int
 hb_subset_depend_lookup_glyph (hb_subset_depend_t *depend,
                                 hb_codepoint_t gid,
@@ -123,6 +129,12 @@ hb_subset_depend_lookup_set (hb_subset_depend_t *depend,
                               hb_codepoint_t index,
                               hb_set_t *out /* OUT */);
 
+HB_EXTERN hb_blob_t *
+hb_subset_depend_serialize_or_fail (hb_subset_depend_t *depend);
+
+HB_EXTERN hb_subset_depend_t *
+hb_subset_depend_from_blob_or_fail (hb_blob_t *blob);
+
 HB_EXTERN void
 hb_subset_depend_destroy (hb_subset_depend_t *depend);
 
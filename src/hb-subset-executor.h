@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_SUBSET_EXECUTOR_H
+#define HB_SUBSET_EXECUTOR_H
+
+#if !defined(HB_SUBSET_H_IN) && !defined(HB_NO_SINGLE_HEADER_ERROR)
+#error "Include <hb-subset.h> instead."
+#endif
+
+#include "hb.h"
+
+HB_BEGIN_DECLS
+
+/**
+ * hb_subset_task_func_t:
+ * @task_data: the @task_data passed to the #hb_subset_executor_func_t
+ * @index: index of the task to run
+ *
+ * A unit of work handed to an #hb_subset_executor_func_t.
+ *
+ * XSince: REPLACEME
+ **/
+typedef void (*hb_subset_task_func_t) (void         *task_data,
+				       unsigned int  index);
+
+/**
+ * hb_subset_executor_func_t:
+ * @task: the task function
+ * @task_data: data to pass to @task
+ * @count: number of tasks
+ * @user_data: the user data passed to
+ *   hb_subset_plan_execute_parallel_or_fail()
+ *
+ * A callback that runs `@task (@task_data, i)` once for every `i`
+ * from 0 to @count - 1, in any order and possibly concurrently, and
+ * returns only after all of them have finished.  Typically this
+ * dispatches the tasks to a thread pool and waits for them.
+ *
+ * HarfBuzz never calls the executor from within one of its tasks, so
+ * an executor backed by a fixed number of workers may simply block
+ * until they are done.
+ *
+ * XSince: REPLACEME
+ **/
+typedef void (*hb_subset_executor_func_t) (hb_subset_task_func_t  task,
+					   void                  *task_data,
+					   unsigned int           count,
+					   void                  *user_data);
+
+HB_END_DECLS
+
+#endif /* HB_SUBSET_EXECUTOR_H */
@@ -26,6 +26,14 @@
 
 #include "hb-bit-page.hh"
 
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HB_IUP_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HB_IUP_SSE2 1
+#endif
+
 using hb_iup_set_t = hb_bit_page_t;
 
 /* This file is a straight port of the following:
@@ -176,114 +184,119 @@ static bool rotate_set (const hb_iup_set_t& org_set,
   return true;
 }
 
-/* Given two reference coordinates (start and end of contour_points array),
- * output interpolated deltas for points in between */
-static bool _iup_segment (const hb_array_t<const contour_point_t> contour_points,
-                          const hb_array_t<const int> x_deltas,
-                          const hb_array_t<const int> y_deltas,
-                          const contour_point_t& p1, const contour_point_t& p2,
-                          int p1_dx, int p2_dx,
-                          int p1_dy, int p2_dy,
-			  double tolerance_sq,
-                          hb_vector_t<double>& interp_x_deltas, /* OUT */
-                          hb_vector_t<double>& interp_y_deltas /* OUT */)
+/* Interpolation along one axis between the two reference points of a
+ * segment: points at or beyond either end take that end's delta, and
+ * points in between are interpolated linearly.  When both ends share
+ * the coordinate, every point gets their delta if they agree and zero
+ * otherwise; lo and hi are then infinite so the first case always
+ * applies. */
+struct iup_axis_t
 {
-  unsigned n = contour_points.length;
-  if (unlikely (!interp_x_deltas.resize_dirty  (n) ||
-                !interp_y_deltas.resize_dirty  (n)))
-    return false;
-
-  for (unsigned j = 0; j < 2; j++)
+  iup_axis_t (double c1, double c2, double d1, double d2)
   {
-    float contour_point_t::* xp;
-    double x1, x2, d1, d2;
-    const int *in;
-    double *out;
-    if (j == 0)
-    {
-      xp = &contour_point_t::x;
-      x1 = static_cast<double> (p1.x);
-      x2 = static_cast<double> (p2.x);
-      d1 = p1_dx;
-      d2 = p2_dx;
-      in = x_deltas.arrayZ;
-      out = interp_x_deltas.arrayZ;
-    }
-    else
+    if (c1 == c2)
     {
-      xp = &contour_point_t::y;
-      x1 = static_cast<double> (p1.y);
-      x2 = static_cast<double> (p2.y);
-      d1 = p1_dy;
-      d2 = p2_dy;
-      in = y_deltas.arrayZ;
-      out = interp_y_deltas.arrayZ;
-    }
-
-    if (x1 == x2)
-    {
-      if (d1 == d2)
-      {
-        for (unsigned i = 0; i < n; i++)
-          out[i] = d1;
-      }
-      else
-      {
-        for (unsigned i = 0; i < n; i++)
-          out[i] = 0.0;
-      }
-      continue;
+      lo = hi = HUGE_VAL;
+      d_lo = d_hi = d1 == d2 ? d1 : 0.0;
+      scale = 0.0;
+      return;
     }
 
-    if (x1 > x2)
+    if (c1 > c2)
     {
-      hb_swap (x1, x2);
+      hb_swap (c1, c2);
       hb_swap (d1, d2);
     }
+    lo = c1;
+    hi = c2;
+    d_lo = d1;
+    d_hi = d2;
+    scale = (d2 - d1) / (c2 - c1);
+  }
 
-    double scale = (d2 - d1) / (x2 - x1);
-    for (unsigned i = 0; i < n; i++)
-    {
-      double x = (double) (contour_points.arrayZ[i].*xp);
-      double d;
-      if (x <= x1)
-        d = d1;
-      else if (x >= x2)
-        d = d2;
-      else
-        d = d1 + (x - x1) * scale;
-
-      out[i] = d;
-      double err = d - in[i];
-      if (err * err > tolerance_sq)
-	return false;
-    }
+  double interpolate (double c) const
+  {
+    if (c <= lo) return d_lo;
+    if (c >= hi) return d_hi;
+    return d_lo + (c - lo) * scale;
   }
-  return true;
-}
 
+  double lo, hi;
+  double d_lo, d_hi;
+  double scale;
+};
+
+/* Given two reference points p1 and p2, check whether the deltas of the
+ * points in between can be interpolated from theirs within tolerance.
+ *
+ * Both axes of a point are interpolated together, in the two lanes of a
+ * vector where available.  Each lane does the same operations in the
+ * same order as iup_axis_t::interpolate(), so the result does not
+ * depend on the path taken. */
 static bool _can_iup_in_between (const hb_array_t<const contour_point_t> contour_points,
                                  const hb_array_t<const int> x_deltas,
                                  const hb_array_t<const int> y_deltas,
                                  const contour_point_t& p1, const contour_point_t& p2,
                                  int p1_dx, int p2_dx,
                                  int p1_dy, int p2_dy,
-                                 double tolerance_sq,
-				 hb_vector_t<double> &interp_x_deltas, /* scratch */
-				 hb_vector_t<double> &interp_y_deltas /* scratch */)
+                                 double tolerance_sq)
 {
-  if (!_iup_segment (contour_points, x_deltas, y_deltas,
-                     p1, p2, p1_dx, p2_dx, p1_dy, p2_dy,
-		     tolerance_sq,
-                     interp_x_deltas, interp_y_deltas))
-    return false;
+  const iup_axis_t ax (p1.x, p2.x, p1_dx, p2_dx);
+  const iup_axis_t ay (p1.y, p2.y, p1_dy, p2_dy);
 
   unsigned num = contour_points.length;
-
-  for (unsigned i = 0; i < num; i++)
+  unsigned i = 0;
+#if defined(HB_IUP_SSE2)
+  const __m128d lo = _mm_set_pd (ay.lo, ax.lo);
+  const __m128d hi = _mm_set_pd (ay.hi, ax.hi);
+  const __m128d d_lo = _mm_set_pd (ay.d_lo, ax.d_lo);
+  const __m128d d_hi = _mm_set_pd (ay.d_hi, ax.d_hi);
+  const __m128d scale = _mm_set_pd (ay.scale, ax.scale);
+  for (; i < num; i++)
+  {
+    const contour_point_t &p = contour_points.arrayZ[i];
+    __m128d c = _mm_set_pd (p.y, p.x);
+    __m128d mid = _mm_add_pd (d_lo, _mm_mul_pd (_mm_sub_pd (c, lo), scale));
+    __m128d at_lo = _mm_cmple_pd (c, lo);
+    __m128d at_hi = _mm_cmpge_pd (c, hi);
+    __m128d d = _mm_or_pd (_mm_and_pd (at_hi, d_hi), _mm_andnot_pd (at_hi, mid));
+    d = _mm_or_pd (_mm_and_pd (at_lo, d_lo), _mm_andnot_pd (at_lo, d));
+
+    __m128d err = _mm_sub_pd (_mm_set_pd (y_deltas.arrayZ[i], x_deltas.arrayZ[i]), d);
+    err = _mm_mul_pd (err, err);
+    if (_mm_cvtsd_f64 (err) + _mm_cvtsd_f64 (_mm_unpackhi_pd (err, err)) > tolerance_sq)
+      return false;
+  }
+#elif defined(HB_IUP_NEON)
+  const double lo_[2] = {ax.lo, ay.lo};
+  const double hi_[2] = {ax.hi, ay.hi};
+  const double d_lo_[2] = {ax.d_lo, ay.d_lo};
+  const double d_hi_[2] = {ax.d_hi, ay.d_hi};
+  const double scale_[2] = {ax.scale, ay.scale};
+  const float64x2_t lo = vld1q_f64 (lo_);
+  const float64x2_t hi = vld1q_f64 (hi_);
+  const float64x2_t d_lo = vld1q_f64 (d_lo_);
+  const float64x2_t d_hi = vld1q_f64 (d_hi_);
+  const float64x2_t scale = vld1q_f64 (scale_);
+  for (; i < num; i++)
+  {
+    float64x2_t c = vcvt_f64_f32 (vld1_f32 (&contour_points.arrayZ[i].x));
+    float64x2_t mid = vaddq_f64 (d_lo, vmulq_f64 (vsubq_f64 (c, lo), scale));
+    float64x2_t d = vbslq_f64 (vcgeq_f64 (c, hi), d_hi, mid);
+    d = vbslq_f64 (vcleq_f64 (c, lo), d_lo, d);
+
+    const double delta[2] = {(double) x_deltas.arrayZ[i], (double) y_deltas.arrayZ[i]};
+    float64x2_t err = vsubq_f64 (vld1q_f64 (delta), d);
+    err = vmulq_f64 (err, err);
+    if (vgetq_lane_f64 (err, 0) + vgetq_lane_f64 (err, 1) > tolerance_sq)
+      return false;
+  }
+#endif
+  for (; i < num; i++)
   {
-    double dx = static_cast<double> (x_deltas.arrayZ[i]) - interp_x_deltas.arrayZ[i];
-    double dy = static_cast<double> (y_deltas.arrayZ[i]) - interp_y_deltas.arrayZ[i];
+    const contour_point_t &p = contour_points.arrayZ[i];
+    double dx = static_cast<double> (x_deltas.arrayZ[i]) - ax.interpolate (p.x);
+    double dy = static_cast<double> (y_deltas.arrayZ[i]) - ay.interpolate (p.y);
 
     if (dx * dx + dy * dy > tolerance_sq)
       return false;
@@ -299,8 +312,8 @@ static bool _iup_contour_optimize_dp (const contour_point_vector_t& contour_poin
                                       unsigned lookback,
                                       hb_vector_t<unsigned>& costs, /* OUT */
                                       hb_vector_t<int>& chain, /* OUT */
-				      hb_vector_t<double> &interp_x_deltas_scratch,
-				      hb_vector_t<double> &interp_y_deltas_scratch)
+                                      unsigned period,
+                                      hb_vector_t<uint8_t>& can_iup_memo /* scratch */)
 {
   unsigned n = contour_points.length;
   if (unlikely (!costs.resize_dirty  (n) ||
@@ -309,6 +322,35 @@ static bool _iup_contour_optimize_dp (const contour_point_vector_t& contour_poin
 
   lookback = hb_min (lookback, MAX_LOOKBACK);
 
+  /* If the points repeat with @period, so do the segments: the one
+   * from j to i is the same as the one from j - period to i - period,
+   * with -1 standing for n - 1.  Their interpolation checks are
+   * memoized by end point and length: 0 for unknown, 1 for yes and 2
+   * for no. */
+  if (period &&
+      unlikely (!can_iup_memo.reset ().resize (period * MAX_LOOKBACK)))
+    return false;
+
+  auto can_iup = [&] (unsigned i, int j)
+  {
+    uint8_t *memo = period ? &can_iup_memo.arrayZ[(i % period) * MAX_LOOKBACK + (i - j)] : nullptr;
+    if (memo && *memo)
+      return *memo == 1;
+
+    /* num points between i and j */
+    unsigned num_points = i - j - 1;
+    unsigned p1 = (j == -1 ? n - 1 : j);
+    bool ret = _can_iup_in_between (contour_points.as_array ().sub_array (j + 1, num_points),
+                                    x_deltas.as_array ().sub_array (j + 1, num_points),
+                                    y_deltas.as_array ().sub_array (j + 1, num_points),
+                                    contour_points.arrayZ[p1], contour_points.arrayZ[i],
+                                    x_deltas.arrayZ[p1], x_deltas.arrayZ[i],
+                                    y_deltas.arrayZ[p1], y_deltas.arrayZ[i],
+                                    tolerance_sq);
+    if (memo) *memo = ret ? 1 : 2;
+    return ret;
+  };
+
   for (unsigned i = 0; i < n; i++)
   {
     unsigned best_cost = (i == 0 ? 1 : costs.arrayZ[i-1] + 1);
@@ -323,18 +365,7 @@ static bool _iup_contour_optimize_dp (const contour_point_vector_t& contour_poin
     for (int j = i - 2; j >= lookback_index; j--)
     {
       unsigned cost = j == -1 ? 1 : costs.arrayZ[j] + 1;
-      /* num points between i and j */
-      unsigned num_points = i - j - 1;
-      unsigned p1 = (j == -1 ? n - 1 : j);
-      if (cost < best_cost &&
-          _can_iup_in_between (contour_points.as_array ().sub_array (j + 1, num_points),
-                               x_deltas.as_array ().sub_array (j + 1, num_points),
-                               y_deltas.as_array ().sub_array (j + 1, num_points),
-                               contour_points.arrayZ[p1], contour_points.arrayZ[i],
-                               x_deltas.arrayZ[p1], x_deltas.arrayZ[i],
-                               y_deltas.arrayZ[p1], y_deltas.arrayZ[i],
-                               tolerance_sq,
-			       interp_x_deltas_scratch, interp_y_deltas_scratch))
+      if (cost < best_cost && can_iup (i, j))
       {
         best_cost = cost;
         costs.arrayZ[i] = best_cost;
@@ -409,6 +440,14 @@ static bool _iup_contour_optimize (const hb_array_t<const contour_point_t> conto
   hb_iup_set_t forced_set;
   _iup_contour_bound_forced_set (contour_points, x_deltas, y_deltas, forced_set, tolerance);
 
+  /* If every point is forced, they all have to be referenced. */
+  if (forced_set.get_population () == n)
+  {
+    for (unsigned i = 0; i < n; i++)
+      opt_indices.arrayZ[i] = true;
+    return true;
+  }
+
   hb_vector_t<unsigned> &costs = scratch.costs.reset ();
   hb_vector_t<int> &chain = scratch.chain.reset ();
 
@@ -432,7 +471,7 @@ static bool _iup_contour_optimize (const hb_array_t<const contour_point_t> conto
     if (!_iup_contour_optimize_dp (rot_points, rot_x_deltas, rot_y_deltas,
                                    rot_forced_set, tolerance_sq, n,
                                    costs, chain,
-				   scratch.interp_x_deltas, scratch.interp_y_deltas))
+                                   0, scratch.can_iup_memo))
       return false;
 
     hb_iup_set_t solution;
@@ -460,8 +499,9 @@ static bool _iup_contour_optimize (const hb_array_t<const contour_point_t> conto
   }
   else
   {
-    hb_vector_t<int> repeat_x_deltas, repeat_y_deltas;
-    contour_point_vector_t repeat_points;
+    hb_vector_t<int> &repeat_x_deltas = scratch.repeat_x_deltas;
+    hb_vector_t<int> &repeat_y_deltas = scratch.repeat_y_deltas;
+    contour_point_vector_t &repeat_points = scratch.repeat_points;
 
     if (unlikely (!repeat_x_deltas.resize_dirty  (n * 2) ||
                   !repeat_y_deltas.resize_dirty  (n * 2) ||
@@ -469,22 +509,19 @@ static bool _iup_contour_optimize (const hb_array_t<const contour_point_t> conto
       return false;
 
     unsigned contour_point_size = hb_static_size (contour_point_t);
-    for (unsigned i = 0; i < n; i++)
-    {
-      hb_memcpy ((void *) repeat_x_deltas.arrayZ, (const void *) x_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
-      hb_memcpy ((void *) (repeat_x_deltas.arrayZ + n), (const void *) x_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
+    hb_memcpy ((void *) repeat_x_deltas.arrayZ, (const void *) x_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
+    hb_memcpy ((void *) (repeat_x_deltas.arrayZ + n), (const void *) x_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
 
-      hb_memcpy ((void *) repeat_y_deltas.arrayZ, (const void *) y_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
-      hb_memcpy ((void *) (repeat_y_deltas.arrayZ + n), (const void *) y_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
+    hb_memcpy ((void *) repeat_y_deltas.arrayZ, (const void *) y_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
+    hb_memcpy ((void *) (repeat_y_deltas.arrayZ + n), (const void *) y_deltas.arrayZ, n * sizeof (repeat_x_deltas[0]));
 
-      hb_memcpy ((void *) repeat_points.arrayZ, (const void *) contour_points.arrayZ, n * contour_point_size);
-      hb_memcpy ((void *) (repeat_points.arrayZ + n), (const void *) contour_points.arrayZ, n * contour_point_size);
-    }
+    hb_memcpy ((void *) repeat_points.arrayZ, (const void *) contour_points.arrayZ, n * contour_point_size);
+    hb_memcpy ((void *) (repeat_points.arrayZ + n), (const void *) contour_points.arrayZ, n * contour_point_size);
 
     if (!_iup_contour_optimize_dp (repeat_points, repeat_x_deltas, repeat_y_deltas,
                                    forced_set, tolerance_sq, n,
                                    costs, chain,
-				   scratch.interp_x_deltas, scratch.interp_y_deltas))
+                                   n, scratch.can_iup_memo))
       return false;
 
     unsigned best_cost = n + 1;
@@ -30,14 +30,16 @@
 struct iup_scratch_t
 {
   hb_vector_t<unsigned> end_points;
-  hb_vector_t<double> interp_x_deltas;
-  hb_vector_t<double> interp_y_deltas;
   hb_vector_t<unsigned> costs;
   hb_vector_t<int> chain;
   hb_vector_t<bool> rot_indices;
   hb_vector_t<int> rot_x_deltas;
   hb_vector_t<int> rot_y_deltas;
   contour_point_vector_t rot_points;
+  hb_vector_t<int> repeat_x_deltas;
+  hb_vector_t<int> repeat_y_deltas;
+  contour_point_vector_t repeat_points;
+  hb_vector_t<uint8_t> can_iup_memo;
 };
 
 /* given contour points and deltas, optimize a set of referenced points within error
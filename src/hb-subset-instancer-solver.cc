@@ -453,3 +453,32 @@ rebase_tent (Triple tent, Triple axisLimit, TripleDistances axis_triple_distance
 		       Triple{n (t.minimum), n (t.middle), n (t.maximum)}));
   }
 }
+
+void
+rebase_tent_cache_t::rebase_tent (Triple tent, Triple axisLimit, TripleDistances axis_triple_distances,
+				  rebase_tent_result_t &out,
+				  rebase_tent_result_t &scratch)
+{
+  key_t key = {{tent.minimum, tent.middle, tent.maximum,
+		axisLimit.minimum, axisLimit.middle, axisLimit.maximum,
+		axis_triple_distances.negative, axis_triple_distances.positive}};
+  uint32_t hash = key.hash ();
+
+  {
+    hb_lock_t l (lock);
+    const rebase_tent_result_t *cached;
+    if (results.has_with_hash (key, hash, &cached))
+    {
+      hits++;
+      out = *cached;
+      return;
+    }
+  }
+
+  ::rebase_tent (tent, axisLimit, axis_triple_distances, out, scratch);
+
+  hb_lock_t l (lock);
+  misses++;
+  if (likely (!out.in_error ()))
+    results.set_with_hash (key, hash, out);
+}
@@ -26,6 +26,7 @@
 #define HB_SUBSET_INSTANCER_SOLVER_HH
 
 #include "hb.hh"
+#include "hb-map.hh"
 
 /* pre-normalized distances */
 struct TripleDistances
@@ -111,4 +112,43 @@ HB_INTERNAL void rebase_tent (Triple tent,
 			      rebase_tent_result_t &out,
 			      rebase_tent_result_t &scratch);
 
+/* Memoizes rebase_tent () by its arguments.  A partial-instancing plan
+ * keeps one for all its tables, since the same regions show up in every
+ * tuple variation store of a font, and in most tuples of gvar.  Safe to
+ * use from multiple threads. */
+struct rebase_tent_cache_t
+{
+  HB_INTERNAL void rebase_tent (Triple tent,
+				Triple axisLimit,
+				TripleDistances axis_triple_distances,
+				rebase_tent_result_t &out,
+				rebase_tent_result_t &scratch);
+
+  /* Only needed while tables are subsetted concurrently; unlocked
+   * otherwise. */
+  void set_lock (hb_mutex_t *lock_) { lock = lock_; }
+
+  unsigned get_hits () const { return hits; }
+  unsigned get_misses () const { return misses; }
+
+  private:
+  /* Compared bitwise, so that results are reused only for arguments
+   * that would produce them bit for bit. */
+  struct key_t
+  {
+    double values[8];
+
+    uint32_t hash () const
+    { return fasthash32 (values, sizeof (values), 0xf437ffe6); }
+
+    bool operator == (const key_t &o) const
+    { return !hb_memcmp (values, o.values, sizeof (values)); }
+  };
+
+  hb_mutex_t *lock = nullptr;
+  hb_hashmap_t<key_t, rebase_tent_result_t> results;
+  unsigned hits = 0;
+  unsigned misses = 0;
+};
+
 #endif /* HB_SUBSET_INSTANCER_SOLVER_HH */
@@ -283,6 +283,44 @@ remap_feature_indices (const hb_set_t &feature_indices,
   }
 }
 
+const OT::GSUB_closure_cache_t *
+hb_subset_accelerator_t::get_gsub_closure_cache (hb_face_t *face) const
+{
+retry:
+  OT::GSUB_closure_cache_t *cache = gsub_closure_cache.get_acquire ();
+  if (unlikely (!cache))
+  {
+    cache = (OT::GSUB_closure_cache_t *) hb_calloc (1, sizeof (OT::GSUB_closure_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    new (cache) OT::GSUB_closure_cache_t (face);
+
+    if (unlikely (!gsub_closure_cache.cmpexch (nullptr, cache)))
+    {
+      cache->~GSUB_closure_cache_t ();
+      hb_free (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+static void
+_gsub_closure (hb_subset_plan_t *plan,
+	       const hb_set_t   *lookup_indices,
+	       hb_set_t         *gids_to_retain)
+{
+  const OT::GSUB_closure_cache_t *cache = plan->accelerator
+					? plan->accelerator->get_gsub_closure_cache (plan->source)
+					: nullptr;
+  if (cache)
+    cache->closure (plan->source, lookup_indices, gids_to_retain);
+  else
+    hb_ot_layout_lookups_substitute_closure (plan->source,
+					     lookup_indices,
+					     gids_to_retain);
+}
+
 template <typename T>
 static void
 _closure_glyphs_lookups_features (hb_subset_plan_t   *plan,
@@ -294,7 +332,8 @@ _closure_glyphs_lookups_features (hb_subset_plan_t   *plan,
 				 hb_hashmap_t<unsigned, hb::shared_ptr<hb_set_t>> *feature_record_cond_idx_map,
 				 hb_hashmap_t<unsigned, const OT::Feature*> *feature_substitutes_map,
                                  hb_set_t &catch_all_record_feature_idxes,
-                                 hb_hashmap_t<unsigned, hb_pair_t<const void*, const void*>>& catch_all_record_idx_feature_map)
+                                 hb_hashmap_t<unsigned, hb_pair_t<const void*, const void*>>& catch_all_record_idx_feature_map,
+				 const hb_map_t     *base_lookups)
 {
   hb_blob_ptr_t<T> table = plan->source_table<T> ();
   hb_tag_t table_tag = table->tableTag;
@@ -308,10 +347,19 @@ _closure_glyphs_lookups_features (hb_subset_plan_t   *plan,
                               catch_all_record_feature_idxes,
                               catch_all_record_idx_feature_map);
 
+  if (base_lookups)
+  {
+    // The base plan closed over a superset of our glyphs, so any lookup it
+    // found inactive is inactive for us too; don't visit those again.
+    hb_set_t active_lookup_indices;
+    for (unsigned lookup_index : lookup_indices)
+      if (base_lookups->has (lookup_index))
+        active_lookup_indices.add (lookup_index);
+    hb_swap (lookup_indices, active_lookup_indices);
+  }
+
   if (table_tag == HB_OT_TAG_GSUB && !(plan->flags & HB_SUBSET_FLAGS_NO_LAYOUT_CLOSURE))
-    hb_ot_layout_lookups_substitute_closure (plan->source,
-                                             &lookup_indices,
-					     gids_to_retain);
+    _gsub_closure (plan, &lookup_indices, gids_to_retain);
   table->closure_lookups (plan->source,
 			  gids_to_retain,
                           &lookup_indices);
@@ -351,7 +399,8 @@ void layout_nameid_closure (hb_subset_plan_t* plan,
 
 void
 layout_populate_gids_to_retain (hb_subset_plan_t* plan,
-		                hb_set_t* drop_tables) {
+		                hb_set_t* drop_tables,
+		                const hb_subset_plan_t* base) {
   if (!drop_tables->has (HB_OT_TAG_GSUB))
     // closure all glyphs/lookups/features needed for GSUB substitutions.
     _closure_glyphs_lookups_features<GSUB> (
@@ -364,7 +413,8 @@ layout_populate_gids_to_retain (hb_subset_plan_t* plan,
         &plan->gsub_feature_record_cond_idx_map,
         &plan->gsub_feature_substitutes_map,
         plan->gsub_old_features,
-        plan->gsub_old_feature_idx_tag_map);
+        plan->gsub_old_feature_idx_tag_map,
+        base ? &base->gsub_lookups : nullptr);
 
   if (!drop_tables->has (HB_OT_TAG_GPOS))
     _closure_glyphs_lookups_features<GPOS> (
@@ -377,7 +427,8 @@ layout_populate_gids_to_retain (hb_subset_plan_t* plan,
         &plan->gpos_feature_record_cond_idx_map,
         &plan->gpos_feature_substitutes_map,
         plan->gpos_old_features,
-        plan->gpos_old_feature_idx_tag_map);
+        plan->gpos_old_feature_idx_tag_map,
+        base ? &base->gpos_lookups : nullptr);
 }
 
 #ifndef HB_NO_VAR
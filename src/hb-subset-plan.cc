@@ -35,6 +35,7 @@
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
 #include "hb-ot-layout-base-table.hh"
+#include "hb-ot-layout-gsub-table.hh"
 #include "hb-ot-cff1-table.hh"
 #include "hb-ot-cff2-table.hh"
 #include "OT/Color/COLR/COLR.hh"
@@ -53,6 +54,14 @@ hb_subset_accelerator_t::~hb_subset_accelerator_t ()
   cff1_accel.fini ();
   cff2_accel.fini ();
 #endif
+
+  OT::GSUB_closure_cache_t *cache = gsub_closure_cache.get_relaxed ();
+  if (cache)
+  {
+    cache->~GSUB_closure_cache_t ();
+    hb_free (cache);
+  }
+
   hb_face_destroy (source);
 }
 
@@ -437,7 +446,8 @@ _nameid_closure (hb_subset_plan_t* plan,
 
 static void
 _populate_gids_to_retain (hb_subset_plan_t* plan,
-		          hb_set_t* drop_tables)
+		          hb_set_t* drop_tables,
+		          const hb_subset_plan_t* base)
 {
   OT::glyf_accelerator_t glyf (plan->source);
 #ifndef HB_NO_SUBSET_CFF
@@ -461,7 +471,11 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
   plan->_glyphset_mathed = plan->_glyphset_gsub;
 
 #ifndef HB_NO_SUBSET_LAYOUT
-  layout_populate_gids_to_retain(plan, drop_tables);
+  // Layout results of the base plan can only be reused if it covers our
+  // glyphs; the closure of a subset is a subset of the closure.
+  if (base && !plan->_glyphset_mathed.is_subset (base->_glyphset_mathed))
+    base = nullptr;
+  layout_populate_gids_to_retain(plan, drop_tables, base);
 #endif
 
   _remove_invalid_gids (&plan->_glyphset_gsub, plan->source->get_num_glyphs ());
@@ -627,8 +641,26 @@ _create_old_gid_to_new_gid_map (const hb_face_t *face,
   return true;
 }
 
+/* Whether the layout results of base can be reused for a plan of face
+ * with input; everything that feeds into the layout closure, other than
+ * the glyphs themselves, must match. */
+static bool
+_is_compatible_base (const hb_subset_plan_t *base,
+		     hb_face_t *face,
+		     const hb_subset_input_t *input)
+{
+  return base->source == face &&
+	 !base->in_error () &&
+	 base->flags == input->flags &&
+	 base->drop_tables == *input->sets.drop_tables &&
+	 base->layout_features == *input->sets.layout_features &&
+	 base->layout_scripts == *input->sets.layout_scripts &&
+	 base->user_axes_location == input->axes_location;
+}
+
 hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
-				    const hb_subset_input_t *input)
+				    const hb_subset_input_t *input,
+				    const hb_subset_plan_t *base)
 {
   successful = true;
   flags = input->flags;
@@ -658,6 +690,12 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
   pinned_at_default = true;
   has_gdef_varstore = false;
   has_avar2 = false;
+  parallel_lock = nullptr;
+  executor = nullptr;
+  executor_user_data = nullptr;
+  sink = nullptr;
+  sink_user_data = nullptr;
+  memory = peak_memory = 0;
 
 #ifdef HB_EXPERIMENTAL_API
   for (auto _ : input->name_table_overrides)
@@ -694,7 +732,9 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
 
   _populate_unicodes_to_retain (input->sets.unicodes, input->sets.glyphs, this);
 
-  _populate_gids_to_retain (this, input->sets.drop_tables);
+  if (base && !_is_compatible_base (base, face, input))
+    base = nullptr;
+  _populate_gids_to_retain (this, input->sets.drop_tables, base);
   if (unlikely (in_error ()))
     return;
 
@@ -782,6 +822,10 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
 
 hb_subset_plan_t::~hb_subset_plan_t()
 {
+  if (rebase_tent_cache.get_hits () || rebase_tent_cache.get_misses ())
+    DEBUG_MSG (SUBSET, nullptr, "rebase_tent: %u cached, %u solved",
+	       rebase_tent_cache.get_hits (), rebase_tent_cache.get_misses ());
+
   hb_face_destroy (dest);
 
   hb_map_destroy (codepoint_to_glyph);
@@ -835,6 +879,51 @@ hb_subset_plan_create_or_fail (hb_face_t	 *face,
   return plan;
 }
 
+/**
+ * hb_subset_plan_create_from_base_or_fail:
+ * @face: font face to create the plan for.
+ * @input: a #hb_subset_input_t input.
+ * @base: (nullable): a plan previously created for @face.
+ *
+ * Computes a plan for subsetting the supplied face according
+ * to a provided input, like hb_subset_plan_create_or_fail(), but
+ * reusing the work already done for @base where possible.
+ *
+ * This speeds up planning a series of related requests, for example
+ * several subsets of a common superset: create a plan for the superset
+ * once and pass it as @base when planning each request.
+ *
+ * Layout closure results of @base are reused when @base was created for
+ * @face with the same flags, drop tables, layout features, layout
+ * scripts and axes settings as @input, and its glyph set covers the
+ * glyphs requested by @input.  Otherwise planning proceeds from scratch.
+ * Either way the resulting plan is the same as the one
+ * hb_subset_plan_create_or_fail() returns for @face and @input.
+ *
+ * Return value: (transfer full): New subset plan. Destroy with
+ * hb_subset_plan_destroy(). If there is a failure creating the plan
+ * nullptr will be returned.
+ *
+ * XSince: REPLACEME
+ **/
+hb_subset_plan_t *
+hb_subset_plan_create_from_base_or_fail (hb_face_t               *face,
+					 const hb_subset_input_t *input,
+					 const hb_subset_plan_t  *base)
+{
+  hb_subset_plan_t *plan;
+  if (unlikely (!(plan = hb_object_create<hb_subset_plan_t> (face, input, base))))
+    return nullptr;
+
+  if (unlikely (plan->in_error ()))
+  {
+    hb_subset_plan_destroy (plan);
+    return nullptr;
+  }
+
+  return plan;
+}
+
 /**
  * hb_subset_plan_destroy:
  * @plan: a #hb_subset_plan_t
@@ -906,6 +995,51 @@ hb_subset_plan_unicode_to_old_glyph_mapping (const hb_subset_plan_t *plan)
   return plan->codepoint_to_glyph;
 }
 
+/**
+ * hb_subset_plan_get_peak_memory:
+ * @plan: a subsetting plan.
+ *
+ * Returns the most memory that the last execution of @plan held at
+ * once for serialization buffers and finished tables of the subset
+ * font.  Tables that are kept in the resulting face count until the
+ * end; with hb_subset_plan_execute_to_sink_or_fail() they only count
+ * until the sink returns.  Memory of the plan itself, the source font
+ * and temporary data of individual table subsetters is not included.
+ *
+ * Return value: the peak memory, in bytes.
+ *
+ * XSince: REPLACEME
+ **/
+unsigned int
+hb_subset_plan_get_peak_memory (const hb_subset_plan_t *plan)
+{
+  return plan->peak_memory;
+}
+
+/**
+ * hb_subset_plan_get_instancer_solver_stats:
+ * @plan: a subsetting plan.
+ * @solved: (out) (optional): number of tent rebasings that were solved.
+ * @reused: (out) (optional): number of tent rebasings answered from
+ *   earlier solutions.
+ *
+ * Returns how often partial instancing of @plan had to rebase a
+ * variation region tent onto the new axis limits, split into the
+ * cases that were solved and the ones that reused an identical
+ * earlier solution, across all executions of @plan so far.  Both
+ * are zero when no axis is limited to a range.
+ *
+ * XSince: REPLACEME
+ **/
+void
+hb_subset_plan_get_instancer_solver_stats (const hb_subset_plan_t *plan,
+					   unsigned int          *solved,
+					   unsigned int          *reused)
+{
+  if (solved) *solved = plan->rebase_tent_cache.get_misses ();
+  if (reused) *reused = plan->rebase_tent_cache.get_hits ();
+}
+
 /**
  * hb_subset_plan_reference: (skip)
  * @plan: a #hb_subset_plan_t object.
@@ -128,7 +128,8 @@ namespace OT {
 struct hb_subset_plan_t
 {
   HB_INTERNAL hb_subset_plan_t (hb_face_t *,
-				const hb_subset_input_t *input);
+				const hb_subset_input_t *input,
+				const hb_subset_plan_t *base = nullptr);
 
   HB_INTERNAL ~hb_subset_plan_t();
 
@@ -184,6 +185,40 @@ struct hb_subset_plan_t
   const hb_subset_accelerator_t* accelerator;
   hb_subset_accelerator_t* inprogress_accelerator;
 
+  // Set while hb_subset_plan_execute_parallel_or_fail() runs tables
+  // concurrently; guards dest and sanitized_table_cache.
+  hb_mutex_t *parallel_lock;
+  // Also set while it runs; tables with a lot of independent work can
+  // then split it into tasks of their own (see defer_tasks ()).
+  hb_subset_executor_func_t executor;
+  void *executor_user_data;
+
+  // Work deferred by tables during parallel execution, keyed by table.
+  // Guarded by parallel_lock.
+  struct deferred_t
+  {
+    hb_tag_t tag;
+    void *state;
+    void (*destroy) (void *state);
+    hb_subset_task_func_t task;
+    unsigned count;
+  };
+  hb_vector_t<deferred_t> deferred;
+
+  // rebase_tent () results, shared by all tables when partial instancing.
+  mutable rebase_tent_cache_t rebase_tent_cache;
+
+  // Set while hb_subset_plan_execute_to_sink_or_fail() runs; finished
+  // tables go to it instead of dest.
+  hb_subset_table_sink_func_t sink;
+  void *sink_user_data;
+
+  // Bytes of serialization buffers and finished tables currently held,
+  // and the most held at once during the last execution.  Guarded by
+  // parallel_lock.
+  unsigned memory;
+  unsigned peak_memory;
+
  public:
 
   template<typename T>
@@ -191,7 +226,7 @@ struct hb_subset_plan_t
   {
     hb_blob_ptr_t<T> operator () (hb_subset_plan_t *plan)
     {
-      hb_lock_t lock (plan->accelerator ? &plan->accelerator->sanitized_table_cache_lock : nullptr);
+      hb_lock_t lock (plan->accelerator ? &plan->accelerator->sanitized_table_cache_lock : plan->parallel_lock);
 
       auto *cache = plan->accelerator ? &plan->accelerator->sanitized_table_cache : &plan->sanitized_table_cache;
       if (cache
@@ -294,6 +329,91 @@ struct hb_subset_plan_t
     return true;
   }
 
+  void reset_memory ()
+  {
+    memory = peak_memory = 0;
+  }
+
+  void hold_memory (unsigned size)
+  {
+    hb_lock_t lock (parallel_lock);
+    memory += size;
+    peak_memory = hb_max (peak_memory, memory);
+  }
+
+  void release_memory (unsigned size)
+  {
+    hb_lock_t lock (parallel_lock);
+    memory -= size;
+  }
+
+  /*
+   * Deferred work.  While hb_subset_plan_execute_parallel_or_fail ()
+   * runs, a table with a lot of independent work, say per glyph, does
+   * not wait for it in its own task: it creates its state here, queues
+   * its tasks with defer_tasks () and returns empty.  The executor then
+   * runs the tasks of all such tables together, as top-level tasks, and
+   * the tables are subsetted again; this time get_deferred () returns
+   * the state, with the work done.  That way the executor is never
+   * called from within one of its own tasks.
+   */
+
+  template <typename T>
+  static void _destroy_deferred (void *state)
+  {
+    ((T *) state)->~T ();
+    hb_free (state);
+  }
+
+  template <typename T>
+  T *get_deferred (hb_tag_t tag)
+  {
+    hb_lock_t lock (parallel_lock);
+    for (const deferred_t &d : deferred)
+      if (d.tag == tag)
+	return (T *) d.state;
+    return nullptr;
+  }
+
+  template <typename T, typename ...Ts>
+  T *create_deferred (hb_tag_t tag, Ts&&... ds)
+  {
+    T *state = (T *) hb_calloc (1, sizeof (T));
+    if (unlikely (!state))
+      return nullptr;
+    new (state) T (std::forward<Ts> (ds)...);
+
+    hb_lock_t lock (parallel_lock);
+    deferred.push (deferred_t {tag, state, _destroy_deferred<T>, nullptr, 0});
+    if (unlikely (deferred.in_error ()))
+    {
+      _destroy_deferred<T> (state);
+      return nullptr;
+    }
+    return state;
+  }
+
+  /* Queues @count calls of @task, with the state of @tag as task data. */
+  bool defer_tasks (hb_tag_t tag, hb_subset_task_func_t task, unsigned count)
+  {
+    hb_lock_t lock (parallel_lock);
+    for (deferred_t &d : deferred)
+      if (d.tag == tag)
+      {
+	d.task = task;
+	d.count = count;
+	return true;
+      }
+    return false;
+  }
+
+  void fini_deferred ()
+  {
+    for (const deferred_t &d : deferred)
+      d.destroy (d.state);
+    deferred.fini ();
+  }
+
   inline bool
   add_table (hb_tag_t tag,
 	     hb_blob_t *contents)
@@ -307,6 +427,19 @@ struct hb_subset_plan_t
 		hb_blob_get_length (source_blob));
       hb_blob_destroy (source_blob);
     }
+
+    unsigned length = hb_blob_get_length (contents);
+    hold_memory (length);
+
+    if (sink)
+    {
+      // Streaming: the table is only held while the sink has it.
+      bool ret = sink (tag, contents, sink_user_data);
+      release_memory (length);
+      return ret;
+    }
+
+    hb_lock_t lock (parallel_lock);
     return hb_face_builder_add_table (dest, tag, contents);
   }
 };
@@ -376,7 +509,8 @@ layout_nameid_closure (hb_subset_plan_t* plan,
 
 HB_INTERNAL void
 layout_populate_gids_to_retain (hb_subset_plan_t* plan,
-                                hb_set_t* drop_tables);
+                                hb_set_t* drop_tables,
+                                const hb_subset_plan_t* base = nullptr);
 
 HB_INTERNAL void
 collect_layout_variation_indices (hb_subset_plan_t* plan);
@@ -161,6 +161,12 @@ _hb_subset_table (hb_subset_plan_t *plan, hb_vector_t<char> &buf)
     return false;
   }
 
+  /* The serialization buffer is held until the table is added; when
+   * streaming to a sink, it is freed as soon as the table is copied out. */
+  unsigned buf_held = hb_max (buf.allocated, 0);
+  plan->hold_memory (buf_held);
+  HB_SCOPE_GUARD (plan->release_memory (buf_held));
+
   bool needed = false;
   hb_serialize_context_t serializer (buf.arrayZ, buf.allocated);
   {
@@ -169,6 +175,12 @@ _hb_subset_table (hb_subset_plan_t *plan, hb_vector_t<char> &buf)
   }
   _hb_do_destroy (source_blob, hb_prioritize);
 
+  if ((unsigned) hb_max (buf.allocated, 0) > buf_held)
+  {
+    plan->hold_memory (buf.allocated - buf_held);
+    buf_held = buf.allocated;
+  }
+
   if (serializer.in_error () && !serializer.only_offset_overflow ())
   {
     DEBUG_MSG (SUBSET, nullptr, "OT::%c%c%c%c::subset FAILED!", HB_UNTAG (tag));
@@ -183,6 +195,12 @@ _hb_subset_table (hb_subset_plan_t *plan, hb_vector_t<char> &buf)
 
   bool result = false;
   hb_blob_t *dest_blob = _hb_subset_repack (tag, serializer);
+  if (plan->sink)
+  {
+    buf.fini ();
+    plan->release_memory (buf_held);
+    buf_held = 0;
+  }
   if (dest_blob)
   {
     DEBUG_MSG (SUBSET, nullptr,
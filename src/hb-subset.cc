@@ -311,6 +311,26 @@ _subset_table (hb_subset_plan_t *plan,
   return true;
 }
 
+static void
+_collect_pending_tags (hb_subset_plan_t *plan,
+		       hb_set_t &pending_subset_tags /* OUT */)
+{
+  hb_tag_t table_tags[32];
+  unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
+
+  while (((void) _get_table_tags (plan, offset, &num_tables, table_tags), num_tables))
+  {
+    for (unsigned i = 0; i < num_tables; ++i)
+    {
+      hb_tag_t tag = table_tags[i];
+      if (_should_drop_table (plan, tag)) continue;
+      pending_subset_tags.add (tag);
+    }
+
+    offset += num_tables;
+  }
+}
+
 static void _attach_accelerator_data (hb_subset_plan_t* plan,
                                       hb_face_t* face /* IN/OUT */)
 {
@@ -339,6 +359,53 @@ static void _attach_accelerator_data (hb_subset_plan_t* plan,
     hb_subset_accelerator_t::destroy (accel);
 }
 
+static bool
+_subset_tables (hb_subset_plan_t *plan)
+{
+  hb_set_t subsetted_tags, pending_subset_tags;
+  _collect_pending_tags (plan, pending_subset_tags);
+
+  hb_vector_t<char> buf;
+  buf.alloc (8192 - 16);
+
+  while (!pending_subset_tags.is_empty ())
+  {
+    if (subsetted_tags.in_error ()
+	|| pending_subset_tags.in_error ()) {
+      return false;
+    }
+
+    bool made_changes = false;
+    for (hb_tag_t tag : pending_subset_tags)
+    {
+      if (!_dependencies_satisfied (plan, tag,
+				    subsetted_tags,
+				    pending_subset_tags))
+      {
+	// delayed subsetting for some tables since they might have dependency on other tables
+	// in some cases: e.g: during instantiating glyf tables, hmetrics/vmetrics are updated
+	// and saved in subset plan, hmtx/vmtx subsetting need to use these updated metrics values
+	continue;
+      }
+
+      pending_subset_tags.del (tag);
+      subsetted_tags.add (tag);
+      made_changes = true;
+
+      if (unlikely (!_subset_table (plan, buf, tag)))
+	return false;
+    }
+
+    if (!made_changes)
+    {
+      DEBUG_MSG (SUBSET, nullptr, "Table dependencies unable to be satisfied. Subset failed.");
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  * hb_subset_or_fail:
  * @source: font face data to be subset.
@@ -390,72 +457,282 @@ hb_subset_plan_execute_or_fail (hb_subset_plan_t *plan)
     return nullptr;
   }
 
-  hb_tag_t table_tags[32];
-  unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
+  plan->reset_memory ();
 
-  hb_set_t subsetted_tags, pending_subset_tags;
-  while (((void) _get_table_tags (plan, offset, &num_tables, table_tags), num_tables))
+  bool success = _subset_tables (plan);
+
+  if (success && plan->attach_accelerator_data) {
+    _attach_accelerator_data (plan, plan->dest);
+  }
+
+  return success ? hb_face_reference (plan->dest) : nullptr;
+}
+
+/**
+ * hb_subset_plan_execute_to_sink_or_fail:
+ * @plan: a subsetting plan.
+ * @sink: callback that receives each table of the subset font.
+ * @user_data: data to pass to @sink.
+ *
+ * Executes the provided subsetting @plan like
+ * hb_subset_plan_execute_or_fail(), but instead of assembling the
+ * subset into a face, hands every table to @sink as soon as it has
+ * been serialized (and repacked, if needed) and then releases it.
+ * This bounds the memory used to roughly that of the largest table
+ * rather than the whole subset font; see
+ * hb_subset_plan_get_peak_memory().
+ *
+ * Tables are passed in the order they are subsetted, not in tag
+ * order, and the checksum adjustment of 'head' is left for the
+ * caller to compute.  If the subset operation fails, @sink may
+ * already have received some of the tables.  No accelerator data is
+ * attached, even if requested by the subset input.
+ *
+ * Return value: `true` if all tables were subsetted and accepted by
+ * @sink, `false` otherwise.
+ *
+ * XSince: REPLACEME
+ **/
+hb_bool_t
+hb_subset_plan_execute_to_sink_or_fail (hb_subset_plan_t            *plan,
+					hb_subset_table_sink_func_t  sink,
+					void                        *user_data)
+{
+  if (unlikely (!plan || plan->in_error () || !sink)) {
+    return false;
+  }
+
+  plan->reset_memory ();
+  plan->sink = sink;
+  plan->sink_user_data = user_data;
+
+  bool success = _subset_tables (plan);
+
+  plan->sink = nullptr;
+  plan->sink_user_data = nullptr;
+
+  return success;
+}
+
+
+struct hb_subset_table_task_t
+{
+  hb_tag_t tag;
+  bool success;
+};
+
+struct hb_subset_parallel_data_t
+{
+  hb_subset_plan_t *plan;
+  hb_vector_t<hb_subset_table_task_t> tasks;
+  hb_vector_t<hb_vector_t<char>> bufs;
+};
+
+static void
+_subset_table_task (void *task_data, unsigned index)
+{
+  hb_subset_parallel_data_t *data = (hb_subset_parallel_data_t *) task_data;
+  hb_subset_table_task_t &task = data->tasks.arrayZ[index];
+  task.success = _subset_table (data->plan, data->bufs.arrayZ[index], task.tag);
+}
+
+static bool
+_subset_table_tasks (hb_subset_parallel_data_t &data,
+		     hb_subset_executor_func_t  executor,
+		     void                      *user_data)
+{
+  if (unlikely (data.tasks.in_error () ||
+		!data.bufs.resize (data.tasks.length)))
+    return false;
+
+  if (data.tasks.length == 1)
+    _subset_table_task (&data, 0);
+  else
+    executor (_subset_table_task, &data, data.tasks.length, user_data);
+
+  for (const hb_subset_table_task_t &task : data.tasks)
+    if (!task.success)
+      return false;
+  return true;
+}
+
+/* The tasks deferred by all tables, numbered one after the other. */
+struct hb_subset_deferred_data_t
+{
+  hb_subset_plan_t *plan;
+  hb_vector_t<unsigned> entries; /* Indices into plan->deferred. */
+  hb_vector_t<unsigned> starts; /* Number of the first task of each. */
+};
+
+static void
+_deferred_task (void *task_data, unsigned index)
+{
+  hb_subset_deferred_data_t *data = (hb_subset_deferred_data_t *) task_data;
+  unsigned i = 0;
+  while (i + 1 < data->starts.length && data->starts.arrayZ[i + 1] <= index)
+    i++;
+  const hb_subset_plan_t::deferred_t &d = data->plan->deferred.arrayZ[data->entries.arrayZ[i]];
+  d.task (d.state, index - data->starts.arrayZ[i]);
+}
+
+/* Runs the work tables deferred in one executor call, then subsets
+ * those tables again; repeated until none defers any more. */
+static bool
+_subset_deferred (hb_subset_parallel_data_t &data,
+		  hb_subset_executor_func_t  executor,
+		  void                      *user_data)
+{
+  hb_subset_plan_t *plan = data.plan;
+  hb_subset_deferred_data_t deferred;
+  deferred.plan = plan;
+
+  while (true)
   {
-    for (unsigned i = 0; i < num_tables; ++i)
+    deferred.entries.reset ();
+    deferred.starts.reset ();
+    unsigned count = 0;
+    for (unsigned i = 0; i < plan->deferred.length; i++)
+      if (plan->deferred.arrayZ[i].count)
+      {
+	deferred.entries.push (i);
+	deferred.starts.push (count);
+	count += plan->deferred.arrayZ[i].count;
+      }
+    if (unlikely (plan->deferred.in_error () ||
+		  deferred.entries.in_error () ||
+		  deferred.starts.in_error ()))
+      return false;
+    if (!count)
+      return true;
+
+    executor (_deferred_task, &deferred, count, user_data);
+
+    data.tasks.reset ();
+    for (unsigned i : deferred.entries)
     {
-      hb_tag_t tag = table_tags[i];
-      if (_should_drop_table (plan, tag)) continue;
-      pending_subset_tags.add (tag);
+      hb_subset_plan_t::deferred_t &d = plan->deferred.arrayZ[i];
+      d.count = 0;
+      data.tasks.push (hb_subset_table_task_t {d.tag, false});
     }
+    if (!_subset_table_tasks (data, executor, user_data))
+      return false;
+  }
+}
 
-    offset += num_tables;
+/**
+ * hb_subset_plan_execute_parallel_or_fail:
+ * @plan: a subsetting plan.
+ * @executor: (nullable): callback that runs table subsetting tasks.
+ * @user_data: data to pass to @executor.
+ *
+ * Executes the provided subsetting @plan like
+ * hb_subset_plan_execute_or_fail(), but hands tables that do not
+ * depend on each other to @executor so they can be subsetted
+ * concurrently.  Tables are still processed in dependency order
+ * (for example when instancing, glyf before hmtx), in rounds: each
+ * round runs every table whose dependencies have been subsetted
+ * through one call to @executor.  Tables with a lot of independent
+ * work, such as instancing the glyph variations of gvar, split it
+ * into tasks that are handed to @executor after their round, in one
+ * more call for all such tables together, and then finish.  @executor
+ * is never called from within one of its own tasks.
+ *
+ * Each task serializes into its own buffer, and tables are assembled
+ * into the face in tag order regardless of completion order, so the
+ * result is identical to that of hb_subset_plan_execute_or_fail().
+ *
+ * HarfBuzz does not create threads itself; @executor decides where
+ * tasks run.  If @executor is `NULL`, this is equivalent to
+ * hb_subset_plan_execute_or_fail().
+ *
+ * @plan must not be used from other threads during this call.
+ *
+ * Return value:
+ * on success returns a reference to generated font subset. If the subsetting operation fails
+ * returns nullptr.
+ *
+ * XSince: REPLACEME
+ **/
+hb_face_t *
+hb_subset_plan_execute_parallel_or_fail (hb_subset_plan_t          *plan,
+					 hb_subset_executor_func_t  executor,
+					 void                      *user_data)
+{
+  if (!executor)
+    return hb_subset_plan_execute_or_fail (plan);
+
+  if (unlikely (!plan || plan->in_error ())) {
+    return nullptr;
   }
 
+  hb_set_t subsetted_tags, pending_subset_tags;
+  _collect_pending_tags (plan, pending_subset_tags);
+
   bool success = true;
 
-  {
-    // Grouping to deallocate buf before calling hb_face_reference (plan->dest).
+  plan->reset_memory ();
 
-    hb_vector_t<char> buf;
-    buf.alloc (8192 - 16);
+  hb_mutex_t lock;
+  plan->parallel_lock = &lock;
+  plan->rebase_tent_cache.set_lock (&lock);
+  plan->executor = executor;
+  plan->executor_user_data = user_data;
+
+  {
+    hb_subset_parallel_data_t data;
+    data.plan = plan;
 
-    while (!pending_subset_tags.is_empty ())
+    while (success && !pending_subset_tags.is_empty ())
     {
       if (subsetted_tags.in_error ()
 	  || pending_subset_tags.in_error ()) {
 	success = false;
-	goto end;
+	break;
       }
 
-      bool made_changes = false;
+      /* Tables ready in this round are judged against the pending set
+       * as it was at the start of the round, so nothing runs alongside
+       * a table it depends on. */
+      data.tasks.reset ();
       for (hb_tag_t tag : pending_subset_tags)
+	if (_dependencies_satisfied (plan, tag,
+				     subsetted_tags,
+				     pending_subset_tags))
+	  data.tasks.push (hb_subset_table_task_t {tag, false});
+
+      if (unlikely (data.tasks.in_error ()))
       {
-	if (!_dependencies_satisfied (plan, tag,
-				      subsetted_tags,
-				      pending_subset_tags))
-	{
-	  // delayed subsetting for some tables since they might have dependency on other tables
-	  // in some cases: e.g: during instantiating glyf tables, hmetrics/vmetrics are updated
-	  // and saved in subset plan, hmtx/vmtx subsetting need to use these updated metrics values
-	  continue;
-	}
-
-	pending_subset_tags.del (tag);
-	subsetted_tags.add (tag);
-	made_changes = true;
-
-	success = _subset_table (plan, buf, tag);
-	if (unlikely (!success)) goto end;
+	success = false;
+	break;
       }
 
-      if (!made_changes)
+      if (!data.tasks.length)
       {
 	DEBUG_MSG (SUBSET, nullptr, "Table dependencies unable to be satisfied. Subset failed.");
 	success = false;
-	goto end;
+	break;
+      }
+
+      for (const hb_subset_table_task_t &task : data.tasks)
+      {
+	pending_subset_tags.del (task.tag);
+	subsetted_tags.add (task.tag);
       }
+
+      success = _subset_table_tasks (data, executor, user_data) &&
+		_subset_deferred (data, executor, user_data);
     }
   }
 
+  plan->fini_deferred ();
+  plan->parallel_lock = nullptr;
+  plan->rebase_tent_cache.set_lock (nullptr);
+  plan->executor = nullptr;
+  plan->executor_user_data = nullptr;
+
   if (success && plan->attach_accelerator_data) {
     _attach_accelerator_data (plan, plan->dest);
   }
 
-end:
   return success ? hb_face_reference (plan->dest) : nullptr;
-}
\ No newline at end of file
+}
@@ -31,6 +31,7 @@
 #include "hb.h"
 #include "hb-ot.h"
 #include "hb-subset-serialize.h"
+#include "hb-subset-executor.h"
 #include "hb-subset-depend.h"
 #include "hb-subset-serialize.h"
 
@@ -277,10 +278,51 @@ hb_subset_or_fail (hb_face_t *source, const hb_subset_input_t *input);
 HB_EXTERN hb_face_t *
 hb_subset_plan_execute_or_fail (hb_subset_plan_t *plan);
 
+HB_EXTERN hb_face_t *
+hb_subset_plan_execute_parallel_or_fail (hb_subset_plan_t          *plan,
+					 hb_subset_executor_func_t  executor,
+					 void                      *user_data);
+
+/**
+ * hb_subset_table_sink_func_t:
+ * @tag: tag of the table
+ * @blob: data of the table
+ * @user_data: the user data passed to
+ *   hb_subset_plan_execute_to_sink_or_fail()
+ *
+ * A callback that receives a finished table of the subset font.
+ * @blob is released once this returns; reference it to keep it.
+ *
+ * Return value: `true` to continue subsetting, `false` to fail.
+ *
+ * XSince: REPLACEME
+ **/
+typedef hb_bool_t (*hb_subset_table_sink_func_t) (hb_tag_t    tag,
+						  hb_blob_t  *blob,
+						  void       *user_data);
+
+HB_EXTERN hb_bool_t
+hb_subset_plan_execute_to_sink_or_fail (hb_subset_plan_t            *plan,
+					hb_subset_table_sink_func_t  sink,
+					void                        *user_data);
+
+HB_EXTERN unsigned int
+hb_subset_plan_get_peak_memory (const hb_subset_plan_t *plan);
+
+HB_EXTERN void
+hb_subset_plan_get_instancer_solver_stats (const hb_subset_plan_t *plan,
+					   unsigned int          *solved,
+					   unsigned int          *reused);
+
 HB_EXTERN hb_subset_plan_t *
 hb_subset_plan_create_or_fail (hb_face_t                 *face,
                                const hb_subset_input_t   *input);
 
+HB_EXTERN hb_subset_plan_t *
+hb_subset_plan_create_from_base_or_fail (hb_face_t               *face,
+					 const hb_subset_input_t *input,
+					 const hb_subset_plan_t  *base);
+
 HB_EXTERN void
 hb_subset_plan_destroy (hb_subset_plan_t *plan);
 
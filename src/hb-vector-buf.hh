@@ -29,16 +29,9 @@
 
 #include "hb.hh"
 #include "hb-vector.hh"
-#include <math.h>
-#include <stdio.h>
+#include "hb-vector-num.hh"
 #include <string.h>
 
-HB_INTERNAL const char *
-hb_vector_decimal_point_get (void);
-
-static const double _hb_vector_buf_pow10[13] = {1., 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
-						1e7, 1e8, 1e9, 1e10, 1e11, 1e12};
-
 struct hb_vector_buf_t : hb_vector_t<char>
 {
   unsigned precision = 2;
@@ -65,9 +58,10 @@ struct hb_vector_buf_t : hb_vector_t<char>
 
   bool append_unsigned (unsigned v)
   {
-    char tmp[16];
-    snprintf (tmp, sizeof (tmp), "%u", v);
-    return append_len (tmp, (unsigned) strlen (tmp));
+    char tmp[10];
+    char *end = tmp + sizeof (tmp);
+    char *p = _hb_vector_num_write_digits (v, end);
+    return append_len (p, (unsigned) (end - p));
   }
 
   bool append_hex_byte (unsigned v)
@@ -82,92 +76,9 @@ struct hb_vector_buf_t : hb_vector_t<char>
 
   void append_num (float v, unsigned p)
   {
-    if (p > 12) p = 12;
-
-    float rounded_zero_threshold = 0.5f;
-    for (unsigned i = 0; i < p; i++)
-      rounded_zero_threshold *= 0.1f;
-    if (fabsf (v) < rounded_zero_threshold)
-      v = 0.f;
-
-    if (!(v == v) || !std::isfinite (v))
-    {
-      append_c ('0');
+    if (unlikely (!alloc (length + HB_VECTOR_NUM_MAX_LENGTH)))
       return;
-    }
-
-    /* Fast path: fixed-point decimal via integer math.  @v has a
-     * 24-bit significand and 5^12 has 28 bits, so v*10^p is exact in
-     * a double for p <= 12; rounding it half-to-even therefore
-     * matches snprintf "%.pf" output digit-for-digit, while skipping
-     * the (much slower) printf floating-point formatting and any
-     * locale decimal-point fix-up. */
-    double scaled = (double) v * _hb_vector_buf_pow10[p];
-    if (likely (fabs (scaled) < 9.0e18))
-    {
-      double fl = floor (scaled);
-      double diff = scaled - fl;
-      int64_t n = (int64_t) fl;
-      if (diff > 0.5 || (diff == 0.5 && (n & 1)))
-	n++;
-
-      uint64_t u = (uint64_t) (n < 0 ? -n : n);
-      unsigned frac = p;
-      while (frac && !(u % 10))
-      {
-	u /= 10;
-	frac--;
-      }
-
-      char tmp[24];
-      char *end = tmp + sizeof (tmp);
-      char *s = end;
-      unsigned d = 0;
-      do
-      {
-	*--s = (char) ('0' + (char) (u % 10));
-	u /= 10;
-	if (++d == frac)
-	  *--s = '.';
-      }
-      while (u || d < frac + 1);
-      if (v < 0.f)
-	*--s = '-';
-
-      append_len (s, (unsigned) (end - s));
-      return;
-    }
-
-    char fmt[6];
-    snprintf (fmt, sizeof (fmt), "%%.%uf", p);
-    char out[128];
-    snprintf (out, sizeof (out), fmt, (double) v);
-
-    const char *decimal_point = hb_vector_decimal_point_get ();
-
-    if (decimal_point[0] != '.' || decimal_point[1] != '\0')
-    {
-      char *dp = strstr (out, decimal_point);
-      if (dp)
-      {
-	unsigned dp_len = (unsigned) strlen (decimal_point);
-	unsigned tail_len = (unsigned) strlen (dp + dp_len);
-	memmove (dp + 1, dp + dp_len, tail_len + 1);
-	*dp = '.';
-      }
-    }
-
-    char *dot = strchr (out, '.');
-    if (dot)
-    {
-      char *end = out + strlen (out) - 1;
-      while (end > dot && *end == '0')
-	*end-- = '\0';
-      if (end == dot)
-	*end = '\0';
-    }
-
-    append_len (out, (unsigned) strlen (out));
+    length += hb_vector_num_fixed (v, p, arrayZ + length);
   }
 
   void append_svg_color (hb_color_t color, bool with_alpha)
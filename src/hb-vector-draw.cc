@@ -28,6 +28,7 @@
 
 #include "hb-vector-draw.hh"
 #include "hb-vector-path.hh"
+#include "hb-vector-pdf.hh"
 
 #include <math.h>
 #include <string.h>
@@ -354,6 +355,7 @@ hb_vector_draw_set_scale_factor (hb_vector_draw_t *draw,
 {
   draw->x_scale_factor = x_scale_factor > 0.f ? x_scale_factor : 1.f;
   draw->y_scale_factor = y_scale_factor > 0.f ? y_scale_factor : 1.f;
+  draw->svg_reuse.reset_glyphs ();
 }
 
 /**
@@ -534,6 +536,82 @@ hb_vector_draw_new_path (hb_vector_draw_t *draw)
   draw->new_path ();
 }
 
+/* Glyph def values recorded in svg_reuse: the def id plus two, or
+ * one of these. */
+enum {
+  HB_VECTOR_DRAW_GLYPH_FAILED = 0,
+  HB_VECTOR_DRAW_GLYPH_EMPTY  = 1,
+};
+
+/* Emits @glyph's outline into the defs once per document, untransformed,
+ * and references it from the body with a <use> carrying the transform. */
+static hb_bool_t
+hb_vector_draw_glyph_svg_reuse (hb_vector_draw_t *draw,
+				hb_font_t *font,
+				hb_codepoint_t glyph)
+{
+  auto key = draw->svg_reuse.glyph_key (font, glyph);
+  unsigned value;
+  if (!draw->svg_reuse.get_glyph (key, &value))
+  {
+    /* Scale factors stay applied, so the def is in output units like
+     * inline paths; only the transform moves to the <use>. */
+    hb_transform_t<> transform = draw->transform;
+    draw->transform = {1, 0, 0, 1, 0, 0};
+    hb_bool_t ret = hb_font_draw_glyph_or_fail (font, glyph, hb_vector_draw_get_funcs (draw), draw);
+    draw->transform = transform;
+
+    if (!ret)
+      value = HB_VECTOR_DRAW_GLYPH_FAILED;
+    else if (!draw->path.length)
+      value = HB_VECTOR_DRAW_GLYPH_EMPTY;
+    else
+    {
+      unsigned def_id = draw->path_def_count++;
+      draw->defs.append_str ("<path id=\"p");
+      draw->defs.append_unsigned (def_id);
+      draw->defs.append_str ("\" d=\"");
+      draw->defs.append_len (draw->path.arrayZ, draw->path.length);
+      draw->defs.append_str ("\"/>\n");
+      value = def_id + 2;
+    }
+    draw->path.shrink (0);
+    draw->svg_reuse.set_glyph (key, value);
+  }
+
+  if (value < 2)
+    return value != HB_VECTOR_DRAW_GLYPH_FAILED;
+
+  /* Conjugate the transform by the scale factors the def is already
+   * divided by. */
+  const hb_transform_t<> &t = draw->transform;
+  float sx = draw->x_scale_factor, sy = draw->y_scale_factor;
+  unsigned sprec = draw->body.scale_precision ();
+  draw->body.append_str ("<use href=\"#p");
+  draw->body.append_unsigned (value - 2);
+  if (t.xx == 1.f && t.yx == 0.f && t.xy == 0.f && t.yy == 1.f)
+    draw->body.append_str ("\" transform=\"translate(");
+  else
+  {
+    draw->body.append_str ("\" transform=\"matrix(");
+    draw->body.append_num (t.xx, sprec);
+    draw->body.append_c (',');
+    draw->body.append_num (t.yx * sx / sy, sprec);
+    draw->body.append_c (',');
+    draw->body.append_num (t.xy * sy / sx, sprec);
+    draw->body.append_c (',');
+    draw->body.append_num (t.yy, sprec);
+    draw->body.append_c (',');
+  }
+  draw->body.append_num (t.x0 / sx);
+  draw->body.append_c (',');
+  draw->body.append_num (t.y0 / sy);
+  draw->body.append_str (")\" fill=\"");
+  draw->body.append_svg_color (draw->foreground, true);
+  draw->body.append_str ("\"/>\n");
+  return true;
+}
+
 /**
  * hb_vector_draw_glyph_or_fail:
  * @draw: a draw context.
@@ -578,6 +656,8 @@ hb_vector_draw_glyph_or_fail (hb_vector_draw_t *draw,
   }
 
   draw->new_path ();
+  if (draw->format == HB_VECTOR_FORMAT_SVG && draw->svg_reuse.enabled)
+    return hb_vector_draw_glyph_svg_reuse (draw, font, glyph);
   return hb_font_draw_glyph_or_fail (font, glyph, hb_vector_draw_get_funcs (draw), draw);
 }
 
@@ -602,6 +682,57 @@ hb_vector_draw_glyph (hb_vector_draw_t *draw,
   hb_vector_draw_glyph_or_fail (draw, font, glyph, extents_mode);
 }
 
+/**
+ * hb_vector_draw_buffer:
+ * @draw: a draw context.
+ * @font: font object.
+ * @buffer: a buffer holding shaped glyphs.
+ * @extents_mode: extents update mode.
+ *
+ * Draws all glyphs of @buffer into @draw as one run of text.  The
+ * pen starts at the origin of the current transform and moves by
+ * the glyph advances; glyph offsets are applied on top.  The
+ * transform is left as it was.
+ *
+ * For SVG output, glyph outlines are shared across the run as with
+ * hb_vector_draw_set_svg_reuse(), whether or not that is set, so
+ * repeated glyphs cost one `<use>` element each.
+ *
+ * Buffers not holding glyphs (i.e. not shaped) are ignored.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_draw_buffer (hb_vector_draw_t *draw,
+		       hb_font_t *font,
+		       hb_buffer_t *buffer,
+		       hb_vector_extents_mode_t extents_mode)
+{
+  if (hb_buffer_get_content_type (buffer) != HB_BUFFER_CONTENT_TYPE_GLYPHS)
+    return;
+
+  unsigned count;
+  const hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  const hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  hb_transform_t<> base = draw->transform;
+  bool reuse = draw->svg_reuse.enabled;
+  draw->svg_reuse.enabled = true;
+
+  hb_position_t x = 0, y = 0;
+  for (unsigned i = 0; i < count; i++)
+  {
+    draw->transform = base;
+    draw->transform.translate (x + pos[i].x_offset, y + pos[i].y_offset);
+    hb_vector_draw_glyph_or_fail (draw, font, info[i].codepoint, extents_mode);
+    x += pos[i].x_advance;
+    y += pos[i].y_advance;
+  }
+
+  draw->transform = base;
+  draw->svg_reuse.enabled = reuse;
+}
+
 
 /**
  * hb_vector_draw_set_precision:
@@ -610,6 +741,10 @@ hb_vector_draw_glyph (hb_vector_draw_t *draw,
  *
  * Sets numeric output precision for draw output.
  *
+ * Numbers are written with at most @precision fractional digits
+ * (up to 12), but never with more digits than it takes to read back
+ * the same single-precision value.
+ *
  * Since: 14.2.0
  */
 void
@@ -636,6 +771,88 @@ hb_vector_draw_get_precision (const hb_vector_draw_t *draw)
   return draw->get_precision ();
 }
 
+/**
+ * hb_vector_draw_set_svg_reuse:
+ * @draw: a draw context.
+ * @reuse: whether to share glyph outlines within a document.
+ *
+ * Enables document-level sharing of glyph outlines in SVG output.
+ * When enabled, hb_vector_draw_glyph() and
+ * hb_vector_draw_glyph_or_fail() emit each distinct glyph outline
+ * once into `<defs>` and reference it with a transformed `<use>`,
+ * which shrinks text-heavy documents considerably.  Glyphs are
+ * told apart by font, font serial (see hb_font_get_serial()) and
+ * glyph ID, so a font changed mid-document, e.g. to new variation
+ * coordinates, gets fresh definitions.
+ *
+ * Outlines fed through hb_vector_draw_get_funcs() directly are
+ * always emitted inline.  No effect on PDF output.  Default is
+ * disabled.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_draw_set_svg_reuse (hb_vector_draw_t *draw,
+                              hb_bool_t reuse)
+{
+  draw->svg_reuse.enabled = reuse;
+}
+
+/**
+ * hb_vector_draw_get_svg_reuse:
+ * @draw: a draw context.
+ *
+ * Returns whether glyph outlines are shared within SVG documents.
+ * See hb_vector_draw_set_svg_reuse().
+ *
+ * Return value: `true` if SVG reuse is enabled.
+ *
+ * XSince: REPLACEME
+ */
+hb_bool_t
+hb_vector_draw_get_svg_reuse (const hb_vector_draw_t *draw)
+{
+  return draw->svg_reuse.enabled;
+}
+
+/**
+ * hb_vector_draw_set_pdf_compression_level:
+ * @draw: a draw context.
+ * @level: compression level, 0 to 9.
+ *
+ * Sets how PDF output is compressed.  At level 0, the default, the
+ * file is plain PDF 1.4 text.  Levels 1 to 9 Flate-encode the content
+ * stream at that zlib compression level and pack the remaining
+ * objects and the cross-reference table into compressed streams,
+ * which needs PDF 1.5.  Without zlib support, output is always
+ * uncompressed.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_draw_set_pdf_compression_level (hb_vector_draw_t *draw,
+                                          unsigned level)
+{
+  draw->pdf_compression_level = hb_min (level, 9u);
+}
+
+/**
+ * hb_vector_draw_get_pdf_compression_level:
+ * @draw: a draw context.
+ *
+ * Returns the PDF compression level set on @draw.
+ * See hb_vector_draw_set_pdf_compression_level().
+ *
+ * Return value: the compression level.
+ *
+ * XSince: REPLACEME
+ */
+unsigned
+hb_vector_draw_get_pdf_compression_level (const hb_vector_draw_t *draw)
+{
+  return draw->pdf_compression_level;
+}
+
 /**
  * hb_vector_draw_set_foreground:
  * @draw: a draw context.
@@ -751,66 +968,44 @@ hb_vector_draw_render_pdf (hb_vector_draw_t *draw)
   if (draw->body.length)
     stream.append_len (draw->body.arrayZ, draw->body.length);
 
-  /* Build PDF objects, tracking byte offsets for xref. */
+  /* Build PDF objects. */
   hb_vector_buf_t out;
   hb_buf_recover_recycled (draw->recycled_blob, &out);
   out.alloc (stream.length + 512);
 
-  unsigned offsets[5]; /* objects 1-4, plus end */
-
-  out.append_str ("%PDF-1.4\n%\xC0\xC1\xC2\xC3\n");
-
-  /* Object 1: Catalog */
-  offsets[0] = out.length;
-  out.append_str ("1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+  hb_vector_pdf_writer_t pdf (&out, 4, draw->pdf_compression_level);
 
-  /* Object 2: Pages */
-  offsets[1] = out.length;
-  out.append_str ("2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+  static const char catalog[] = "<< /Type /Catalog /Pages 2 0 R >>";
+  static const char pages[] = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
+  pdf.add_object (1, catalog, sizeof (catalog) - 1);
+  pdf.add_object (2, pages, sizeof (pages) - 1);
 
   /* Object 3: Page.  Extents are in SVG space (y = -font_y).
    * Convert back: font Y range = [-(ey+eh) .. -ey]. */
-  offsets[2] = out.length;
-  out.append_str ("3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [");
-  out.append_num (ex);
-  out.append_c (' ');
-  out.append_num (-(ey + eh));
-  out.append_c (' ');
-  out.append_num (ex + ew);
-  out.append_c (' ');
-  out.append_num (-ey);
-  out.append_str ("] /Contents 4 0 R");
+  hb_vector_buf_t page;
+  page.append_str ("<< /Type /Page /Parent 2 0 R /MediaBox [");
+  page.append_num (ex);
+  page.append_c (' ');
+  page.append_num (-(ey + eh));
+  page.append_c (' ');
+  page.append_num (ex + ew);
+  page.append_c (' ');
+  page.append_num (-ey);
+  page.append_str ("] /Contents 4 0 R");
   if (draw->pdf_extgstate_dict.length)
   {
-    out.append_str (" /Resources << /ExtGState << ");
-    out.append_len (draw->pdf_extgstate_dict.arrayZ, draw->pdf_extgstate_dict.length);
-    out.append_str (">> >>");
+    page.append_str (" /Resources << /ExtGState << ");
+    page.append_len (draw->pdf_extgstate_dict.arrayZ, draw->pdf_extgstate_dict.length);
+    page.append_str (">> >>");
   }
-  out.append_str (" >>\nendobj\n");
+  page.append_str (" >>");
+  pdf.add_object (3, page.arrayZ, page.length);
 
   /* Object 4: Content stream */
-  offsets[3] = out.length;
-  out.append_str ("4 0 obj\n<< /Length ");
-  out.append_unsigned (stream.length);
-  out.append_str (" >>\nstream\n");
-  out.append_len (stream.arrayZ, stream.length);
-  out.append_str ("endstream\nendobj\n");
-
-  /* Cross-reference table */
-  unsigned xref_offset = out.length;
-  out.append_str ("xref\n0 5\n");
-  out.append_str ("0000000000 65535 f \n");
-  for (unsigned i = 0; i < 4; i++)
-  {
-    char tmp[21];
-    snprintf (tmp, sizeof (tmp), "%010u 00000 n \n", offsets[i]);
-    out.append_len (tmp, 20);
-  }
+  pdf.add_stream (4, "<< ", 3, stream.arrayZ, stream.length);
 
-  /* Trailer */
-  out.append_str ("trailer\n<< /Size 5 /Root 1 0 R >>\nstartxref\n");
-  out.append_unsigned (xref_offset);
-  out.append_str ("\n%%EOF\n");
+  if (unlikely (!pdf.finish () || page.in_error ()))
+    return nullptr;
 
   hb_blob_t *blob = hb_buf_blob_from (&draw->recycled_blob, &out);
 
@@ -950,6 +1145,8 @@ hb_vector_draw_clear (hb_vector_draw_t *draw)
   draw->body.clear ();
   draw->path.clear ();
   draw->work_left = HB_VECTOR_MAX_DRAW_WORK;
+  draw->svg_reuse.clear ();
+  draw->path_def_count = 0;
 }
 
 /**
@@ -967,6 +1164,8 @@ hb_vector_draw_reset (hb_vector_draw_t *draw)
   draw->x_scale_factor = 1.f;
   draw->y_scale_factor = 1.f;
   draw->set_precision (2);
+  draw->svg_reuse.enabled = false;
+  draw->pdf_compression_level = 0;
   hb_vector_draw_clear (draw);
 }
 
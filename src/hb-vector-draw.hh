@@ -34,6 +34,7 @@
 #include "hb-machinery.hh"
 #include "hb-vector-buf.hh"
 #include "hb-vector-internal.hh"
+#include "hb-vector-svg-reuse.hh"
 
 struct hb_vector_draw_t
 {
@@ -53,6 +54,9 @@ struct hb_vector_draw_t
   hb_vector_buf_t path;
   hb_vector_buf_t pdf_extgstate_dict;
   unsigned pdf_extgstate_count = 0;
+  hb_vector_svg_reuse_t svg_reuse;
+  unsigned path_def_count = 0;
+  unsigned pdf_compression_level = 0;
 
   /* Cumulative output budget for the current draw session; reset by
    * hb_vector_draw_clear().  Charge complete path commands so budget
@@ -81,6 +85,7 @@ struct hb_vector_draw_t
     defs.precision = p;
     body.precision = p;
     path.precision = p;
+    svg_reuse.reset_glyphs ();
   }
 
   unsigned get_precision () const { return path.precision; }
@@ -0,0 +1,263 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb.hh"
+
+#include "hb-vector-num.hh"
+
+
+/* Shortest round-trip float to decimal, after Ulf Adams' Ryu
+ * (https://github.com/ulfjack/ryu, f2s.c; Apache-2.0 / Boost).
+ *
+ * The float and the two midpoints to its neighbors are scaled by a
+ * power of ten, using 64-bit approximations of 5^q and 5^-q that are
+ * exact enough for all 24-bit significands; digits are then removed
+ * for as long as the interval between the midpoints still contains the
+ * shortened value. */
+
+#define HB_VECTOR_NUM_POW5_INV_BITCOUNT 59
+#define HB_VECTOR_NUM_POW5_BITCOUNT 61
+
+/* floor(2^(pow5bits(q)-1+59) / 5^q) + 1 */
+static const uint64_t _hb_vector_num_pow5_inv[31] =
+{
+  0x0800000000000001u, 0x0666666666666667u, 0x051EB851EB851EB9u,
+  0x04189374BC6A7EFAu, 0x068DB8BAC710CB2Au, 0x053E2D6238DA3C22u,
+  0x0431BDE82D7B634Eu, 0x06B5FCA6AF2BD216u, 0x055E63B88C230E78u,
+  0x044B82FA09B5A52Du, 0x06DF37F675EF6EAEu, 0x057F5FF85E592558u,
+  0x0465E6604B7A8447u, 0x0709709A125DA071u, 0x05A126E1A84AE6C1u,
+  0x0480EBE7B9D58567u, 0x0734ACA5F6226F0Bu, 0x05C3BD5191B525A3u,
+  0x049C97747490EAE9u, 0x0760F253EDB4AB0Eu, 0x05E72843249088D8u,
+  0x04B8ED0283A6D3E0u, 0x078E480405D7B966u, 0x060B6CD004AC9452u,
+  0x04D5F0A66A23A9DBu, 0x07BCB43D769F762Bu, 0x063090312BB2C4EFu,
+  0x04F3A68DBC8F03F3u, 0x07EC3DAF94180651u, 0x065697BFA9ACD1DAu,
+  0x051212FFBAF0A7E2u
+};
+
+/* 5^i, normalized to 61 bits. */
+static const uint64_t _hb_vector_num_pow5[48] =
+{
+  0x1000000000000000u, 0x1400000000000000u, 0x1900000000000000u,
+  0x1F40000000000000u, 0x1388000000000000u, 0x186A000000000000u,
+  0x1E84800000000000u, 0x1312D00000000000u, 0x17D7840000000000u,
+  0x1DCD650000000000u, 0x12A05F2000000000u, 0x174876E800000000u,
+  0x1D1A94A200000000u, 0x12309CE540000000u, 0x16BCC41E90000000u,
+  0x1C6BF52634000000u, 0x11C37937E0800000u, 0x16345785D8A00000u,
+  0x1BC16D674EC80000u, 0x1158E460913D0000u, 0x15AF1D78B58C4000u,
+  0x1B1AE4D6E2EF5000u, 0x10F0CF064DD59200u, 0x152D02C7E14AF680u,
+  0x1A784379D99DB420u, 0x108B2A2C28029094u, 0x14ADF4B7320334B9u,
+  0x19D971E4FE8401E7u, 0x1027E72F1F128130u, 0x1431E0FAE6D7217Cu,
+  0x193E5939A08CE9DBu, 0x1F8DEF8808B02452u, 0x13B8B5B5056E16B3u,
+  0x18A6E32246C99C60u, 0x1ED09BEAD87C0378u, 0x13426172C74D822Bu,
+  0x1812F9CF7920E2B6u, 0x1E17B84357691B64u, 0x12CED32A16A1B11Eu,
+  0x178287F49C4A1D66u, 0x1D6329F1C35CA4BFu, 0x125DFA371A19E6F7u,
+  0x16F578C4E0A060B5u, 0x1CB2D6F618C878E3u, 0x11EFC659CF7D4B8Du,
+  0x166BB7F0435C9E71u, 0x1C06A5EC5433C60Du, 0x118427B3B4A05BC8u
+};
+
+/* ceil(log2(5^e)), or 1 for e == 0; for 0 <= e <= 3528. */
+static inline int
+_pow5bits (int e)
+{ return (int) (((uint32_t) e * 1217359) >> 19) + 1; }
+
+/* floor(log10(2^e)); for 0 <= e <= 1650. */
+static inline int
+_log10_pow2 (int e)
+{ return (int) (((uint32_t) e * 78913) >> 18); }
+
+/* floor(log10(5^e)); for 0 <= e <= 2620. */
+static inline int
+_log10_pow5 (int e)
+{ return (int) (((uint32_t) e * 732923) >> 20); }
+
+static inline bool
+_multiple_of_pow5 (uint32_t v, int p)
+{
+  unsigned count = 0;
+  while (v && !(v % 5))
+  {
+    v /= 5;
+    count++;
+  }
+  return (int) count >= p;
+}
+
+static inline bool
+_multiple_of_pow2 (uint32_t v, int p)
+{ return !(v & ((1u << p) - 1)); }
+
+/* (m * factor) >> shift, for shift > 32. */
+static inline uint32_t
+_mul_shift (uint32_t m, uint64_t factor, int shift)
+{
+  uint64_t lo = (uint64_t) m * (uint32_t) factor;
+  uint64_t hi = (uint64_t) m * (uint32_t) (factor >> 32);
+  uint64_t sum = (lo >> 32) + hi;
+  return (uint32_t) (sum >> (shift - 32));
+}
+
+static inline uint32_t
+_mul_pow5_inv_div_pow2 (uint32_t m, int q, int j)
+{ return _mul_shift (m, _hb_vector_num_pow5_inv[q], j); }
+
+static inline uint32_t
+_mul_pow5_div_pow2 (uint32_t m, int i, int j)
+{ return _mul_shift (m, _hb_vector_num_pow5[i], j); }
+
+uint32_t
+hb_vector_num_shortest_decimal (float v, int *exponent)
+{
+  uint32_t bits;
+  hb_memcpy (&bits, &v, sizeof (bits));
+  uint32_t ieee_mantissa = bits & ((1u << 23) - 1);
+  int ieee_exponent = (int) ((bits >> 23) & 0xFF);
+
+  int e2;
+  uint32_t m2;
+  if (!ieee_exponent)
+  {
+    e2 = 1 - 127 - 23 - 2;
+    m2 = ieee_mantissa;
+  }
+  else
+  {
+    e2 = ieee_exponent - 127 - 23 - 2;
+    m2 = (1u << 23) | ieee_mantissa;
+  }
+  bool accept_bounds = !(m2 & 1);
+
+  /* The float and the midpoints to its neighbors, times 4. */
+  uint32_t mv = 4 * m2;
+  uint32_t mp = 4 * m2 + 2;
+  uint32_t mm_shift = ieee_mantissa || ieee_exponent <= 1;
+  uint32_t mm = 4 * m2 - 1 - mm_shift;
+
+  uint32_t vr, vp, vm;
+  int e10;
+  bool vm_trailing_zeros = false;
+  bool vr_trailing_zeros = false;
+  unsigned last_removed_digit = 0;
+  if (e2 >= 0)
+  {
+    int q = _log10_pow2 (e2);
+    e10 = q;
+    int k = HB_VECTOR_NUM_POW5_INV_BITCOUNT + _pow5bits (q) - 1;
+    int i = -e2 + q + k;
+    vr = _mul_pow5_inv_div_pow2 (mv, q, i);
+    vp = _mul_pow5_inv_div_pow2 (mp, q, i);
+    vm = _mul_pow5_inv_div_pow2 (mm, q, i);
+    if (q && (vp - 1) / 10 <= vm / 10)
+    {
+      int l = HB_VECTOR_NUM_POW5_INV_BITCOUNT + _pow5bits (q - 1) - 1;
+      last_removed_digit = _mul_pow5_inv_div_pow2 (mv, q - 1, -e2 + q - 1 + l) % 10;
+    }
+    if (q <= 9)
+    {
+      /* Only one of mp, mv and mm can be a multiple of 5, if any. */
+      if (!(mv % 5))
+	vr_trailing_zeros = _multiple_of_pow5 (mv, q);
+      else if (accept_bounds)
+	vm_trailing_zeros = _multiple_of_pow5 (mm, q);
+      else
+	vp -= _multiple_of_pow5 (mp, q);
+    }
+  }
+  else
+  {
+    int q = _log10_pow5 (-e2);
+    e10 = q + e2;
+    int i = -e2 - q;
+    int k = _pow5bits (i) - HB_VECTOR_NUM_POW5_BITCOUNT;
+    int j = q - k;
+    vr = _mul_pow5_div_pow2 (mv, i, j);
+    vp = _mul_pow5_div_pow2 (mp, i, j);
+    vm = _mul_pow5_div_pow2 (mm, i, j);
+    if (q && (vp - 1) / 10 <= vm / 10)
+    {
+      j = q - 1 - (_pow5bits (i + 1) - HB_VECTOR_NUM_POW5_BITCOUNT);
+      last_removed_digit = _mul_pow5_div_pow2 (mv, i + 1, j) % 10;
+    }
+    if (q <= 1)
+    {
+      /* mv = 4 * m2 has at least two trailing zero bits. */
+      vr_trailing_zeros = true;
+      if (accept_bounds)
+	vm_trailing_zeros = mm_shift == 1;
+      else
+	vp--;
+    }
+    else if (q < 31)
+      vr_trailing_zeros = _multiple_of_pow2 (mv, q - 1);
+  }
+
+  /* Remove digits while the interval still allows it. */
+  int removed = 0;
+  uint32_t output;
+  if (vm_trailing_zeros || vr_trailing_zeros)
+  {
+    /* Rare: the bounds or the value itself end in zeros. */
+    while (vp / 10 > vm / 10)
+    {
+      vm_trailing_zeros &= !(vm % 10);
+      vr_trailing_zeros &= !last_removed_digit;
+      last_removed_digit = vr % 10;
+      vr /= 10; vp /= 10; vm /= 10;
+      removed++;
+    }
+    if (vm_trailing_zeros)
+      while (!(vm % 10))
+      {
+	vr_trailing_zeros &= !last_removed_digit;
+	last_removed_digit = vr % 10;
+	vr /= 10; vp /= 10; vm /= 10;
+	removed++;
+      }
+    /* Round half to even on an exact tie. */
+    if (vr_trailing_zeros && last_removed_digit == 5 && !(vr % 2))
+      last_removed_digit = 4;
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+		   last_removed_digit >= 5);
+  }
+  else
+  {
+    while (vp / 10 > vm / 10)
+    {
+      last_removed_digit = vr % 10;
+      vr /= 10; vp /= 10; vm /= 10;
+      removed++;
+    }
+    output = vr + (vr == vm || last_removed_digit >= 5);
+  }
+
+  int exp = e10 + removed;
+  while (output && !(output % 10))
+  {
+    output /= 10;
+    exp++;
+  }
+  *exponent = exp;
+  return output;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_VECTOR_NUM_HH
+#define HB_VECTOR_NUM_HH
+
+#include "hb.hh"
+
+#include <math.h>
+
+
+/* Float to decimal conversion for the SVG and PDF writers.
+ *
+ * Output is always plain notation (PDF has no exponent syntax), uses
+ * '.' whatever the locale, and is written to a caller-provided buffer
+ * of at least HB_VECTOR_NUM_MAX_LENGTH bytes; nothing allocates.
+ *
+ * hb_vector_num_fixed() matches snprintf "%.pf" with trailing zeros
+ * removed, except where the float cannot carry that many digits: there
+ * it writes the shortest decimal that reads back as the same float
+ * whenever that is no longer.  hb_vector_num_shortest() always writes
+ * the latter. */
+
+#define HB_VECTOR_NUM_MAX_LENGTH 64
+
+/* Returns d and sets *exponent such that d * 10^*exponent is the
+ * shortest decimal that rounds to @v, with no trailing zeros in d.
+ * @v must be finite and positive. */
+HB_INTERNAL uint32_t
+hb_vector_num_shortest_decimal (float v, int *exponent);
+
+static const double _hb_vector_num_pow10[13] = {1., 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+						1e7, 1e8, 1e9, 1e10, 1e11, 1e12};
+
+static const uint64_t _hb_vector_num_pow10_int[20] =
+{
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+  10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+  100000000000ull, 1000000000000ull, 10000000000000ull,
+  100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+  100000000000000000ull, 1000000000000000000ull,
+  10000000000000000000ull
+};
+
+static const char _hb_vector_num_digit_pairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/* Writes the digits of @u ending just before @end; returns the start. */
+static inline char *
+_hb_vector_num_write_digits (uint64_t u, char *end)
+{
+  while (u >= 100)
+  {
+    unsigned r = (unsigned) (u % 100);
+    u /= 100;
+    end -= 2;
+    end[0] = _hb_vector_num_digit_pairs[2 * r];
+    end[1] = _hb_vector_num_digit_pairs[2 * r + 1];
+  }
+  if (u >= 10)
+  {
+    end -= 2;
+    end[0] = _hb_vector_num_digit_pairs[2 * u];
+    end[1] = _hb_vector_num_digit_pairs[2 * u + 1];
+  }
+  else
+    *--end = (char) ('0' + u);
+  return end;
+}
+
+static inline unsigned
+_hb_vector_num_count_digits (uint64_t u)
+{
+  unsigned n = 1;
+  while (n < 20 && u >= _hb_vector_num_pow10_int[n])
+    n++;
+  return n;
+}
+
+/* Writes @digits * 10^@exponent in plain notation; returns the length.
+ * The length is worked out first so that the digits can be written
+ * in place, back to front. */
+static inline unsigned
+hb_vector_num_write (bool negative, uint64_t digits, int exponent, char *buf)
+{
+  unsigned n = _hb_vector_num_count_digits (digits);
+  unsigned frac = exponent < 0 ? (unsigned) -exponent : 0;
+  unsigned zeros = exponent > 0 ? (unsigned) exponent : 0;
+  unsigned len = negative + (n > frac ? n - frac : 1) + zeros + (frac ? frac + 1 : 0);
+
+  char *p = buf + len;
+  if (zeros)
+  {
+    p -= zeros;
+    memset (p, '0', zeros);
+  }
+  if (frac)
+  {
+    /* Past the significant digits this writes the leading zeros. */
+    for (unsigned i = 0; i < frac; i++)
+    {
+      *--p = (char) ('0' + digits % 10);
+      digits /= 10;
+    }
+    *--p = '.';
+  }
+  p = _hb_vector_num_write_digits (digits, p);
+  if (negative)
+    *--p = '-';
+  return len;
+}
+
+static inline unsigned
+hb_vector_num_shortest (float v, char *buf)
+{
+  if (unlikely (!std::isfinite (v)) || v == 0.f)
+  {
+    buf[0] = '0';
+    return 1;
+  }
+  int exponent;
+  uint32_t digits = hb_vector_num_shortest_decimal (fabsf (v), &exponent);
+  return hb_vector_num_write (v < 0.f, digits, exponent, buf);
+}
+
+static inline unsigned
+hb_vector_num_fixed (float v, unsigned precision, char *buf)
+{
+  if (precision > 12) precision = 12;
+
+  if (unlikely (!std::isfinite (v)))
+  {
+    buf[0] = '0';
+    return 1;
+  }
+
+  /* @v has a 24-bit significand and 5^12 has 28 bits, so v*10^p is
+   * exact in a double for p <= 12; rounding it half-to-even therefore
+   * matches snprintf "%.pf" digit-for-digit. */
+  double scaled = (double) v * _hb_vector_num_pow10[precision];
+
+  /* From 2^23 on the float's spacing approaches 10^-p and "%.pf" starts
+   * printing digits the float does not hold.  Use the shortest
+   * round-trip form instead whenever it is no longer. */
+  if (unlikely (!(fabs (scaled) < 8388608.)))
+  {
+    int exponent;
+    uint32_t digits = hb_vector_num_shortest_decimal (fabsf (v), &exponent);
+    if (-exponent <= (int) precision || !(fabs (scaled) < 9.0e18))
+      return hb_vector_num_write (v < 0.f, digits, exponent, buf);
+  }
+
+  /* Round the magnitude half-to-even; that is symmetric, so the sign
+   * can be put back afterwards. */
+  double a = fabs (scaled);
+  uint64_t u = (uint64_t) a;
+  double diff = a - (double) u;
+  if (diff > 0.5 || (diff == 0.5 && (u & 1)))
+    u++;
+  if (!u)
+  {
+    buf[0] = '0';
+    return 1;
+  }
+
+  int exponent = -(int) precision;
+  while (exponent < 0 && !(u % 10))
+  {
+    u /= 10;
+    exponent++;
+  }
+  return hb_vector_num_write (scaled < 0., u, exponent, buf);
+}
+
+
+#endif /* HB_VECTOR_NUM_HH */
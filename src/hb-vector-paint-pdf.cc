@@ -28,6 +28,7 @@
 
 #include "hb-vector-paint.hh"
 #include "hb-vector-draw.hh"
+#include "hb-vector-pdf.hh"
 #include "hb-paint.hh"
 
 #include <math.h>
@@ -52,73 +53,148 @@
 
 /* ---- PDF object collector ---- */
 
+/* An extra PDF object.  For streams, @data is the start of the stream
+ * dictionary, without /Length and the closing ">>". */
 struct hb_pdf_obj_t
 {
   hb_vector_buf_t data;
+  hb_vector_buf_t stream;
+  bool is_stream = false;
+  bool encoded = false;	/* stream is Flate-encoded already */
+
+  uint32_t hash () const
+  {
+    return hb_bytes_t (data.arrayZ, data.length).hash () * 31u +
+	   hb_bytes_t (stream.arrayZ, stream.length).hash () + is_stream;
+  }
+
+  bool operator == (const hb_pdf_obj_t &o) const
+  {
+    return is_stream == o.is_stream && encoded == o.encoded &&
+	   hb_bytes_t (data.arrayZ, data.length) == hb_bytes_t (o.data.arrayZ, o.data.length) &&
+	   hb_bytes_t (stream.arrayZ, stream.length) == hb_bytes_t (o.stream.arrayZ, o.stream.length);
+  }
 };
 
 /* Collects extra PDF objects (shadings, functions, ExtGState)
  * during painting.  Referenced from the content stream by name
- * (e.g. /SH0, /GS0) and emitted at render time. */
-static bool
-hb_pdf_build_indexed_smask (hb_vector_buf_t *out,
-			    const char *idat_data, unsigned idat_len,
-			    unsigned width, unsigned height,
-			    const uint8_t *trns, unsigned trns_len);
-
+ * (e.g. /SH0, /GS0) and emitted at render time.
+ *
+ * Objects are built leaves first, so identical objects refer to
+ * identical children; each distinct object is kept once, and gets
+ * one resource name. */
 struct hb_pdf_resources_t
 {
   hb_vector_t<hb_pdf_obj_t> objects;   /* extra objects, starting at id 5 */
+  hb_hashmap_t<uint32_t, unsigned> object_ids;	/* content hash -> id */
   hb_vector_buf_t extgstate_dict;    /* /GS0 5 0 R /GS1 6 0 R ... */
   hb_vector_buf_t shading_dict;      /* /SH0 7 0 R ... */
   hb_vector_buf_t xobject_dict;      /* /Im0 8 0 R ... */
+  hb_hashmap_t<unsigned, unsigned> names;	/* object id -> name index */
   unsigned extgstate_count = 0;
   unsigned shading_count = 0;
   unsigned xobject_count = 0;
+  unsigned form_count = 0;
+  /* Object holding the resource dictionary, shared by the page and
+   * the glyph forms; 0 while there are no forms. */
+  unsigned resources_id = 0;
+  /* Image XObjects by blob data; the blobs are referenced so the
+   * data pointers stay unique for the life of the document. */
+  hb_hashmap_t<const void *, unsigned> image_xobjects;
+  hb_vector_t<hb_blob_t *> image_blobs;
+
+  ~hb_pdf_resources_t ()
+  {
+    for (auto *blob : image_blobs)
+      hb_blob_destroy (blob);
+  }
+
+  unsigned add_object (hb_pdf_obj_t &&obj)
+  {
+    uint32_t hash = obj.hash ();
+    const unsigned *id;
+    if (object_ids.has (hash, &id) &&
+	objects.arrayZ[*id - 5] == obj)
+      return *id;
+
+    unsigned new_id = 5 + objects.length; /* objects 1-4 are fixed */
+    if (likely (objects.push_or_fail (std::move (obj))))
+      object_ids.set (hash, new_id);
+    return new_id;
+  }
 
   unsigned add_object (hb_vector_buf_t &&obj_data)
   {
-    unsigned id = 5 + objects.length; /* objects 1-4 are fixed */
     hb_pdf_obj_t obj;
     obj.data = std::move (obj_data);
-    objects.push (std::move (obj));
-    return id;
+    return add_object (std::move (obj));
+  }
+
+  unsigned add_stream_object (hb_vector_buf_t &&dict,
+			      hb_vector_buf_t &&stream,
+			      bool encoded = false)
+  {
+    hb_pdf_obj_t obj;
+    obj.data = std::move (dict);
+    obj.stream = std::move (stream);
+    obj.is_stream = true;
+    obj.encoded = encoded;
+    return add_object (std::move (obj));
+  }
+
+  /* Allocates an object to be filled in at render time.  Returns 0
+   * on allocation failure. */
+  unsigned reserve_object ()
+  {
+    if (unlikely (!objects.push_or_fail ()))
+      return 0;
+    return 4 + objects.length;
+  }
+
+  /* Names object @obj_id in @dict, as prefix + index.  Returns the
+   * index; an object already named keeps its name. */
+  unsigned add_name (hb_vector_buf_t &dict, const char *prefix,
+		     unsigned &count, unsigned obj_id)
+  {
+    const unsigned *idx;
+    if (names.has (obj_id, &idx))
+      return *idx;
+
+    unsigned new_idx = count++;
+    names.set (obj_id, new_idx);
+    dict.append_c ('/');
+    dict.append_str (prefix);
+    dict.append_unsigned (new_idx);
+    dict.append_c (' ');
+    dict.append_unsigned (obj_id);
+    dict.append_str (" 0 R ");
+    return new_idx;
+  }
+
+  unsigned add_extgstate (hb_vector_buf_t &&obj)
+  {
+    unsigned obj_id = add_object (std::move (obj));
+    return add_name (extgstate_dict, "GS", extgstate_count, obj_id);
   }
 
   /* Add ExtGState for fill opacity, return resource name index. */
   unsigned add_extgstate_alpha (float alpha)
   {
-    unsigned idx = extgstate_count++;
     hb_vector_buf_t obj;
     obj.append_str ("<< /Type /ExtGState /ca ");
     obj.append_num (alpha, 4);
     obj.append_str (" >>");
-    unsigned obj_id = add_object (std::move (obj));
-
-    extgstate_dict.append_str ("/GS");
-    extgstate_dict.append_unsigned (idx);
-    extgstate_dict.append_c (' ');
-    extgstate_dict.append_unsigned (obj_id);
-    extgstate_dict.append_str (" 0 R ");
-    return idx;
+    return add_extgstate (std::move (obj));
   }
 
   /* Add ExtGState for blend mode, return resource name index. */
   unsigned add_extgstate_blend (const char *bm)
   {
-    unsigned idx = extgstate_count++;
     hb_vector_buf_t obj;
     obj.append_str ("<< /Type /ExtGState /BM /");
     obj.append_str (bm);
     obj.append_str (" >>");
-    unsigned obj_id = add_object (std::move (obj));
-
-    extgstate_dict.append_str ("/GS");
-    extgstate_dict.append_unsigned (idx);
-    extgstate_dict.append_c (' ');
-    extgstate_dict.append_unsigned (obj_id);
-    extgstate_dict.append_str (" 0 R ");
-    return idx;
+    return add_extgstate (std::move (obj));
   }
 
   /* Add ExtGState with an SMask (soft mask) referencing a Form XObject
@@ -146,28 +222,15 @@ struct hb_pdf_resources_t
     form.append_str ("/Resources << /Shading << /SHa ");
     form.append_unsigned (alpha_shading_id);
     form.append_str (" 0 R >> >>\n");
-    form.append_str ("/Length ");
-    form.append_unsigned (form_stream.length);
-    form.append_str (" >>\nstream\n");
-    form.append_len (form_stream.arrayZ, form_stream.length);
-    form.append_str ("endstream");
-    unsigned form_id = add_object (std::move (form));
+    unsigned form_id = add_stream_object (std::move (form), std::move (form_stream));
 
     /* ExtGState with luminosity soft mask. */
-    unsigned idx = extgstate_count++;
     hb_vector_buf_t gs;
     gs.append_str ("<< /Type /ExtGState\n");
     gs.append_str ("/SMask << /Type /Mask /S /Luminosity /G ");
     gs.append_unsigned (form_id);
     gs.append_str (" 0 R >> >>");
-    unsigned gs_id = add_object (std::move (gs));
-
-    extgstate_dict.append_str ("/GS");
-    extgstate_dict.append_unsigned (idx);
-    extgstate_dict.append_c (' ');
-    extgstate_dict.append_unsigned (gs_id);
-    extgstate_dict.append_str (" 0 R ");
-    return idx;
+    return add_extgstate (std::move (gs));
   }
 
   /* Add a shading, return resource name index. */
@@ -179,41 +242,29 @@ struct hb_pdf_resources_t
 
   /* Register an already-allocated object as a shading resource. */
   unsigned add_shading_by_id (unsigned obj_id)
-  {
-    unsigned idx = shading_count++;
-    shading_dict.append_str ("/SH");
-    shading_dict.append_unsigned (idx);
-    shading_dict.append_c (' ');
-    shading_dict.append_unsigned (obj_id);
-    shading_dict.append_str (" 0 R ");
-    return idx;
-  }
+  { return add_name (shading_dict, "SH", shading_count, obj_id); }
 
-  /* Add an XObject image, return resource name index.
-   * idat_data/idat_len is the concatenated PNG IDAT payload (zlib data).
-   * colors is 1 (gray), 3 (RGB), or 4 (RGBA); for indexed, pass colors=1.
-   * plte/plte_len is the PLTE chunk data for indexed images (may be null). */
-  unsigned add_xobject_png_image (const char *idat_data, unsigned idat_len,
-				  unsigned width, unsigned height,
-				  unsigned colors, bool has_alpha,
-				  const uint8_t *plte = nullptr,
-				  unsigned plte_len = 0,
-				  const uint8_t *trns = nullptr,
-				  unsigned trns_len = 0)
+  /* Register a Form XObject, return resource name index. */
+  unsigned add_form (unsigned obj_id)
+  { return add_name (xobject_dict, "Fm", form_count, obj_id); }
+
+  /* Add an XObject image from parsed PNG data, return resource name
+   * index. */
+  unsigned add_xobject_png_image (const hb_vector_paint_png_t &png)
   {
-    unsigned idx = xobject_count++;
     hb_vector_buf_t obj;
     obj.append_str ("<< /Type /XObject /Subtype /Image\n");
     obj.append_str ("/Width ");
-    obj.append_unsigned (width);
+    obj.append_unsigned (png.width);
     obj.append_str (" /Height ");
-    obj.append_unsigned (height);
+    obj.append_unsigned (png.height);
     obj.append_str ("\n/BitsPerComponent 8\n");
 
-    if (plte && plte_len >= 3)
+    if (png.plte.length >= 3)
     {
       /* Indexed color: /ColorSpace [/Indexed /DeviceRGB N <hex palette>] */
-      unsigned n_entries = plte_len / 3;
+      const uint8_t *plte = (const uint8_t *) png.plte.arrayZ;
+      unsigned n_entries = png.plte.length / 3;
       obj.append_str ("/ColorSpace [/Indexed /DeviceRGB ");
       obj.append_unsigned (n_entries - 1);
       obj.append_str (" <");
@@ -227,37 +278,25 @@ struct hb_pdf_resources_t
     else
     {
       obj.append_str ("/ColorSpace ");
-      unsigned color_channels = has_alpha ? colors - 1 : colors;
+      unsigned color_channels = png.has_alpha ? png.colors - 1 : png.colors;
       obj.append_str (color_channels == 1 ? "/DeviceGray" : "/DeviceRGB");
       obj.append_c ('\n');
     }
 
-    /* Build SMask for indexed images with tRNS transparency. */
-    unsigned smask_id = 0;
-    if (plte && trns && trns_len)
+    /* SMask for indexed images with tRNS transparency. */
+    if (png.smask.length)
     {
-      hb_vector_buf_t smask_stream;
-      if (hb_pdf_build_indexed_smask (&smask_stream, idat_data, idat_len,
-				      width, height, trns, trns_len))
-      {
-	hb_vector_buf_t smask_obj;
-	smask_obj.append_str ("<< /Type /XObject /Subtype /Image\n");
-	smask_obj.append_str ("/Width ");
-	smask_obj.append_unsigned (width);
-	smask_obj.append_str (" /Height ");
-	smask_obj.append_unsigned (height);
-	smask_obj.append_str ("\n/ColorSpace /DeviceGray /BitsPerComponent 8\n");
-	smask_obj.append_str ("/Length ");
-	smask_obj.append_unsigned (smask_stream.length);
-	smask_obj.append_str (" >>\nstream\n");
-	smask_obj.append_len (smask_stream.arrayZ, smask_stream.length);
-	smask_obj.append_str ("\nendstream");
-	smask_id = add_object (std::move (smask_obj));
-      }
-    }
+      hb_vector_buf_t smask_obj;
+      smask_obj.append_str ("<< /Type /XObject /Subtype /Image\n");
+      smask_obj.append_str ("/Width ");
+      smask_obj.append_unsigned (png.width);
+      smask_obj.append_str (" /Height ");
+      smask_obj.append_unsigned (png.height);
+      smask_obj.append_str ("\n/ColorSpace /DeviceGray /BitsPerComponent 8\n");
+      hb_vector_buf_t smask;
+      smask.append_len (png.smask.arrayZ, png.smask.length);
+      unsigned smask_id = add_stream_object (std::move (smask_obj), std::move (smask));
 
-    if (smask_id)
-    {
       obj.append_str ("/SMask ");
       obj.append_unsigned (smask_id);
       obj.append_str (" 0 R\n");
@@ -265,26 +304,15 @@ struct hb_pdf_resources_t
 
     obj.append_str ("/Filter /FlateDecode\n");
     obj.append_str ("/DecodeParms << /Predictor 15 /Colors ");
-    obj.append_unsigned (colors);
+    obj.append_unsigned (png.colors);
     obj.append_str (" /BitsPerComponent 8 /Columns ");
-    obj.append_unsigned (width);
+    obj.append_unsigned (png.width);
     obj.append_str (" >>\n");
-    obj.append_str ("/Length ");
-    obj.append_unsigned (idat_len);
-    obj.append_str (" >>\nstream\n");
-    obj.append_len (idat_data, idat_len);
-    obj.append_str ("\nendstream");
-
-    (void) has_alpha;
-
-    unsigned obj_id = add_object (std::move (obj));
+    hb_vector_buf_t idat;
+    idat.append_len (png.idat.arrayZ, png.idat.length);
 
-    xobject_dict.append_str ("/Im");
-    xobject_dict.append_unsigned (idx);
-    xobject_dict.append_c (' ');
-    xobject_dict.append_unsigned (obj_id);
-    xobject_dict.append_str (" 0 R ");
-    return idx;
+    unsigned obj_id = add_stream_object (std::move (obj), std::move (idat), true);
+    return add_name (xobject_dict, "Im", xobject_count, obj_id);
   }
 };
 
@@ -705,29 +733,11 @@ hb_pdf_png_u32 (const uint8_t *p)
 	 ((uint32_t) p[2] << 8)  | (uint32_t) p[3];
 }
 
-static hb_bool_t
-hb_pdf_paint_image (hb_paint_funcs_t *,
-		    void *paint_data,
-		    hb_blob_t *image,
-		    unsigned width,
-		    unsigned height,
-		    hb_tag_t format,
-		    float slant HB_UNUSED,
-		    hb_glyph_extents_t *extents,
-		    void *)
+/* Parse a PNG blob for embedding: IHDR parameters, the concatenated
+ * IDAT payload, and the palette and alpha mask of indexed images. */
+static bool
+hb_pdf_parse_png (hb_blob_t *image, hb_vector_paint_png_t *png)
 {
-  if (format != HB_TAG ('p','n','g',' '))
-    return false;
-  if (!extents || !width || !height)
-    return false;
-
-  auto *paint = (hb_vector_paint_t *) paint_data;
-  if (unlikely (!paint->ensure_initialized ()))
-    return false;
-  auto *res = hb_pdf_get_resources (paint);
-  if (unlikely (!res))
-    return false;
-
   unsigned len = 0;
   const uint8_t *data = (const uint8_t *) hb_blob_get_data (image, &len);
   if (!data || len < 8)
@@ -739,15 +749,9 @@ hb_pdf_paint_image (hb_paint_funcs_t *,
     return false;
 
   /* Parse PNG chunks: extract IHDR and concatenate IDAT payloads. */
-  unsigned png_w = 0, png_h = 0;
-  unsigned colors = 3; /* default RGB */
   uint8_t color_type = 2;
-  bool has_alpha = false;
-  const uint8_t *plte_data = nullptr;
-  unsigned plte_len = 0;
   const uint8_t *trns_data = nullptr;
   unsigned trns_len = 0;
-  hb_vector_buf_t idat;
 
   unsigned pos = 8;
   /* Invariant: pos <= len (len >= 8 checked above).  All bounds checks below
@@ -764,26 +768,26 @@ hb_pdf_paint_image (hb_paint_funcs_t *,
     if (chunk_type == 0x49484452u) /* IHDR */
     {
       if (chunk_len < 13) return false;
-      png_w = hb_pdf_png_u32 (chunk_data);
-      png_h = hb_pdf_png_u32 (chunk_data + 4);
+      png->width = hb_pdf_png_u32 (chunk_data);
+      png->height = hb_pdf_png_u32 (chunk_data + 4);
       uint8_t bit_depth = chunk_data[8];
       color_type = chunk_data[9];
       if (bit_depth != 8) return false; /* only 8-bit supported */
 
       switch (color_type)
       {
-      case 0: colors = 1; has_alpha = false; break; /* Grayscale */
-      case 2: colors = 3; has_alpha = false; break; /* RGB */
-      case 3: colors = 1; has_alpha = false; break; /* Indexed */
-      case 4: colors = 2; has_alpha = true;  break; /* Gray+Alpha */
-      case 6: colors = 4; has_alpha = true;  break; /* RGBA */
+      case 0: png->colors = 1; png->has_alpha = false; break; /* Grayscale */
+      case 2: png->colors = 3; png->has_alpha = false; break; /* RGB */
+      case 3: png->colors = 1; png->has_alpha = false; break; /* Indexed */
+      case 4: png->colors = 2; png->has_alpha = true;  break; /* Gray+Alpha */
+      case 6: png->colors = 4; png->has_alpha = true;  break; /* RGBA */
       default: return false;
       }
     }
     else if (chunk_type == 0x504C5445u) /* PLTE */
     {
-      plte_data = chunk_data;
-      plte_len = chunk_len;
+      png->plte.resize (0);
+      png->plte.append_len ((const char *) chunk_data, chunk_len);
     }
     else if (chunk_type == 0x74524E53u) /* tRNS */
     {
@@ -792,7 +796,7 @@ hb_pdf_paint_image (hb_paint_funcs_t *,
     }
     else if (chunk_type == 0x49444154u) /* IDAT */
     {
-      idat.append_len ((const char *) chunk_data, chunk_len);
+      png->idat.append_len ((const char *) chunk_data, chunk_len);
     }
     else if (chunk_type == 0x49454E44u) /* IEND */
       break;
@@ -800,14 +804,77 @@ hb_pdf_paint_image (hb_paint_funcs_t *,
     pos += 12 + chunk_len;
   }
 
-  if (!png_w || !png_h || !idat.length)
+  if (!png->width || !png->height || !png->idat.length)
     return false;
+  if (unlikely (png->idat.in_error () || png->plte.in_error ()))
+    return false;
+
+  /* Build SMask for indexed images with tRNS transparency. */
+  if (png->plte.length >= 3 && trns_data && trns_len &&
+      !hb_pdf_build_indexed_smask (&png->smask, png->idat.arrayZ, png->idat.length,
+				   png->width, png->height, trns_data, trns_len))
+    png->smask.resize (0);
+
+  return true;
+}
 
-  unsigned im_idx = res->add_xobject_png_image (idat.arrayZ, idat.length,
-						 png_w, png_h,
-						 colors, has_alpha,
-						 plte_data, plte_len,
-						 trns_data, trns_len);
+static hb_bool_t
+hb_pdf_paint_image (hb_paint_funcs_t *,
+		    void *paint_data,
+		    hb_blob_t *image,
+		    unsigned width,
+		    unsigned height,
+		    hb_tag_t format,
+		    float slant HB_UNUSED,
+		    hb_glyph_extents_t *extents,
+		    void *)
+{
+  if (format != HB_TAG ('p','n','g',' '))
+    return false;
+  if (!extents || !width || !height)
+    return false;
+
+  auto *paint = (hb_vector_paint_t *) paint_data;
+  if (unlikely (!paint->ensure_initialized ()))
+    return false;
+  auto *res = hb_pdf_get_resources (paint);
+  if (unlikely (!res))
+    return false;
+
+  const void *key = hb_blob_get_data (image, nullptr);
+  if (!key)
+    return false;
+
+  /* Each image is embedded once per document, and parsed once while
+   * it stays in the image cache. */
+  unsigned im_idx;
+  unsigned *cached_idx;
+  if (res->image_xobjects.has (key, &cached_idx))
+    im_idx = *cached_idx;
+  else
+  {
+    hb_vector_paint_png_t parsed;
+    HB_SCOPE_GUARD (parsed.fini ());
+    hb_vector_paint_png_t *png = paint->image_cache.lookup (image, format);
+    if (!png)
+    {
+      if (!hb_pdf_parse_png (image, &parsed))
+	return false;
+      png = paint->image_cache.insert (image, format, parsed);
+      if (!png)
+	png = &parsed;
+    }
+
+    im_idx = res->add_xobject_png_image (*png);
+
+    if (likely (res->image_blobs.push_or_fail (hb_blob_reference (image))))
+    {
+      if (unlikely (!res->image_xobjects.set (key, im_idx)))
+	hb_blob_destroy (res->image_blobs.pop ());
+    }
+    else
+      hb_blob_destroy (image);
+  }
 
   /* Emit: save state, set CTM to map image (0,0)-(1,1) to extents, paint. */
   auto &body = paint->current_body ();
@@ -1470,12 +1537,8 @@ hb_pdf_paint_sweep_gradient (hb_paint_funcs_t *,
     sh.append_c (' ');
     sh.append_num (yhi, 2);
     sh.append_str (decode_suffix);
-    sh.append_str ("]\n/Length ");
-    sh.append_unsigned (m.length);
-    sh.append_str (" >>\nstream\n");
-    sh.append_len (m.arrayZ, m.length);
-    sh.append_str ("\nendstream");
-    return res->add_object (std::move (sh));
+    sh.append_str ("]\n");
+    return res->add_stream_object (std::move (sh), std::move (m));
   };
 
   unsigned sh_obj_id = hb_pdf_build_mesh_shading (mesh, "DeviceRGB",
@@ -1638,8 +1701,131 @@ hb_vector_paint_pdf_funcs_get ()
 }
 
 
+/* ---- glyph forms ---- */
+
+/* Paints @glyph by invoking its Form XObject, painting the glyph into
+ * a new one the first time it is seen in the document.  The forms
+ * live in svg_reuse's glyph table: the form name index plus one, or
+ * 0 for a glyph that failed to paint. */
+hb_bool_t
+hb_vector_paint_pdf_glyph_form (hb_vector_paint_t *paint,
+				hb_font_t *font,
+				hb_codepoint_t glyph,
+				hb_bool_t fallible)
+{
+  hb_paint_funcs_t *funcs = hb_vector_paint_pdf_funcs_get ();
+  auto *res = hb_pdf_get_resources (paint);
+  if (unlikely (!res || !paint->ensure_initialized ()))
+    goto inline_glyph;
+  if (!res->resources_id &&
+      unlikely (!(res->resources_id = res->reserve_object ())))
+    goto inline_glyph;
+
+  {
+    auto key = paint->svg_reuse.glyph_key (font, glyph);
+    unsigned value;
+    if (!paint->svg_reuse.get_glyph (key, &value))
+    {
+      unsigned precision = paint->current_body ().precision;
+      if (unlikely (!paint->group_stack.push_or_fail ()))
+	goto inline_glyph;
+      paint->current_body ().precision = precision;
+
+      hb_bool_t ret = true;
+      if (fallible)
+	ret = hb_font_paint_glyph_or_fail (font, glyph, funcs, paint,
+					   (unsigned) paint->palette,
+					   paint->foreground);
+      else
+	hb_font_paint_glyph (font, glyph, funcs, paint,
+			     (unsigned) paint->palette,
+			     paint->foreground);
+
+      hb_vector_buf_t form_stream = std::move (paint->current_body ());
+      paint->group_stack.pop ();
+      if (unlikely (form_stream.in_error ()))
+	return false;
+
+      value = 0;
+      if (ret)
+      {
+	/* Glyphs may paint well outside their advance box, but not
+	 * by many ems. */
+	int x_scale, y_scale;
+	hb_font_get_scale (font, &x_scale, &y_scale);
+	float bound = hb_max (32767.f,
+			      4.f * hb_max (fabsf (paint->sx ((float) x_scale)),
+					    fabsf (paint->sy ((float) y_scale))));
+
+	hb_vector_buf_t form;
+	form.append_str ("<< /Type /XObject /Subtype /Form\n/BBox [");
+	form.append_num (-bound, 0);
+	form.append_c (' ');
+	form.append_num (-bound, 0);
+	form.append_c (' ');
+	form.append_num (bound, 0);
+	form.append_c (' ');
+	form.append_num (bound, 0);
+	form.append_str ("]\n/Resources ");
+	form.append_unsigned (res->resources_id);
+	form.append_str (" 0 R\n");
+	unsigned form_id = res->add_stream_object (std::move (form),
+						   std::move (form_stream));
+	value = res->add_form (form_id) + 1;
+      }
+      paint->svg_reuse.set_glyph (key, value);
+    }
+
+    if (!value)
+      return false;
+
+    auto &body = paint->current_body ();
+    body.append_str ("/Fm");
+    body.append_unsigned (value - 1);
+    body.append_str (" Do\n");
+    return true;
+  }
+
+inline_glyph:
+  if (fallible)
+    return hb_font_paint_glyph_or_fail (font, glyph, funcs, paint,
+					(unsigned) paint->palette,
+					paint->foreground);
+  hb_font_paint_glyph (font, glyph, funcs, paint,
+		       (unsigned) paint->palette,
+		       paint->foreground);
+  return true;
+}
+
+
 /* ---- render ---- */
 
+/* Appends the page resource dictionary to @out. */
+static void
+hb_pdf_append_resources (hb_vector_buf_t *out, const hb_pdf_resources_t *res)
+{
+  out->append_str ("<<");
+  if (res->extgstate_dict.length)
+  {
+    out->append_str (" /ExtGState << ");
+    out->append_len (res->extgstate_dict.arrayZ, res->extgstate_dict.length);
+    out->append_str (">>");
+  }
+  if (res->shading_dict.length)
+  {
+    out->append_str (" /Shading << ");
+    out->append_len (res->shading_dict.arrayZ, res->shading_dict.length);
+    out->append_str (">>");
+  }
+  if (res->xobject_dict.length)
+  {
+    out->append_str (" /XObject << ");
+    out->append_len (res->xobject_dict.arrayZ, res->xobject_dict.length);
+    out->append_str (">>");
+  }
+  out->append_str (" >>");
+}
+
 hb_blob_t *
 hb_vector_paint_render_pdf (hb_vector_paint_t *paint)
 {
@@ -1657,70 +1843,8 @@ hb_vector_paint_render_pdf (hb_vector_paint_t *paint)
   float ew = paint->extents.width;
   float eh = paint->extents.height;
 
-  unsigned num_extra = res ? res->objects.length : 0;
-  unsigned total_objects = 4 + num_extra; /* 1-based: 1..total_objects */
-
-  /* Build PDF. */
-  hb_vector_buf_t out;
-  hb_buf_recover_recycled (paint->recycled_blob, &out);
-  out.alloc (content.length + num_extra * 128 + 1024);
-
-  hb_vector_t<unsigned> offsets;
-  if (unlikely (!offsets.resize (total_objects)))
-    return nullptr;
-
-  out.append_str ("%PDF-1.4\n%\xC0\xC1\xC2\xC3\n");
-
-  /* Object 1: Catalog */
-  offsets.arrayZ[0] = out.length;
-  out.append_str ("1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
-
-  /* Object 2: Pages */
-  offsets.arrayZ[1] = out.length;
-  out.append_str ("2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
-
-  /* Object 3: Page */
-  offsets.arrayZ[2] = out.length;
-  out.append_str ("3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [");
-  out.append_num (ex);
-  out.append_c (' ');
-  out.append_num (ey);
-  out.append_c (' ');
-  out.append_num (ex + ew);
-  out.append_c (' ');
-  out.append_num (ey + eh);
-  out.append_str ("]\n/Contents 4 0 R");
-
-  /* Resources. */
-  bool has_resources = res &&
-    (res->extgstate_dict.length || res->shading_dict.length || res->xobject_dict.length);
-  if (has_resources)
-  {
-    out.append_str ("\n/Resources <<");
-    if (res->extgstate_dict.length)
-    {
-      out.append_str (" /ExtGState << ");
-      out.append_len (res->extgstate_dict.arrayZ, res->extgstate_dict.length);
-      out.append_str (">>");
-    }
-    if (res->shading_dict.length)
-    {
-      out.append_str (" /Shading << ");
-      out.append_len (res->shading_dict.arrayZ, res->shading_dict.length);
-      out.append_str (">>");
-    }
-    if (res->xobject_dict.length)
-    {
-      out.append_str (" /XObject << ");
-      out.append_len (res->xobject_dict.arrayZ, res->xobject_dict.length);
-      out.append_str (">>");
-    }
-    out.append_str (" >>");
-  }
-
-  out.append_str (" >>\nendobj\n");
-
-  /* Build content stream: optional background rect + glyph content. */
+  /* Content stream prefix: optional background rect.  Built first, as
+   * it may add a graphics state to the resources. */
   hb_vector_buf_t bg_prefix;
   if (hb_color_get_alpha (paint->background))
   {
@@ -1753,46 +1877,72 @@ hb_vector_paint_render_pdf (hb_vector_paint_t *paint)
     bg_prefix.append_num (eh);
     bg_prefix.append_str (" re f\n");
   }
-  unsigned stream_len = bg_prefix.length + content.length;
+
+  unsigned num_extra = res ? res->objects.length : 0;
+  if (res && res->resources_id)
+  {
+    auto &obj = res->objects.arrayZ[res->resources_id - 5];
+    obj.data.resize (0);
+    hb_pdf_append_resources (&obj.data, res);
+  }
+
+  /* Build PDF. */
+  hb_vector_buf_t out;
+  hb_buf_recover_recycled (paint->recycled_blob, &out);
+  out.alloc (content.length + num_extra * 128 + 1024);
+
+  hb_vector_pdf_writer_t pdf (&out, 4 + num_extra, paint->pdf_compression_level);
+
+  static const char catalog[] = "<< /Type /Catalog /Pages 2 0 R >>";
+  static const char pages[] = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
+  pdf.add_object (1, catalog, sizeof (catalog) - 1);
+  pdf.add_object (2, pages, sizeof (pages) - 1);
+
+  /* Object 3: Page */
+  hb_vector_buf_t page;
+  page.append_str ("<< /Type /Page /Parent 2 0 R /MediaBox [");
+  page.append_num (ex);
+  page.append_c (' ');
+  page.append_num (ey);
+  page.append_c (' ');
+  page.append_num (ex + ew);
+  page.append_c (' ');
+  page.append_num (ey + eh);
+  page.append_str ("]\n/Contents 4 0 R");
+  if (res && res->resources_id)
+  {
+    page.append_str ("\n/Resources ");
+    page.append_unsigned (res->resources_id);
+    page.append_str (" 0 R");
+  }
+  else if (res &&
+	   (res->extgstate_dict.length || res->shading_dict.length || res->xobject_dict.length))
+  {
+    page.append_str ("\n/Resources ");
+    hb_pdf_append_resources (&page, res);
+  }
+  page.append_str (" >>");
+  pdf.add_object (3, page.arrayZ, page.length);
 
   /* Object 4: Content stream */
-  offsets.arrayZ[3] = out.length;
-  out.append_str ("4 0 obj\n<< /Length ");
-  out.append_unsigned (stream_len);
-  out.append_str (" >>\nstream\n");
-  out.append_len (bg_prefix.arrayZ, bg_prefix.length);
-  out.append_len (content.arrayZ, content.length);
-  out.append_str ("endstream\nendobj\n");
+  pdf.add_stream (4, "<< ", 3,
+		  bg_prefix.arrayZ, bg_prefix.length,
+		  content.arrayZ, content.length);
 
   /* Extra objects (functions, shadings, ExtGState). */
   for (unsigned i = 0; i < num_extra; i++)
   {
-    offsets.arrayZ[4 + i] = out.length;
-    out.append_unsigned (5 + i);
-    out.append_str (" 0 obj\n");
     auto &obj = res->objects.arrayZ[i];
-    out.append_len (obj.data.arrayZ, obj.data.length);
-    out.append_str ("\nendobj\n");
-  }
-
-  /* Cross-reference table */
-  unsigned xref_offset = out.length;
-  out.append_str ("xref\n0 ");
-  out.append_unsigned (total_objects + 1);
-  out.append_str ("\n0000000000 65535 f \n");
-  for (unsigned i = 0; i < total_objects; i++)
-  {
-    char tmp[21];
-    snprintf (tmp, sizeof (tmp), "%010u 00000 n \n", offsets.arrayZ[i]);
-    out.append_len (tmp, 20);
+    if (obj.is_stream)
+      pdf.add_stream (5 + i, obj.data.arrayZ, obj.data.length,
+		      obj.stream.arrayZ, obj.stream.length,
+		      nullptr, 0, obj.encoded);
+    else
+      pdf.add_object (5 + i, obj.data.arrayZ, obj.data.length);
   }
 
-  /* Trailer */
-  out.append_str ("trailer\n<< /Size ");
-  out.append_unsigned (total_objects + 1);
-  out.append_str (" /Root 1 0 R >>\nstartxref\n");
-  out.append_unsigned (xref_offset);
-  out.append_str ("\n%%EOF\n");
+  if (unlikely (!pdf.finish () || page.in_error () || bg_prefix.in_error ()))
+    return nullptr;
 
   hb_blob_t *blob = hb_buf_blob_from (&paint->recycled_blob, &out);
 
@@ -424,6 +424,112 @@ hb_vector_paint_pop_transform (hb_paint_funcs_t *,
     paint->current_body ().append_str ("</g>\n");
 }
 
+/* Extracts @glyph's outline into paint->path. */
+static void
+hb_vector_paint_svg_draw_glyph (hb_vector_paint_t *paint,
+				hb_font_t *font,
+				hb_codepoint_t glyph)
+{
+  paint->path.clear ();
+  /* Skip the outline extraction when the session work budget is
+   * spent; an empty path keeps the document structure intact, and
+   * an empty clip path clips everything out. */
+  if (likely (paint->work_left > 0))
+  {
+    hb_vector_path_sink_t sink = {&paint->path, paint->get_precision (),
+				 paint->x_scale_factor, paint->y_scale_factor,
+				 &paint->work_left};
+    hb_font_draw_glyph (font, glyph, hb_vector_svg_path_draw_funcs_get (), &sink);
+  }
+}
+
+/* Returns the id of a <path> def holding @glyph's outline, and with
+ * @clip, of the <clipPath> wrapping it.  With SVG reuse, glyphs seen
+ * earlier in the document are not drawn again. */
+static unsigned
+hb_vector_paint_svg_glyph_def (hb_vector_paint_t *paint,
+			       hb_font_t *font,
+			       hb_codepoint_t glyph,
+			       bool clip)
+{
+  const char *pfx = paint->id_prefix;
+  unsigned pfx_len = paint->id_prefix_length;
+
+  /* Recorded value: def id << 1 | has clipPath. */
+  hb_vector_svg_reuse_t::glyph_key_t key = {};
+  unsigned value = 0;
+  bool found = false;
+  if (paint->svg_reuse.enabled)
+  {
+    key = paint->svg_reuse.glyph_key (font, glyph);
+    found = paint->svg_reuse.get_glyph (key, &value);
+    if (found && (!clip || (value & 1)))
+      return value >> 1;
+  }
+
+  unsigned def_id;
+  if (found)
+    def_id = value >> 1;
+  else
+  {
+    hb_vector_paint_svg_draw_glyph (paint, font, glyph);
+    def_id = paint->path_def_count++;
+    paint->defs.append_str ("<path id=\"");
+    paint->defs.append_len (pfx, pfx_len);
+    paint->defs.append_c ('p');
+    paint->defs.append_unsigned (def_id);
+    paint->defs.append_str ("\" d=\"");
+    paint->defs.append_len (paint->path.arrayZ, paint->path.length);
+    paint->defs.append_str ("\"/>\n");
+  }
+
+  if (clip)
+  {
+    paint->defs.append_str ("<clipPath id=\"");
+    paint->defs.append_len (pfx, pfx_len);
+    paint->defs.append_str ("clip-p");
+    paint->defs.append_unsigned (def_id);
+    paint->defs.append_str ("\"><use href=\"#");
+    paint->defs.append_len (pfx, pfx_len);
+    paint->defs.append_c ('p');
+    paint->defs.append_unsigned (def_id);
+    paint->defs.append_str ("\"/></clipPath>\n");
+  }
+
+  if (paint->svg_reuse.enabled)
+    paint->svg_reuse.set_glyph (key, (def_id << 1) | (clip || (value & 1)));
+  return def_id;
+}
+
+/* Appends a definition to the defs: @element, an id made of @kind
+ * and a number taken from @counter, and the rest of the definition
+ * as serialized in paint->def_scratch.  Returns the number.  With SVG
+ * reuse, an identical definition emitted earlier is returned instead;
+ * the serialized rest includes the closing tag, so definitions of
+ * different elements never compare equal. */
+static unsigned
+hb_vector_paint_svg_def (hb_vector_paint_t *paint,
+			 const char *element,
+			 const char *kind,
+			 unsigned *counter)
+{
+  const hb_vector_buf_t &tail = paint->def_scratch;
+  unsigned id = *counter;
+  if (paint->svg_reuse.enabled &&
+      paint->svg_reuse.get_def (tail.arrayZ, tail.length, id, &id))
+    return id;
+  (*counter)++;
+
+  paint->defs.append_c ('<');
+  paint->defs.append_str (element);
+  paint->defs.append_str (" id=\"");
+  paint->defs.append_len (paint->id_prefix, paint->id_prefix_length);
+  paint->defs.append_str (kind);
+  paint->defs.append_unsigned (id);
+  paint->defs.append_len (tail.arrayZ, tail.length);
+  return id;
+}
+
 static void
 hb_vector_paint_fill_glyph (hb_paint_funcs_t *,
                             void *paint_data,
@@ -437,18 +543,21 @@ hb_vector_paint_fill_glyph (hb_paint_funcs_t *,
   if (unlikely (!paint->ensure_initialized ()))
     return;
 
-  paint->path.clear ();
-  /* Skip the outline extraction when the session work budget is
-   * spent; an empty path keeps the document structure intact. */
-  if (likely (paint->work_left > 0))
+  auto &body = paint->current_body ();
+  if (paint->svg_reuse.enabled)
   {
-    hb_vector_path_sink_t sink = {&paint->path, paint->get_precision (),
-				 paint->x_scale_factor, paint->y_scale_factor,
-				 &paint->work_left};
-    hb_font_draw_glyph (font, glyph, hb_vector_svg_path_draw_funcs_get (), &sink);
+    unsigned def_id = hb_vector_paint_svg_glyph_def (paint, font, glyph, false);
+    body.append_str ("<use href=\"#");
+    body.append_len (paint->id_prefix, paint->id_prefix_length);
+    body.append_c ('p');
+    body.append_unsigned (def_id);
+    body.append_str ("\" fill=\"");
+    body.append_svg_color (color, true);
+    body.append_str ("\"/>\n");
+    return;
   }
 
-  auto &body = paint->current_body ();
+  hb_vector_paint_svg_draw_glyph (paint, font, glyph);
   body.append_str ("<path d=\"");
   body.append_len (paint->path.arrayZ, paint->path.length);
   body.append_str ("\" fill=\"");
@@ -470,34 +579,7 @@ hb_vector_paint_push_clip_glyph (hb_paint_funcs_t *,
   const char *pfx = paint->id_prefix;
   unsigned pfx_len = paint->id_prefix_length;
 
-  paint->path.clear ();
-  /* Skip the outline extraction when the session work budget is
-   * spent; an empty clip path clips everything out. */
-  if (likely (paint->work_left > 0))
-  {
-    hb_vector_path_sink_t sink = {&paint->path, paint->get_precision (),
-				 paint->x_scale_factor, paint->y_scale_factor,
-				 &paint->work_left};
-    hb_font_draw_glyph (font, glyph, hb_vector_svg_path_draw_funcs_get (), &sink);
-  }
-
-  unsigned def_id = paint->path_def_count++;
-  paint->defs.append_str ("<path id=\"");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_c ('p');
-  paint->defs.append_unsigned (def_id);
-  paint->defs.append_str ("\" d=\"");
-  paint->defs.append_len (paint->path.arrayZ, paint->path.length);
-  paint->defs.append_str ("\"/>\n");
-  paint->defs.append_str ("<clipPath id=\"");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_str ("clip-p");
-  paint->defs.append_unsigned (def_id);
-  paint->defs.append_str ("\"><use href=\"#");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_c ('p');
-  paint->defs.append_unsigned (def_id);
-  paint->defs.append_str ("\"/></clipPath>\n");
+  unsigned def_id = hb_vector_paint_svg_glyph_def (paint, font, glyph, true);
 
   paint->current_body ().append_str ("<g clip-path=\"url(#");
   paint->current_body ().append_len (pfx, pfx_len);
@@ -519,20 +601,19 @@ hb_vector_paint_push_clip_rectangle (hb_paint_funcs_t *,
 
   const char *pfx = paint->id_prefix;
   unsigned pfx_len = paint->id_prefix_length;
-  unsigned clip_id = paint->clip_rect_counter++;
-  paint->defs.append_str ("<clipPath id=\"");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_c ('c');
-  paint->defs.append_unsigned (clip_id);
-  paint->defs.append_str ("\"><rect x=\"");
-  paint->defs.append_num (paint->sx (xmin));
-  paint->defs.append_str ("\" y=\"");
-  paint->defs.append_num (paint->sy (ymin));
-  paint->defs.append_str ("\" width=\"");
-  paint->defs.append_num (paint->sx (xmax - xmin));
-  paint->defs.append_str ("\" height=\"");
-  paint->defs.append_num (paint->sy (ymax - ymin));
-  paint->defs.append_str ("\"/></clipPath>\n");
+  auto &tail = paint->def_scratch;
+  tail.clear ();
+  tail.append_str ("\"><rect x=\"");
+  tail.append_num (paint->sx (xmin));
+  tail.append_str ("\" y=\"");
+  tail.append_num (paint->sy (ymin));
+  tail.append_str ("\" width=\"");
+  tail.append_num (paint->sx (xmax - xmin));
+  tail.append_str ("\" height=\"");
+  tail.append_num (paint->sy (ymax - ymin));
+  tail.append_str ("\"/></clipPath>\n");
+  unsigned clip_id = hb_vector_paint_svg_def (paint, "clipPath", "c",
+					      &paint->clip_rect_counter);
 
   paint->current_body ().append_str ("<g clip-path=\"url(#");
   paint->current_body ().append_len (pfx, pfx_len);
@@ -661,14 +742,40 @@ hb_vector_paint_image (hb_paint_funcs_t *,
     body.append_num (paint->sy ((float) extents->height) / height);
     body.append_str (")\">\n");
 
-    body.append_str ("<image href=\"data:image/png;base64,");
-    body.append_base64 ((const uint8_t *) png_data, len);
-    body.append_str ("\" width=\"");
-    body.append_num ((float) width);
-    body.append_str ("\" height=\"");
-    body.append_num ((float) height);
-    body.append_str ("\"/>\n</g>\n");
+    if (!paint->svg_reuse.enabled)
+    {
+      body.append_str ("<image href=\"data:image/png;base64,");
+      body.append_base64 ((const uint8_t *) png_data, len);
+      body.append_str ("\" width=\"");
+      body.append_num ((float) width);
+      body.append_str ("\" height=\"");
+      body.append_num ((float) height);
+      body.append_str ("\"/>\n</g>\n");
+      return true;
+    }
 
+    unsigned image_id;
+    if (!paint->svg_reuse.get_image (image, &image_id))
+    {
+      image_id = paint->image_def_count++;
+      paint->defs.append_str ("<image id=\"");
+      paint->defs.append_len (paint->id_prefix, paint->id_prefix_length);
+      paint->defs.append_c ('i');
+      paint->defs.append_unsigned (image_id);
+      paint->defs.append_str ("\" href=\"data:image/png;base64,");
+      paint->defs.append_base64 ((const uint8_t *) png_data, len);
+      paint->defs.append_str ("\" width=\"");
+      paint->defs.append_num ((float) width);
+      paint->defs.append_str ("\" height=\"");
+      paint->defs.append_num ((float) height);
+      paint->defs.append_str ("\"/>\n");
+      paint->svg_reuse.set_image (image, image_id);
+    }
+    body.append_str ("<use href=\"#");
+    body.append_len (paint->id_prefix, paint->id_prefix_length);
+    body.append_c ('i');
+    body.append_unsigned (image_id);
+    body.append_str ("\"/>\n</g>\n");
     return true;
   }
 
@@ -701,7 +808,6 @@ hb_vector_paint_linear_gradient (hb_paint_funcs_t *,
 
   const char *pfx = paint->id_prefix;
   unsigned pfx_len = paint->id_prefix_length;
-  unsigned grad_id = paint->gradient_counter++;
 
   /* Reduce COLR's 3-anchor (P0, P1, P2) to SVG's 2-point
    * (start, end) gradient. */
@@ -713,23 +819,23 @@ hb_vector_paint_linear_gradient (hb_paint_funcs_t *,
   float gx1 = lx0 + mx * (lx1 - lx0);
   float gy1 = ly0 + mx * (ly1 - ly0);
 
-  paint->defs.append_str ("<linearGradient id=\"");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_str ("gr");
-  paint->defs.append_unsigned (grad_id);
-  paint->defs.append_str ("\" gradientUnits=\"userSpaceOnUse\" x1=\"");
-  paint->defs.append_num (paint->sx (gx0));
-  paint->defs.append_str ("\" y1=\"");
-  paint->defs.append_num (paint->sy (gy0));
-  paint->defs.append_str ("\" x2=\"");
-  paint->defs.append_num (paint->sx (gx1));
-  paint->defs.append_str ("\" y2=\"");
-  paint->defs.append_num (paint->sy (gy1));
-  paint->defs.append_str ("\" spreadMethod=\"");
-  paint->defs.append_str (hb_vector_svg_extend_mode_str (hb_color_line_get_extend (color_line)));
-  paint->defs.append_str ("\">\n");
-  hb_vector_svg_emit_color_stops (paint, &paint->defs, &stops);
-  paint->defs.append_str ("</linearGradient>\n");
+  auto &tail = paint->def_scratch;
+  tail.clear ();
+  tail.append_str ("\" gradientUnits=\"userSpaceOnUse\" x1=\"");
+  tail.append_num (paint->sx (gx0));
+  tail.append_str ("\" y1=\"");
+  tail.append_num (paint->sy (gy0));
+  tail.append_str ("\" x2=\"");
+  tail.append_num (paint->sx (gx1));
+  tail.append_str ("\" y2=\"");
+  tail.append_num (paint->sy (gy1));
+  tail.append_str ("\" spreadMethod=\"");
+  tail.append_str (hb_vector_svg_extend_mode_str (hb_color_line_get_extend (color_line)));
+  tail.append_str ("\">\n");
+  hb_vector_svg_emit_color_stops (paint, &tail, &stops);
+  tail.append_str ("</linearGradient>\n");
+  unsigned grad_id = hb_vector_paint_svg_def (paint, "linearGradient", "gr",
+					      &paint->gradient_counter);
 
   paint->current_body ().append_str (
                      "<rect x=\"-32767\" y=\"-32767\" width=\"65534\" height=\"65534\" fill=\"url(#");
@@ -769,32 +875,31 @@ hb_vector_paint_radial_gradient (hb_paint_funcs_t *,
 
   const char *pfx = paint->id_prefix;
   unsigned pfx_len = paint->id_prefix_length;
-  unsigned grad_id = paint->gradient_counter++;
 
-  paint->defs.append_str ("<radialGradient id=\"");
-  paint->defs.append_len (pfx, pfx_len);
-  paint->defs.append_str ("gr");
-  paint->defs.append_unsigned (grad_id);
-  paint->defs.append_str ("\" gradientUnits=\"userSpaceOnUse\" cx=\"");
-  paint->defs.append_num (paint->sx (gx1));
-  paint->defs.append_str ("\" cy=\"");
-  paint->defs.append_num (paint->sy (gy1));
-  paint->defs.append_str ("\" r=\"");
-  paint->defs.append_num (paint->sx (gr1));
-  paint->defs.append_str ("\" fx=\"");
-  paint->defs.append_num (paint->sx (gx0));
-  paint->defs.append_str ("\" fy=\"");
-  paint->defs.append_num (paint->sy (gy0));
+  auto &tail = paint->def_scratch;
+  tail.clear ();
+  tail.append_str ("\" gradientUnits=\"userSpaceOnUse\" cx=\"");
+  tail.append_num (paint->sx (gx1));
+  tail.append_str ("\" cy=\"");
+  tail.append_num (paint->sy (gy1));
+  tail.append_str ("\" r=\"");
+  tail.append_num (paint->sx (gr1));
+  tail.append_str ("\" fx=\"");
+  tail.append_num (paint->sx (gx0));
+  tail.append_str ("\" fy=\"");
+  tail.append_num (paint->sy (gy0));
   if (gr0 > 0)
   {
-    paint->defs.append_str ("\" fr=\"");
-    paint->defs.append_num (paint->sx (gr0));
+    tail.append_str ("\" fr=\"");
+    tail.append_num (paint->sx (gr0));
   }
-  paint->defs.append_str ("\" spreadMethod=\"");
-  paint->defs.append_str (hb_vector_svg_extend_mode_str (hb_color_line_get_extend (color_line)));
-  paint->defs.append_str ("\">\n");
-  hb_vector_svg_emit_color_stops (paint, &paint->defs, &stops);
-  paint->defs.append_str ("</radialGradient>\n");
+  tail.append_str ("\" spreadMethod=\"");
+  tail.append_str (hb_vector_svg_extend_mode_str (hb_color_line_get_extend (color_line)));
+  tail.append_str ("\">\n");
+  hb_vector_svg_emit_color_stops (paint, &tail, &stops);
+  tail.append_str ("</radialGradient>\n");
+  unsigned grad_id = hb_vector_paint_svg_def (paint, "radialGradient", "gr",
+					      &paint->gradient_counter);
 
   paint->current_body ().append_str (
                      "<rect x=\"-32767\" y=\"-32767\" width=\"65534\" height=\"65534\" fill=\"url(#");
@@ -214,6 +214,7 @@ hb_vector_paint_set_scale_factor (hb_vector_paint_t *paint,
 {
   paint->x_scale_factor = x_scale_factor > 0.f ? x_scale_factor : 1.f;
   paint->y_scale_factor = y_scale_factor > 0.f ? y_scale_factor : 1.f;
+  paint->svg_reuse.reset_glyphs ();
 }
 
 /**
@@ -354,6 +355,7 @@ hb_vector_paint_set_foreground (hb_vector_paint_t *paint,
                                 hb_color_t foreground)
 {
   paint->foreground = foreground;
+  paint->colors_changed ();
 }
 
 /**
@@ -422,6 +424,7 @@ hb_vector_paint_set_palette (hb_vector_paint_t *paint,
                              int palette)
 {
   paint->palette = palette;
+  paint->colors_changed ();
 }
 
 /**
@@ -462,6 +465,7 @@ hb_vector_paint_set_custom_palette_color (hb_vector_paint_t *paint,
                                           hb_color_t color)
 {
   paint->custom_palette_colors.set (color_index, color);
+  paint->colors_changed ();
 }
 
 /**
@@ -479,6 +483,7 @@ void
 hb_vector_paint_clear_custom_palette_colors (hb_vector_paint_t *paint)
 {
   paint->custom_palette_colors.clear ();
+  paint->colors_changed ();
 }
 
 /**
@@ -554,7 +559,9 @@ hb_vector_paint_glyph_impl (hb_vector_paint_t *paint,
 			   paint->transform.x0, paint->transform.y0);
 
   hb_bool_t ret = true;
-  if (fallible)
+  if (paint->format == HB_VECTOR_FORMAT_PDF && paint->pdf_compression_level)
+    ret = hb_vector_paint_pdf_glyph_form (paint, font, glyph, fallible);
+  else if (fallible)
     ret = hb_font_paint_glyph_or_fail (font, glyph,
 				       funcs, paint,
 				       (unsigned) paint->palette,
@@ -626,6 +633,58 @@ hb_vector_paint_glyph (hb_vector_paint_t *paint,
 			      extents_mode, false);
 }
 
+/**
+ * hb_vector_paint_buffer:
+ * @paint: a paint context.
+ * @font: font object.
+ * @buffer: a buffer holding shaped glyphs.
+ * @extents_mode: extents update mode.
+ *
+ * Paints all glyphs of @buffer into @paint as one run of text, the
+ * way hb_vector_paint_glyph() paints each.  The pen starts at the
+ * origin of the current transform and moves by the glyph advances;
+ * glyph offsets are applied on top.  The transform is left as it was.
+ *
+ * For SVG output, glyph outlines, gradients and images are shared
+ * across the run as with hb_vector_paint_set_svg_reuse(), whether or
+ * not that is set.
+ *
+ * Buffers not holding glyphs (i.e. not shaped) are ignored.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_paint_buffer (hb_vector_paint_t *paint,
+			hb_font_t         *font,
+			hb_buffer_t       *buffer,
+			hb_vector_extents_mode_t extents_mode)
+{
+  if (hb_buffer_get_content_type (buffer) != HB_BUFFER_CONTENT_TYPE_GLYPHS)
+    return;
+
+  unsigned count;
+  const hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  const hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  hb_transform_t<> base = paint->transform;
+  bool reuse = paint->svg_reuse.enabled;
+  paint->svg_reuse.enabled = true;
+
+  hb_position_t x = 0, y = 0;
+  for (unsigned i = 0; i < count; i++)
+  {
+    paint->transform = base;
+    paint->transform.translate (x + pos[i].x_offset, y + pos[i].y_offset);
+    hb_vector_paint_glyph_impl (paint, font, info[i].codepoint,
+				extents_mode, false);
+    x += pos[i].x_advance;
+    y += pos[i].y_advance;
+  }
+
+  paint->transform = base;
+  paint->svg_reuse.enabled = reuse;
+}
+
 /**
  * hb_vector_paint_set_svg_prefix:
  * @paint: a paint context.
@@ -683,6 +742,89 @@ hb_vector_paint_get_svg_prefix (const hb_vector_paint_t *paint)
   return paint->id_prefix ? paint->id_prefix : "";
 }
 
+/**
+ * hb_vector_paint_set_svg_reuse:
+ * @paint: a paint context.
+ * @reuse: whether to share definitions within a document.
+ *
+ * Enables document-level sharing of SVG definitions.  When enabled,
+ * each distinct glyph outline painted or used as a clip is emitted
+ * once into `<defs>` and referenced with `<use>` afterwards, and
+ * identical gradients are emitted once.  Glyphs are told apart by
+ * font, font serial (see hb_font_get_serial()) and glyph ID, so a
+ * font changed mid-document, e.g. to new variation coordinates,
+ * gets fresh definitions.
+ *
+ * No effect on PDF output.  Default is disabled.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_paint_set_svg_reuse (hb_vector_paint_t *paint,
+                               hb_bool_t reuse)
+{
+  paint->svg_reuse.enabled = reuse;
+}
+
+/**
+ * hb_vector_paint_get_svg_reuse:
+ * @paint: a paint context.
+ *
+ * Returns whether definitions are shared within SVG documents.
+ * See hb_vector_paint_set_svg_reuse().
+ *
+ * Return value: `true` if SVG reuse is enabled.
+ *
+ * XSince: REPLACEME
+ */
+hb_bool_t
+hb_vector_paint_get_svg_reuse (const hb_vector_paint_t *paint)
+{
+  return paint->svg_reuse.enabled;
+}
+
+/**
+ * hb_vector_paint_set_pdf_compression_level:
+ * @paint: a paint context.
+ * @level: compression level, 0 to 9.
+ *
+ * Sets how PDF output is compressed.  At level 0, the default, the
+ * file is plain PDF 1.4 text.  Levels 1 to 9 Flate-encode all streams
+ * at that zlib compression level, pack the remaining objects and the
+ * cross-reference table into compressed streams (PDF 1.5), and paint
+ * each distinct glyph once into a Form XObject that its repeats in
+ * the document draw from.  Without zlib support, the level only
+ * controls the glyph sharing.
+ *
+ * Identical images, shadings and graphics states are emitted once
+ * at any level.
+ *
+ * XSince: REPLACEME
+ */
+void
+hb_vector_paint_set_pdf_compression_level (hb_vector_paint_t *paint,
+                                           unsigned level)
+{
+  paint->pdf_compression_level = hb_min (level, 9u);
+}
+
+/**
+ * hb_vector_paint_get_pdf_compression_level:
+ * @paint: a paint context.
+ *
+ * Returns the PDF compression level set on @paint.
+ * See hb_vector_paint_set_pdf_compression_level().
+ *
+ * Return value: the compression level.
+ *
+ * XSince: REPLACEME
+ */
+unsigned
+hb_vector_paint_get_pdf_compression_level (const hb_vector_paint_t *paint)
+{
+  return paint->pdf_compression_level;
+}
+
 /**
  * hb_vector_paint_set_precision:
  * @paint: a paint context.
@@ -690,6 +832,10 @@ hb_vector_paint_get_svg_prefix (const hb_vector_paint_t *paint)
  *
  * Sets numeric output precision for paint output.
  *
+ * Numbers are written with at most @precision fractional digits
+ * (up to 12), but never with more digits than it takes to read back
+ * the same single-precision value.
+ *
  * Since: 14.2.0
  */
 void
@@ -748,9 +894,12 @@ hb_vector_paint_clear (hb_vector_paint_t *paint)
   paint->gradient_counter = 0;
   paint->color_glyph_depth = 0;
   paint->path_def_count = 0;
+  paint->image_def_count = 0;
   hb_set_clear (paint->active_color_glyphs);
   paint->color_stops_scratch.clear ();
   paint->captured_scratch.clear ();
+  paint->def_scratch.clear ();
+  paint->svg_reuse.clear ();
 }
 
 
@@ -797,6 +946,8 @@ hb_vector_paint_reset (hb_vector_paint_t *paint)
   paint->foreground = HB_COLOR (0, 0, 0, 255);
   paint->palette = 0;
   paint->set_precision (2);
+  paint->svg_reuse.enabled = false;
+  paint->pdf_compression_level = 0;
   hb_vector_paint_clear (paint);
 }
 
@@ -36,6 +36,38 @@
 #include "hb-vector-path.hh"
 #include "hb-vector-buf.hh"
 #include "hb-vector-internal.hh"
+#include "hb-paint-image-cache.hh"
+#include "hb-vector-svg-reuse.hh"
+
+
+/* Memory budget of the paint image cache, in bytes. */
+#ifndef HB_VECTOR_PAINT_IMAGE_CACHE_SIZE
+#define HB_VECTOR_PAINT_IMAGE_CACHE_SIZE (4u << 20)
+#endif
+
+/* A PNG paint image parsed for PDF embedding, as kept in the image
+ * cache: the IDAT data, passed through as a FlateDecode image, and
+ * for indexed images with tRNS transparency the inflated alpha mask. */
+struct hb_vector_paint_png_t
+{
+  hb_vector_buf_t idat;
+  hb_vector_buf_t plte;
+  hb_vector_buf_t smask;	/* width * height alpha bytes, or empty */
+  unsigned width = 0;
+  unsigned height = 0;
+  unsigned colors = 3;	/* Samples per pixel in idat */
+  bool has_alpha = false;
+
+  size_t size () const
+  { return (size_t) idat.length + plte.length + smask.length; }
+
+  void fini ()
+  {
+    idat.fini ();
+    plte.fini ();
+    smask.fini ();
+  }
+};
 
 
 struct hb_vector_paint_t
@@ -76,10 +108,17 @@ struct hb_vector_paint_t
   unsigned gradient_counter = 0;
   unsigned color_glyph_depth = 0;
   unsigned path_def_count = 0;
+  unsigned image_def_count = 0;
   hb_set_t *active_color_glyphs = nullptr;
   hb_vector_t<hb_color_stop_t> color_stops_scratch;
   hb_vector_buf_t captured_scratch;
+  hb_vector_buf_t def_scratch;
+  /* In PDF output, svg_reuse maps glyphs to their Form XObjects. */
+  hb_vector_svg_reuse_t svg_reuse;
+  unsigned pdf_compression_level = 0;
   hb_blob_t *recycled_blob = nullptr;
+  /* Decoded bitmap images (sbix, CBDT), kept across renders */
+  hb_paint_image_cache_t<hb_vector_paint_png_t> image_cache {HB_VECTOR_PAINT_IMAGE_CACHE_SIZE};
 
   hb_vector_buf_t &current_body () { return group_stack.tail (); }
 
@@ -103,10 +142,19 @@ struct hb_vector_paint_t
     p = hb_min (p, 12u);
     defs.precision = p;
     path.precision = p;
+    def_scratch.precision = p;
+    svg_reuse.reset_glyphs ();
   }
 
   unsigned get_precision () const { return path.precision; }
 
+  /* PDF glyph forms have the colors baked in. */
+  void colors_changed ()
+  {
+    if (format == HB_VECTOR_FORMAT_PDF)
+      svg_reuse.reset_glyphs ();
+  }
+
   bool ensure_initialized ()
   {
     if (group_stack.length)
@@ -132,5 +180,9 @@ HB_INTERNAL hb_blob_t * hb_vector_paint_render_svg (hb_vector_paint_t *paint);
 HB_INTERNAL hb_paint_funcs_t * hb_vector_paint_pdf_funcs_get ();
 HB_INTERNAL hb_blob_t * hb_vector_paint_render_pdf (hb_vector_paint_t *paint);
 HB_INTERNAL void hb_vector_paint_pdf_free_resources (hb_vector_paint_t *paint);
+HB_INTERNAL hb_bool_t hb_vector_paint_pdf_glyph_form (hb_vector_paint_t *paint,
+						      hb_font_t *font,
+						      hb_codepoint_t glyph,
+						      hb_bool_t fallible);
 
 #endif /* HB_VECTOR_PAINT_HH */
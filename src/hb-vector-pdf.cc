@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#include "hb.hh"
+
+#include "hb-vector-pdf.hh"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+
+hb_vector_pdf_writer_t::hb_vector_pdf_writer_t (hb_vector_buf_t *out_,
+						unsigned num_objects,
+						unsigned level_)
+  : out (out_), level (hb_min (level_, 9u))
+{
+#ifndef HAVE_ZLIB
+  level = 0;
+#endif
+  if (unlikely (!entries.resize (num_objects)))
+    successful = false;
+  out->append_str (level ? "%PDF-1.5\n%\xC0\xC1\xC2\xC3\n"
+			 : "%PDF-1.4\n%\xC0\xC1\xC2\xC3\n");
+}
+
+void
+hb_vector_pdf_writer_t::begin_object (unsigned id)
+{
+  entries.arrayZ[id - 1] = {out->length, false};
+  out->append_unsigned (id);
+  out->append_str (" 0 obj\n");
+}
+
+void
+hb_vector_pdf_writer_t::add_object (unsigned id,
+				    const char *data, unsigned length)
+{
+  if (unlikely (!id || id > entries.length))
+  {
+    successful = false;
+    return;
+  }
+
+  if (level)
+  {
+    entries.arrayZ[id - 1] = {object_count++, true};
+    index.append_unsigned (id);
+    index.append_c (' ');
+    index.append_unsigned (objects.length);
+    index.append_c (' ');
+    objects.append_len (data, length);
+    objects.append_c ('\n');
+    return;
+  }
+
+  begin_object (id);
+  out->append_len (data, length);
+  out->append_str ("\nendobj\n");
+}
+
+void
+hb_vector_pdf_writer_t::add_stream (unsigned id,
+				    const char *dict, unsigned dict_length,
+				    const char *data, unsigned length,
+				    const char *data2, unsigned length2,
+				    bool encoded)
+{
+  if (unlikely (!id || id > entries.length))
+  {
+    successful = false;
+    return;
+  }
+
+  begin_object (id);
+  out->append_len (dict, dict_length);
+  if (level && !encoded && encode (data, length, data2, length2))
+  {
+    out->append_str ("/Filter /FlateDecode ");
+    data = scratch.arrayZ;
+    length = scratch.length;
+    data2 = nullptr;
+    length2 = 0;
+  }
+  out->append_str ("/Length ");
+  out->append_unsigned (length + length2);
+  out->append_str (" >>\nstream\n");
+  out->append_len (data, length);
+  out->append_len (data2, length2);
+  /* The end-of-line marker before endstream is not part of the data,
+   * even when the data itself ends in a newline. */
+  out->append_str ("\nendstream\nendobj\n");
+}
+
+bool
+hb_vector_pdf_writer_t::encode (const char *data, unsigned length,
+				const char *data2, unsigned length2)
+{
+#ifndef HAVE_ZLIB
+  return false;
+#else
+  z_stream stream = {};
+  if (deflateInit (&stream, (int) level) != Z_OK)
+    return false;
+  HB_SCOPE_GUARD (deflateEnd (&stream));
+
+  uLong bound = deflateBound (&stream, (uLong) length + length2);
+  if (unlikely (bound > (uLong) INT_MAX / 2 ||
+		!scratch.resize_dirty ((int) bound)))
+    return false;
+
+  stream.next_out = (Bytef *) scratch.arrayZ;
+  stream.avail_out = (uInt) bound;
+  stream.next_in = (Bytef *) data;
+  stream.avail_in = length;
+  int status = ::deflate (&stream, length2 ? Z_NO_FLUSH : Z_FINISH);
+  if (length2 && status == Z_OK)
+  {
+    stream.next_in = (Bytef *) data2;
+    stream.avail_in = length2;
+    status = ::deflate (&stream, Z_FINISH);
+  }
+  if (status != Z_STREAM_END)
+    return false;
+
+  scratch.resize_dirty ((int) stream.total_out);
+  return true;
+#endif
+}
+
+static void
+hb_vector_pdf_append_be (hb_vector_buf_t *buf, uint32_t v, unsigned bytes)
+{
+  char b[4] = {(char) (v >> 24), (char) (v >> 16), (char) (v >> 8), (char) v};
+  buf->append_len (b + 4 - bytes, bytes);
+}
+
+bool
+hb_vector_pdf_writer_t::finish ()
+{
+  if (!level)
+  {
+    unsigned xref_offset = out->length;
+    out->append_str ("xref\n0 ");
+    out->append_unsigned (entries.length + 1);
+    out->append_str ("\n0000000000 65535 f \n");
+    for (const entry_t &e : entries)
+    {
+      char tmp[21];
+      snprintf (tmp, sizeof (tmp), "%010u 00000 n \n", e.offset);
+      out->append_len (tmp, 20);
+    }
+
+    out->append_str ("trailer\n<< /Size ");
+    out->append_unsigned (entries.length + 1);
+    out->append_str (" /Root 1 0 R >>\nstartxref\n");
+    out->append_unsigned (xref_offset);
+    out->append_str ("\n%%EOF\n");
+    return successful && !out->in_error ();
+  }
+
+  hb_vector_buf_t dict;
+  unsigned object_stream_id = 0;
+  if (object_count)
+  {
+    if (unlikely (!entries.push_or_fail ()))
+      return false;
+    object_stream_id = entries.length;
+    dict.append_str ("<< /Type /ObjStm /N ");
+    dict.append_unsigned (object_count);
+    dict.append_str (" /First ");
+    dict.append_unsigned (index.length);
+    dict.append_c (' ');
+    add_stream (object_stream_id, dict.arrayZ, dict.length,
+		index.arrayZ, index.length,
+		objects.arrayZ, objects.length);
+  }
+
+  /* The xref stream: one row of type (1 byte), offset or object
+   * stream number (4 bytes), and generation or index (4 bytes) per
+   * object, itself included. */
+  if (unlikely (!entries.push_or_fail ()))
+    return false;
+  unsigned xref_id = entries.length;
+  unsigned xref_offset = out->length;
+  entries.tail () = {xref_offset, false};
+
+  hb_vector_buf_t rows;
+  rows.alloc (9 * (entries.length + 1));
+  hb_vector_pdf_append_be (&rows, 0, 1);
+  hb_vector_pdf_append_be (&rows, 0, 4);
+  hb_vector_pdf_append_be (&rows, 65535, 4);
+  for (const entry_t &e : entries)
+  {
+    hb_vector_pdf_append_be (&rows, e.in_object_stream ? 2 : 1, 1);
+    hb_vector_pdf_append_be (&rows, e.in_object_stream ? object_stream_id : e.offset, 4);
+    hb_vector_pdf_append_be (&rows, e.in_object_stream ? e.offset : 0, 4);
+  }
+
+  dict.resize (0);
+  dict.append_str ("<< /Type /XRef /Size ");
+  dict.append_unsigned (entries.length + 1);
+  dict.append_str (" /W [1 4 4] /Root 1 0 R ");
+  add_stream (xref_id, dict.arrayZ, dict.length, rows.arrayZ, rows.length);
+
+  out->append_str ("startxref\n");
+  out->append_unsigned (xref_offset);
+  out->append_str ("\n%%EOF\n");
+  return successful && !out->in_error () && !dict.in_error () && !rows.in_error ();
+}
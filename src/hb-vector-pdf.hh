@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_VECTOR_PDF_HH
+#define HB_VECTOR_PDF_HH
+
+#include "hb.hh"
+
+#include "hb-vector-buf.hh"
+
+
+/* hb_vector_pdf_writer_t — lays out the objects of a one-page PDF
+ * file, for the draw and paint renderers.
+ *
+ * Objects are numbered 1..num_objects by the caller and may be added
+ * in any order; object 1 is the catalog.  At compression level 0 this
+ * writes the PDF 1.4 files hb-vector always has: plain streams and an
+ * xref table.  At levels 1-9 (with zlib) stream data is Flate-encoded,
+ * all other objects are packed into one compressed object stream, and
+ * the cross-reference table is an xref stream; that needs PDF 1.5. */
+struct hb_vector_pdf_writer_t
+{
+  hb_vector_pdf_writer_t (hb_vector_buf_t *out,
+			  unsigned num_objects,
+			  unsigned level);
+
+  /* @data is the object's text, e.g. "<< /Type /Page ... >>". */
+  void add_object (unsigned id, const char *data, unsigned length);
+
+  /* @dict is the start of the stream dictionary, with neither /Length
+   * nor the closing ">>"; the stream data is @data followed by @data2.
+   * Pass @encoded for data that is Flate-encoded already (and says so
+   * in @dict), to store it as is. */
+  void add_stream (unsigned id,
+		   const char *dict, unsigned dict_length,
+		   const char *data, unsigned length,
+		   const char *data2 = nullptr, unsigned length2 = 0,
+		   bool encoded = false);
+
+  /* Writes the object stream, the cross-references and the trailer.
+   * Returns false if out of memory. */
+  bool finish ();
+
+  private:
+  struct entry_t
+  {
+    unsigned offset;	/* In the file, or the index in the object stream */
+    bool in_object_stream;
+  };
+
+  bool encode (const char *data, unsigned length,
+	       const char *data2, unsigned length2);
+  void begin_object (unsigned id);
+
+  hb_vector_buf_t *out;
+  unsigned level;
+  hb_vector_t<entry_t> entries;
+  hb_vector_buf_t objects;	/* Object stream body */
+  hb_vector_buf_t index;	/* Object stream header: "id offset ..." */
+  unsigned object_count = 0;
+  hb_vector_buf_t scratch;
+  bool successful = true;
+};
+
+
+#endif /* HB_VECTOR_PDF_HH */
@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_VECTOR_SVG_REUSE_HH
+#define HB_VECTOR_SVG_REUSE_HH
+
+#include "hb.hh"
+
+#include "hb-map.hh"
+#include "hb-vector-buf.hh"
+
+
+/* hb_vector_svg_reuse_t — document-level sharing of SVG definitions,
+ * used by the draw and paint contexts when SVG reuse is enabled.
+ *
+ * Glyph outlines are keyed by (font, font serial, glyph).  Each font
+ * seen is referenced until clear(), so a key's font pointer cannot be
+ * recycled for another font within a document; the serial catches
+ * fonts changed in between (scale, variation coordinates, ...).
+ *
+ * Images are keyed by the bytes their blob points at; the blobs are
+ * referenced until clear() too, which pins those bytes.
+ *
+ * Other definitions (gradients, ...) are keyed by their serialized
+ * content, minus the id. */
+struct hb_vector_svg_reuse_t
+{
+  struct glyph_key_t
+  {
+    const hb_font_t *font;
+    unsigned serial;
+    hb_codepoint_t glyph;
+
+    uint32_t hash () const
+    { return hb_hash ((uintptr_t) font) ^ hb_hash (serial) ^ (glyph * 2654435761u); }
+
+    bool operator == (const glyph_key_t &o) const
+    { return font == o.font && serial == o.serial && glyph == o.glyph; }
+  };
+
+  struct image_key_t
+  {
+    const char *data;
+    unsigned length;
+
+    uint32_t hash () const
+    { return hb_hash ((uintptr_t) data) ^ hb_hash (length); }
+
+    bool operator == (const image_key_t &o) const
+    { return data == o.data && length == o.length; }
+  };
+
+  bool enabled = false;
+  hb_hashmap_t<glyph_key_t, unsigned> glyphs;
+  hb_hashmap_t<image_key_t, unsigned> images;
+  hb_hashmap_t<hb_vector_t<char>, unsigned> defs;
+  hb_vector_t<hb_font_t *> fonts;	/* Referenced */
+  hb_vector_t<hb_blob_t *> blobs;	/* Referenced */
+  hb_vector_t<char> scratch;
+
+  ~hb_vector_svg_reuse_t () { clear (); }
+
+  glyph_key_t glyph_key (hb_font_t *font, hb_codepoint_t glyph)
+  {
+    if (!fonts.length || fonts.tail () != font)
+    {
+      if (!fonts.lfind (font) && fonts.push_or_fail (font))
+	hb_font_reference (font);
+    }
+    return {font, hb_font_get_serial (font), glyph};
+  }
+
+  /* Returns the id recorded for @key, or false. */
+  bool get_glyph (const glyph_key_t &key, unsigned *value) const
+  {
+    const unsigned *v;
+    if (!glyphs.has (key, &v)) return false;
+    *value = *v;
+    return true;
+  }
+
+  void set_glyph (const glyph_key_t &key, unsigned value)
+  { glyphs.set (key, value); }
+
+  bool get_image (hb_blob_t *blob, unsigned *value) const
+  {
+    unsigned length;
+    const char *data = hb_blob_get_data (blob, &length);
+    const unsigned *v;
+    if (!images.has ({data, length}, &v)) return false;
+    *value = *v;
+    return true;
+  }
+
+  void set_image (hb_blob_t *blob, unsigned value)
+  {
+    if (unlikely (!blobs.push_or_fail (blob)))
+      return;
+    hb_blob_reference (blob);
+    unsigned length;
+    const char *data = hb_blob_get_data (blob, &length);
+    images.set ({data, length}, value);
+  }
+
+  /* Looks up a definition by content.  On a miss, records it with
+   * @new_id and returns false. */
+  bool get_def (const char *content, unsigned length,
+		unsigned new_id, unsigned *id)
+  {
+    scratch.resize (0);
+    if (unlikely (!scratch.resize (length)))
+    {
+      *id = new_id;
+      return false;
+    }
+    hb_memcpy (scratch.arrayZ, content, length);
+    const unsigned *v;
+    if (defs.has (scratch, &v))
+    {
+      *id = *v;
+      return true;
+    }
+    *id = new_id;
+    defs.set (std::move (scratch), new_id);
+    return false;
+  }
+
+  /* Forgets glyph outlines, e.g. after a precision change, which
+   * alters the outline data. */
+  void reset_glyphs () { glyphs.clear (); }
+
+  void clear ()
+  {
+    glyphs.clear ();
+    images.clear ();
+    defs.clear ();
+    for (hb_font_t *font : fonts)
+      hb_font_destroy (font);
+    fonts.clear ();
+    for (hb_blob_t *blob : blobs)
+      hb_blob_destroy (blob);
+    blobs.clear ();
+  }
+};
+
+
+#endif /* HB_VECTOR_SVG_REUSE_HH */
@@ -157,6 +157,12 @@ hb_vector_draw_glyph (hb_vector_draw_t *draw,
                       hb_codepoint_t glyph,
                       hb_vector_extents_mode_t extents_mode);
 
+HB_EXTERN void
+hb_vector_draw_buffer (hb_vector_draw_t *draw,
+                       hb_font_t *font,
+                       hb_buffer_t *buffer,
+                       hb_vector_extents_mode_t extents_mode);
+
 HB_EXTERN hb_bool_t
 hb_vector_draw_glyph_or_fail (hb_vector_draw_t *draw,
                               hb_font_t *font,
@@ -170,6 +176,20 @@ hb_vector_draw_set_precision (hb_vector_draw_t *draw,
 HB_EXTERN unsigned
 hb_vector_draw_get_precision (const hb_vector_draw_t *draw);
 
+HB_EXTERN void
+hb_vector_draw_set_svg_reuse (hb_vector_draw_t *draw,
+                              hb_bool_t reuse);
+
+HB_EXTERN hb_bool_t
+hb_vector_draw_get_svg_reuse (const hb_vector_draw_t *draw);
+
+HB_EXTERN void
+hb_vector_draw_set_pdf_compression_level (hb_vector_draw_t *draw,
+                                          unsigned level);
+
+HB_EXTERN unsigned
+hb_vector_draw_get_pdf_compression_level (const hb_vector_draw_t *draw);
+
 HB_EXTERN void
 hb_vector_draw_set_foreground (hb_vector_draw_t *draw,
                                hb_color_t foreground);
@@ -304,6 +324,12 @@ hb_vector_paint_glyph (hb_vector_paint_t *paint,
 		       hb_codepoint_t     glyph,
 		       hb_vector_extents_mode_t extents_mode);
 
+HB_EXTERN void
+hb_vector_paint_buffer (hb_vector_paint_t *paint,
+			hb_font_t         *font,
+			hb_buffer_t       *buffer,
+			hb_vector_extents_mode_t extents_mode);
+
 HB_EXTERN hb_bool_t
 hb_vector_paint_glyph_or_fail (hb_vector_paint_t *paint,
 			       hb_font_t         *font,
@@ -324,6 +350,20 @@ hb_vector_paint_set_svg_prefix (hb_vector_paint_t *paint,
 HB_EXTERN const char *
 hb_vector_paint_get_svg_prefix (const hb_vector_paint_t *paint);
 
+HB_EXTERN void
+hb_vector_paint_set_svg_reuse (hb_vector_paint_t *paint,
+                               hb_bool_t reuse);
+
+HB_EXTERN hb_bool_t
+hb_vector_paint_get_svg_reuse (const hb_vector_paint_t *paint);
+
+HB_EXTERN void
+hb_vector_paint_set_pdf_compression_level (hb_vector_paint_t *paint,
+                                           unsigned level);
+
+HB_EXTERN unsigned
+hb_vector_paint_get_pdf_compression_level (const hb_vector_paint_t *paint);
+
 HB_EXTERN hb_blob_t *
 hb_vector_paint_render (hb_vector_paint_t *paint);
 
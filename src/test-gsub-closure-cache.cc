@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-ot-layout-gsub-table.hh"
+
+#ifdef HB_NO_OPEN
+#define hb_blob_create_from_file_or_fail(x)  hb_blob_get_empty ()
+#endif
+
+static void
+check_closure (hb_face_t                       *face,
+	       const OT::GSUB_closure_cache_t &cache,
+	       const hb_set_t                  &lookups,
+	       const hb_set_t                  &glyphs)
+{
+  hb_set_t expected (glyphs);
+  hb_ot_layout_lookups_substitute_closure (face, &lookups, &expected);
+  hb_always_assert (!expected.in_error ());
+
+  /* The cache is shared between subset plans; closing over the same
+   * input again must not see anything left over from earlier calls. */
+  for (unsigned i = 0; i < 2; i++)
+  {
+    hb_set_t actual (glyphs);
+    cache.closure (face, &lookups, &actual);
+    hb_always_assert (!actual.in_error ());
+    hb_always_assert (actual == expected);
+  }
+}
+
+static void
+test_font (const char *path)
+{
+  hb_blob_t *blob = hb_blob_create_from_file_or_fail (path);
+  hb_always_assert (blob);
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+
+  unsigned num_glyphs = face->get_num_glyphs ();
+  unsigned num_lookups = hb_ot_layout_table_get_lookup_count (face, HB_OT_TAG_GSUB);
+  hb_always_assert (num_glyphs && num_lookups);
+
+  OT::GSUB_closure_cache_t cache (face);
+  hb_always_assert (cache.relations.length == num_lookups);
+
+  hb_set_t all_lookups, even_lookups;
+  all_lookups.add_range (0, num_lookups - 1);
+  for (unsigned i = 0; i < num_lookups; i += 2)
+    even_lookups.add (i);
+
+  const hb_set_t *lookup_sets[] = {&all_lookups, &even_lookups};
+  for (const hb_set_t *lookups : lookup_sets)
+  {
+    hb_set_t glyphs;
+    unsigned step = num_glyphs / 128 + 1;
+
+    for (unsigned gid = 0; gid < num_glyphs; gid += step)
+    {
+      glyphs.clear ();
+      glyphs.add (gid);
+      check_closure (face, cache, *lookups, glyphs);
+    }
+
+    for (unsigned gid = 0; gid < num_glyphs; gid += step * 8)
+    {
+      glyphs.clear ();
+      glyphs.add_range (gid, hb_min (gid + step * 4, num_glyphs - 1));
+      check_closure (face, cache, *lookups, glyphs);
+    }
+
+    glyphs.clear ();
+    glyphs.add_range (0, num_glyphs - 1);
+    check_closure (face, cache, *lookups, glyphs);
+  }
+
+  hb_face_destroy (face);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf (stderr, "usage: %s font-file...\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 1; i < argc; i++)
+    test_font (argv[i]);
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ */
+
+#include "hb.hh"
+#include "hb-raster.hh"
+
+
+/* The span compositors and the bilinear sampler must match the scalar
+ * per-pixel code bit-for-bit, whichever SIMD path they take.  On NEON
+ * the compiler may fuse the scalar float multiply-adds, so the float
+ * kernels are allowed one unit of difference per channel there. */
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t
+rng ()
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint32_t
+random_premul_pixel ()
+{
+  uint32_t r = rng ();
+  unsigned a;
+  switch (r & 3)
+  {
+  case 0: a = 0; break;
+  case 1: a = 255; break;
+  default: a = (r >> 8) & 0xFF; break;
+  }
+  uint8_t b = (uint8_t) ((r >> 16) % (a + 1));
+  uint8_t g = (uint8_t) ((r >> 20) % (a + 1));
+  uint8_t c = (uint8_t) ((r >> 24) % (a + 1));
+  return hb_raster_pack_pixel (b, g, c, (uint8_t) a);
+}
+
+/* Not necessarily premultiplied: color may exceed alpha. */
+static uint32_t
+random_pixel ()
+{
+  uint32_t r = rng ();
+  switch (r & 3)
+  {
+  case 0: return r & 0x00FFFFFFu;
+  case 1: return r | 0xFF000000u;
+  default: return rng ();
+  }
+}
+
+static bool
+float_pixels_match (uint32_t a, uint32_t b)
+{
+#ifdef HB_RASTER_NEON
+  for (unsigned shift = 0; shift < 32; shift += 8)
+  {
+    int d = (int) ((a >> shift) & 0xFF) - (int) ((b >> shift) & 0xFF);
+    if (d < -1 || d > 1)
+      return false;
+  }
+  return true;
+#else
+  return a == b;
+#endif
+}
+
+static uint8_t
+random_coverage ()
+{
+  uint32_t r = rng ();
+  switch (r & 3)
+  {
+  case 0: return 0;
+  case 1: return 255;
+  default: return (uint8_t) (r >> 8);
+  }
+}
+
+static void
+test_span (unsigned count, bool use_mask, bool premul = true)
+{
+  hb_packed_t<uint32_t> src[HB_RASTER_SPAN_LENGTH];
+  hb_packed_t<uint32_t> dst[HB_RASTER_SPAN_LENGTH + 1];
+  uint32_t expected[HB_RASTER_SPAN_LENGTH];
+  uint8_t mask[HB_RASTER_SPAN_LENGTH];
+
+  for (unsigned i = 0; i < count; i++)
+  {
+    src[i] = hb_packed_t<uint32_t> (premul ? random_premul_pixel () : random_pixel ());
+    /* Runs of zero coverage exercise the skipped-chunk path. */
+    mask[i] = (i & 8) ? 0 : random_coverage ();
+    uint32_t d = random_premul_pixel ();
+    /* Misalign the destination by one pixel half of the time. */
+    dst[i + (count & 1)] = hb_packed_t<uint32_t> (d);
+    uint32_t s = (uint32_t) src[i];
+    if (use_mask)
+      s = hb_raster_alpha_mul (s, mask[i]);
+    expected[i] = hb_raster_src_over (s, d);
+  }
+
+  hb_raster_src_over_span (dst + (count & 1), src, use_mask ? mask : nullptr, count);
+
+  for (unsigned i = 0; i < count; i++)
+    hb_always_assert ((uint32_t) dst[i + (count & 1)] == expected[i]);
+}
+
+static void
+test_blend_span (unsigned count, hb_paint_composite_mode_t mode)
+{
+  hb_packed_t<uint32_t> src[HB_RASTER_SPAN_LENGTH];
+  hb_packed_t<uint32_t> dst[HB_RASTER_SPAN_LENGTH];
+  uint32_t expected[HB_RASTER_SPAN_LENGTH];
+
+  for (unsigned i = 0; i < count; i++)
+  {
+    src[i] = hb_packed_t<uint32_t> (random_premul_pixel ());
+    dst[i] = hb_packed_t<uint32_t> (random_premul_pixel ());
+    /* A single pixel takes the scalar path. */
+    hb_packed_t<uint32_t> d = dst[i];
+    hb_always_assert (hb_raster_separable_blend_span (&d, &src[i], 1, mode));
+    expected[i] = (uint32_t) d;
+  }
+
+  hb_always_assert (hb_raster_separable_blend_span (dst, src, count, mode));
+
+  for (unsigned i = 0; i < count; i++)
+    hb_always_assert (float_pixels_match ((uint32_t) dst[i], expected[i]));
+}
+
+/* The scalar formula of hb_raster_sample_bilinear_premul(). */
+static uint32_t
+sample_bilinear_reference (const hb_packed_t<uint32_t> *src,
+			   unsigned width, unsigned height,
+			   float x, float y)
+{
+  int x0 = (int) floorf (x);
+  int y0 = (int) floorf (y);
+  int x1 = hb_min (x0 + 1, (int) width - 1);
+  int y1 = hb_min (y0 + 1, (int) height - 1);
+  float tx = x - x0, ty = y - y0;
+  float w[4] = {(1.f - tx) * (1.f - ty), tx * (1.f - ty), (1.f - tx) * ty, tx * ty};
+  uint32_t p[4] = {(uint32_t) src[y0 * width + x0], (uint32_t) src[y0 * width + x1],
+		   (uint32_t) src[y1 * width + x0], (uint32_t) src[y1 * width + x1]};
+  uint32_t result = 0;
+  for (unsigned shift = 0; shift < 32; shift += 8)
+  {
+    float v = ((p[0] >> shift) & 0xff) * w[0] + ((p[1] >> shift) & 0xff) * w[1] +
+	      ((p[2] >> shift) & 0xff) * w[2] + ((p[3] >> shift) & 0xff) * w[3];
+    result |= (uint32_t) (v + 0.5f) << shift;
+  }
+  return result;
+}
+
+static void
+test_bilinear ()
+{
+  const unsigned width = 7, height = 5;
+  hb_packed_t<uint32_t> image[width * height];
+  for (unsigned i = 0; i < width * height; i++)
+    image[i] = hb_packed_t<uint32_t> (random_premul_pixel ());
+
+  for (unsigned iter = 0; iter < 10000; iter++)
+  {
+    float x = (float) (rng () % 65536) / 65536.f * (width - 1);
+    float y = (float) (rng () % 65536) / 65536.f * (height - 1);
+    if (iter < 4)
+    {
+      /* Corners, where the far texel is clamped. */
+      x = (iter & 1) ? (float) (width - 1) : 0.f;
+      y = (iter & 2) ? (float) (height - 1) : 0.f;
+    }
+    hb_always_assert (float_pixels_match (hb_raster_sample_bilinear_premul (image, width, height, x, y),
+					  sample_bilinear_reference (image, width, height, x, y)));
+  }
+}
+
+int
+main (int argc HB_UNUSED, char **argv HB_UNUSED)
+{
+  /* Exhaustive over source alpha and coverage for a fixed color ratio. */
+  for (unsigned a = 0; a < 256; a++)
+    for (unsigned m = 0; m < 256; m += 3)
+    {
+      hb_packed_t<uint32_t> src[4], dst[4];
+      uint8_t mask[4];
+      uint32_t expected[4];
+      for (unsigned i = 0; i < 4; i++)
+      {
+	uint32_t s = hb_raster_pack_pixel ((uint8_t) (a / (i + 1)), (uint8_t) (a / 2), (uint8_t) a, (uint8_t) a);
+	uint32_t d = hb_raster_pack_pixel ((uint8_t) (i * 60), 128, 255, 255);
+	src[i] = hb_packed_t<uint32_t> (s);
+	dst[i] = hb_packed_t<uint32_t> (d);
+	mask[i] = (uint8_t) m;
+	expected[i] = hb_raster_src_over (hb_raster_alpha_mul (s, m), d);
+      }
+      hb_raster_src_over_span (dst, src, mask, 4);
+      for (unsigned i = 0; i < 4; i++)
+	hb_always_assert ((uint32_t) dst[i] == expected[i]);
+    }
+
+  for (unsigned iter = 0; iter < 2000; iter++)
+  {
+    unsigned count = 1 + rng () % HB_RASTER_SPAN_LENGTH;
+    test_span (count, true);
+    test_span (count, false);
+    test_span (count, true, false);
+    test_span (count, false, false);
+  }
+
+  for (unsigned mode = HB_PAINT_COMPOSITE_MODE_SCREEN;
+       mode <= HB_PAINT_COMPOSITE_MODE_MULTIPLY;
+       mode++)
+    for (unsigned iter = 0; iter < 200; iter++)
+      test_blend_span (1 + rng () % HB_RASTER_SPAN_LENGTH, (hb_paint_composite_mode_t) mode);
+  hb_always_assert (!hb_raster_separable_blend_span (nullptr, nullptr, 0, HB_PAINT_COMPOSITE_MODE_HSL_HUE));
+
+  test_bilinear ();
+
+  return 0;
+}
@@ -2012,6 +2012,38 @@ static void test_duplicate_interior ()
   free (buffer);
 }
 
+static void test_duplicate_updates_distances ()
+{
+  size_t buffer_size = 100;
+  void* buffer = malloc (buffer_size);
+  hb_serialize_context_t c (buffer, buffer_size);
+  populate_serializer_complex_2 (&c);
+
+  // Each 16 bit link costs 65536 plus the size of the child:
+  // mn = 2, jkl = 3, ghi = 5, def = 5.
+  graph_t graph (c.object_graph ());
+  graph.sort_shortest_distance ();
+  hb_always_assert (graph.vertices_[1].distance == 65536 + 3);
+  hb_always_assert (graph.vertices_[2].distance == (65536 + 5) * 2);
+
+  // Move abc's link to jkl onto a copy, leaving jkl reachable only through ghi.
+  hb_set_t parents;
+  parents.add (4);
+  hb_always_assert (graph.duplicate (&parents, 1) == 5);
+  graph.sort_shortest_distance ();
+  hb_always_assert (!graph.in_error ());
+
+  hb_always_assert (graph.stats.full_distance_updates == 1);
+  hb_always_assert (graph.stats.incremental_distance_updates == 1);
+  hb_always_assert (graph.vertices_[4].distance == 0);
+  hb_always_assert (graph.vertices_[0].distance == 65536 + 2);
+  hb_always_assert (graph.vertices_[5].distance == 65536 + 3);
+  hb_always_assert (graph.vertices_[2].distance == (65536 + 5) * 2);
+  hb_always_assert (graph.vertices_[1].distance == (65536 + 5) * 2 + 65536 + 3);
+
+  free (buffer);
+}
+
 static void
 test_serialize ()
 {
@@ -2120,6 +2152,24 @@ static void test_resolve_overflows_via_multiple_duplications ()
   hb_blob_destroy (out);
 }
 
+static void test_resolve_overflows_stats ()
+{
+  size_t buffer_size = 300000;
+  void* buffer = malloc (buffer_size);
+  hb_serialize_context_t c (buffer, buffer_size);
+  populate_serializer_with_multiple_dedup_overflow (&c);
+  graph_t graph (c.object_graph ());
+
+  hb_always_assert (hb_resolve_graph_overflows (HB_TAG_NONE, 5, false, graph));
+  hb_always_assert (graph.stats.rounds);
+  hb_always_assert (graph.stats.iterations >= graph.stats.rounds);
+  hb_always_assert (graph.stats.duplications);
+  hb_always_assert (graph.stats.incremental_distance_updates == graph.stats.duplications);
+  hb_always_assert (graph.stats.full_distance_updates == 1);
+
+  free (buffer);
+}
+
 static void test_resolve_overflows_via_space_assignment ()
 {
   size_t buffer_size = 160000;
@@ -2866,6 +2916,7 @@ main (int argc, char **argv)
   test_resolve_overflows_via_sort ();
   test_resolve_overflows_via_duplication ();
   test_resolve_overflows_via_multiple_duplications ();
+  test_resolve_overflows_stats ();
   test_resolve_overflows_via_priority ();
   test_resolve_overflows_via_space_assignment ();
   test_resolve_overflows_via_isolation ();
@@ -2878,6 +2929,7 @@ main (int argc, char **argv)
   test_resolve_mixed_overflows_via_isolation_spaces ();
   test_duplicate_leaf ();
   test_duplicate_interior ();
+  test_duplicate_updates_distances ();
   test_virtual_link ();
   test_repack_last();
   test_shared_node_with_virtual_links ();
@@ -476,4 +476,31 @@ main (int argc, char **argv)
     hb_always_assert (out[0].first == 1.0);
     hb_always_assert (approx (out[0].second, Triple (0.5, 0.625, 0.75)));
   }
+
+  /* Memoized */
+  {
+    Triple tent (0.0, 1.0, 1.0);
+    Triple axis_range (-1.0, 0.0, 0.5);
+    rebase_tent_result_t expected, out, scratch;
+    rebase_tent (tent, axis_range, default_axis_distances, expected, scratch);
+
+    rebase_tent_cache_t cache;
+    for (unsigned i = 0; i < 3; i++)
+    {
+      cache.rebase_tent (tent, axis_range, default_axis_distances, out, scratch);
+      hb_always_assert (out.length == expected.length);
+      for (unsigned j = 0; j < out.length; j++)
+      {
+        hb_always_assert (out[j].first == expected[j].first);
+        hb_always_assert (out[j].second == expected[j].second);
+      }
+    }
+    hb_always_assert (cache.get_misses () == 1);
+    hb_always_assert (cache.get_hits () == 2);
+
+    /* Different distances are a different key. */
+    TripleDistances axis_distances{2.0, 1.0};
+    cache.rebase_tent (tent, axis_range, axis_distances, out, scratch);
+    hb_always_assert (cache.get_misses () == 2);
+  }
 }
@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ */
+
+#include "hb.hh"
+#include "hb-vector-num.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static void
+check_fixed (float v, unsigned precision, const char *expected)
+{
+  char buf[HB_VECTOR_NUM_MAX_LENGTH + 1];
+  unsigned len = hb_vector_num_fixed (v, precision, buf);
+  buf[len] = '\0';
+  if (strcmp (buf, expected))
+  {
+    fprintf (stderr, "fixed (%.9g, %u): got %s, expected %s\n",
+	     (double) v, precision, buf, expected);
+    abort ();
+  }
+}
+
+static void
+check_shortest (float v, const char *expected)
+{
+  char buf[HB_VECTOR_NUM_MAX_LENGTH + 1];
+  unsigned len = hb_vector_num_shortest (v, buf);
+  buf[len] = '\0';
+  if (strcmp (buf, expected))
+  {
+    fprintf (stderr, "shortest (%.9g): got %s, expected %s\n",
+	     (double) v, buf, expected);
+    abort ();
+  }
+}
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t
+rng ()
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+/* Significant digits of a decimal number, without sign, decimal point,
+ * exponent, and leading or trailing zeros. */
+static void
+significant_digits (const char *s, char *digits)
+{
+  char *p = digits;
+  for (; *s && *s != 'e'; s++)
+    if (*s >= '0' && *s <= '9' && (p != digits || *s != '0'))
+      *p++ = *s;
+  while (p > digits && p[-1] == '0')
+    p--;
+  *p = '\0';
+}
+
+/* The shortest output has no more digits than the shortest correctly
+ * rounded "%.pe" that reads back, and the same digits if as long. */
+static void
+check_shortest_length (float v, const char *buf)
+{
+  char reference[32];
+  for (int p = 0; p < 9; p++)
+  {
+    snprintf (reference, sizeof (reference), "%.*e", p, (double) v);
+    if (strtof (reference, nullptr) == v)
+      break;
+  }
+
+  char got[64], expected[32];
+  significant_digits (buf, got);
+  significant_digits (reference, expected);
+  if (strlen (got) > strlen (expected) ||
+      (strlen (got) == strlen (expected) && strcmp (got, expected)))
+  {
+    fprintf (stderr, "shortest (%.9g): got %s, expected digits %s\n",
+	     (double) v, buf, expected);
+    abort ();
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  check_fixed (0.f, 2, "0");
+  check_fixed (-0.f, 2, "0");
+  check_fixed (-0.004f, 2, "0");
+  check_fixed (1.f, 2, "1");
+  check_fixed (-1.5f, 2, "-1.5");
+  check_fixed (0.125f, 2, "0.12");
+  check_fixed (0.375f, 2, "0.38");
+  check_fixed (1234.5678f, 2, "1234.57");
+  check_fixed (1234.5678f, 0, "1235");
+  check_fixed (0.015625f, 7, "0.015625");
+  check_fixed (1.f / 3.f, 7, "0.3333333");
+  check_fixed (100.f, 12, "100");
+  check_fixed (0.1f, 12, "0.1");
+  check_fixed (1234567.875f, 2, "1234567.9");
+  check_fixed (16777216.f, 2, "16777216");
+  check_fixed (1e20f, 2, "100000000000000000000");
+  check_fixed (INFINITY, 2, "0");
+  check_fixed (NAN, 2, "0");
+
+  check_shortest (0.f, "0");
+  check_shortest (0.1f, "0.1");
+  check_shortest (-2.5f, "-2.5");
+  check_shortest (1.f / 3.f, "0.33333334");
+  check_shortest (123456.7f, "123456.7");
+  check_shortest (3.4028235e38f, "340282350000000000000000000000000000000");
+  check_shortest (1e-45f, "0.000000000000000000000000000000000000000000001");
+  check_shortest (1.17549435e-38f, "0.000000000000000000000000000000000000011754944");
+
+  /* Where the float holds the requested digits, fixed output is that
+   * of "%.pf" with trailing zeros removed; shortest output always
+   * reads back exactly, with no more digits than needed. */
+  for (unsigned i = 0; i < 1000000; i++)
+  {
+    uint32_t bits = rng ();
+    float v;
+    hb_memcpy (&v, &bits, sizeof (v));
+    if (!std::isfinite (v))
+      continue;
+    unsigned precision = i % 13;
+    int exp;
+    v = ldexpf (frexpf (v, &exp), (int) (i % 40) - 16);
+
+    char buf[HB_VECTOR_NUM_MAX_LENGTH + 1];
+    unsigned len = hb_vector_num_shortest (v, buf);
+    buf[len] = '\0';
+    hb_always_assert (strtof (buf, nullptr) == v);
+    check_shortest_length (v, buf);
+
+    if (!(fabs ((double) v) * _hb_vector_num_pow10[precision] < 8388608.))
+      continue;
+    char expected[64];
+    snprintf (expected, sizeof (expected), "%.*f", (int) precision, (double) v);
+    char *dot = strchr (expected, '.');
+    if (dot)
+    {
+      char *end = expected + strlen (expected) - 1;
+      while (end > dot && *end == '0')
+	*end-- = '\0';
+      if (end == dot)
+	*end = '\0';
+    }
+    check_fixed (v, precision, strcmp (expected, "-0") ? expected : "0");
+  }
+
+  return 0;
+}
@@ -31,6 +31,7 @@
 
 #define FONT_FILE      "fonts/Roboto-Regular.abc.ttf"
 #define COLR_FONT_FILE "fonts/test_glyphs-glyf_colr_1.ttf"
+#define VAR_FONT_FILE  "fonts/Roboto-Variable.abc.ttf"
 
 struct hb_gpu_test_texel_t
 {
@@ -400,6 +401,79 @@ test_encode_band_membership (void)
   hb_face_destroy (face);
 }
 
+static void
+test_encode_texel_budget (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  g_assert_nonnull (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 128, 128);
+
+  hb_gpu_draw_t *draw = hb_gpu_draw_create_or_fail ();
+  g_assert_nonnull (draw);
+  g_assert_cmpuint (hb_gpu_draw_get_texel_budget (draw), ==, 0);
+
+  unsigned glyph_count = hb_face_get_glyph_count (face);
+  for (hb_codepoint_t gid = 0; gid < glyph_count; gid++)
+  {
+    hb_gpu_draw_encode_stats_t fixed, adaptive, small;
+
+    hb_gpu_draw_set_texel_budget (draw, 0);
+    hb_gpu_draw_glyph (draw, font, gid);
+    hb_blob_t *blob = hb_gpu_draw_encode (draw, nullptr);
+    g_assert_nonnull (blob);
+    hb_gpu_draw_get_encode_stats (draw, &fixed);
+    g_assert_cmpuint (fixed.texel_count * 8, ==, hb_blob_get_length (blob));
+    hb_blob_destroy (blob);
+
+    /* Unconstrained: never worse per pixel than the fixed layout. */
+    hb_gpu_draw_set_texel_budget (draw, 65536);
+    hb_gpu_draw_glyph (draw, font, gid);
+    blob = hb_gpu_draw_encode (draw, nullptr);
+    g_assert_nonnull (blob);
+    assert_band_membership (blob);
+    hb_gpu_draw_get_encode_stats (draw, &adaptive);
+    g_assert_cmpuint (adaptive.texel_count * 8, ==, hb_blob_get_length (blob));
+    g_assert_cmpuint (adaptive.max_hband_curves + adaptive.max_vband_curves, <=,
+		      fixed.max_hband_curves + fixed.max_vband_curves);
+    hb_blob_destroy (blob);
+
+    /* Budget too small for anything: smallest layout. */
+    hb_gpu_draw_set_texel_budget (draw, 1);
+    hb_gpu_draw_glyph (draw, font, gid);
+    blob = hb_gpu_draw_encode (draw, nullptr);
+    g_assert_nonnull (blob);
+    assert_band_membership (blob);
+    hb_gpu_draw_get_encode_stats (draw, &small);
+    g_assert_cmpuint (small.texel_count, <=, fixed.texel_count);
+    g_assert_cmpuint (small.texel_count, <=, adaptive.texel_count);
+    hb_blob_destroy (blob);
+
+    if (!fixed.texel_count)
+      continue;
+
+    g_assert_cmpuint (fixed.num_hbands, >, 0);
+    g_assert_cmpuint (fixed.num_vbands, >, 0);
+    g_assert_cmpfloat (fixed.mean_hband_curves, <=, fixed.max_hband_curves);
+    g_assert_cmpfloat (fixed.mean_vband_curves, <=, fixed.max_vband_curves);
+  }
+
+  hb_gpu_draw_reset (draw);
+  g_assert_cmpuint (hb_gpu_draw_get_texel_budget (draw), ==, 0);
+
+  /* Failed or empty encodes report zeros. */
+  hb_blob_t *blob = hb_gpu_draw_encode (draw, nullptr);
+  hb_gpu_draw_encode_stats_t stats;
+  hb_gpu_draw_get_encode_stats (draw, &stats);
+  g_assert_cmpuint (stats.texel_count, ==, 0);
+  g_assert_cmpuint (stats.num_hbands, ==, 0);
+  hb_blob_destroy (blob);
+
+  hb_gpu_draw_destroy (draw);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 static void
 test_extents_saturate_overflow (void)
 {
@@ -825,6 +899,503 @@ test_shapes (void)
 }
 
 
+/* A blob of @texels texels, each filled with @fill. */
+static hb_blob_t *
+atlas_test_blob (unsigned texels, char fill)
+{
+  unsigned length = texels * sizeof (hb_gpu_test_texel_t);
+  char *data = (char *) malloc (length ? length : 1);
+  memset (data, fill, length);
+  return hb_blob_create (data, length, HB_MEMORY_MODE_WRITABLE, data, free);
+}
+
+static hb_bool_t
+atlas_test_add (hb_gpu_atlas_t *atlas,
+		hb_font_t      *font,
+		hb_codepoint_t  glyph,
+		unsigned        texels,
+		unsigned       *offset)
+{
+  hb_blob_t *blob = atlas_test_blob (texels, (char) glyph);
+  hb_bool_t ret = hb_gpu_atlas_add (atlas, font, glyph, blob, nullptr, offset);
+  hb_blob_destroy (blob);
+  return ret;
+}
+
+static hb_bool_t
+atlas_test_has_data (hb_gpu_atlas_t *atlas,
+		     unsigned        offset,
+		     unsigned        texels,
+		     char            fill)
+{
+  unsigned length;
+  const char *data = hb_gpu_atlas_get_data (atlas, &length);
+  unsigned start = offset * sizeof (hb_gpu_test_texel_t);
+  unsigned end = (offset + texels) * sizeof (hb_gpu_test_texel_t);
+  if (end > length)
+    return false;
+  for (unsigned i = start; i < end; i++)
+    if (data[i] != fill)
+      return false;
+  return true;
+}
+
+static void
+test_atlas_create_destroy (void)
+{
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1024);
+  g_assert_nonnull (atlas);
+  g_assert_cmpuint (hb_gpu_atlas_get_capacity (atlas), ==, 1024);
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 0);
+
+  hb_gpu_atlas_t *ref = hb_gpu_atlas_reference (atlas);
+  g_assert_true (ref == atlas);
+  hb_gpu_atlas_destroy (ref);
+
+  /* Nothing is allocated until glyphs are added. */
+  unsigned length;
+  hb_gpu_atlas_get_data (atlas, &length);
+  g_assert_cmpuint (length, ==, 0);
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 0, nullptr, nullptr), ==, 0);
+
+  hb_gpu_atlas_destroy (atlas);
+
+  g_assert_null (hb_gpu_atlas_create_or_fail (G_MAXUINT));
+}
+
+static void
+test_atlas_add_lookup (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1024);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  hb_glyph_extents_t ext;
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 1, &offset, &ext));
+
+  hb_glyph_extents_t in_ext = {1, 2, 3, -4};
+  hb_blob_t *blob = atlas_test_blob (10, 1);
+  g_assert_true (hb_gpu_atlas_add (atlas, font, 1, blob, &in_ext, &offset));
+  hb_blob_destroy (blob);
+  g_assert_cmpuint (offset, ==, 0);
+  g_assert_true (atlas_test_add (atlas, font, 2, 20, &offset));
+  g_assert_cmpuint (offset, ==, 10);
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 30);
+
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, &offset, &ext));
+  g_assert_cmpuint (offset, ==, 0);
+  g_assert_cmpint (ext.x_bearing, ==, 1);
+  g_assert_cmpint (ext.height, ==, -4);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 2, &offset, nullptr));
+  g_assert_cmpuint (offset, ==, 10);
+  g_assert_true (atlas_test_has_data (atlas, 0, 10, 1));
+  g_assert_true (atlas_test_has_data (atlas, 10, 20, 2));
+
+  /* Empty glyphs take no room. */
+  g_assert_true (atlas_test_add (atlas, font, 3, 0, &offset));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 3, nullptr, nullptr));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 30);
+
+  /* Blobs must be whole texels. */
+  blob = hb_blob_create ("abc", 3, HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+  g_assert_false (hb_gpu_atlas_add (atlas, font, 4, blob, nullptr, &offset));
+  hb_blob_destroy (blob);
+
+  /* Too big to ever fit. */
+  g_assert_false (atlas_test_add (atlas, font, 5, 2000, &offset));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+
+  /* Replacing an entry. */
+  unsigned serial = hb_gpu_atlas_get_serial (atlas);
+  g_assert_true (atlas_test_add (atlas, font, 1, 5, &offset));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 25);
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), !=, serial);
+
+  hb_gpu_atlas_clear (atlas);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 2, nullptr, nullptr));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 0);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_font_instances (void)
+{
+  hb_face_t *face = hb_test_open_font_file (VAR_FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *other = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1024);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  g_assert_true (atlas_test_add (atlas, font, 1, 4, &offset));
+  g_assert_false (hb_gpu_atlas_lookup (atlas, other, 1, nullptr, nullptr));
+
+  /* Entries are keyed by scale and variations as well as font. */
+  int x_scale, y_scale;
+  hb_font_get_scale (font, &x_scale, &y_scale);
+  hb_font_set_scale (font, x_scale * 2, y_scale * 2);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+  g_assert_true (atlas_test_add (atlas, font, 1, 4, &offset));
+  g_assert_cmpuint (offset, ==, 4);
+
+  hb_font_set_scale (font, x_scale, y_scale);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, &offset, nullptr));
+  g_assert_cmpuint (offset, ==, 0);
+
+  int coords[1] = {8192};
+  hb_font_set_var_coords_normalized (font, coords, 1);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+  hb_font_set_var_coords_normalized (font, nullptr, 0);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (other);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_eviction (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (100);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  for (unsigned g = 1; g <= 4; g++)
+    g_assert_true (atlas_test_add (atlas, font, g, 25, &offset));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 100);
+
+  /* Everything is in use by the current frame. */
+  unsigned serial = hb_gpu_atlas_get_serial (atlas);
+  g_assert_false (atlas_test_add (atlas, font, 5, 25, &offset));
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), ==, serial);
+
+  /* Next frame: the least recently used glyph goes. */
+  hb_gpu_atlas_clear_dirty (atlas);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+  g_assert_true (atlas_test_add (atlas, font, 5, 25, &offset));
+  g_assert_cmpuint (offset, ==, 25);
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), !=, serial);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 2, nullptr, nullptr));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+  g_assert_true (atlas_test_has_data (atlas, 25, 25, 5));
+
+  /* Glyphs used this frame survive; 3 and 4 make room for 6. */
+  g_assert_true (atlas_test_add (atlas, font, 6, 50, &offset));
+  g_assert_cmpuint (offset, ==, 50);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 3, nullptr, nullptr));
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, 4, nullptr, nullptr));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 5, nullptr, nullptr));
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_compaction (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (100);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  for (unsigned g = 1; g <= 5; g++)
+    g_assert_true (atlas_test_add (atlas, font, g, 20, &offset));
+
+  /* Free 2 and 4, leaving two holes of 20; then ask for 40. */
+  hb_gpu_atlas_clear_dirty (atlas);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, nullptr, nullptr));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 3, nullptr, nullptr));
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 5, nullptr, nullptr));
+  g_assert_true (atlas_test_add (atlas, font, 2, 0, &offset));
+  g_assert_true (atlas_test_add (atlas, font, 4, 0, &offset));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, 60);
+
+  unsigned serial = hb_gpu_atlas_get_serial (atlas);
+  g_assert_true (atlas_test_add (atlas, font, 6, 40, &offset));
+  g_assert_cmpuint (offset, ==, 60);
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), !=, serial);
+
+  /* Survivors moved down, in order, with their data. */
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 1, &offset, nullptr));
+  g_assert_cmpuint (offset, ==, 0);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 3, &offset, nullptr));
+  g_assert_cmpuint (offset, ==, 20);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 5, &offset, nullptr));
+  g_assert_cmpuint (offset, ==, 40);
+  g_assert_true (atlas_test_has_data (atlas, 0, 20, 1));
+  g_assert_true (atlas_test_has_data (atlas, 20, 20, 3));
+  g_assert_true (atlas_test_has_data (atlas, 40, 20, 5));
+  g_assert_true (atlas_test_has_data (atlas, 60, 40, 6));
+
+  /* Everything moved needs uploading. */
+  hb_gpu_atlas_range_t ranges[4];
+  unsigned count = 4;
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 0, &count, ranges), ==, 1);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (ranges[0].offset, ==, 0);
+  g_assert_cmpuint (ranges[0].length, ==, 100);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_dirty_ranges (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1000);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  for (unsigned g = 1; g <= 4; g++)
+    g_assert_true (atlas_test_add (atlas, font, g, 10, &offset));
+
+  /* Adjacent writes coalesce. */
+  hb_gpu_atlas_range_t ranges[4];
+  unsigned count = 4;
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 0, &count, ranges), ==, 1);
+  g_assert_cmpuint (ranges[0].offset, ==, 0);
+  g_assert_cmpuint (ranges[0].length, ==, 40);
+
+  hb_gpu_atlas_clear_dirty (atlas);
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 0, nullptr, nullptr), ==, 0);
+
+  /* Refill two holes; the ranges come back sorted. */
+  g_assert_true (atlas_test_add (atlas, font, 3, 0, &offset));
+  g_assert_true (atlas_test_add (atlas, font, 1, 0, &offset));
+  g_assert_true (atlas_test_add (atlas, font, 5, 5, &offset));
+  g_assert_cmpuint (offset, ==, 0);
+  g_assert_true (atlas_test_add (atlas, font, 6, 10, &offset));
+  g_assert_cmpuint (offset, ==, 20);
+  g_assert_true (atlas_test_add (atlas, font, 7, 5, &offset));
+  g_assert_cmpuint (offset, ==, 5);
+
+  count = 1;
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 0, &count, ranges), ==, 2);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (ranges[0].offset, ==, 0);
+  g_assert_cmpuint (ranges[0].length, ==, 10);
+  count = 4;
+  g_assert_cmpuint (hb_gpu_atlas_get_dirty_ranges (atlas, 1, &count, ranges), ==, 2);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (ranges[0].offset, ==, 20);
+  g_assert_cmpuint (ranges[0].length, ==, 10);
+
+  /* Too many ranges collapse into one. */
+  hb_gpu_atlas_clear_dirty (atlas);
+  for (unsigned g = 100; g < 300; g++)
+    g_assert_true (atlas_test_add (atlas, font, g, 1, &offset));
+  for (unsigned g = 100; g < 300; g += 2)
+    g_assert_true (atlas_test_add (atlas, font, g, 0, &offset));
+  hb_gpu_atlas_clear_dirty (atlas);
+  for (unsigned g = 300; g < 400; g++)
+    g_assert_true (atlas_test_add (atlas, font, g, 1, &offset));
+  unsigned total = hb_gpu_atlas_get_dirty_ranges (atlas, 0, nullptr, nullptr);
+  g_assert_cmpuint (total, <=, 64);
+  count = 1;
+  hb_gpu_atlas_get_dirty_ranges (atlas, 0, &count, ranges);
+  g_assert_cmpuint (ranges[0].offset, ==, 40);
+  g_assert_cmpuint (ranges[0].length, >, 1);
+  count = 1;
+  hb_gpu_atlas_get_dirty_ranges (atlas, total - 1, &count, ranges);
+  g_assert_cmpuint (ranges[0].offset + ranges[0].length, ==, 239);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_draw_glyph (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  hb_gpu_draw_t *draw = hb_gpu_draw_create_or_fail ();
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1 << 16);
+  g_assert_nonnull (atlas);
+
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'a', &gid));
+
+  unsigned offset;
+  hb_glyph_extents_t ext;
+  g_assert_true (hb_gpu_atlas_draw_glyph (atlas, draw, font, gid, &offset, &ext));
+  g_assert_cmpint (ext.width, >, 0);
+  unsigned used = hb_gpu_atlas_get_used (atlas);
+  g_assert_cmpuint (used, >, 0);
+
+  /* Matches a direct encode. */
+  hb_gpu_draw_glyph (draw, font, gid);
+  hb_blob_t *blob = hb_gpu_draw_encode (draw, nullptr);
+  g_assert_cmpuint (hb_blob_get_length (blob), ==, used * sizeof (hb_gpu_test_texel_t));
+  unsigned length;
+  const char *data = hb_gpu_atlas_get_data (atlas, &length);
+  g_assert_true (0 == memcmp (data + offset * sizeof (hb_gpu_test_texel_t),
+			      hb_blob_get_data (blob, nullptr),
+			      hb_blob_get_length (blob)));
+  hb_blob_destroy (blob);
+
+  /* Second time is a hit. */
+  hb_glyph_extents_t ext2;
+  unsigned offset2;
+  g_assert_true (hb_gpu_atlas_draw_glyph (atlas, draw, font, gid, &offset2, &ext2));
+  g_assert_cmpuint (offset2, ==, offset);
+  g_assert_cmpint (ext2.width, ==, ext.width);
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), ==, used);
+
+  /* Synthetic bold and slant change the outline, so they get entries
+   * of their own. */
+  hb_font_set_synthetic_bold (font, .1f, .1f, false);
+  hb_glyph_extents_t bold_ext;
+  g_assert_true (hb_font_get_glyph_extents (font, gid, &bold_ext));
+  g_assert_cmpint (bold_ext.width, >, ext.width);
+  g_assert_true (hb_gpu_atlas_draw_glyph (atlas, draw, font, gid, &offset2, &ext2));
+  g_assert_cmpuint (offset2, !=, offset);
+  g_assert_cmpint (ext2.width, ==, bold_ext.width);
+
+  hb_font_set_synthetic_bold (font, .1f, .1f, true);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, gid, nullptr, nullptr));
+  hb_font_set_synthetic_bold (font, 0.f, 0.f, false);
+  hb_font_set_synthetic_slant (font, .2f);
+  g_assert_false (hb_gpu_atlas_lookup (atlas, font, gid, nullptr, nullptr));
+
+  hb_font_set_synthetic_slant (font, 0.f);
+  g_assert_true (hb_gpu_atlas_draw_glyph (atlas, draw, font, gid, &offset2, &ext2));
+  g_assert_cmpuint (offset2, ==, offset);
+  g_assert_cmpint (ext2.width, ==, ext.width);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_gpu_draw_destroy (draw);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_paint_glyph (void)
+{
+  hb_face_t *face = hb_test_open_font_file (COLR_FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  hb_gpu_paint_t *paint = hb_gpu_paint_create_or_fail ();
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail (1 << 16);
+  g_assert_nonnull (atlas);
+
+  unsigned offset;
+  g_assert_true (hb_gpu_atlas_paint_glyph (atlas, paint, font, 10, &offset, nullptr));
+  g_assert_cmpuint (hb_gpu_atlas_get_used (atlas), >, 0);
+  g_assert_true (hb_gpu_atlas_lookup (atlas, font, 10, nullptr, nullptr));
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_gpu_paint_destroy (paint);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+
+static void
+test_glyphs_roundtrip (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  unsigned glyph_count = hb_face_get_glyph_count (face);
+  hb_gpu_draw_t *draw = hb_gpu_draw_create_or_fail ();
+
+  hb_gpu_glyphs_t *glyphs = hb_gpu_glyphs_create_or_fail (glyph_count + 1);
+  g_assert_nonnull (glyphs);
+  g_assert_cmpuint (hb_gpu_glyphs_get_glyph_count (glyphs), ==, glyph_count + 1);
+
+  for (unsigned gid = 0; gid < glyph_count; gid++)
+  {
+    hb_glyph_extents_t ext;
+    hb_gpu_draw_glyph (draw, font, gid);
+    hb_blob_t *blob = hb_gpu_draw_encode (draw, &ext);
+    g_assert_true (hb_gpu_glyphs_set_glyph (glyphs, gid, blob, &ext));
+    hb_blob_destroy (blob);
+  }
+  /* The last glyph repeats the first; it is stored once. */
+  hb_blob_t *first = hb_gpu_glyphs_reference_glyph_blob (glyphs, 1);
+  g_assert_cmpuint (hb_blob_get_length (first), >, 0);
+  g_assert_true (hb_gpu_glyphs_set_glyph (glyphs, glyph_count, first, nullptr));
+
+  g_assert_false (hb_gpu_glyphs_set_glyph (glyphs, glyph_count + 1, first, nullptr));
+  hb_blob_t *odd = hb_blob_create ("abc", 3, HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+  g_assert_false (hb_gpu_glyphs_set_glyph (glyphs, 0, odd, nullptr));
+  hb_blob_destroy (odd);
+
+  hb_blob_t *serialized = hb_gpu_glyphs_serialize (glyphs);
+  g_assert_nonnull (serialized);
+
+  hb_gpu_glyphs_t *loaded = hb_gpu_glyphs_create_for_blob_or_fail (serialized);
+  g_assert_nonnull (loaded);
+  g_assert_cmpuint (hb_gpu_glyphs_get_glyph_count (loaded), ==, glyph_count + 1);
+  g_assert_false (hb_gpu_glyphs_set_glyph (loaded, 0, first, nullptr));
+
+  unsigned data_length;
+  const char *data = hb_gpu_glyphs_get_data (loaded, &data_length);
+  for (unsigned gid = 0; gid <= glyph_count; gid++)
+  {
+    unsigned offset, length;
+    hb_glyph_extents_t ext, loaded_ext;
+    g_assert_true (hb_gpu_glyphs_get_glyph (glyphs, gid, nullptr, nullptr, &ext));
+    g_assert_true (hb_gpu_glyphs_get_glyph (loaded, gid, &offset, &length, &loaded_ext));
+    g_assert_cmpint (ext.x_bearing, ==, loaded_ext.x_bearing);
+    g_assert_cmpint (ext.height, ==, loaded_ext.height);
+
+    hb_blob_t *a = hb_gpu_glyphs_reference_glyph_blob (glyphs, gid);
+    hb_blob_t *b = hb_gpu_glyphs_reference_glyph_blob (loaded, gid);
+    g_assert_cmpuint (hb_blob_get_length (a), ==, hb_blob_get_length (b));
+    g_assert_cmpuint (length * sizeof (hb_gpu_test_texel_t), ==, hb_blob_get_length (b));
+    g_assert_cmpuint ((offset + length) * sizeof (hb_gpu_test_texel_t), <=, data_length);
+    if (length)
+    {
+      g_assert_true (0 == memcmp (hb_blob_get_data (a, nullptr),
+				  hb_blob_get_data (b, nullptr),
+				  hb_blob_get_length (a)));
+      g_assert_true (hb_blob_get_data (b, nullptr) ==
+		     data + offset * sizeof (hb_gpu_test_texel_t));
+    }
+    hb_blob_destroy (a);
+    hb_blob_destroy (b);
+  }
+
+  unsigned first_offset, last_offset;
+  hb_gpu_glyphs_get_glyph (loaded, 1, &first_offset, nullptr, nullptr);
+  hb_gpu_glyphs_get_glyph (loaded, glyph_count, &last_offset, nullptr, nullptr);
+  g_assert_cmpuint (first_offset, ==, last_offset);
+
+  g_assert_false (hb_gpu_glyphs_get_glyph (loaded, glyph_count + 1, nullptr, nullptr, nullptr));
+
+  /* Truncated data is rejected. */
+  hb_blob_t *truncated = hb_blob_create_sub_blob (serialized, 0, hb_blob_get_length (serialized) - 1);
+  g_assert_null (hb_gpu_glyphs_create_for_blob_or_fail (truncated));
+  hb_blob_destroy (truncated);
+  g_assert_null (hb_gpu_glyphs_create_for_blob_or_fail (hb_blob_get_empty ()));
+
+  hb_gpu_glyphs_destroy (loaded);
+  hb_blob_destroy (serialized);
+  hb_blob_destroy (first);
+  hb_gpu_glyphs_destroy (glyphs);
+  hb_gpu_draw_destroy (draw);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -840,6 +1411,7 @@ main (int argc, char **argv)
   hb_test_add (test_encode_preserves_touching_contours);
   hb_test_add (test_recycle_blob);
   hb_test_add (test_encode_band_membership);
+  hb_test_add (test_encode_texel_budget);
   hb_test_add (test_extents_saturate_overflow);
   hb_test_add (test_shapes);
 
@@ -855,5 +1427,16 @@ main (int argc, char **argv)
   hb_test_add (test_paint_clip_path_depth_overflow);
   hb_test_add (test_paint_gradient_overflow_transform);
 
+  hb_test_add (test_atlas_create_destroy);
+  hb_test_add (test_atlas_add_lookup);
+  hb_test_add (test_atlas_font_instances);
+  hb_test_add (test_atlas_eviction);
+  hb_test_add (test_atlas_compaction);
+  hb_test_add (test_atlas_dirty_ranges);
+  hb_test_add (test_atlas_draw_glyph);
+  hb_test_add (test_atlas_paint_glyph);
+
+  hb_test_add (test_glyphs_roundtrip);
+
   return hb_test_run ();
 }
@@ -587,6 +587,223 @@ test_depend_gsub_formats (void)
   hb_face_destroy (face_source);
 }
 
+static void
+assert_depend_equal (hb_subset_depend_t *expected,
+                     hb_subset_depend_t *actual,
+                     unsigned int num_glyphs)
+{
+  hb_set_t *expected_set = hb_set_create ();
+  hb_set_t *actual_set = hb_set_create ();
+  hb_codepoint_t index;
+
+  for (hb_codepoint_t gid = 0; gid <= num_glyphs; gid++)
+  {
+    unsigned int total = hb_subset_depend_lookup_glyph (expected, gid, 0, NULL, NULL);
+    g_assert_cmpuint (hb_subset_depend_lookup_glyph (actual, gid, 0, NULL, NULL), ==, total);
+
+    for (unsigned int i = 0; i < total; i++)
+    {
+      hb_subset_depend_entry_t e, a;
+      unsigned int count = 1;
+      hb_subset_depend_lookup_glyph (expected, gid, i, &count, &e);
+      count = 1;
+      hb_subset_depend_lookup_glyph (actual, gid, i, &count, &a);
+      g_assert_cmpuint (count, ==, 1);
+
+      g_assert_cmpuint (a.table_tag, ==, e.table_tag);
+      g_assert_cmpuint (a.dependent, ==, e.dependent);
+      g_assert_cmpuint (a.layout_tag, ==, e.layout_tag);
+      g_assert_cmpuint (a.ligature_set_index, ==, e.ligature_set_index);
+      g_assert_cmpuint (a.context_set_index, ==, e.context_set_index);
+      g_assert_cmpuint (a.flags, ==, e.flags);
+    }
+  }
+
+  /* Sets are numbered densely from zero. */
+  for (index = 0; hb_subset_depend_lookup_set (expected, index, expected_set); index++)
+  {
+    hb_set_add (actual_set, HB_SET_VALUE_INVALID - 1); /* Must be overwritten. */
+    g_assert_true (hb_subset_depend_lookup_set (actual, index, actual_set));
+    g_assert_true (hb_set_is_equal (actual_set, expected_set));
+  }
+  g_assert_false (hb_subset_depend_lookup_set (actual, index, actual_set));
+
+  hb_set_destroy (expected_set);
+  hb_set_destroy (actual_set);
+}
+
+/* Test that context sets are not shared between chain context subtables
+ * whose rules are shared but whose backtrack/lookahead ClassDefs differ */
+static void
+test_depend_chain_context_shared_rules (void)
+{
+  /* In NotoSansNewa-Regular.ttf, abvs chain context Format 2 subtables
+   * share rule sets but not ClassDefs.  Nya_stem.cd (188) and
+   * Nya_stem.cd.alt (190) reach ShimHead120 (594) both after Ba.icd
+   * (233) and after Ra.icd (245); a context set computed for one
+   * subtable must not be reused for the other. */
+  hb_face_t *face = hb_test_open_font_file ("../subset/data/fonts/NotoSansNewa-Regular.ttf");
+  hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+  hb_set_t *context = hb_set_create ();
+  hb_codepoint_t sources[] = {188, 190};
+  g_assert_nonnull (depend);
+
+  for (unsigned int i = 0; i < G_N_ELEMENTS (sources); i++)
+  {
+    unsigned int total = hb_subset_depend_lookup_glyph (depend, sources[i], 0, NULL, NULL);
+    hb_bool_t found_233 = FALSE, found_245 = FALSE;
+
+    for (unsigned int index = 0; index < total; index++)
+    {
+      hb_subset_depend_entry_t entry;
+      unsigned int count = 1;
+      hb_subset_depend_lookup_glyph (depend, sources[i], index, &count, &entry);
+
+      if (entry.table_tag != HB_OT_TAG_GSUB || entry.dependent != 594 ||
+          entry.layout_tag != HB_TAG ('a','b','v','s') ||
+          entry.context_set_index == HB_CODEPOINT_INVALID)
+        continue;
+
+      g_assert_true (hb_subset_depend_lookup_set (depend, entry.context_set_index, context));
+      found_233 = found_233 || hb_set_has (context, 233);
+      found_245 = found_245 || hb_set_has (context, 245);
+    }
+
+    g_test_message ("Testing shared chain rules: %u -> 594 after 233 and after 245", sources[i]);
+    g_assert_true (found_233);
+    g_assert_true (found_245);
+  }
+
+  hb_set_destroy (context);
+  hb_subset_depend_destroy (depend);
+  hb_face_destroy (face);
+}
+
+/* Test that a serialized graph loads back identical to the built one */
+static void
+test_depend_serialize (void)
+{
+  const char *fonts[] = {
+    "fonts/NotoSans-Bold.ttf",
+    "fonts/cff1_seac.C0.otf",
+    "fonts/test_glyphs-glyf_colr_1.ttf",
+    "fonts/MathTestFontFull.otf",
+    "fonts/SourceSansPro-Regular.otf",
+    "fonts/ContextFormat2-Depend-Test.ttf",
+  };
+
+  for (unsigned int i = 0; i < G_N_ELEMENTS (fonts); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[i]);
+    hb_subset_depend_t *built = hb_subset_depend_from_face_or_fail (face);
+    hb_subset_depend_t *loaded;
+    hb_blob_t *blob, *blob2;
+    unsigned int length;
+
+    g_test_message ("Testing serialize round trip: %s", fonts[i]);
+    g_assert_nonnull (built);
+
+    blob = hb_subset_depend_serialize_or_fail (built);
+    g_assert_nonnull (blob);
+
+    loaded = hb_subset_depend_from_blob_or_fail (blob);
+    g_assert_nonnull (loaded);
+    assert_depend_equal (built, loaded, hb_face_get_glyph_count (face));
+
+    /* A loaded graph serializes back to its own data. */
+    blob2 = hb_subset_depend_serialize_or_fail (loaded);
+    g_assert_nonnull (blob2);
+    g_assert_cmpmem (hb_blob_get_data (blob2, NULL), hb_blob_get_length (blob2),
+                     hb_blob_get_data (blob, NULL), hb_blob_get_length (blob));
+    hb_blob_destroy (blob2);
+    hb_subset_depend_destroy (loaded);
+
+    /* Truncated data is rejected. */
+    length = hb_blob_get_length (blob);
+    blob2 = hb_blob_create_sub_blob (blob, 0, length - 1);
+    g_assert_null (hb_subset_depend_from_blob_or_fail (blob2));
+    hb_blob_destroy (blob2);
+
+    hb_blob_destroy (blob);
+    hb_subset_depend_destroy (built);
+    hb_face_destroy (face);
+  }
+
+  /* Neither an empty blob nor a font is a serialized graph. */
+  g_assert_null (hb_subset_depend_from_blob_or_fail (hb_blob_get_empty ()));
+  {
+    hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+    hb_blob_t *blob = hb_face_reference_blob (face);
+    g_assert_null (hb_subset_depend_from_blob_or_fail (blob));
+    hb_blob_destroy (blob);
+    hb_face_destroy (face);
+  }
+}
+
+/* Runs the tasks backwards, to catch any dependence on task order. */
+static void
+reverse_executor (hb_subset_task_func_t task,
+                  void *task_data,
+                  unsigned int count,
+                  void *user_data)
+{
+  unsigned int *num_tasks = (unsigned int *) user_data;
+  *num_tasks = count;
+  while (count--)
+    task (task_data, count);
+}
+
+/* Test that a parallel build produces the same graph as a serial one */
+static void
+test_depend_parallel (void)
+{
+  const char *fonts[] = {
+    "fonts/NotoSans-Bold.ttf",
+    "fonts/cff1_seac.C0.otf",
+    "fonts/test_glyphs-glyf_colr_1.ttf",
+    "fonts/MathTestFontFull.otf",
+    "fonts/SourceSansPro-Regular.otf",
+    "fonts/ContextFormat2-Depend-Test.ttf",
+  };
+
+  for (unsigned int i = 0; i < G_N_ELEMENTS (fonts); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[i]);
+    hb_subset_depend_t *serial = hb_subset_depend_from_face_or_fail (face);
+    hb_subset_depend_t *parallel;
+    hb_blob_t *blob, *blob2;
+    unsigned int num_tasks = 0;
+
+    g_test_message ("Testing parallel build: %s", fonts[i]);
+    g_assert_nonnull (serial);
+    blob = hb_subset_depend_serialize_or_fail (serial);
+    g_assert_nonnull (blob);
+
+    parallel = hb_subset_depend_from_face_parallel_or_fail (face, reverse_executor, &num_tasks);
+    g_assert_nonnull (parallel);
+    g_assert_cmpuint (num_tasks, >, 1);
+    assert_depend_equal (serial, parallel, hb_face_get_glyph_count (face));
+    blob2 = hb_subset_depend_serialize_or_fail (parallel);
+    g_assert_cmpmem (hb_blob_get_data (blob2, NULL), hb_blob_get_length (blob2),
+                     hb_blob_get_data (blob, NULL), hb_blob_get_length (blob));
+    hb_blob_destroy (blob2);
+    hb_subset_depend_destroy (parallel);
+
+    /* Without an executor the tasks run on the calling thread. */
+    parallel = hb_subset_depend_from_face_parallel_or_fail (face, NULL, NULL);
+    g_assert_nonnull (parallel);
+    blob2 = hb_subset_depend_serialize_or_fail (parallel);
+    g_assert_cmpmem (hb_blob_get_data (blob2, NULL), hb_blob_get_length (blob2),
+                     hb_blob_get_data (blob, NULL), hb_blob_get_length (blob));
+    hb_blob_destroy (blob2);
+    hb_subset_depend_destroy (parallel);
+
+    hb_blob_destroy (blob);
+    hb_subset_depend_destroy (serial);
+    hb_face_destroy (face);
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -597,6 +814,9 @@ main (int argc, char **argv)
   hb_test_add (test_depend_colr);
   hb_test_add (test_depend_math);
   hb_test_add (test_depend_gsub_formats);
+  hb_test_add (test_depend_chain_context_shared_rules);
+  hb_test_add (test_depend_serialize);
+  hb_test_add (test_depend_parallel);
 
   return hb_test_run ();
 }
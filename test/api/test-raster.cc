@@ -286,6 +286,345 @@ test_set_glyph_extents_overflow (void)
   hb_raster_paint_destroy (paint);
 }
 
+/* ── Test 8: rendering into caller-owned memory ──────────────────── */
+
+static void
+count_destroy (void *user_data)
+{
+  (*(unsigned *) user_data)++;
+}
+
+static void
+test_target_image (void)
+{
+  /* A 16×8 A8 "atlas"; render a glyph into a 6×4 slot at (3, 2). */
+  const unsigned atlas_w = 16, atlas_h = 8;
+  uint8_t atlas[atlas_w * atlas_h];
+  memset (atlas, 0x55, sizeof (atlas));
+
+  unsigned destroyed = 0;
+  hb_raster_extents_t slot = {10, 20, 6, 4, atlas_w};
+  hb_raster_image_t *img = hb_raster_image_create_for_data_or_fail (atlas + 2 * atlas_w + 3,
+								    sizeof (atlas) - (2 * atlas_w + 3),
+								    HB_RASTER_FORMAT_A8, &slot,
+								    &destroyed, count_destroy);
+  g_assert_nonnull (img);
+  g_assert_true (hb_raster_image_get_buffer (img) == atlas + 2 * atlas_w + 3);
+
+  /* Storage is never reallocated. */
+  hb_raster_extents_t too_big = {0, 0, atlas_w, atlas_h, atlas_w};
+  g_assert_false (hb_raster_image_configure (img, HB_RASTER_FORMAT_A8, &too_big));
+
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  hb_raster_draw_set_target_image (rdr, img);
+  draw_rect (rdr, 12.f, 21.f, 14.f, 23.f);
+  hb_raster_image_t *out = hb_raster_draw_render (rdr);
+  g_assert_true (out == img);
+  hb_raster_image_destroy (out);
+
+  for (unsigned y = 0; y < atlas_h; y++)
+    for (unsigned x = 0; x < atlas_w; x++)
+    {
+      uint8_t v = atlas[y * atlas_w + x];
+      bool in_slot = x >= 3 && x < 9 && y >= 2 && y < 6;
+      bool in_rect = x >= 5 && x < 7 && y >= 3 && y < 5;
+      g_assert_cmpint (v, ==, in_rect ? 255 : in_slot ? 0 : 0x55);
+    }
+
+  /* The target is one-shot. */
+  draw_rect (rdr, 0.f, 0.f, 1.f, 1.f);
+  out = hb_raster_draw_render (rdr);
+  g_assert_true (out != img);
+  hb_raster_image_destroy (out);
+
+  hb_raster_draw_destroy (rdr);
+
+  g_assert_cmpuint (destroyed, ==, 0);
+  hb_raster_image_destroy (img);
+  g_assert_cmpuint (destroyed, ==, 1);
+
+  /* Too small storage fails and releases user data right away. */
+  img = hb_raster_image_create_for_data_or_fail (atlas, 8, HB_RASTER_FORMAT_A8, &slot,
+						 &destroyed, count_destroy);
+  g_assert_null (img);
+  g_assert_cmpuint (destroyed, ==, 2);
+
+  /* Paint into a BGRA32 slot. */
+  uint32_t color_atlas[8 * 4];
+  for (unsigned i = 0; i < 8 * 4; i++)
+    color_atlas[i] = 0x12345678u;
+
+  hb_raster_extents_t color_slot = {0, 0, 4, 2, 8 * 4};
+  img = hb_raster_image_create_for_data_or_fail ((uint8_t *) (color_atlas + 8 + 2),
+						 sizeof (color_atlas) - (8 + 2) * 4,
+						 HB_RASTER_FORMAT_BGRA32, &color_slot,
+						 nullptr, nullptr);
+  g_assert_nonnull (img);
+
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_set_target_image (paint, img);
+  hb_paint_color (hb_raster_paint_get_funcs (paint), paint,
+		  false, HB_COLOR (0, 0, 255, 255));
+  out = hb_raster_paint_render (paint);
+  g_assert_true (out == img);
+  hb_raster_image_destroy (out);
+
+  for (unsigned y = 0; y < 4; y++)
+    for (unsigned x = 0; x < 8; x++)
+    {
+      bool in_slot = x >= 2 && x < 6 && y >= 1 && y < 3;
+      g_assert_cmphex (color_atlas[y * 8 + x], ==, in_slot ? 0xFFFF0000u : 0x12345678u);
+    }
+
+  hb_raster_paint_destroy (paint);
+  hb_raster_image_destroy (img);
+}
+
+/* ── Test 9: subtree cache ───────────────────────────────────────── */
+
+static hb_raster_image_t *
+paint_glyph (hb_raster_paint_t *paint, hb_font_t *font, hb_codepoint_t gid)
+{
+  hb_glyph_extents_t gext;
+  if (!hb_font_get_glyph_extents (font, gid, &gext))
+    return nullptr;
+  hb_raster_paint_set_glyph_extents (paint, &gext);
+  hb_raster_paint_glyph (paint, font, gid);
+  return hb_raster_paint_render (paint);
+}
+
+static void
+test_paint_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/test_glyphs-glyf_colr_1.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 200, 200);
+
+  /* The subtree cache is opt-in. */
+  hb_raster_paint_t *uncached = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_t *cached = hb_raster_paint_create_or_fail ();
+  g_assert_cmpuint (hb_raster_paint_get_cache_size (uncached), ==, 0);
+  hb_raster_paint_set_cache_size (cached, 4 << 20);
+  g_assert_cmpuint (hb_raster_paint_get_cache_size (cached), ==, 4 << 20);
+
+  /* The two caches have separate budgets. */
+  g_assert_cmpuint (hb_raster_paint_get_image_cache_size (cached), ==, 4 << 20);
+  hb_raster_paint_set_image_cache_size (cached, 1 << 20);
+  g_assert_cmpuint (hb_raster_paint_get_image_cache_size (cached), ==, 1 << 20);
+  g_assert_cmpuint (hb_raster_paint_get_cache_size (cached), ==, 4 << 20);
+
+  /* One that keeps evicting. */
+  hb_raster_paint_t *small = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_set_cache_size (small, 64 << 10);
+
+  /* Each twice over, so later passes are served from the caches.  Cached
+   * coverage masks are exact; composited PaintColrGlyph subtrees may
+   * round differently, which is why the cache is not on by default. */
+  unsigned num_glyphs = hb_face_get_glyph_count (face);
+  for (unsigned pass = 0; pass < 4; pass++)
+    for (hb_codepoint_t gid = 0; gid < num_glyphs; gid++)
+    {
+      hb_raster_image_t *a = paint_glyph (uncached, font, gid);
+      hb_raster_image_t *b = paint_glyph (pass & 1 ? small : cached, font, gid);
+      g_assert_true (!a == !b);
+      if (!a) continue;
+
+      hb_raster_extents_t ea, eb;
+      hb_raster_image_get_extents (a, &ea);
+      hb_raster_image_get_extents (b, &eb);
+      g_assert_cmpint (ea.x_origin, ==, eb.x_origin);
+      g_assert_cmpint (ea.y_origin, ==, eb.y_origin);
+      g_assert_cmpuint (ea.width, ==, eb.width);
+      g_assert_cmpuint (ea.height, ==, eb.height);
+
+      const uint8_t *pa = hb_raster_image_get_buffer (a);
+      const uint8_t *pb = hb_raster_image_get_buffer (b);
+      for (unsigned y = 0; y < ea.height; y++)
+	for (unsigned x = 0; x < ea.width * 4; x++)
+	  g_assert_cmpint (abs ((int) pa[y * ea.stride + x] - (int) pb[y * eb.stride + x]), <=, 2);
+
+      hb_raster_paint_recycle_image (uncached, a);
+      hb_raster_paint_recycle_image (pass & 1 ? small : cached, b);
+    }
+
+  hb_raster_paint_set_cache_size (cached, 0);
+  hb_raster_paint_destroy (small);
+  hb_raster_paint_destroy (uncached);
+  hb_raster_paint_destroy (cached);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 10: bitmap image cache and mipmaps ─────────────────────── */
+
+static uint64_t
+image_alpha_sum (hb_raster_image_t *img)
+{
+  hb_raster_extents_t ext;
+  hb_raster_image_get_extents (img, &ext);
+  const uint8_t *p = hb_raster_image_get_buffer (img);
+  uint64_t sum = 0;
+  for (unsigned y = 0; y < ext.height; y++)
+    for (unsigned x = 0; x < ext.width; x++)
+      sum += p[y * ext.stride + x * 4 + 3];
+  return sum;
+}
+
+static void
+test_image_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoColorEmoji.subset.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 24, 24);
+
+  hb_raster_paint_t *uncached = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_t *cached = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_t *mipmapped = hb_raster_paint_create_or_fail ();
+  g_assert_cmpuint (hb_raster_paint_get_image_cache_size (cached), ==, 4 << 20);
+  hb_raster_paint_set_image_cache_size (uncached, 0);
+  g_assert_cmpuint (hb_raster_paint_get_image_cache_size (uncached), ==, 0);
+  g_assert_false (hb_raster_paint_get_image_mipmaps (mipmapped));
+  hb_raster_paint_set_image_mipmaps (mipmapped, true);
+  g_assert_true (hb_raster_paint_get_image_mipmaps (mipmapped));
+
+  /* Decoded images are exact; mipmaps only filter them. */
+  unsigned num_glyphs = hb_face_get_glyph_count (face);
+  unsigned painted = 0;
+  for (unsigned pass = 0; pass < 2; pass++)
+    for (hb_codepoint_t gid = 0; gid < num_glyphs; gid++)
+    {
+      hb_raster_image_t *a = paint_glyph (uncached, font, gid);
+      hb_raster_image_t *b = paint_glyph (cached, font, gid);
+      hb_raster_image_t *m = paint_glyph (mipmapped, font, gid);
+      g_assert_true (!a == !b);
+      g_assert_true (!a == !m);
+      if (!a) continue;
+
+      hb_raster_extents_t ea, eb, em;
+      hb_raster_image_get_extents (a, &ea);
+      hb_raster_image_get_extents (b, &eb);
+      hb_raster_image_get_extents (m, &em);
+      g_assert_cmpuint (ea.width, ==, eb.width);
+      g_assert_cmpuint (ea.height, ==, eb.height);
+      g_assert_cmpuint (ea.width, ==, em.width);
+      g_assert_cmpuint (ea.height, ==, em.height);
+
+      const uint8_t *pa = hb_raster_image_get_buffer (a);
+      const uint8_t *pb = hb_raster_image_get_buffer (b);
+      for (unsigned y = 0; y < ea.height; y++)
+	g_assert_cmpmem (pa + y * ea.stride, ea.width * 4,
+			 pb + y * eb.stride, eb.width * 4);
+
+      uint64_t sa = image_alpha_sum (a);
+      uint64_t sm = image_alpha_sum (m);
+      if (sa)
+      {
+	painted++;
+	g_assert_cmpuint (sm > sa ? sm - sa : sa - sm, <, sa / 10);
+      }
+
+      hb_raster_paint_recycle_image (uncached, a);
+      hb_raster_paint_recycle_image (cached, b);
+      hb_raster_paint_recycle_image (mipmapped, m);
+    }
+  g_assert_cmpuint (painted, >, 0);
+
+  hb_raster_paint_destroy (uncached);
+  hb_raster_paint_destroy (cached);
+  hb_raster_paint_destroy (mipmapped);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 11: PNG encoding options ───────────────────────────────── */
+
+static void
+check_png_roundtrip (hb_raster_image_t *img, const hb_raster_png_options_t *options)
+{
+  hb_blob_t *blob = hb_raster_image_serialize_to_png_with_options_or_fail (img, options);
+  g_assert_nonnull (blob);
+
+  hb_raster_image_t *decoded = hb_raster_image_create_or_fail ();
+  g_assert_true (hb_raster_image_deserialize_from_png_or_fail (decoded, blob));
+  hb_blob_destroy (blob);
+
+  hb_raster_extents_t e, d;
+  hb_raster_image_get_extents (img, &e);
+  hb_raster_image_get_extents (decoded, &d);
+  g_assert_cmpuint (d.width, ==, e.width);
+  g_assert_cmpuint (d.height, ==, e.height);
+
+  bool a8 = hb_raster_image_get_format (img) == HB_RASTER_FORMAT_A8;
+  bool palette = options && options->a8_mode == HB_RASTER_PNG_A8_PALETTE;
+  const uint8_t *src = hb_raster_image_get_buffer (img);
+  const uint8_t *dst = hb_raster_image_get_buffer (decoded);
+  for (unsigned y = 0; y < e.height; y++)
+    for (unsigned x = 0; x < e.width; x++)
+    {
+      uint32_t px;
+      memcpy (&px, dst + y * d.stride + x * 4, 4);
+      uint32_t expected;
+      if (!a8)
+	memcpy (&expected, src + y * e.stride + x * 4, 4);
+      else
+      {
+	uint32_t v = src[y * e.stride + x];
+	expected = palette ? v << 24 : 0xFF000000u | v << 16 | v << 8 | v;
+      }
+      g_assert_cmphex (px, ==, expected);
+    }
+
+  hb_raster_image_destroy (decoded);
+}
+
+static void
+test_png_options (void)
+{
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  draw_rect (rdr, 2.f, 2.f, 30.f, 21.5f);
+  draw_rect (rdr, 10.25f, 5.f, 17.f, 40.f);
+  hb_raster_image_t *a8 = hb_raster_draw_render (rdr);
+  g_assert_nonnull (a8);
+
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  hb_raster_extents_t ext = {0, 0, 7, 5, 0};
+  hb_raster_paint_set_extents (paint, &ext);
+  hb_paint_color (hb_raster_paint_get_funcs (paint), paint,
+		  false, HB_COLOR (0, 0, 255, 255));
+  hb_raster_image_t *bgra = hb_raster_paint_render (paint);
+  g_assert_nonnull (bgra);
+
+  check_png_roundtrip (a8, nullptr);
+  check_png_roundtrip (bgra, nullptr);
+
+  for (int level = -1; level <= 9; level += 5)
+    for (unsigned filter = HB_RASTER_PNG_FILTER_DEFAULT; filter <= HB_RASTER_PNG_FILTER_PAETH; filter++)
+    {
+      hb_raster_png_options_t options = HB_RASTER_PNG_OPTIONS_DEFAULT;
+      options.compression_level = level;
+      options.filter = (hb_raster_png_filter_t) filter;
+      check_png_roundtrip (a8, &options);
+      check_png_roundtrip (bgra, &options);
+      options.a8_mode = HB_RASTER_PNG_A8_PALETTE;
+      check_png_roundtrip (a8, &options);
+    }
+
+  /* Stored, no compression: at least as large as the pixels. */
+  hb_raster_png_options_t stored = HB_RASTER_PNG_OPTIONS_DEFAULT;
+  stored.compression_level = 0;
+  check_png_roundtrip (a8, &stored);
+  hb_blob_t *blob = hb_raster_image_serialize_to_png_with_options_or_fail (a8, &stored);
+  hb_raster_extents_t e;
+  hb_raster_image_get_extents (a8, &e);
+  g_assert_cmpuint (hb_blob_get_length (blob), >, (e.width + 1) * e.height);
+  hb_blob_destroy (blob);
+
+  hb_raster_draw_recycle_image (rdr, a8);
+  hb_raster_paint_recycle_image (paint, bgra);
+  hb_raster_draw_destroy (rdr);
+  hb_raster_paint_destroy (paint);
+}
+
 /* ── main ────────────────────────────────────────────────────────── */
 
 int
@@ -300,6 +639,10 @@ main (int argc, char **argv)
   hb_test_add (test_set_glyph_extents_with_transform);
   hb_test_add (test_image_nonfinite_transform);
   hb_test_add (test_set_glyph_extents_overflow);
+  hb_test_add (test_target_image);
+  hb_test_add (test_paint_cache);
+  hb_test_add (test_image_cache);
+  hb_test_add (test_png_options);
 
   return hb_test_run ();
 }
@@ -192,6 +192,196 @@ test_subset_plan (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+_reverse_executor (hb_subset_task_func_t  task,
+		   void                  *task_data,
+		   unsigned int           count,
+		   void                  *user_data)
+{
+  unsigned *calls = (unsigned *) user_data;
+  (*calls)++;
+  /* Run tasks out of order; the result must not depend on it. */
+  for (unsigned i = count; i; i--)
+    task (task_data, i - 1);
+}
+
+static hb_blob_t *
+_execute_to_blob (hb_face_t                 *face,
+		  hb_subset_input_t         *input,
+		  hb_subset_executor_func_t  executor,
+		  unsigned                  *calls)
+{
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  g_assert_true (plan);
+  hb_face_t *subset = hb_subset_plan_execute_parallel_or_fail (plan, executor, calls);
+  g_assert_true (subset);
+  hb_blob_t *blob = hb_face_reference_blob (subset);
+  hb_face_destroy (subset);
+  hb_subset_plan_destroy (plan);
+  return blob;
+}
+
+static void
+test_subset_plan_execute_parallel (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Variable.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_set_add (codepoints, 97);
+  hb_set_add (codepoints, 99);
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  for (unsigned instance = 0; instance < 2; instance++)
+  {
+    /* Instancing makes the metrics tables wait for glyf. */
+    if (instance)
+      hb_subset_input_pin_axis_location (input, face, HB_TAG ('w','g','h','t'), 700.f);
+
+    unsigned calls = 0;
+    hb_blob_t *expected = _execute_to_blob (face, input, NULL, NULL);
+    hb_blob_t *actual = _execute_to_blob (face, input, _reverse_executor, &calls);
+    g_assert_cmpuint (calls, >, 0);
+
+    unsigned expected_length, actual_length;
+    const char *expected_data = hb_blob_get_data (expected, &expected_length);
+    const char *actual_data = hb_blob_get_data (actual, &actual_length);
+    g_assert_cmpmem (expected_data, expected_length, actual_data, actual_length);
+
+    hb_blob_destroy (expected);
+    hb_blob_destroy (actual);
+  }
+
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_plan_instancer_solver_stats (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Variable.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_set_add (codepoints, 97);
+  hb_set_add (codepoints, 99);
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  for (unsigned parallel = 0; parallel < 2; parallel++)
+  {
+    hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+    g_assert_true (plan);
+
+    /* Nothing is solved before execution, or without limited axes. */
+    unsigned solved = 1, reused = 1;
+    hb_subset_plan_get_instancer_solver_stats (plan, &solved, &reused);
+    g_assert_cmpuint (solved, ==, 0);
+    g_assert_cmpuint (reused, ==, 0);
+
+    unsigned calls = 0;
+    hb_face_t *subset = hb_subset_plan_execute_parallel_or_fail (plan,
+								  parallel ? _reverse_executor : NULL,
+								  &calls);
+    g_assert_true (subset);
+    hb_face_destroy (subset);
+
+    hb_subset_plan_get_instancer_solver_stats (plan, &solved, &reused);
+    g_assert_cmpuint (solved, ==, 0);
+    g_assert_cmpuint (reused, ==, 0);
+    hb_subset_plan_destroy (plan);
+  }
+
+  g_assert_true (hb_subset_input_set_axis_range (input, face, HB_TAG ('w','g','h','t'), 400.f, 700.f, 400.f));
+
+  for (unsigned parallel = 0; parallel < 2; parallel++)
+  {
+    hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+    g_assert_true (plan);
+
+    unsigned calls = 0;
+    hb_face_t *subset = hb_subset_plan_execute_parallel_or_fail (plan,
+								  parallel ? _reverse_executor : NULL,
+								  &calls);
+    g_assert_true (subset);
+    hb_face_destroy (subset);
+
+    /* Regions shared between glyphs and tables are solved once. */
+    unsigned solved, reused;
+    hb_subset_plan_get_instancer_solver_stats (plan, &solved, &reused);
+    g_assert_cmpuint (solved, >, 0);
+    g_assert_cmpuint (reused, >, 0);
+
+    /* Either may be omitted. */
+    hb_subset_plan_get_instancer_solver_stats (plan, NULL, NULL);
+    hb_subset_plan_destroy (plan);
+  }
+
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+static hb_blob_t *
+_plan_to_blob (hb_subset_plan_t *plan)
+{
+  g_assert_true (plan);
+  hb_face_t *subset = hb_subset_plan_execute_or_fail (plan);
+  g_assert_true (subset);
+  hb_blob_t *blob = hb_face_reference_blob (subset);
+  hb_face_destroy (subset);
+  hb_subset_plan_destroy (plan);
+  return blob;
+}
+
+static void
+test_subset_plan_create_from_base (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fil.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_set_add (codepoints, 'f');
+  hb_set_add (codepoints, 'i');
+  hb_set_add (codepoints, 'l');
+  hb_subset_input_t *base_input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  hb_subset_plan_t *base = hb_subset_plan_create_or_fail (face, base_input);
+  g_assert_true (base);
+
+  /* Narrowed, covered by base; extended; and incompatible with base. */
+  const char *requests[] = {"fi", "l", "fil", "fia", "fi"};
+  for (unsigned i = 0; i < G_N_ELEMENTS (requests); i++)
+  {
+    codepoints = hb_set_create ();
+    for (const char *c = requests[i]; *c; c++)
+      hb_set_add (codepoints, *c);
+    hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+    hb_set_destroy (codepoints);
+    if (i == G_N_ELEMENTS (requests) - 1)
+      hb_subset_input_set_flags (input, HB_SUBSET_FLAGS_RETAIN_GIDS);
+
+    hb_blob_t *expected = _plan_to_blob (hb_subset_plan_create_or_fail (face, input));
+    hb_blob_t *actual = _plan_to_blob (hb_subset_plan_create_from_base_or_fail (face, input, base));
+
+    unsigned expected_length, actual_length;
+    const char *expected_data = hb_blob_get_data (expected, &expected_length);
+    const char *actual_data = hb_blob_get_data (actual, &actual_length);
+    g_assert_cmpmem (expected_data, expected_length, actual_data, actual_length);
+
+    hb_blob_destroy (expected);
+    hb_blob_destroy (actual);
+    hb_subset_input_destroy (input);
+  }
+
+  /* A NULL base plans from scratch. */
+  hb_subset_plan_t *plan = hb_subset_plan_create_from_base_or_fail (face, base_input, NULL);
+  g_assert_true (plan);
+  hb_subset_plan_destroy (plan);
+
+  hb_subset_plan_destroy (base);
+  hb_subset_input_destroy (base_input);
+  hb_face_destroy (face);
+}
+
 static hb_blob_t*
 _copy_table (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data)
 {
@@ -231,6 +421,116 @@ test_subset_create_for_tables_face (void)
   hb_face_destroy (face_ac);
 }
 
+static void
+test_subset_reference_blobs (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_set_add (codepoints, 97);
+  hb_set_add (codepoints, 99);
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  hb_face_t *subset = hb_subset_or_fail (face, input);
+  g_assert_true (subset);
+
+  hb_blob_t *expected = hb_face_reference_blob (subset);
+  unsigned int expected_length;
+  const char *expected_data = hb_blob_get_data (expected, &expected_length);
+
+  unsigned int total = hb_face_builder_reference_blobs (subset, 0, NULL, NULL);
+  g_assert_cmpuint (total, >, 1);
+
+  /* Fetch in pages of two; the concatenation must be the full font. */
+  unsigned int offset = 0;
+  for (unsigned int start = 0; start < total; start += 2)
+  {
+    hb_blob_t *blobs[2];
+    unsigned int count = 2;
+    g_assert_cmpuint (hb_face_builder_reference_blobs (subset, start, &count, blobs), ==, total);
+    g_assert_cmpuint (count, ==, MIN (2, total - start));
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int length;
+      const char *data = hb_blob_get_data (blobs[i], &length);
+      g_assert_cmpuint (offset + length, <=, expected_length);
+      g_assert_cmpmem (data, length, expected_data + offset, length);
+      offset += length;
+      hb_blob_destroy (blobs[i]);
+    }
+  }
+  g_assert_cmpuint (offset, ==, expected_length);
+
+  /* Not a builder face. */
+  g_assert_cmpuint (hb_face_builder_reference_blobs (face, 0, NULL, NULL), ==, 0);
+
+  hb_blob_destroy (expected);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (subset);
+  hb_face_destroy (face);
+}
+
+static hb_bool_t
+_add_table_to_builder (hb_tag_t tag, hb_blob_t *blob, void *user_data)
+{
+  return hb_face_builder_add_table ((hb_face_t *) user_data, tag, blob);
+}
+
+static hb_bool_t
+_reject_table (hb_tag_t tag HB_UNUSED, hb_blob_t *blob HB_UNUSED, void *user_data HB_UNUSED)
+{
+  return false;
+}
+
+static void
+test_subset_plan_execute_to_sink (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create ();
+  hb_set_add (codepoints, 97);
+  hb_set_add (codepoints, 99);
+  hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+  hb_set_destroy (codepoints);
+
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  g_assert_true (plan);
+
+  hb_face_t *subset = hb_subset_plan_execute_or_fail (plan);
+  g_assert_true (subset);
+  unsigned int peak = hb_subset_plan_get_peak_memory (plan);
+
+  /* Streamed tables assemble into the same font... */
+  hb_face_t *builder = hb_face_builder_create ();
+  g_assert_true (hb_subset_plan_execute_to_sink_or_fail (plan, _add_table_to_builder, builder));
+  hb_subset_test_check (subset, builder, HB_TAG ('g','l','y','f'));
+  hb_subset_test_check (subset, builder, HB_TAG ('c','m','a','p'));
+
+  hb_blob_t *expected = hb_face_reference_blob (subset);
+  hb_blob_t *actual = hb_face_reference_blob (builder);
+  unsigned int expected_length, actual_length;
+  const char *expected_data = hb_blob_get_data (expected, &expected_length);
+  const char *actual_data = hb_blob_get_data (actual, &actual_length);
+  g_assert_cmpmem (actual_data, actual_length, expected_data, expected_length);
+  hb_blob_destroy (expected);
+  hb_blob_destroy (actual);
+
+  /* ...while holding only one table at a time. */
+  unsigned int streamed_peak = hb_subset_plan_get_peak_memory (plan);
+  g_assert_cmpuint (streamed_peak, >, 0);
+  g_assert_cmpuint (streamed_peak, <, peak);
+
+  /* A sink can fail the subset operation. */
+  g_assert_false (hb_subset_plan_execute_to_sink_or_fail (plan, _reject_table, NULL));
+
+  hb_face_destroy (builder);
+  hb_face_destroy (subset);
+  hb_subset_plan_destroy (plan);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
 #ifdef HB_EXPERIMENTAL_API
 const uint8_t CFF2[226] = {
   // From https://learn.microsoft.com/en-us/typography/opentype/spec/cff2
@@ -613,7 +913,12 @@ main (int argc, char **argv)
   hb_test_add (test_subset_set_flags);
   hb_test_add (test_subset_sets);
   hb_test_add (test_subset_plan);
+  hb_test_add (test_subset_plan_execute_parallel);
+  hb_test_add (test_subset_plan_instancer_solver_stats);
+  hb_test_add (test_subset_plan_create_from_base);
   hb_test_add (test_subset_create_for_tables_face);
+  hb_test_add (test_subset_reference_blobs);
+  hb_test_add (test_subset_plan_execute_to_sink);
 
   #ifdef HB_EXPERIMENTAL_API
   hb_test_add (test_subset_input_to_string);
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ */
+
+#include "hb-test.h"
+#include "hb-vector.h"
+
+#include <string.h>
+
+#define FONT_FILE "fonts/Roboto-Regular.abc.ttf"
+
+/* Transform set by the caller before drawing a run. */
+static const float base_transform[6] = {2.f, 0.f, 0.f, -2.f, 10.f, 20.f};
+
+static hb_buffer_t *
+shape_text (hb_font_t *font, const char *text)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, nullptr, 0);
+  return buffer;
+}
+
+static unsigned
+count_occurrences (hb_blob_t *blob, const char *needle)
+{
+  unsigned length;
+  const char *data = hb_blob_get_data (blob, &length);
+  size_t needle_len = strlen (needle);
+  unsigned count = 0;
+  for (unsigned i = 0; i + needle_len <= length; i++)
+    if (!memcmp (data + i, needle, needle_len))
+      count++;
+  return count;
+}
+
+static void
+assert_base_transform (const float t[6])
+{
+  for (unsigned i = 0; i < 6; i++)
+    g_assert_cmpfloat (t[i], ==, base_transform[i]);
+}
+
+
+static void
+test_draw_buffer (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = shape_text (font, "abacab");
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 6);
+
+  hb_vector_draw_t *draw = hb_vector_draw_create_or_fail (HB_VECTOR_FORMAT_SVG);
+  g_assert_nonnull (draw);
+  g_assert_false (hb_vector_draw_get_svg_reuse (draw));
+  hb_vector_draw_set_transform (draw,
+				base_transform[0], base_transform[1],
+				base_transform[2], base_transform[3],
+				base_transform[4], base_transform[5]);
+
+  hb_vector_draw_buffer (draw, font, buffer, HB_VECTOR_EXTENTS_MODE_EXPAND);
+
+  /* The caller's transform and reuse setting are restored. */
+  float t[6];
+  hb_vector_draw_get_transform (draw, &t[0], &t[1], &t[2], &t[3], &t[4], &t[5]);
+  assert_base_transform (t);
+  g_assert_false (hb_vector_draw_get_svg_reuse (draw));
+
+  /* Three distinct outlines are defined once each; every glyph of
+   * the run references one. */
+  hb_blob_t *blob = hb_vector_draw_render (draw);
+  g_assert_nonnull (blob);
+  g_assert_cmpuint (count_occurrences (blob, "<path "), ==, 3);
+  g_assert_cmpuint (count_occurrences (blob, "<use "), ==, 6);
+  hb_blob_destroy (blob);
+
+  /* Unshaped buffers are ignored, leaving nothing to render. */
+  hb_buffer_t *unshaped = hb_buffer_create ();
+  hb_buffer_add_utf8 (unshaped, "abc", -1, 0, -1);
+  hb_vector_draw_buffer (draw, font, unshaped, HB_VECTOR_EXTENTS_MODE_EXPAND);
+  g_assert_null (hb_vector_draw_render (draw));
+  hb_buffer_destroy (unshaped);
+
+  hb_vector_draw_destroy (draw);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_paint_buffer (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = shape_text (font, "abacab");
+
+  hb_vector_paint_t *paint = hb_vector_paint_create_or_fail (HB_VECTOR_FORMAT_SVG);
+  g_assert_nonnull (paint);
+  g_assert_false (hb_vector_paint_get_svg_reuse (paint));
+  hb_vector_paint_set_transform (paint,
+				 base_transform[0], base_transform[1],
+				 base_transform[2], base_transform[3],
+				 base_transform[4], base_transform[5]);
+
+  hb_vector_paint_buffer (paint, font, buffer, HB_VECTOR_EXTENTS_MODE_EXPAND);
+
+  float t[6];
+  hb_vector_paint_get_transform (paint, &t[0], &t[1], &t[2], &t[3], &t[4], &t[5]);
+  assert_base_transform (t);
+  g_assert_false (hb_vector_paint_get_svg_reuse (paint));
+
+  hb_blob_t *blob = hb_vector_paint_render (paint);
+  g_assert_nonnull (blob);
+  g_assert_cmpuint (count_occurrences (blob, "<path "), ==, 3);
+  g_assert_cmpuint (count_occurrences (blob, "<use "), ==, 6);
+  hb_blob_destroy (blob);
+
+  hb_vector_paint_destroy (paint);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+int
+main (int argc, char **argv)
+{
+  hb_test_init (&argc, &argv);
+
+  hb_test_add (test_draw_buffer);
+  hb_test_add (test_paint_buffer);
+
+  return hb_test_run ();
+}
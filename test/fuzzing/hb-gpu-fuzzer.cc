@@ -25,9 +25,14 @@ extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
 
   volatile unsigned counter = !glyph_count;
 
+  /* Odd glyphs exercise the adaptive band layout. */
+  unsigned texel_budget = size ? 1 + data[size - 1] * 64u : 65536;
+
   for (unsigned gid = 0; gid < limit; gid++)
   {
     hb_gpu_draw_reset (draw);
+    if (gid & 1)
+      hb_gpu_draw_set_texel_budget (draw, texel_budget);
     hb_gpu_draw_glyph (draw, input.font, gid);
 
     hb_glyph_extents_t extents;
@@ -40,6 +45,9 @@ extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
       counter += length;
       if (blob_data && length)
 	counter += (unsigned char) blob_data[0];
+      hb_gpu_draw_encode_stats_t stats;
+      hb_gpu_draw_get_encode_stats (draw, &stats);
+      counter += stats.texel_count;
       hb_gpu_draw_recycle_blob (draw, blob);
     }
 
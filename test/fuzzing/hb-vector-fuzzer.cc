@@ -6,6 +6,8 @@ static void
 exercise_format (const _fuzzing_shape_input_t *input,
 		 hb_vector_format_t format,
 		 unsigned precision,
+		 bool reuse,
+		 unsigned compression,
 		 volatile unsigned *counter)
 {
   hb_vector_draw_t  *draw  = hb_vector_draw_create_or_fail  (format);
@@ -20,6 +22,10 @@ exercise_format (const _fuzzing_shape_input_t *input,
 
   hb_vector_draw_set_precision  (draw,  precision);
   hb_vector_paint_set_precision (paint, precision);
+  hb_vector_draw_set_svg_reuse  (draw,  reuse);
+  hb_vector_paint_set_svg_reuse (paint, reuse);
+  hb_vector_draw_set_pdf_compression_level  (draw,  compression);
+  hb_vector_paint_set_pdf_compression_level (paint, compression);
 
   unsigned glyph_count = hb_face_get_glyph_count (input->face);
   unsigned limit = glyph_count > 16 ? 16 : glyph_count;
@@ -34,6 +40,15 @@ exercise_format (const _fuzzing_shape_input_t *input,
     hb_vector_paint_set_transform (paint, 1.f, 0.f, 0.f, 1.f, x, y);
     hb_vector_paint_glyph (paint, input->font, gid, HB_VECTOR_EXTENTS_MODE_EXPAND);
 
+    /* Draw it again elsewhere, so reuse has something to share. */
+    if (reuse)
+    {
+      hb_vector_draw_set_transform (draw, 1.f, 0.f, 0.f, 1.f, x + 160.f, y);
+      hb_vector_draw_glyph  (draw,  input->font, gid, HB_VECTOR_EXTENTS_MODE_EXPAND);
+      hb_vector_paint_set_transform (paint, 1.f, 0.f, 0.f, 1.f, x + 160.f, y);
+      hb_vector_paint_glyph (paint, input->font, gid, HB_VECTOR_EXTENTS_MODE_EXPAND);
+    }
+
     hb_blob_t *draw_blob = hb_vector_draw_render (draw);
     if (draw_blob)
     {
@@ -70,6 +85,8 @@ extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
     return 0;
 
   unsigned precision = size ? data[size - 1] % 5 : 0;
+  bool reuse = size && (data[size - 1] & 0x80);
+  unsigned compression = size && (data[size - 1] & 0x40) ? 1 : 0;
 
   unsigned glyph_count = hb_face_get_glyph_count (input.face);
   volatile unsigned counter = !glyph_count;
@@ -77,8 +94,8 @@ extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
   /* Exercise both output formats.  Each has its own serializer, path
    * encoder, gradient machinery, and (for PDF) indexed-PNG SMask +
    * Type 6 Coons-patch encoder. */
-  exercise_format (&input, HB_VECTOR_FORMAT_SVG, precision, &counter);
-  exercise_format (&input, HB_VECTOR_FORMAT_PDF, precision, &counter);
+  exercise_format (&input, HB_VECTOR_FORMAT_SVG, precision, reuse, compression, &counter);
+  exercise_format (&input, HB_VECTOR_FORMAT_PDF, precision, reuse, compression, &counter);
 
   return counter ? 0 : 0;
 }
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <thread>
 #include <condition_variable>
+#include <deque>
 #include <vector>
 
 #ifdef HAVE_CONFIG_H
@@ -15,7 +16,11 @@
 enum operation_t
 {
   subset_codepoints,
-  subset_glyphs
+  subset_glyphs,
+  subset_parallel,
+  desubroutinize_parallel,
+  instance_parallel,
+  depend_parallel
 };
 
 #define SUBSET_FONT_BASE_PATH "test/subset/data/fonts/"
@@ -36,6 +41,11 @@ struct test_input_t
 };
 
 
+/* Partially instanced with IUP delta optimization, which instances glyph
+ * variations in parallel too. */
+static const test_input_t instance_test =
+  {SUBSET_FONT_BASE_PATH "Roboto-Variable.ttf", 4000};
+
 static test_input_t *tests = default_tests;
 static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
 
@@ -70,6 +80,149 @@ static void AddGlyphs(unsigned num_glyphs_in_font,
   }
 }
 
+/* Runs each table task on its own thread. */
+static void thread_executor (hb_subset_task_func_t task,
+                             void *task_data,
+                             unsigned int count,
+                             void *user_data)
+{
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < count; i++)
+    workers.push_back (std::thread (task, task_data, i));
+  for (auto &worker : workers)
+    worker.join ();
+}
+
+/* A fixed number of workers shared by all threads; the executor just
+ * blocks until they have run its tasks.  Were the executor ever called
+ * from within a task, this would deadlock. */
+struct fixed_pool_t
+{
+  struct job_t
+  {
+    hb_subset_task_func_t task;
+    void *task_data;
+    unsigned index;
+    unsigned *remaining;
+  };
+
+  std::mutex m;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  std::deque<job_t> jobs;
+  std::vector<std::thread> workers;
+  bool stop = false;
+
+  void start (unsigned num_workers)
+  {
+    for (unsigned i = 0; i < num_workers; i++)
+      workers.push_back (std::thread (&fixed_pool_t::work, this));
+  }
+
+  void finish ()
+  {
+    {
+      std::unique_lock<std::mutex> lk (m);
+      stop = true;
+    }
+    work_cv.notify_all ();
+    for (auto &worker : workers)
+      worker.join ();
+  }
+
+  void work ()
+  {
+    std::unique_lock<std::mutex> lk (m);
+    while (true)
+    {
+      work_cv.wait (lk, [this] { return stop || !jobs.empty (); });
+      if (jobs.empty ())
+        return;
+      job_t job = jobs.front ();
+      jobs.pop_front ();
+
+      lk.unlock ();
+      job.task (job.task_data, job.index);
+      lk.lock ();
+
+      if (!--*job.remaining)
+        done_cv.notify_all ();
+    }
+  }
+
+  void run (hb_subset_task_func_t task, void *task_data, unsigned count)
+  {
+    unsigned remaining = count;
+    std::unique_lock<std::mutex> lk (m);
+    for (unsigned i = 0; i < count; i++)
+      jobs.push_back (job_t {task, task_data, i, &remaining});
+    work_cv.notify_all ();
+    done_cv.wait (lk, [&remaining] { return !remaining; });
+  }
+};
+
+static fixed_pool_t fixed_pool;
+
+static void fixed_pool_executor (hb_subset_task_func_t task,
+                                 void *task_data,
+                                 unsigned int count,
+                                 void *user_data)
+{
+  ((fixed_pool_t *) user_data)->run (task, task_data, count);
+}
+
+static void subset_parallel_and_compare (hb_face_t *face,
+                                         hb_subset_input_t *input,
+                                         hb_subset_executor_func_t executor,
+                                         void *executor_data)
+{
+  hb_face_t *expected = hb_subset_or_fail (face, input);
+  assert (expected);
+
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  assert (plan);
+  hb_face_t *actual = hb_subset_plan_execute_parallel_or_fail (plan, executor, executor_data);
+  assert (actual);
+  hb_subset_plan_destroy (plan);
+
+  hb_blob_t *expected_blob = hb_face_reference_blob (expected);
+  hb_blob_t *actual_blob = hb_face_reference_blob (actual);
+  unsigned expected_length, actual_length;
+  const char *expected_data = hb_blob_get_data (expected_blob, &expected_length);
+  const char *actual_data = hb_blob_get_data (actual_blob, &actual_length);
+  assert (expected_length == actual_length);
+  assert (!memcmp (expected_data, actual_data, expected_length));
+
+  hb_blob_destroy (expected_blob);
+  hb_blob_destroy (actual_blob);
+  hb_face_destroy (expected);
+  hb_face_destroy (actual);
+}
+
+#ifdef HB_EXPERIMENTAL_API
+static void depend_parallel_and_compare (hb_face_t *face)
+{
+  hb_subset_depend_t *expected = hb_subset_depend_from_face_or_fail (face);
+  assert (expected);
+  hb_subset_depend_t *actual = hb_subset_depend_from_face_parallel_or_fail (face, thread_executor, nullptr);
+  assert (actual);
+
+  hb_blob_t *expected_blob = hb_subset_depend_serialize_or_fail (expected);
+  hb_blob_t *actual_blob = hb_subset_depend_serialize_or_fail (actual);
+  assert (expected_blob && actual_blob);
+  unsigned expected_length, actual_length;
+  const char *expected_data = hb_blob_get_data (expected_blob, &expected_length);
+  const char *actual_data = hb_blob_get_data (actual_blob, &actual_length);
+  assert (expected_length == actual_length);
+  assert (!memcmp (expected_data, actual_data, expected_length));
+
+  hb_blob_destroy (expected_blob);
+  hb_blob_destroy (actual_blob);
+  hb_subset_depend_destroy (expected);
+  hb_subset_depend_destroy (actual);
+}
+#endif
+
 static void subset (operation_t operation,
                     const test_input_t &test_input,
                     hb_face_t *face)
@@ -88,6 +241,9 @@ static void subset (operation_t operation,
   switch (operation)
   {
     case subset_codepoints:
+    case subset_parallel:
+    case desubroutinize_parallel:
+    case instance_parallel:
     {
       hb_set_t* all_codepoints = hb_set_create ();
       hb_face_collect_unicodes (face, all_codepoints);
@@ -102,10 +258,40 @@ static void subset (operation_t operation,
       AddGlyphs(num_glyphs, subset_size, input);
     }
     break;
+
+    case depend_parallel:
+    break;
+  }
+
+  /* CFF charstrings are flattened and encoded in parallel too. */
+  if (operation == desubroutinize_parallel)
+    hb_subset_input_set_flags (input, HB_SUBSET_FLAGS_DESUBROUTINIZE |
+				      HB_SUBSET_FLAGS_NO_HINTING);
+
+  if (operation == instance_parallel)
+  {
+    hb_subset_input_set_flags (input, HB_SUBSET_FLAGS_OPTIMIZE_IUP_DELTAS);
+    hb_subset_input_pin_axis_location (input, face, HB_TAG ('w','d','t','h'), 80.f);
   }
 
   for (unsigned i = 0; i < num_repetitions; i++)
   {
+    if (operation == subset_parallel ||
+        operation == desubroutinize_parallel ||
+        operation == instance_parallel)
+    {
+      subset_parallel_and_compare (face, input, thread_executor, nullptr);
+      subset_parallel_and_compare (face, input, fixed_pool_executor, &fixed_pool);
+      continue;
+    }
+#ifdef HB_EXPERIMENTAL_API
+    if (operation == depend_parallel)
+    {
+      depend_parallel_and_compare (face);
+      continue;
+    }
+#endif
+
     hb_face_t* subset = hb_subset_or_fail (face, input);
     assert (subset);
     hb_face_destroy (subset);
@@ -170,13 +356,24 @@ int main(int argc, char** argv)
   }
 
   printf ("Num threads %u; num repetitions %u\n", num_threads, num_repetitions);
+  fixed_pool.start (2);
   for (unsigned i = 0; i < num_tests; i++)
   {
     auto& test_input = tests[i];
     test_operation (subset_codepoints, "codepoints", test_input);
     test_operation (subset_glyphs, "glyphs", test_input);
+    test_operation (subset_parallel, "parallel", test_input);
+    test_operation (desubroutinize_parallel, "desubroutinize-parallel", test_input);
+#ifdef HB_EXPERIMENTAL_API
+    test_operation (depend_parallel, "depend-parallel", test_input);
+#endif
   }
 
+  if (tests == default_tests)
+    test_operation (instance_parallel, "instance-parallel", instance_test);
+
+  fixed_pool.finish ();
+
   if (tests != default_tests)
     free (tests);
 }
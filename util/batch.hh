@@ -29,37 +29,230 @@
 
 typedef int (*main_func_t) (int argc, char **argv);
 
-template <typename main_t, bool report_status=false>
+/* Options following --batch, eg. "--batch --jobs=4 --timing":
+ *
+ *  --jobs=N  Run up to N requests at a time, on a pool of worker threads.
+ *            Results are still reported in the order requests are read.
+ *            Only for tools whose main_t can parse () on the reading thread
+ *            and run () on a worker.  Requests should write to their own
+ *            output files.
+ *  --timing  Report the wall-clock time of each request, after its
+ *            status if the tool reports one, or to stderr otherwise.
+ */
+struct batch_options_t
+{
+  bool parse (int argc, char **argv, bool concurrent)
+  {
+    for (int i = 0; i < argc; i++)
+    {
+      if (!strncmp (argv[i], "--jobs=", 7))
+      {
+	char *end;
+	errno = 0;
+	unsigned long n = strtoul (argv[i] + 7, &end, 10);
+	if (errno || *end || !n || n > 1024)
+	{
+	  g_printerr ("%s: Invalid number of jobs: '%s'\n", g_get_prgname (), argv[i] + 7);
+	  return false;
+	}
+	if (n > 1 && !concurrent)
+	{
+	  g_printerr ("%s: --jobs is not supported by this tool\n", g_get_prgname ());
+	  return false;
+	}
+	jobs = n;
+      }
+      else if (!strcmp (argv[i], "--timing"))
+	timing = true;
+      else
+      {
+	g_printerr ("%s: Unknown batch option: '%s'\n", g_get_prgname (), argv[i]);
+	return false;
+      }
+    }
+    return true;
+  }
+
+  unsigned jobs = 1;
+  bool timing = false;
+};
+
+/* Splits a request line, which is modified, into arguments separated by ';'. */
+static inline int
+batch_split_line (char *buf, char *argv0, char **args, unsigned max_args)
+{
+  size_t l = strlen (buf);
+  if (l && buf[l - 1] == '\n') buf[l - 1] = '\0';
+
+  int argc = 0;
+  args[argc++] = argv0;
+  char *p = buf, *e;
+  args[argc++] = p;
+  while ((e = strchr (p, ';')) && argc < (int) max_args)
+  {
+    *e++ = '\0';
+    while (*e == ';')
+      e++;
+    args[argc++] = p = e;
+  }
+  return argc;
+}
+
+static inline void
+batch_report (bool report_status, bool timing, int result, gint64 elapsed_us)
+{
+  if (report_status)
+  {
+    fprintf (stdout, result == 0 ? "success" : "failure");
+    if (timing)
+      fprintf (stdout, " %.3fms", elapsed_us / 1000.);
+    fprintf (stdout, "\n");
+  }
+  else if (timing)
+    fprintf (stderr, "%.3fms\n", elapsed_us / 1000.);
+  fflush (stdout);
+}
+
+/* Runs requests on a thread pool.  Each request is parsed on the reading
+ * thread, since option parsing shares the face cache, then run on a worker.
+ * Whichever worker finds the oldest requests done reports them, so replies
+ * go out in order as soon as possible; a client waiting for the reply to
+ * one request before sending the next is not kept waiting. */
+template <typename main_t, bool report_status>
+struct batch_pool_t
+{
+  struct job_t
+  {
+    main_t main;
+    int result = 0;
+    gint64 elapsed = 0;
+    bool done = false;
+  };
+
+  batch_pool_t (const batch_options_t &options_)
+  : options (options_),
+    pool (g_thread_pool_new (run_job, this, options_.jobs, TRUE, nullptr))
+  {
+    g_mutex_init (&lock);
+    g_cond_init (&cond);
+  }
+
+  ~batch_pool_t ()
+  {
+    g_thread_pool_free (pool, FALSE, TRUE);
+    assert (g_queue_is_empty (&pending));
+    g_cond_clear (&cond);
+    g_mutex_clear (&lock);
+  }
+
+  void push (int argc, char **argv)
+  {
+    /* Bound the number of parsed requests waiting for a worker. */
+    g_mutex_lock (&lock);
+    while (g_queue_get_length (&pending) >= 2 * options.jobs)
+      g_cond_wait (&cond, &lock);
+    g_mutex_unlock (&lock);
+
+    job_t *job = new job_t;
+    gint64 start = g_get_monotonic_time ();
+    job->main.parse (argc, argv);
+    job->elapsed = g_get_monotonic_time () - start;
+
+    g_mutex_lock (&lock);
+    g_queue_push_tail (&pending, job);
+    g_mutex_unlock (&lock);
+
+    g_thread_pool_push (pool, job, nullptr);
+  }
+
+  int finish ()
+  {
+    g_mutex_lock (&lock);
+    while (!g_queue_is_empty (&pending))
+      g_cond_wait (&cond, &lock);
+    g_mutex_unlock (&lock);
+    return ret;
+  }
+
+  private:
+  static void run_job (gpointer data, gpointer user_data)
+  {
+    job_t *job = (job_t *) data;
+    batch_pool_t *thiz = (batch_pool_t *) user_data;
+
+    gint64 start = g_get_monotonic_time ();
+    int result = job->main.run ();
+    gint64 elapsed = g_get_monotonic_time () - start;
+
+    g_mutex_lock (&thiz->lock);
+    job->result = result;
+    job->elapsed += elapsed;
+    job->done = true;
+    job_t *head;
+    while ((head = (job_t *) g_queue_peek_head (&thiz->pending)) && head->done)
+    {
+      g_queue_pop_head (&thiz->pending);
+      batch_report (report_status, thiz->options.timing, head->result, head->elapsed);
+      thiz->ret = MAX (thiz->ret, head->result);
+      delete head;
+    }
+    g_cond_broadcast (&thiz->cond);
+    g_mutex_unlock (&thiz->lock);
+  }
+
+  const batch_options_t &options;
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  GQueue pending = G_QUEUE_INIT;
+  int ret = 0;
+};
+
+template <typename main_t, bool report_status>
+static int
+batch_main_concurrent (char *argv0, const batch_options_t &options, hb_true_type)
+{
+  batch_pool_t<main_t, report_status> pool (options);
+  char buf[4092];
+  while (fgets (buf, sizeof (buf), stdin))
+  {
+    char *args[64];
+    int argc = batch_split_line (buf, argv0, args, ARRAY_LENGTH (args));
+    pool.push (argc, args);
+  }
+  return pool.finish ();
+}
+template <typename main_t, bool report_status>
+static int
+batch_main_concurrent (char *, const batch_options_t &, hb_false_type)
+{ assert (false); return RETURN_VALUE_OPTION_PARSING_FAILED; }
+
+/* With concurrent set, main_t must also provide parse (argc, argv) and
+ * run (), which together do what its operator () does. */
+template <typename main_t, bool report_status=false, bool concurrent=false>
 int
 batch_main (int argc, char **argv)
 {
-  if (argc == 2 && !strcmp (argv[1], "--batch"))
+  if (argc >= 2 && !strcmp (argv[1], "--batch"))
   {
+    batch_options_t options;
+    if (!options.parse (argc - 2, argv + 2, concurrent))
+      return RETURN_VALUE_OPTION_PARSING_FAILED;
+
+    if (concurrent && options.jobs > 1)
+      return batch_main_concurrent<main_t, report_status> (argv[0], options,
+							     hb_bool_constant<concurrent> ());
+
     int ret = 0;
     char buf[4092];
     while (fgets (buf, sizeof (buf), stdin))
     {
-      size_t l = strlen (buf);
-      if (l && buf[l - 1] == '\n') buf[l - 1] = '\0';
-
       char *args[64];
-      argc = 0;
-      args[argc++] = argv[0];
-      char *p = buf, *e;
-      args[argc++] = p;
-      while ((e = strchr (p, ';')) && argc < (int) ARRAY_LENGTH (args))
-      {
-	*e++ = '\0';
-	while (*e == ';')
-	  e++;
-	args[argc++] = p = e;
-      }
+      argc = batch_split_line (buf, argv[0], args, ARRAY_LENGTH (args));
 
+      gint64 start = g_get_monotonic_time ();
       int result = main_t () (argc, args);
-
-      if (report_status)
-	fprintf (stdout, result == 0 ? "success\n" : "failure\n");
-      fflush (stdout);
+      batch_report (report_status, options.timing, result, g_get_monotonic_time () - start);
 
       ret = MAX (ret, result);
     }
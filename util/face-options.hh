@@ -50,19 +50,64 @@ struct face_options_t
 
   virtual hb_face_t *default_face () { return nullptr; }
 
+  /* Faces loaded so far, most recently used first.  Batch mode keeps
+   * them across requests, so that a font used again is not reloaded. */
   static struct cache_t
   {
     ~cache_t ()
     {
-      g_free (font_path);
-      g_free (face_loader);
-      hb_face_destroy (face);
+      for (unsigned i = 0; i < length; i++)
+	entries[i].fini ();
     }
 
-    char *font_path = nullptr;
-    char *face_loader = nullptr;
-    unsigned face_index = (unsigned) -1;
-    hb_face_t *face = nullptr;
+    struct entry_t
+    {
+      void fini ()
+      {
+	g_free (font_path);
+	g_free (face_loader);
+	hb_face_destroy (face);
+      }
+
+      char *font_path;
+      char *face_loader;
+      unsigned face_index;
+      hb_face_t *face;
+    };
+
+    hb_face_t *find (const char *font_path, unsigned face_index, const char *face_loader)
+    {
+      for (unsigned i = 0; i < length; i++)
+      {
+	entry_t entry = entries[i];
+	if (entry.face_index != face_index ||
+	    0 != strcmp (entry.font_path, font_path) ||
+	    0 != g_strcmp0 (entry.face_loader, face_loader))
+	  continue;
+
+	memmove (entries + 1, entries, i * sizeof (entries[0]));
+	entries[0] = entry;
+	return entry.face;
+      }
+      return nullptr;
+    }
+
+    void add (const char *font_path, unsigned face_index, const char *face_loader,
+	      hb_face_t *face)
+    {
+      if (length == ARRAY_LENGTH (entries))
+	entries[--length].fini ();
+
+      memmove (entries + 1, entries, length * sizeof (entries[0]));
+      entries[0] = {g_strdup (font_path),
+		    g_strdup (face_loader),
+		    face_index,
+		    hb_face_reference (face)};
+      length++;
+    }
+
+    entry_t entries[16];
+    unsigned length = 0;
   } cache;
 
   char *font_file = nullptr;
@@ -106,30 +151,22 @@ face_options_t::post_parse (GError **error)
 #endif
   }
 
-  if ((!cache.font_path || 0 != strcmp (cache.font_path, font_path)) ||
-      (cache.face_loader != face_loader &&
-       (cache.face_loader && face_loader && 0 != strcmp (cache.face_loader, face_loader))) ||
-      cache.face_index != face_index)
+  hb_face_t *face_ = cache.find (font_path, face_index, face_loader);
+  if (!face_)
   {
-    hb_face_destroy (cache.face);
-    cache.face = hb_face_create_from_file_or_fail_using (font_path, face_index, face_loader);
-    cache.face_index = face_index;
-
-    g_free ((char *) cache.font_path);
-    g_free ((char *) cache.face_loader);
-    cache.font_path = g_strdup (font_path);
-    cache.face_loader = face_loader ? g_strdup (face_loader) : nullptr;
-
-    if (!cache.face)
+    face_ = hb_face_create_from_file_or_fail_using (font_path, face_index, face_loader);
+    if (!face_)
     {
       g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_FAILED,
 		   "%s: Failed loading font face", font_path);
       return_value = RETURN_VALUE_FACE_LOAD_FAILED;
       return;
     }
+    cache.add (font_path, face_index, face_loader, face_);
+    hb_face_destroy (face_);
   }
 
-  set_face (cache.face);
+  set_face (face_);
 }
 
 static G_GNUC_NORETURN gboolean
@@ -31,19 +31,240 @@
 #include <cstdlib>
 #include <cstring>
 #include <cinttypes>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock clock_type;
+
+static uint64_t
+ns_between (clock_type::time_point a, clock_type::time_point b)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (b - a).count ();
+}
+
+
+/* Per-encoder statistics, summed over all jobs. */
+struct encoder_stats_t
+{
+  unsigned encoded = 0;
+  uint64_t bytes = 0;
+  unsigned max_bytes = 0;
+  unsigned max_gid = 0;
+  uint64_t walk_ns = 0;
+  uint64_t encode_ns = 0;
+
+  void add (const encoder_stats_t &o)
+  {
+    encoded += o.encoded;
+    bytes += o.bytes;
+    if (o.max_bytes > max_bytes ||
+	(o.max_bytes == max_bytes && o.max_gid < max_gid))
+    {
+      max_bytes = o.max_bytes;
+      max_gid = o.max_gid;
+    }
+    walk_ns += o.walk_ns;
+    encode_ns += o.encode_ns;
+  }
+
+  void count (unsigned gid, unsigned len)
+  {
+    encoded++;
+    bytes += len;
+    if (len > max_bytes) { max_bytes = len; max_gid = gid; }
+  }
+};
+
+struct job_stats_t
+{
+  encoder_stats_t paint, draw;
+  unsigned empty = 0;
+  unsigned failed = 0;
+  unsigned not_stored = 0;
+
+  void add (const job_stats_t &o)
+  {
+    paint.add (o.paint);
+    draw.add (o.draw);
+    empty += o.empty;
+    failed += o.failed;
+    not_stored += o.not_stored;
+  }
+};
+
+struct job_t
+{
+  hb_font_t *font;	/* Immutable; shared by all workers */
+  unsigned glyph_count;
+  unsigned num_iters;
+  bool draw_only;
+
+  hb_gpu_glyphs_t *output;
+  std::mutex output_lock;
+
+  std::atomic<unsigned> next_gid {0};
+};
+
+static void
+encode_glyph (job_t          *job,
+	      hb_gpu_paint_t *paint,
+	      hb_gpu_draw_t  *draw,
+	      unsigned        gid,
+	      unsigned        iter,
+	      job_stats_t    *stats)
+{
+  hb_font_t *font = job->font;
+  hb_blob_t *encoded = nullptr;
+  hb_glyph_extents_t extents;
+
+  if (paint)
+  {
+    hb_gpu_paint_clear (paint);
+
+    clock_type::time_point t0 = clock_type::now ();
+    hb_gpu_paint_glyph (paint, font, gid);
+    clock_type::time_point t1 = clock_type::now ();
+    encoded = hb_gpu_paint_encode (paint, &extents);
+    clock_type::time_point t2 = clock_type::now ();
+
+    stats->paint.walk_ns   += ns_between (t0, t1);
+    stats->paint.encode_ns += ns_between (t1, t2);
+  }
+
+  bool is_draw = false;
+  if (!encoded)
+  {
+    /* Paint did not produce a blob (v1 feature, empty glyph), or
+     * we are only drawing.  Use the draw encoder. */
+    hb_gpu_draw_clear (draw);
+    clock_type::time_point f0 = clock_type::now ();
+    hb_gpu_draw_glyph (draw, font, gid);
+    clock_type::time_point f1 = clock_type::now ();
+    encoded = hb_gpu_draw_encode (draw, &extents);
+    clock_type::time_point f2 = clock_type::now ();
+    stats->draw.walk_ns   += ns_between (f0, f1);
+    stats->draw.encode_ns += ns_between (f1, f2);
+    is_draw = true;
+  }
+
+  if (!encoded)
+  {
+    if (iter == 0)
+    {
+      fprintf (stderr, "gid %u: encode failed\n", gid);
+      stats->failed++;
+    }
+    return;
+  }
+
+  if (iter == 0)
+  {
+    unsigned len = hb_blob_get_length (encoded);
+    if (len == 0)
+      stats->empty++;
+    else if (is_draw)
+      stats->draw.count (gid, len);
+    else
+      stats->paint.count (gid, len);
+
+    /* A set holds one kind of encoding; draw fallbacks do not go
+     * into a paint set. */
+    if (job->output && len)
+    {
+      if (is_draw && !job->draw_only)
+	stats->not_stored++;
+      else
+      {
+	std::lock_guard<std::mutex> lock (job->output_lock);
+	if (!hb_gpu_glyphs_set_glyph (job->output, gid, encoded, &extents))
+	  stats->not_stored++;
+      }
+    }
+  }
+
+  if (is_draw)
+    hb_gpu_draw_recycle_blob (draw, encoded);
+  else
+    hb_gpu_paint_recycle_blob (paint, encoded);
+}
+
+/* Each worker owns its encoders, and with them the encode scratch
+ * buffers, and pulls glyph ids off the shared counter. */
+static void
+worker (job_t *job, job_stats_t *stats)
+{
+  hb_gpu_paint_t *paint = job->draw_only ? nullptr : hb_gpu_paint_create_or_fail ();
+  hb_gpu_draw_t  *draw  = hb_gpu_draw_create_or_fail ();
+  if ((!job->draw_only && !paint) || !draw)
+  {
+    fprintf (stderr, "Failed to create GPU encoder.\n");
+    stats->failed = job->glyph_count;
+    hb_gpu_paint_destroy (paint);
+    hb_gpu_draw_destroy (draw);
+    return;
+  }
+
+  unsigned gid;
+  while ((gid = job->next_gid.fetch_add (1, std::memory_order_relaxed)) < job->glyph_count)
+    for (unsigned iter = 0; iter < job->num_iters; iter++)
+      encode_glyph (job, paint, draw, gid, iter, stats);
+
+  hb_gpu_paint_destroy (paint);
+  hb_gpu_draw_destroy (draw);
+}
+
+
+static void
+print_encoder_stats (const char *label,
+		     const encoder_stats_t &s,
+		     unsigned num_iters,
+		     uint64_t per_glyph_divisor)
+{
+  printf ("\n");
+  printf ("%s %u\n", label, s.encoded);
+  printf ("  total:       %.2f KiB\n", s.bytes / 1024.);
+  printf ("  avg:         %.2f KiB/glyph\n",
+	  s.bytes / 1024. / s.encoded);
+  printf ("  max:         %.2f KiB (gid %u)\n",
+	  s.max_bytes / 1024., s.max_gid);
+  printf ("  walk:        %.3fms (%.1fus/glyph)\n",
+	  s.walk_ns / 1e6 / num_iters,
+	  per_glyph_divisor ? s.walk_ns / 1e3 / per_glyph_divisor : 0.);
+  printf ("  encode:      %.3fms (%.1fus/glyph)\n",
+	  s.encode_ns / 1e6 / num_iters,
+	  per_glyph_divisor ? s.encode_ns / 1e3 / per_glyph_divisor : 0.);
+}
+
+static void
+usage (FILE *f, const char *prog)
+{
+  fprintf (f, "Usage: %s [-n iterations] [-j jobs] [--draw] [-o FILE] FONTFILE\n"
+	      "\n"
+	      "  -n N        Encode every glyph N times (default: 1)\n"
+	      "  -j N        Encode with N threads; 0 uses one per CPU (default: 1)\n"
+	      "  --draw      Use the draw encoder only, not the paint encoder\n"
+	      "  -o FILE     Write the encoded glyphs to FILE; see\n"
+	      "              hb_gpu_glyphs_create_for_blob_or_fail()\n",
+	   prog);
+}
 
 int
 main (int argc, char **argv)
 {
   const char *font_path = nullptr;
+  const char *output_path = nullptr;
   unsigned num_iters = 1;
+  unsigned num_jobs = 1;
+  bool draw_only = false;
 
   for (int i = 1; i < argc; i++)
   {
     if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
     {
-      fprintf (stderr, "Usage: %s [-n iterations] FONTFILE\n", argv[0]);
+      usage (stdout, argv[0]);
       return 0;
     }
     if (!strcmp (argv[i], "-n") && i + 1 < argc)
@@ -52,12 +273,30 @@ main (int argc, char **argv)
       if (!num_iters) num_iters = 1;
       continue;
     }
+    if (!strcmp (argv[i], "-j") && i + 1 < argc)
+    {
+      num_jobs = atoi (argv[++i]);
+      if (!num_jobs)
+	num_jobs = std::thread::hardware_concurrency ();
+      if (!num_jobs) num_jobs = 1;
+      continue;
+    }
+    if (!strcmp (argv[i], "-o") && i + 1 < argc)
+    {
+      output_path = argv[++i];
+      continue;
+    }
+    if (!strcmp (argv[i], "--draw"))
+    {
+      draw_only = true;
+      continue;
+    }
     font_path = argv[i];
   }
 
   if (!font_path)
   {
-    fprintf (stderr, "Usage: %s [-n iterations] FONTFILE\n", argv[0]);
+    usage (stderr, argv[0]);
     return 1;
   }
 
@@ -70,6 +309,7 @@ main (int argc, char **argv)
 
   hb_face_t *face = hb_face_create (blob, 0);
   hb_font_t *font = hb_font_create (face);
+  hb_font_make_immutable (font);
   unsigned glyph_count = hb_face_get_glyph_count (face);
 
   if (!glyph_count)
@@ -81,156 +321,98 @@ main (int argc, char **argv)
     return 1;
   }
 
-  hb_gpu_paint_t *paint = hb_gpu_paint_create_or_fail ();
-  hb_gpu_draw_t  *draw  = hb_gpu_draw_create_or_fail ();
-  if (!paint || !draw)
+  hb_gpu_glyphs_t *output = nullptr;
+  if (output_path && !(output = hb_gpu_glyphs_create_or_fail (glyph_count)))
   {
-    fprintf (stderr, "Failed to create GPU encoder.\n");
-    hb_gpu_paint_destroy (paint);
-    hb_gpu_draw_destroy (draw);
+    fprintf (stderr, "Failed to create glyph set.\n");
     hb_font_destroy (font);
     hb_face_destroy (face);
     hb_blob_destroy (blob);
     return 1;
   }
 
-  unsigned num_paint_encoded = 0;
-  unsigned num_draw_encoded  = 0;
-  unsigned num_empty = 0;
-  unsigned num_failed = 0;
-  uint64_t paint_bytes = 0;
-  uint64_t draw_bytes  = 0;
-  unsigned paint_max_bytes = 0;
-  unsigned draw_max_bytes  = 0;
-  unsigned paint_max_gid = 0;
-  unsigned draw_max_gid  = 0;
-  uint64_t paint_walk_ns   = 0;
-  uint64_t paint_encode_ns = 0;
-  uint64_t draw_walk_ns    = 0;
-  uint64_t draw_encode_ns  = 0;
+  job_t job;
+  job.font = font;
+  job.glyph_count = glyph_count;
+  job.num_iters = num_iters;
+  job.draw_only = draw_only;
+  job.output = output;
 
-  typedef std::chrono::steady_clock clock;
-  clock::time_point wall_start = clock::now ();
+  std::vector<job_stats_t> job_stats (num_jobs);
+  clock_type::time_point wall_start = clock_type::now ();
 
-  for (unsigned iter = 0; iter < num_iters; iter++)
-  for (unsigned gid = 0; gid < glyph_count; gid++)
+  if (num_jobs == 1)
+    worker (&job, &job_stats[0]);
+  else
   {
-    hb_gpu_paint_clear (paint);
-
-    clock::time_point t0 = clock::now ();
-    hb_gpu_paint_glyph (paint, font, gid);
-    clock::time_point t1 = clock::now ();
-
-    hb_blob_t *encoded = hb_gpu_paint_encode (paint, nullptr);
-    clock::time_point t2 = clock::now ();
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < num_jobs; i++)
+      threads.emplace_back (worker, &job, &job_stats[i]);
+    for (auto &thread : threads)
+      thread.join ();
+  }
 
-    paint_walk_ns   += std::chrono::duration_cast<std::chrono::nanoseconds> (t1 - t0).count ();
-    paint_encode_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (t2 - t1).count ();
+  uint64_t wall_ns = ns_between (wall_start, clock_type::now ());
 
-    bool is_fallback = false;
-    if (!encoded)
-    {
-      /* Paint did not produce a blob (v1 feature, empty glyph).
-       * Fall back to the draw encoder. */
-      hb_gpu_draw_clear (draw);
-      clock::time_point f0 = clock::now ();
-      hb_gpu_draw_glyph (draw, font, gid);
-      clock::time_point f1 = clock::now ();
-      encoded = hb_gpu_draw_encode (draw, nullptr);
-      clock::time_point f2 = clock::now ();
-      draw_walk_ns   += std::chrono::duration_cast<std::chrono::nanoseconds> (f1 - f0).count ();
-      draw_encode_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (f2 - f1).count ();
-      is_fallback = true;
-    }
+  job_stats_t stats;
+  for (const auto &s : job_stats)
+    stats.add (s);
 
-    if (!encoded)
-    {
-      if (iter == 0)
-      {
-	fprintf (stderr, "gid %u: encode failed\n", gid);
-	num_failed++;
-      }
-      continue;
-    }
+  int ret = stats.failed ? 1 : 0;
 
-    if (iter == 0)
+  uint64_t output_bytes = 0;
+  if (output)
+  {
+    hb_blob_t *serialized = hb_gpu_glyphs_serialize (output);
+    unsigned length = 0;
+    const char *data = serialized ? hb_blob_get_data (serialized, &length) : nullptr;
+    FILE *f = serialized ? fopen (output_path, "wb") : nullptr;
+    if (!f ||
+	fwrite (data, 1, length, f) != length ||
+	fclose (f))
     {
-      unsigned len = hb_blob_get_length (encoded);
-      if (len == 0)
-	num_empty++;
-      else if (is_fallback)
-      {
-	num_draw_encoded++;
-	draw_bytes += len;
-	if (len > draw_max_bytes) { draw_max_bytes = len; draw_max_gid = gid; }
-      }
-      else
-      {
-	num_paint_encoded++;
-	paint_bytes += len;
-	if (len > paint_max_bytes) { paint_max_bytes = len; paint_max_gid = gid; }
-      }
+      fprintf (stderr, "Failed to write %s\n", output_path);
+      ret = 1;
     }
-    if (is_fallback)
-      hb_gpu_draw_recycle_blob (draw, encoded);
-    else
-      hb_gpu_paint_recycle_blob (paint, encoded);
+    output_bytes = length;
+    hb_blob_destroy (serialized);
+    hb_gpu_glyphs_destroy (output);
   }
 
-  uint64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds> (clock::now () - wall_start).count ();
-
   printf ("font:          %s\n", font_path);
   printf ("glyphs:        %u\n", glyph_count);
-  printf ("empty:         %u\n", num_empty);
-  if (num_failed)
-    printf ("FAILED:        %u\n", num_failed);
+  printf ("empty:         %u\n", stats.empty);
+  if (stats.failed)
+    printf ("FAILED:        %u\n", stats.failed);
 
   uint64_t total_glyphs = (uint64_t) glyph_count * num_iters;
 
-  if (num_paint_encoded)
-  {
-    printf ("\n");
-    printf ("paint encoded: %u\n", num_paint_encoded);
-    printf ("  total:       %.2f KiB\n", paint_bytes / 1024.);
-    printf ("  avg:         %.2f KiB/glyph\n",
-	    paint_bytes / 1024. / num_paint_encoded);
-    printf ("  max:         %.2f KiB (gid %u)\n",
-	    paint_max_bytes / 1024., paint_max_gid);
-    printf ("  walk:        %.3fms (%.1fus/glyph)\n",
-	    paint_walk_ns / 1e6 / num_iters,
-	    total_glyphs ? paint_walk_ns / 1e3 / total_glyphs : 0.);
-    printf ("  encode:      %.3fms (%.1fus/glyph)\n",
-	    paint_encode_ns / 1e6 / num_iters,
-	    total_glyphs ? paint_encode_ns / 1e3 / total_glyphs : 0.);
-  }
-
-  if (num_draw_encoded)
+  if (stats.paint.encoded)
+    print_encoder_stats ("paint encoded:", stats.paint, num_iters, total_glyphs);
+
+  if (stats.draw.encoded)
+    print_encoder_stats (draw_only ? "draw encoded: " : "draw fallback:",
+			 stats.draw, num_iters,
+			 draw_only ? total_glyphs : (uint64_t) stats.draw.encoded * num_iters);
+
+  if (output_path)
   {
     printf ("\n");
-    printf ("draw fallback: %u\n", num_draw_encoded);
-    printf ("  total:       %.2f KiB\n", draw_bytes / 1024.);
-    printf ("  avg:         %.2f KiB/glyph\n",
-	    draw_bytes / 1024. / num_draw_encoded);
-    printf ("  max:         %.2f KiB (gid %u)\n",
-	    draw_max_bytes / 1024., draw_max_gid);
-    printf ("  walk:        %.3fms (%.1fus/glyph)\n",
-	    draw_walk_ns / 1e6 / num_iters,
-	    num_draw_encoded ? draw_walk_ns / 1e3 / num_draw_encoded : 0.);
-    printf ("  encode:      %.3fms (%.1fus/glyph)\n",
-	    draw_encode_ns / 1e6 / num_iters,
-	    num_draw_encoded ? draw_encode_ns / 1e3 / num_draw_encoded : 0.);
+    printf ("output:        %s\n", output_path);
+    printf ("  size:        %.2f KiB\n", output_bytes / 1024.);
+    if (stats.not_stored)
+      printf ("  not stored:  %u\n", stats.not_stored);
   }
 
   printf ("\n");
-  printf ("wall:     %.3fms (%.0f glyphs/s)\n",
+  printf ("wall:     %.3fms (%.0f glyphs/s, %u jobs)\n",
 	  wall_ns / 1e6 / num_iters,
-	  wall_ns ? total_glyphs * 1e9 / wall_ns : 0.);
+	  wall_ns ? total_glyphs * 1e9 / wall_ns : 0.,
+	  num_jobs);
 
-  hb_gpu_paint_destroy (paint);
-  hb_gpu_draw_destroy (draw);
   hb_font_destroy (font);
   hb_face_destroy (face);
   hb_blob_destroy (blob);
 
-  return num_failed ? 1 : 0;
+  return ret;
 }
@@ -33,28 +33,66 @@
 #include <string.h>
 #include <math.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-static void
-write_ppm (hb_raster_image_t *img, const char *dir, unsigned gid)
+
+/* Time spent in each phase, summed over all jobs.
+ *
+ * draw:   feeding outlines / paint ops into the rasterizer;
+ * sweep:  hb_raster_*_render(), i.e. coverage sweep and compositing;
+ * encode: converting the image to PPM;
+ * write:  file or archive I/O. */
+struct phase_times_t
+{
+  double draw = 0, sweep = 0, encode = 0, write = 0;
+
+  void add (const phase_times_t &o)
+  {
+    draw += o.draw;
+    sweep += o.sweep;
+    encode += o.encode;
+    write += o.write;
+  }
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+static double
+seconds_since (clock_type::time_point &t)
+{
+  clock_type::time_point now = clock_type::now ();
+  double s = std::chrono::duration<double> (now - t).count ();
+  t = now;
+  return s;
+}
+
+
+static bool
+encode_ppm (hb_raster_image_t *img, std::string &out)
 {
   hb_raster_extents_t ext;
   hb_raster_image_get_extents (img, &ext);
-  if (!ext.width || !ext.height) return;
-
-  char path[512];
-  snprintf (path, sizeof path, "%s/%05u.ppm", dir, gid);
-  FILE *f = fopen (path, "wb");
-  if (!f) { fprintf (stderr, "cannot write %s\n", path); return; }
+  if (!ext.width || !ext.height) return false;
 
   const uint8_t *buf = hb_raster_image_get_buffer (img);
   hb_raster_format_t fmt = hb_raster_image_get_format (img);
 
-  fprintf (f, "P6\n%u %u\n255\n", ext.width, ext.height);
-  uint8_t rgb[3];
+  char header[64];
+  int header_len = snprintf (header, sizeof header, "P6\n%u %u\n255\n", ext.width, ext.height);
+  out.resize ((size_t) header_len + (size_t) ext.width * ext.height * 3);
+  memcpy (&out[0], header, header_len);
+
+  uint8_t *rgb = (uint8_t *) &out[header_len];
   for (unsigned row = 0; row < ext.height; row++)
   {
     const uint8_t *src = buf + (ext.height - 1 - row) * ext.stride;
-    for (unsigned x = 0; x < ext.width; x++)
+    for (unsigned x = 0; x < ext.width; x++, rgb += 3)
     {
       if (fmt == HB_RASTER_FORMAT_A8)
       {
@@ -73,85 +111,124 @@ write_ppm (hb_raster_image_t *img, const char *dir, unsigned gid)
 	rgb[1] = (uint8_t) (g + ((255 * inv_a + 128 + ((255 * inv_a + 128) >> 8)) >> 8));
 	rgb[2] = (uint8_t) (b + ((255 * inv_a + 128 + ((255 * inv_a + 128) >> 8)) >> 8));
       }
-      fwrite (rgb, 1, 3, f);
     }
   }
+  return true;
+}
+
+static void
+write_ppm (const std::string &ppm, const char *dir, unsigned gid)
+{
+  char path[512];
+  snprintf (path, sizeof path, "%s/%05u.ppm", dir, gid);
+  FILE *f = fopen (path, "wb");
+  if (!f) { fprintf (stderr, "cannot write %s\n", path); return; }
+  fwrite (ppm.data (), 1, ppm.size (), f);
   fclose (f);
 }
 
-int
-main (int argc, char **argv)
+
+/* A POSIX ustar archive with one NNNNN.ppm member per glyph.
+ *
+ * Jobs finish glyphs out of order; members are buffered until every
+ * lower glyph id is done, so the archive is identical for any -j. */
+struct archive_t
 {
-  unsigned num_iterations = 1;
-  int argi = 1;
-  for (; argi < argc; argi++)
+  FILE *f = nullptr;
+  std::mutex lock;
+  std::vector<std::string> pending;
+  std::vector<bool> done;
+  unsigned next = 0;
+
+  bool open (const char *path, unsigned glyph_count)
   {
-    const char *arg = argv[argi];
-    if (strcmp (arg, "--") == 0)
-    {
-      argi++;
-      break;
-    }
-    if (arg[0] != '-')
-      break;
-    if (strcmp (arg, "-h") == 0 || strcmp (arg, "--help") == 0)
-    {
-      fprintf (stderr, "Usage: %s [-n N|--num-iterations N] font-file [font-size] [output-dir]\n", argv[0]);
-      return 0;
-    }
-    if (strcmp (arg, "-n") == 0 || strcmp (arg, "--num-iterations") == 0)
-    {
-      if (++argi >= argc)
-      {
-	fprintf (stderr, "Missing value for %s\n", arg);
-	return 1;
-      }
-      char *end = nullptr;
-      long n = strtol (argv[argi], &end, 10);
-      if (!argv[argi][0] || end == argv[argi] || *end || n <= 0)
-      {
-	fprintf (stderr, "Invalid --num-iterations: %s\n", argv[argi]);
-	return 1;
-      }
-      num_iterations = (unsigned) n;
-      continue;
-    }
+    f = fopen (path, "wb");
+    pending.resize (glyph_count);
+    done.resize (glyph_count);
+    return f;
+  }
 
-    fprintf (stderr, "Unknown option: %s\n", arg);
-    return 1;
+  bool close ()
+  {
+    static const char zeros[1024] = {};
+    fwrite (zeros, 1, sizeof zeros, f);
+    bool ret = !ferror (f);
+    return fclose (f) == 0 && ret;
   }
 
-  if (argc - argi < 1 || argc - argi > 3)
+  /* Takes @ppm; an empty string means the glyph has no image. */
+  void put (unsigned gid, std::string &ppm)
   {
-    fprintf (stderr, "Usage: %s [-n N|--num-iterations N] font-file [font-size] [output-dir]\n", argv[0]);
-    return 1;
+    std::lock_guard<std::mutex> l (lock);
+    pending[gid].swap (ppm);
+    done[gid] = true;
+    for (; next < done.size () && done[next]; next++)
+    {
+      if (!pending[next].empty ())
+	write_member (next, pending[next]);
+      std::string ().swap (pending[next]);
+    }
   }
 
-  hb_face_t *face = hb_face_create_from_file_or_fail (argv[argi], 0);
-  if (!face) { fprintf (stderr, "Failed to open font\n"); return 1; }
+  void write_member (unsigned gid, const std::string &data)
+  {
+    char header[512] = {};
+    snprintf (header + 0, 100, "%05u.ppm", gid);	/* name */
+    memcpy (header + 100, "0000644", 8);		/* mode */
+    memcpy (header + 108, "0000000", 8);		/* uid */
+    memcpy (header + 116, "0000000", 8);		/* gid */
+    snprintf (header + 124, 12, "%011llo", (unsigned long long) data.size ());
+    memcpy (header + 136, "00000000000", 12);		/* mtime */
+    memset (header + 148, ' ', 8);			/* chksum, while summing */
+    header[156] = '0';					/* typeflag: regular file */
+    memcpy (header + 257, "ustar", 6);			/* magic */
+    memcpy (header + 263, "00", 2);			/* version */
 
-  unsigned upem = hb_face_get_upem (face);
+    unsigned sum = 0;
+    for (unsigned i = 0; i < sizeof header; i++)
+      sum += (uint8_t) header[i];
+    snprintf (header + 148, 8, "%06o", sum);
+    header[155] = ' ';
 
-  int font_size = (argc - argi > 1) ? atoi (argv[argi + 1]) : (int) upem;
-  if (font_size <= 0) font_size = (int) upem;
+    static const char zeros[512] = {};
+    fwrite (header, 1, sizeof header, f);
+    fwrite (data.data (), 1, data.size (), f);
+    fwrite (zeros, 1, (512 - data.size () % 512) % 512, f);
+  }
+};
 
-  const char *outdir = (argc - argi > 2) ? argv[argi + 2] : nullptr;
 
-  hb_font_t *font = hb_font_create (face);
-  hb_font_set_scale (font, font_size, font_size);
+struct job_t
+{
+  hb_font_t *font;	/* Immutable; shared by all workers */
+  bool has_color;
+  unsigned glyph_count;
+  unsigned num_iterations;
+  const char *outdir;
+  archive_t *archive;
 
-  bool has_color = hb_ot_color_has_paint (face) ||
-		   hb_ot_color_has_layers (face) ||
-		   hb_ot_color_has_png (face);
+  std::atomic<unsigned> next_gid {0};
+};
 
+/* Each worker owns its rasterizer contexts and pulls glyph ids off
+ * the shared counter until the font is exhausted. */
+static void
+worker (job_t *job, phase_times_t *times)
+{
+  hb_font_t *font = job->font;
   hb_raster_draw_t  *rdr = hb_raster_draw_create_or_fail ();
-  hb_raster_paint_t *pnt = has_color ? hb_raster_paint_create_or_fail () : nullptr;
-  unsigned glyph_count = hb_face_get_glyph_count (face);
+  hb_raster_paint_t *pnt = job->has_color ? hb_raster_paint_create_or_fail () : nullptr;
+  bool output = job->outdir || job->archive;
+  std::string ppm;
 
-  for (unsigned gid = 0; gid < glyph_count; gid++)
+  unsigned gid;
+  while ((gid = job->next_gid.fetch_add (1, std::memory_order_relaxed)) < job->glyph_count)
   {
-    for (unsigned iter = 0; iter < num_iterations; iter++)
+    ppm.clear ();
+    for (unsigned iter = 0; iter < job->num_iterations; iter++)
     {
+      bool last = iter + 1 == job->num_iterations;
+      clock_type::time_point t = clock_type::now ();
       hb_raster_image_t *img = nullptr;
 
       if (pnt)
@@ -162,14 +239,21 @@ main (int argc, char **argv)
 	{
 	  hb_raster_paint_set_transform (pnt, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f);
 	  hb_bool_t painted = hb_raster_paint_glyph_or_fail (pnt, font, gid);
+	  times->draw += seconds_since (t);
 	  if (painted)
+	  {
 	    img = hb_raster_paint_render (pnt);
+	    times->sweep += seconds_since (t);
+	  }
 	}
 
 	if (img)
 	{
-	  if (outdir && iter + 1 == num_iterations)
-	    write_ppm (img, outdir, gid);
+	  if (output && last)
+	  {
+	    encode_ppm (img, ppm);
+	    times->encode += seconds_since (t);
+	  }
 	  hb_raster_paint_recycle_image (pnt, img);
 	  continue;
 	}
@@ -177,20 +261,201 @@ main (int argc, char **argv)
 
       hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f);
       hb_raster_draw_glyph (rdr, font, gid);
+      times->draw += seconds_since (t);
 
       img = hb_raster_draw_render (rdr);
+      times->sweep += seconds_since (t);
       if (img)
       {
-	if (outdir && iter + 1 == num_iterations)
-	  write_ppm (img, outdir, gid);
+	if (output && last)
+	{
+	  encode_ppm (img, ppm);
+	  times->encode += seconds_since (t);
+	}
 	hb_raster_draw_recycle_image (rdr, img);
       }
     }
+
+    clock_type::time_point t = clock_type::now ();
+    if (job->archive)
+      job->archive->put (gid, ppm);
+    else if (job->outdir && !ppm.empty ())
+      write_ppm (ppm, job->outdir, gid);
+    times->write += seconds_since (t);
   }
 
   hb_raster_paint_destroy (pnt);
   hb_raster_draw_destroy (rdr);
+}
+
+
+static void
+usage (FILE *f, const char *prog)
+{
+  fprintf (f, "Usage: %s [-n N|--num-iterations N] [-j N|--jobs N] [--archive FILE] [--timing]\n"
+	      "       font-file [font-size] [output-dir]\n"
+	      "\n"
+	      "  -j, --jobs N      Rasterize with N threads; 0 uses one per CPU (default: 1)\n"
+	      "  --archive FILE    Write all glyph images into a single tar archive\n"
+	      "  --timing          Report per-phase timing and throughput on stderr\n",
+	   prog);
+}
+
+static bool
+parse_unsigned (const char *arg, const char *value, bool allow_zero, unsigned *out)
+{
+  char *end = nullptr;
+  long n = strtol (value, &end, 10);
+  if (!value[0] || end == value || *end || n < (allow_zero ? 0 : 1))
+  {
+    fprintf (stderr, "Invalid %s: %s\n", arg, value);
+    return false;
+  }
+  *out = (unsigned) n;
+  return true;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned num_iterations = 1;
+  unsigned num_jobs = 1;
+  const char *archive_path = nullptr;
+  bool timing = false;
+  int argi = 1;
+  for (; argi < argc; argi++)
+  {
+    const char *arg = argv[argi];
+    if (strcmp (arg, "--") == 0)
+    {
+      argi++;
+      break;
+    }
+    if (arg[0] != '-')
+      break;
+    if (strcmp (arg, "-h") == 0 || strcmp (arg, "--help") == 0)
+    {
+      usage (stdout, argv[0]);
+      return 0;
+    }
+    if (strcmp (arg, "--timing") == 0)
+    {
+      timing = true;
+      continue;
+    }
+
+    bool is_iterations = strcmp (arg, "-n") == 0 || strcmp (arg, "--num-iterations") == 0;
+    bool is_jobs = strcmp (arg, "-j") == 0 || strcmp (arg, "--jobs") == 0;
+    bool is_archive = strcmp (arg, "--archive") == 0;
+    if (!is_iterations && !is_jobs && !is_archive)
+    {
+      fprintf (stderr, "Unknown option: %s\n", arg);
+      return 1;
+    }
+    if (++argi >= argc)
+    {
+      fprintf (stderr, "Missing value for %s\n", arg);
+      return 1;
+    }
+    if (is_iterations && !parse_unsigned ("--num-iterations", argv[argi], false, &num_iterations))
+      return 1;
+    if (is_jobs && !parse_unsigned ("--jobs", argv[argi], true, &num_jobs))
+      return 1;
+    if (is_archive)
+      archive_path = argv[argi];
+  }
+
+  if (argc - argi < 1 || argc - argi > 3)
+  {
+    usage (stderr, argv[0]);
+    return 1;
+  }
+
+  if (!num_jobs)
+    num_jobs = hb_max (1u, std::thread::hardware_concurrency ());
+
+  hb_face_t *face = hb_face_create_from_file_or_fail (argv[argi], 0);
+  if (!face) { fprintf (stderr, "Failed to open font\n"); return 1; }
+
+  unsigned upem = hb_face_get_upem (face);
+
+  int font_size = (argc - argi > 1) ? atoi (argv[argi + 1]) : (int) upem;
+  if (font_size <= 0) font_size = (int) upem;
+
+  const char *outdir = (argc - argi > 2) ? argv[argi + 2] : nullptr;
+
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, font_size, font_size);
+  hb_font_make_immutable (font);
+
+  unsigned glyph_count = hb_face_get_glyph_count (face);
+
+  archive_t archive;
+  if (archive_path && !archive.open (archive_path, glyph_count))
+  {
+    fprintf (stderr, "cannot write %s\n", archive_path);
+    return 1;
+  }
+
+  job_t job;
+  job.font = font;
+  job.has_color = hb_ot_color_has_paint (face) ||
+		  hb_ot_color_has_layers (face) ||
+		  hb_ot_color_has_png (face);
+  job.glyph_count = glyph_count;
+  job.num_iterations = num_iterations;
+  job.outdir = outdir;
+  job.archive = archive_path ? &archive : nullptr;
+
+  std::vector<phase_times_t> times (num_jobs);
+  clock_type::time_point start = clock_type::now ();
+
+  if (num_jobs == 1)
+    worker (&job, &times[0]);
+  else
+  {
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < num_jobs; i++)
+      threads.emplace_back (worker, &job, &times[i]);
+    for (auto &thread : threads)
+      thread.join ();
+  }
+
+  double wall = seconds_since (start);
+
+  int ret = 0;
+  if (archive_path && !archive.close ())
+  {
+    fprintf (stderr, "error writing %s\n", archive_path);
+    ret = 1;
+  }
+
+  if (timing)
+  {
+    phase_times_t total;
+    for (const auto &t : times)
+      total.add (t);
+    double busy = total.draw + total.sweep + total.encode + total.write;
+    unsigned long long renders = (unsigned long long) glyph_count * num_iterations;
+
+    fprintf (stderr, "%u glyphs x %u iterations, %u jobs: %.3fs wall, %.0f glyphs/s\n",
+	     glyph_count, num_iterations, num_jobs, wall,
+	     wall > 0 ? renders / wall : 0.);
+    fprintf (stderr, "phase     seconds   share   us/glyph  (summed over jobs)\n");
+    const struct { const char *name; double t; } phases[] = {
+      {"draw",   total.draw},
+      {"sweep",  total.sweep},
+      {"encode", total.encode},
+      {"write",  total.write},
+    };
+    for (const auto &p : phases)
+      fprintf (stderr, "%-8s %8.3f  %5.1f%%  %9.2f\n",
+	       p.name, p.t,
+	       busy > 0 ? 100. * p.t / busy : 0.,
+	       renders ? 1e6 * p.t / renders : 0.);
+  }
+
   hb_font_destroy (font);
   hb_face_destroy (face);
-  return 0;
+  return ret;
 }
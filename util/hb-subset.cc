@@ -50,6 +50,7 @@ struct subset_main_t : option_parser_t, face_options_t, output_options_t<false>
   {}
   ~subset_main_t ()
   {
+    hb_font_destroy (font);
     hb_subset_input_destroy (input);
   }
 
@@ -93,30 +94,25 @@ struct subset_main_t : option_parser_t, face_options_t, output_options_t<false>
 
     add_options ();
     option_parser_t::parse (&argc, &argv);
+
+    if (preprocess)
+    {
+      hb_face_t *preprocessed = preprocessed_cache.get (face);
+      set_face (preprocessed);
+      hb_face_destroy (preprocessed);
+    }
   }
 
   int operator () (int argc, char **argv)
   {
     parse (argc, argv);
+    return run ();
+  }
 
-    hb_face_t* orig_face = face;
-    if (orig_face != cache.face)
-    {
-      hb_face_destroy (cache.face);
-      cache.face = hb_face_reference (orig_face);
-      if (cache.face_preprocessed)
-      {
-        hb_face_destroy (cache.face_preprocessed);
-	cache.face_preprocessed = nullptr;
-      }
-    }
-
-    if (preprocess)
-    {
-      if (!cache.face_preprocessed)
-        cache.face_preprocessed = preprocess_face (cache.face);
-      orig_face = cache.face_preprocessed;
-    }
+  /* Batch mode with --jobs calls this on a worker thread, after parse (). */
+  int run ()
+  {
+    hb_face_t *orig_face = face;
 
     hb_face_t *new_face = nullptr;
     for (unsigned i = 0; i < num_iterations; i++)
@@ -128,9 +124,18 @@ struct subset_main_t : option_parser_t, face_options_t, output_options_t<false>
     bool success = new_face;
     if (success)
     {
-      hb_blob_t *result = hb_face_reference_blob (new_face);
-      write_file (output_file, result);
-      hb_blob_destroy (result);
+      /* Write the tables straight out, without assembling the font first. */
+      /* At most the table directory, then each table and its padding. */
+      unsigned int count = 1 + 2 * hb_face_get_table_tags (new_face, 0, nullptr, nullptr);
+      hb_blob_t **blobs = g_new (hb_blob_t *, count);
+      if (!hb_face_builder_reference_blobs (new_face, 0, &count, blobs))
+	blobs[count++] = hb_face_reference_blob (new_face);
+      for (unsigned int i = 0; i < count; i++)
+      {
+	write_file (output_file, blobs[i]);
+	hb_blob_destroy (blobs[i]);
+      }
+      g_free (blobs);
     }
     else if (hb_face_get_glyph_count (orig_face) == 0)
       fail (false, "Invalid font file.");
@@ -180,22 +185,61 @@ struct subset_main_t : option_parser_t, face_options_t, output_options_t<false>
   gboolean preprocess = false;
   hb_subset_input_t *input = nullptr;
 
-  static struct cache_t
+  /* For looking up glyph names. */
+  hb_font_t *font = nullptr;
+
+  /* Preprocessed faces, by the face they were made from, most recently
+   * used first.  Only accessed from parse (), which batch mode runs on
+   * one thread. */
+  static struct preprocessed_cache_t
   {
-    ~cache_t ()
+    ~preprocessed_cache_t ()
     {
-      hb_face_destroy (face);
-      hb_face_destroy (face_preprocessed);
-      hb_font_destroy (font);
+      for (unsigned i = 0; i < length; i++)
+      {
+	hb_face_destroy (entries[i].face);
+	hb_face_destroy (entries[i].preprocessed);
+      }
     }
 
-    hb_face_t *face = nullptr;
-    hb_face_t *face_preprocessed = nullptr;
-    hb_font_t *font = nullptr;
-  } cache;
+    hb_face_t *get (hb_face_t *face)
+    {
+      unsigned i;
+      for (i = 0; i < length; i++)
+	if (entries[i].face == face)
+	  break;
+
+      entry_t entry;
+      if (i < length)
+	entry = entries[i];
+      else
+      {
+	if (length == ARRAY_LENGTH (entries))
+	{
+	  length--;
+	  hb_face_destroy (entries[length].face);
+	  hb_face_destroy (entries[length].preprocessed);
+	}
+	entry = {hb_face_reference (face), preprocess_face (face)};
+	i = length++;
+      }
+
+      memmove (entries + 1, entries, i * sizeof (entries[0]));
+      entries[0] = entry;
+      return hb_face_reference (entry.preprocessed);
+    }
+
+    struct entry_t
+    {
+      hb_face_t *face;
+      hb_face_t *preprocessed;
+    };
+    entry_t entries[16];
+    unsigned length = 0;
+  } preprocessed_cache;
 };
 
-subset_main_t::cache_t subset_main_t::cache {};
+subset_main_t::preprocessed_cache_t subset_main_t::preprocessed_cache {};
 
 static gboolean
 parse_gids (const char *name G_GNUC_UNUSED,
@@ -303,9 +347,9 @@ parse_glyphs (const char *name,
   const char *p = arg;
   const char *p_end = arg + strlen (arg);
 
-  if (!subset_main->cache.font)
-    subset_main->cache.font = hb_font_create (subset_main->face);
-  hb_font_t *font = subset_main->cache.font;
+  if (!subset_main->font)
+    subset_main->font = hb_font_create (subset_main->face);
+  hb_font_t *font = subset_main->font;
 
   while (p < p_end)
   {
@@ -1036,5 +1080,5 @@ int
 main (int argc, char **argv)
 {
   argv_t args (argc, argv);
-  return batch_main<subset_main_t, true> (args.argc, args.argv);
+  return batch_main<subset_main_t, true, true> (args.argc, args.argv);
 }
@@ -63,6 +63,8 @@ struct vector_output_t : output_options_t<>, view_options_t
     GOptionEntry entries[] =
     {
       {"precision",  0, 0, G_OPTION_ARG_INT,    &this->precision,     "Decimal precision (default: 2)",     "N"},
+      {"svg-reuse",  0, 0, G_OPTION_ARG_NONE,   &this->svg_reuse,     "Emit repeated glyphs and gradients once in SVG <defs>", nullptr},
+      {"pdf-compression-level",0, 0, G_OPTION_ARG_INT, &this->pdf_compression_level, "Compress PDF output with zlib level N, 0-9 (default: 0)", "N"},
       {nullptr}
     };
     parser->add_group (entries,
@@ -197,6 +199,8 @@ struct vector_output_t : output_options_t<>, view_options_t
     hb_vector_draw_set_scale_factor (draw, scale, scale);
     hb_vector_draw_set_extents (draw, &extents);
     hb_vector_draw_set_precision (draw, precision);
+    hb_vector_draw_set_svg_reuse (draw, svg_reuse);
+    hb_vector_draw_set_pdf_compression_level (draw, pdf_compression_level);
     hb_vector_draw_set_foreground (draw, foreground);
     hb_vector_draw_set_background (draw, background);
 
@@ -209,6 +213,8 @@ struct vector_output_t : output_options_t<>, view_options_t
       hb_vector_paint_set_palette (paint, this->palette);
       apply_custom_palette (paint);
       hb_vector_paint_set_precision (paint, precision);
+      hb_vector_paint_set_svg_reuse (paint, svg_reuse);
+      hb_vector_paint_set_pdf_compression_level (paint, pdf_compression_level);
     }
 
     bool had_draw = false;
@@ -521,6 +527,8 @@ struct vector_output_t : output_options_t<>, view_options_t
   }
 
   int precision = 2;
+  gboolean svg_reuse = false;
+  int pdf_compression_level = 0;
   hb_color_t background = HB_COLOR (255, 255, 255, 255);
   hb_color_t foreground = HB_COLOR (0, 0, 0, 255);
 